@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2010-06-10
-// Last changed: 2012-12-12
+// Last changed: 2014-03-27
 //
 // Description: Benchmark for the evaluations of functions at arbitrary points.
 
@@ -46,9 +46,12 @@ int main(int argc, char* argv[])
 
   const std::size_t mesh_max_size = 32;
   const std::size_t num_points  = 10000000;
+  const std::size_t batch_size  = 100000;
 
   // Start timing
   tic();
+  double t_single = 0.0;
+  double t_batch = 0.0;
   for (std::size_t N = 10; N < mesh_max_size; N += 2)
   {
     UnitCubeMesh mesh(N, N, N);
@@ -64,18 +67,42 @@ int main(int argc, char* argv[])
     // Initialize random generator generator (produces same sequence each test).
     srand(1);
 
+    // Evaluate point by point
+    Timer t0("Function evaluation (single point)");
     for (std::size_t i = 1; i <= num_points; ++i)
     {
       X[0] = std::rand()/static_cast<double>(RAND_MAX);
       X[1] = std::rand()/static_cast<double>(RAND_MAX);
       X[2] = std::rand()/static_cast<double>(RAND_MAX);
 
-      f.eval(value, X);
+      f0.eval(value, X);
     }
+    t_single += t0.stop();
 
     // Use X variable.
     info("x = %.12e\ty = %.12e\tz = %.12e\tf(x) = %.12e", X[0], X[1], X[2], value[0]);
+
+    // Evaluate same points in batches
+    srand(1);
+    Array<double> Xb(3*batch_size);
+    Array<double> values(batch_size);
+    Timer t1("Function evaluation (batch)");
+    for (std::size_t i = 0; i < num_points; i += batch_size)
+    {
+      for (std::size_t j = 0; j < Xb.size(); ++j)
+        Xb[j] = std::rand()/static_cast<double>(RAND_MAX);
+
+      f0.eval_points(values, Xb);
+    }
+    t_batch += t1.stop();
+
+    // Use values variable.
+    info("x = %.12e\ty = %.12e\tz = %.12e\tf(x) = %.12e",
+         Xb[Xb.size() - 3], Xb[Xb.size() - 2], Xb[Xb.size() - 1],
+         values[values.size() - 1]);
   }
+  info("Single point evaluation: %g s", t_single);
+  info("Batch evaluation:        %g s", t_batch);
   info("BENCH  %g",toc());
 
   return 0;
@@ -15,29 +15,70 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
-// This benchmark measures the performance of building a BoundingBoxTree (and
-// one call to compute_entities, which is dominated by building).
+// This benchmark measures the performance of building a BoundingBoxTree
+// with median and surface area heuristic (SAH) splits, and of querying
+// the resulting trees with compute_entity_collisions. The number of
+// threads used for building may be given as the first argument.
 //
 // First added:  2013-04-18
-// Last changed: 2013-06-25
+// Last changed: 2014-03-27
 
+#include <cstdlib>
+#include <string>
 #include <vector>
 #include <dolfin.h>
 
 using namespace dolfin;
 
 #define SIZE 128
+#define NUM_QUERIES 1000000
 
 int main(int argc, char* argv[])
 {
+  // Set number of threads
+  if (argc > 1)
+    parameters["num_threads"] = atoi(argv[1]);
+
   // Create mesh
   UnitCubeMesh mesh(SIZE, SIZE, SIZE);
 
-  // Create and build tree
-  tic();
-  BoundingBoxTree tree;
-  tree.build(mesh);
-  info("BENCH %g", toc());
+  // Random query points (same sequence for each tree)
+  std::vector<Point> points(NUM_QUERIES);
+  srand(1);
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    points[i] = Point(std::rand()/static_cast<double>(RAND_MAX),
+                      std::rand()/static_cast<double>(RAND_MAX),
+                      std::rand()/static_cast<double>(RAND_MAX));
+  }
+
+  double t_build = 0.0;
+  const std::string splits[] = {"median", "sah"};
+  for (std::size_t k = 0; k < 2; ++k)
+  {
+    parameters["bounding_box_tree_split"] = splits[k];
+
+    // Create and build tree
+    tic();
+    BoundingBoxTree tree;
+    tree.build(mesh);
+    const double t0 = toc();
+    if (k == 0)
+      t_build = t0;
+
+    // Query tree
+    tic();
+    std::size_t num_collisions = 0;
+    for (std::size_t i = 0; i < points.size(); ++i)
+      num_collisions += tree.compute_entity_collisions(points[i]).size();
+    const double t1 = toc();
+
+    info("%-6s split: build %g s, %d queries %g s (%d collisions)",
+         splits[k].c_str(), t0, NUM_QUERIES, t1, num_collisions);
+  }
+
+  // Report result (build time with median split)
+  info("BENCH %g", t_build);
 
   return 0;
 }
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2006-11-01
-// Last changed: 2012-12-12
+// Last changed: 2014-03-24
 
 #include <dolfin.h>
 
@@ -25,6 +25,24 @@ using namespace dolfin;
 #define NUM_REPS 100
 #define SIZE 128
 
+// Kernel summing vertex indices of cells, used with parallel_for
+class VertexSum
+{
+public:
+
+  VertexSum() : sum(0) {}
+
+  void operator() (const MeshEntityRange& cells, std::size_t c)
+  {
+    const unsigned int* vertices = cells.vertices(c);
+    for (std::size_t i = 0; i < cells.num_vertices(c); i++)
+      sum += vertices[i];
+  }
+
+  int sum;
+
+};
+
 int main(int argc, char* argv[])
 {
   info("Iteration over entities of unit cube of size %d x %d x %d (%d repetitions)",
@@ -44,8 +62,35 @@ int main(int argc, char* argv[])
   }
   info("BENCH %g", toc());
 
-  // To prevent optimizing the loop away
-  info("Sum is %d", sum);
+  // Iterate using direct access to cell vertices
+  int sum_range = 0;
+  const MeshEntityRange cells(mesh, mesh.topology().dim());
+  tic();
+  for (int i = 0; i < NUM_REPS; i++)
+  {
+    for (std::size_t c = cells.begin(); c < cells.end(); c++)
+    {
+      const unsigned int* vertices = cells.vertices(c);
+      for (std::size_t j = 0; j < cells.num_vertices(c); j++)
+        sum_range += vertices[j];
+    }
+  }
+  info("BENCH (MeshEntityRange) %g", toc());
+
+  // Iterate using parallel_for with one kernel per thread
+  int sum_parallel = 0;
+  tic();
+  for (int i = 0; i < NUM_REPS; i++)
+  {
+    std::vector<VertexSum> kernels(MeshEntityRange::num_threads());
+    cells.parallel_for(kernels);
+    for (std::size_t j = 0; j < kernels.size(); j++)
+      sum_parallel += kernels[j].sum;
+  }
+  info("BENCH (parallel_for) %g", toc());
+
+  // To prevent optimizing the loops away
+  info("Sum is %d (%d, %d)", sum, sum_range, sum_parallel);
 
   return 0;
 }
@@ -83,7 +83,7 @@ void Extrapolation::extrapolate(Function& w, const Function& v)
     cell0->get_cell_data(c0);
 
     // Tabulate dofs for w on cell and store values
-    const std::vector<dolfin::la_index>& dofs
+    const ArrayView<const dolfin::la_index> dofs
       = W.dofmap()->cell_dofs(cell0->index());
 
     // Compute coefficients on this cell
@@ -104,7 +104,7 @@ Extrapolation::compute_coefficients(std::vector<std::vector<double> >& coefficie
                                     const Cell& cell0,
                                     const std::vector<double>& vertex_coordinates0,
                                     const ufc::cell& c0,
-                                    const std::vector<dolfin::la_index>& dofs,
+                                    const ArrayView<const dolfin::la_index>& dofs,
                                     std::size_t& offset)
 {
   // Call recursively for mixed elements
@@ -252,7 +252,7 @@ Extrapolation::compute_unique_dofs(const Cell& cell,
                                    std::set<std::size_t>& unique_dofs)
 {
   dolfin_assert(V.dofmap());
-  const std::vector<dolfin::la_index>& dofs
+  const ArrayView<const dolfin::la_index> dofs
     = V.dofmap()->cell_dofs(cell.index());
 
   // Data structure for current cell
@@ -16,18 +16,21 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2008-08-11
-// Last changed: 2013-12-02
+// Last changed: 2014-03-27
 
-#include <dolfin/common/Array.h>
+#include <algorithm>
+#include <dolfin/common/MPI.h>
 #include <dolfin/parameter/GlobalParameters.h>
 #include <dolfin/fem/Assembler.h>
 #include <dolfin/fem/fem_utils.h>
+#include <dolfin/la/KrylovSolver.h>
 #include <dolfin/la/Matrix.h>
-#include <dolfin/la/solve.h>
 #include <dolfin/la/Vector.h>
+#include <dolfin/la/solve.h>
 #include <dolfin/log/log.h>
 #include <dolfin/mesh/BoundaryMesh.h>
 #include <dolfin/mesh/Mesh.h>
+#include <dolfin/mesh/MeshEntityRange.h>
 #include <dolfin/mesh/MeshFunction.h>
 #include <dolfin/function/Function.h>
 #include "Poisson1D.h"
@@ -37,6 +40,110 @@
 
 using namespace dolfin;
 
+//-----------------------------------------------------------------------------
+HarmonicSmoothing::HarmonicSmoothing(Mesh& mesh)
+  : _mesh(&mesh), _topology_version(0)
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+HarmonicSmoothing::~HarmonicSmoothing()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<MeshDisplacement>
+HarmonicSmoothing::smooth(const BoundaryMesh& new_boundary)
+{
+  const Mesh& mesh = *_mesh;
+  const std::size_t d = mesh.geometry().dim();
+  const std::size_t num_vertices = mesh.num_vertices();
+
+  // Mapping of new_boundary vertex numbers to mesh vertex numbers
+  const MeshFunction<std::size_t>& vertex_map_mesh_func =
+                                     new_boundary.entity_map(0);
+  const std::size_t num_boundary_vertices = vertex_map_mesh_func.size();
+  const std::size_t* vertex_map = vertex_map_mesh_func.values();
+
+  // Assemble operator if not done or if topology or boundary has
+  // changed (on any process, since assembly is collective)
+  std::size_t changed = (!_A
+      || mesh.topology().version() != _topology_version
+      || _vertex_map.size() != num_boundary_vertices
+      || !std::equal(_vertex_map.begin(), _vertex_map.end(), vertex_map))
+    ? 1 : 0;
+  if (MPI::size(mesh.mpi_comm()) > 1)
+    changed = MPI::max(mesh.mpi_comm(), changed);
+  if (changed)
+  {
+    init(std::vector<std::size_t>(vertex_map,
+                                  vertex_map + num_boundary_vertices));
+  }
+
+  // Displacement solution wrapped in Expression subclass MeshDisplacement
+  std::shared_ptr<MeshDisplacement> u(new MeshDisplacement(_V));
+
+  // RHS vector and array for storing Dirichlet condition
+  Vector b(*(*u)[0].vector());
+  const std::size_t num_boundary_dofs = _boundary_dofs.size();
+  std::vector<double> boundary_values(num_boundary_dofs);
+
+  // Displacement of all vertices, component after component
+  std::vector<double> displacement(d*num_vertices);
+
+  // Solve system for each dimension. The operator is the same for
+  // all dimensions, so the preconditioner is only built once.
+  for (std::size_t dim = 0; dim < d; dim++)
+  {
+    // Get solution vector
+    std::shared_ptr<GenericVector> x = (*u)[dim].vector();
+
+    // Start from displacement of previous move (if any)
+    if (_x[dim])
+      *x = *_x[dim];
+
+    // Store bc into RHS and solution so that CG solver can be used
+    for (std::size_t i = 0; i < num_boundary_dofs; i++)
+      boundary_values[i] = new_boundary.geometry().x(_boundary_vertices[i], dim)
+                         - mesh.geometry().x(vertex_map[_boundary_vertices[i]], dim);
+    b.zero();
+    b.set(boundary_values.data(), num_boundary_dofs, _boundary_dofs.data());
+    b.apply("insert");
+    x->set(boundary_values.data(), num_boundary_dofs, _boundary_dofs.data());
+    x->apply("insert");
+
+    // Solve system
+    _solver->solve(*x, b);
+
+    // Update_ghost_values()
+    x->update_ghost_values();
+
+    // Get displacement
+    x->get_local(displacement.data() + dim*num_vertices, num_vertices,
+                 _vertex_dofs.data());
+
+    // Keep displacement as initial guess for next move
+    if (_x[dim])
+      *_x[dim] = *x;
+    else
+      _x[dim] = x->copy();
+  }
+
+  // Modify mesh coordinates (in parallel, if enabled)
+  std::vector<double>& coordinates = _mesh->geometry().x();
+  #ifdef HAS_OPENMP
+  const std::size_t num_threads = MeshEntityRange::num_threads();
+  #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t i = 0; i < num_vertices; i++)
+  {
+    for (std::size_t dim = 0; dim < d; dim++)
+      coordinates[i*d + dim] += displacement[dim*num_vertices + i];
+  }
+
+  // Return calculated displacement
+  return u;
+}
 //-----------------------------------------------------------------------------
 std::shared_ptr<MeshDisplacement> HarmonicSmoothing::move(Mesh& mesh,
                                             const BoundaryMesh& new_boundary)
@@ -47,25 +154,31 @@ std::shared_ptr<MeshDisplacement> HarmonicSmoothing::move(Mesh& mesh,
     warning("The function HarmonicSmoothing::move no longer needs "
             "parameters[\"reorder_dofs_serial\"] = false");
 
+  HarmonicSmoothing smoothing(mesh);
+  return smoothing.smooth(new_boundary);
+}
+//-----------------------------------------------------------------------------
+void HarmonicSmoothing::init(const std::vector<std::size_t>& vertex_map)
+{
+  const Mesh& mesh = *_mesh;
   const std::size_t D = mesh.topology().dim();
   const std::size_t d = mesh.geometry().dim();
 
   // Choose form and function space
-  std::shared_ptr<FunctionSpace> V;
   std::shared_ptr<Form> form;
   switch (D)
   {
   case 1:
-    V.reset(new Poisson1D::FunctionSpace(mesh));
-    form.reset(new Poisson1D::BilinearForm(V, V));
+    _V.reset(new Poisson1D::FunctionSpace(mesh));
+    form.reset(new Poisson1D::BilinearForm(_V, _V));
     break;
   case 2:
-    V.reset(new Poisson2D::FunctionSpace(mesh));
-    form.reset(new Poisson2D::BilinearForm(V, V));
+    _V.reset(new Poisson2D::FunctionSpace(mesh));
+    form.reset(new Poisson2D::BilinearForm(_V, _V));
     break;
   case 3:
-    V.reset(new Poisson3D::FunctionSpace(mesh));
-    form.reset(new Poisson3D::BilinearForm(V, V));
+    _V.reset(new Poisson3D::FunctionSpace(mesh));
+    form.reset(new Poisson3D::BilinearForm(_V, _V));
     break;
   default:
     dolfin_error("HarmonicSmoothing.cpp",
@@ -74,40 +187,30 @@ std::shared_ptr<MeshDisplacement> HarmonicSmoothing::move(Mesh& mesh,
   }
 
   // Assemble matrix
-  Matrix A;
+  _A.reset(new Matrix);
   Assembler assembler;
-  assembler.assemble(A, *form);
+  assembler.assemble(*_A, *form);
 
   const std::size_t num_vertices = mesh.num_vertices();
 
   // Dof range
-  const dolfin::la_index n0 = V->dofmap()->ownership_range().first;
-  const dolfin::la_index n1 = V->dofmap()->ownership_range().second;
+  const dolfin::la_index n0 = _V->dofmap()->ownership_range().first;
+  const dolfin::la_index n1 = _V->dofmap()->ownership_range().second;
   const dolfin::la_index num_dofs = n1 - n0;
 
-  // Mapping of new_boundary vertex numbers to mesh vertex numbers
-  const MeshFunction<std::size_t>& vertex_map_mesh_func =
-                                     new_boundary.entity_map(0);
-  const std::size_t num_boundary_vertices = vertex_map_mesh_func.size();
-  const std::vector<std::size_t> vertex_map(vertex_map_mesh_func.values(),
-                      vertex_map_mesh_func.values() + num_boundary_vertices);
-
   // Mapping of mesh vertex numbers to dofs (including ghost dofs)
-  const std::vector<dolfin::la_index> vertex_to_dofs = vertex_to_dof_map(*V);
+  const std::vector<dolfin::la_index> vertex_to_dofs = vertex_to_dof_map(*_V);
 
   // Array of all dofs (including ghosts) with global numbering
-  std::vector<dolfin::la_index> all_global_dofs(num_vertices);
+  _vertex_dofs.resize(num_vertices);
   for (std::size_t i = 0; i < num_vertices; i++)
-    all_global_dofs[i] = vertex_to_dofs[i] + n0;
+    _vertex_dofs[i] = vertex_to_dofs[i] + n0;
 
   // Create arrays for setting bcs.
   // Their indexing does not matter - same ordering does.
-  std::size_t num_boundary_dofs = 0;
-  std::vector<dolfin::la_index> boundary_dofs;
-  boundary_dofs.reserve(num_boundary_vertices);
-  std::vector<std::size_t> boundary_vertices;
-  boundary_vertices.reserve(num_boundary_vertices);
-  for (std::size_t vert = 0; vert < num_boundary_vertices; vert++)
+  _boundary_dofs.clear();
+  _boundary_vertices.clear();
+  for (std::size_t vert = 0; vert < vertex_map.size(); vert++)
   {
     const dolfin::la_index dof = vertex_to_dofs[vertex_map[vert]];
 
@@ -115,76 +218,33 @@ std::shared_ptr<MeshDisplacement> HarmonicSmoothing::move(Mesh& mesh,
     if (dof >= 0 && dof < num_dofs)
     {
       // Global dof numbers
-      boundary_dofs.push_back(dof + n0);
+      _boundary_dofs.push_back(dof + n0);
 
       // new_boundary vertex indices
-      boundary_vertices.push_back(vert);
-
-      num_boundary_dofs++;
+      _boundary_vertices.push_back(vert);
     }
   }
 
   // Modify matrix (insert 1 on diagonal)
-  A.ident(num_boundary_dofs, boundary_dofs.data());
-  A.apply("insert");
-
-  // Arrays for storing dirichlet condition and solution
-  std::vector<double> boundary_values(num_boundary_dofs);
-  std::vector<double> displacement;
-  displacement.reserve(d*num_vertices);
+  _A->ident(_boundary_dofs.size(), _boundary_dofs.data());
+  _A->apply("insert");
 
   // Pick amg as preconditioner if available
   const std::string prec(has_krylov_solver_preconditioner("amg")
                          ? "amg" : "default");
 
-  // Displacement solution wrapped in Expression subclass MeshDisplacement
-  std::shared_ptr<MeshDisplacement> u(new MeshDisplacement(mesh));
+  // Create solver and keep preconditioner between solves
+  _solver.reset(new KrylovSolver("cg", prec));
+  _solver->parameters["nonzero_initial_guess"] = true;
+  _solver->parameters("preconditioner")["structure"] = "same";
+  _solver->set_operator(_A);
 
-  // RHS vector
-  Vector b(*(*u)[0].vector());
+  // Previous displacements do not match the new operator
+  _x.clear();
+  _x.resize(d);
 
-  // Solve system for each dimension
-  for (std::size_t dim = 0; dim < d; dim++)
-  {
-    // Get solution vector
-    std::shared_ptr<GenericVector> x = (*u)[dim].vector();
-
-    if (dim > 0)
-      b.zero();
-
-    // Store bc into RHS and solution so that CG solver can be used
-    for (std::size_t i = 0; i < num_boundary_dofs; i++)
-      boundary_values[i] = new_boundary.geometry().x(boundary_vertices[i], dim)
-                         - mesh.geometry().x(vertex_map[boundary_vertices[i]], dim);
-    b.set(boundary_values.data(), num_boundary_dofs, boundary_dofs.data());
-    b.apply("insert");
-    *x = b;
-
-    // Solve system
-    solve(A, *x, b, "cg", prec);
-
-    // Update_ghost_values()
-    x->update_ghost_values();
-
-    // Get displacement
-    std::vector<double> _displacement(num_vertices);
-    x->get_local(_displacement.data(), num_vertices, all_global_dofs.data());
-    displacement.insert(displacement.end(),
-                        _displacement.begin(),
-                        _displacement.end());
-  }
-
-  // Modify mesh coordinates
-  MeshGeometry& geometry = mesh.geometry();
-  std::vector<double> coord(d);
-  for (std::size_t i = 0; i < num_vertices; i++)
-  {
-    for (std::size_t dim = 0; dim < d; dim++)
-      coord[dim] = displacement[dim*num_vertices + i] + geometry.x(i, dim);
-    geometry.set(i, coord);
-  }
-
-  // Return calculated displacement
-  return u;
+  // Store topology and boundary the operator was built for
+  _topology_version = mesh.topology().version();
+  _vertex_map = vertex_map;
 }
 //-----------------------------------------------------------------------------
@@ -16,34 +16,93 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2008-08-11
-// Last changed: 2013-03-06
+// Last changed: 2014-03-27
 
 #ifndef __HARMONIC_SMOOTHING_H
 #define __HARMONIC_SMOOTHING_H
 
 #include <memory>
+#include <vector>
+#include <dolfin/common/types.h>
 #include "MeshDisplacement.h"
 
 namespace dolfin
 {
 
   class BoundaryMesh;
+  class FunctionSpace;
+  class GenericVector;
+  class KrylovSolver;
+  class Matrix;
   class Mesh;
 
   /// This class implements harmonic mesh smoothing. Poisson's equation
   /// is solved with zero right-hand side (Laplace's equation) for each
   /// coordinate direction to compute new coordinates for all vertices,
   /// given new locations for the coordinates of the boundary.
+  ///
+  /// An object of this class may be kept between repeated moves of
+  /// a mesh (for instance in each time step of an ALE method). The
+  /// Laplace operator is then assembled only on the first move, and
+  /// the preconditioner of the linear solver is reused for all
+  /// coordinate directions and all subsequent moves, with the
+  /// previous displacement as initial guess. The operator is
+  /// reassembled only if the mesh topology or the boundary vertex
+  /// map changes, so it is the operator of the mesh geometry at the
+  /// first move.
 
   class HarmonicSmoothing
   {
   public:
 
+    /// Create harmonic smoothing of given mesh
+    HarmonicSmoothing(Mesh& mesh);
+
+    /// Destructor
+    ~HarmonicSmoothing();
+
+    /// Move coordinates of mesh according to new boundary coordinates
+    /// and return the displacement
+    std::shared_ptr<MeshDisplacement> smooth(const BoundaryMesh& new_boundary);
+
     /// Move coordinates of mesh according to new boundary coordinates
     /// and return the displacement
-    static std::shared_ptr<MeshDisplacement> move(Mesh& mesh, 
+    static std::shared_ptr<MeshDisplacement> move(Mesh& mesh,
                                         const BoundaryMesh& new_boundary);
 
+  private:
+
+    // Assemble operator and initialize solver for given map from
+    // boundary vertices to mesh vertices
+    void init(const std::vector<std::size_t>& vertex_map);
+
+    // The mesh
+    Mesh* _mesh;
+
+    // Scalar piecewise linear function space
+    std::shared_ptr<FunctionSpace> _V;
+
+    // Laplace operator with identity rows for boundary dofs
+    std::shared_ptr<Matrix> _A;
+
+    // Linear solver (with operator set)
+    std::shared_ptr<KrylovSolver> _solver;
+
+    // Topology version and boundary vertex map of operator
+    std::size_t _topology_version;
+    std::vector<std::size_t> _vertex_map;
+
+    // Global dofs of boundary vertices (owned only) and the
+    // corresponding boundary vertex indices
+    std::vector<dolfin::la_index> _boundary_dofs;
+    std::vector<std::size_t> _boundary_vertices;
+
+    // Global dofs of all vertices (including ghosts)
+    std::vector<dolfin::la_index> _vertex_dofs;
+
+    // Displacement of previous move for each coordinate direction
+    std::vector<std::shared_ptr<GenericVector> > _x;
+
   };
 
 }
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-03-05
-// Last changed: 2013-03-05
+// Last changed: 2014-03-27
 
 #include <dolfin/function/FunctionSpace.h>
 #include <dolfin/mesh/Mesh.h>
@@ -56,6 +56,14 @@ MeshDisplacement::MeshDisplacement(const Mesh& mesh)
   _displacements = std::vector<Function> (_dim, Function(V));
 }
 //-----------------------------------------------------------------------------
+MeshDisplacement::MeshDisplacement(std::shared_ptr<const FunctionSpace> V)
+  : Expression(V->mesh()->geometry().dim()),
+    _dim(V->mesh()->geometry().dim())
+{
+  // Store displacement functions
+  _displacements = std::vector<Function> (_dim, Function(V));
+}
+//-----------------------------------------------------------------------------
 MeshDisplacement::MeshDisplacement(const MeshDisplacement& mesh_displacement)
   : Expression(mesh_displacement._dim),
     _dim(mesh_displacement._dim),
@@ -16,11 +16,12 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-03-05
-// Last changed: 2013-03-05
+// Last changed: 2014-03-27
 
 #ifndef __MESH_DISPLACEMENT_H
 #define __MESH_DISPLACEMENT_H
 
+#include <memory>
 #include <vector>
 #include <ufc.h>
 #include <dolfin/common/Array.h>
@@ -29,6 +30,7 @@
 
 namespace dolfin
 {
+  class FunctionSpace;
   class Mesh;
 
   /// This class encapsulates the CG1 representation of the
@@ -49,6 +51,14 @@ namespace dolfin
     ///         Mesh to be displacement defined on.
     MeshDisplacement(const Mesh& mesh);
 
+    /// Create MeshDisplacement with components in given function
+    /// space
+    ///
+    /// *Arguments*
+    ///     V (_FunctionSpace_)
+    ///         Scalar piecewise linear function space on the mesh.
+    MeshDisplacement(std::shared_ptr<const FunctionSpace> V);
+
     /// Copy constructor
     ///
     /// *Arguments*
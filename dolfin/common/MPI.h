@@ -164,6 +164,10 @@ namespace dolfin
     /// Sum values and return sum
     template<typename T> static T sum(const MPI_Comm comm, const T& value);
 
+    /// Sum arrays of values (entry by entry) and return sums
+    template<typename T> static std::vector<T>
+      sum(const MPI_Comm comm, const std::vector<T>& values);
+
     /// All reduce
     template<typename T, typename X> static
       T all_reduce(const MPI_Comm comm, const T& value, X op);
@@ -638,6 +642,22 @@ namespace dolfin
     #endif
   }
   //---------------------------------------------------------------------------
+  template<typename T> std::vector<T>
+    dolfin::MPI::sum(const MPI_Comm comm, const std::vector<T>& values)
+  {
+    #ifdef HAS_MPI
+    std::vector<T> out(values.size());
+    if (!values.empty())
+    {
+      MPI_Allreduce(const_cast<T*>(values.data()), out.data(), values.size(),
+                    mpi_type<T>(), MPI_SUM, comm);
+    }
+    return out;
+    #else
+    return values;
+    #endif
+  }
+  //---------------------------------------------------------------------------
   template<typename T>
     void dolfin::MPI::send_recv(const MPI_Comm comm,
                                 const std::vector<T>& send_value,
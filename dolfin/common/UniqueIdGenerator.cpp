@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2010-12-05
-// Last changed:
+// Last changed: 2014-03-27
 
 #include "UniqueIdGenerator.h"
 
@@ -33,11 +33,15 @@ UniqueIdGenerator::UniqueIdGenerator() : next_id(0)
 //-----------------------------------------------------------------------------
 std::size_t UniqueIdGenerator::id()
 {
-  // Get ID
-  const std::size_t _id = unique_id_generator.next_id;
-
-  // Increment ID
-  ++unique_id_generator.next_id;
+  // Get and increment ID (IDs may be requested from several threads)
+  std::size_t _id;
+  #ifdef HAS_OPENMP
+  #pragma omp critical (unique_id_generator)
+  #endif
+  {
+    _id = unique_id_generator.next_id;
+    ++unique_id_generator.next_id;
+  }
 
   return _id;
 }
@@ -37,7 +37,7 @@ namespace dolfin
 
     UniqueIdGenerator();
 
-    /// Generate a unique ID
+    /// Generate a unique ID (thread-safe)
     static std::size_t id();
 
   private:
@@ -22,7 +22,7 @@
 // Modified by Martin Alnaes 2013
 //
 // First added:  2007-01-17
-// Last changed: 2013-09-19
+// Last changed: 2014-03-24
 
 #include <boost/scoped_ptr.hpp>
 
@@ -32,8 +32,10 @@
 #include <dolfin/la/GenericTensor.h>
 #include <dolfin/mesh/Mesh.h>
 #include <dolfin/mesh/Cell.h>
+#include <dolfin/mesh/DistributedMeshTools.h>
 #include <dolfin/mesh/Facet.h>
 #include <dolfin/mesh/MeshData.h>
+#include <dolfin/mesh/MeshEntityRange.h>
 #include <dolfin/mesh/MeshFunction.h>
 #include <dolfin/mesh/SubDomain.h>
 #include <dolfin/function/GenericFunction.h>
@@ -41,6 +43,7 @@
 #include "GenericDofMap.h"
 #include "Form.h"
 #include "UFC.h"
+#include "AssemblyCache.h"
 #include "FiniteElement.h"
 #include "OpenMpAssembler.h"
 #include "AssemblerBase.h"
@@ -57,6 +60,9 @@ void Assembler::assemble(GenericTensor& A, const Form& a)
   // in turn calls the assembler functions below to assemble over
   // cells, exterior and interior facets.
 
+  // Clear profile from previous assembly
+  profile.reset(parameters["profile_assembly"]);
+
   // Check whether we should call the multi-core assembler
   #ifdef HAS_OPENMP
   const std::size_t num_threads = parameters["num_threads"];
@@ -68,6 +74,7 @@ void Assembler::assemble(GenericTensor& A, const Form& a)
     assembler.finalize_tensor = finalize_tensor;
     assembler.keep_diagonal = keep_diagonal;
     assembler.assemble(A, a);
+    profile = assembler.profile;
     return;
   }
   #endif
@@ -98,6 +105,15 @@ void Assembler::assemble(GenericTensor& A, const Form& a)
   // Initialize global tensor
   init_global_tensor(A, a);
 
+  // Add directly to matrix values if positions have been cached
+  _cache_values = 0;
+  if (cache_insertion_positions && A.rank() == 2)
+  {
+    GenericMatrix& _A = A.down_cast<GenericMatrix>();
+    if (_cache && _cache->valid(a, _A))
+      _cache_values = _A.value_data();
+  }
+
   // Assemble over cells
   assemble_cells(A, a, ufc, cell_domains, 0);
 
@@ -110,6 +126,19 @@ void Assembler::assemble(GenericTensor& A, const Form& a)
   // Finalize assembly of global tensor
   if (finalize_tensor)
     A.apply("add");
+
+  // Record insertion positions for next assembly
+  if (cache_insertion_positions && A.rank() == 2 && !_cache_values
+      && finalize_tensor)
+  {
+    if (!_cache)
+      _cache.reset(new AssemblyCache);
+    _cache->init(a, A.down_cast<GenericMatrix>());
+  }
+  _cache_values = 0;
+
+  // Report time spent in each phase of local assembly
+  profile.register_timings();
 }
 //-----------------------------------------------------------------------------
 void Assembler::assemble_cells(GenericTensor& A,
@@ -122,6 +151,14 @@ void Assembler::assemble_cells(GenericTensor& A,
   if (!ufc.form.has_cell_integrals())
     return;
 
+  // Assemble blocks of cells if requested
+  const std::size_t block_size = parameters["assembly_block_size"];
+  if (block_size > 1)
+  {
+    assemble_cell_blocks(A, a, ufc, domains, values, block_size);
+    return;
+  }
+
   // Set timer
   Timer timer("Assemble cells");
 
@@ -137,7 +174,7 @@ void Assembler::assemble_cells(GenericTensor& A,
     dofmaps.push_back(a.function_space(i)->dofmap().get());
 
   // Vector to hold dof map for a cell
-  std::vector<const std::vector<dolfin::la_index>* > dofs(form_rank);
+  std::vector<ArrayView<const dolfin::la_index> > dofs(form_rank);
 
   // Cell integral
   ufc::cell_integral* integral = ufc.default_cell_integral.get();
@@ -161,16 +198,18 @@ void Assembler::assemble_cells(GenericTensor& A,
       continue;
 
     // Update to current cell
+    profile.start();
     cell->get_cell_data(ufc_cell);
     cell->get_vertex_coordinates(vertex_coordinates);
     ufc.update(*cell, vertex_coordinates, ufc_cell);
+    profile.stop(AssemblyProfile::update);
 
     // Get local-to-global dof maps for cell
     bool empty_dofmap = false;
     for (std::size_t i = 0; i < form_rank; ++i)
     {
-      dofs[i] = &(dofmaps[i]->cell_dofs(cell->index()));
-      empty_dofmap = empty_dofmap || dofs[i]->size() == 0;
+      dofs[i] = dofmaps[i]->cell_dofs(cell->index());
+      empty_dofmap = empty_dofmap || dofs[i].size() == 0;
     }
 
     // Skip if at least one dofmap is empty
@@ -181,18 +220,171 @@ void Assembler::assemble_cells(GenericTensor& A,
     integral->tabulate_tensor(ufc.A.data(), ufc.w(),
                               vertex_coordinates.data(),
                               ufc_cell.orientation);
+    profile.stop(AssemblyProfile::tabulate);
 
     // Add entries to global tensor. Either store values cell-by-cell
     // (currently only available for functionals)
     if (values && ufc.form.rank() == 0)
       (*values)[cell->index()] = ufc.A[0];
+    else if (_cache_values)
+      _cache->add_cell(_cache_values, cell->index(), ufc.A.data());
     else
       add_to_global_tensor(A, ufc.A, dofs);
+    profile.stop(AssemblyProfile::insert);
+    profile.count(AssemblyProfile::cell);
+    profile.inserted(dofs);
 
     p++;
   }
 }
 //-----------------------------------------------------------------------------
+void Assembler::assemble_cell_blocks(GenericTensor& A,
+                                     const Form& a,
+                                     UFC& ufc,
+                                     const MeshFunction<std::size_t>* domains,
+                                     std::vector<double>* values,
+                                     std::size_t block_size)
+{
+  // Skip assembly if there are no cell integrals
+  if (!ufc.form.has_cell_integrals())
+    return;
+
+  dolfin_assert(block_size > 0);
+
+  // Set timer
+  Timer timer("Assemble cells");
+
+  // Extract mesh
+  const Mesh& mesh = a.mesh();
+  const std::size_t num_cells = mesh.num_cells();
+
+  // Form rank
+  const std::size_t form_rank = ufc.form.rank();
+
+  // Collect pointers to dof maps
+  std::vector<const GenericDofMap*> dofmaps;
+  for (std::size_t i = 0; i < form_rank; ++i)
+    dofmaps.push_back(a.function_space(i)->dofmap().get());
+
+  // Check whether integral is domain-dependent
+  bool use_domains = domains && !domains->empty();
+
+  // Size of vertex coordinate array and cell tensor for one cell
+  const std::size_t tdim = mesh.topology().dim();
+  const std::size_t coordinate_size
+    = mesh.type().num_vertices(tdim)*mesh.geometry().dim();
+  const std::size_t tensor_size = ufc.A.size();
+
+  // Direct access to cell vertex coordinates
+  const MeshEntityRange cells(mesh, tdim);
+
+  // Data for a block of cells, stored cell after cell
+  std::vector<std::size_t> block_cells;
+  block_cells.reserve(block_size);
+  std::vector<ufc::cell> block_ufc_cells(block_size);
+  std::vector<double> block_vertex_coordinates(block_size*coordinate_size);
+  std::vector<double> block_A(block_size*tensor_size);
+  std::vector<std::vector<ArrayView<const dolfin::la_index> > >
+    block_dofs(block_size,
+               std::vector<ArrayView<const dolfin::la_index> >(form_rank));
+
+  // Assemble over blocks of cells
+  Progress p(AssemblerBase::progress_message(A.rank(), "cells"), num_cells);
+  std::size_t cell_index = 0;
+  while (cell_index < num_cells)
+  {
+    // Gather data for next block of cells. A block is closed when
+    // it is full or when the next cell uses a different integral.
+    ufc::cell_integral* integral = 0;
+    block_cells.clear();
+    for (; cell_index < num_cells && block_cells.size() < block_size;
+         ++cell_index)
+    {
+      // Get integral for sub domain (if any)
+      ufc::cell_integral* cell_integral = ufc.default_cell_integral.get();
+      if (use_domains)
+        cell_integral = ufc.get_cell_integral((*domains)[cell_index]);
+
+      // Skip if no integral on current domain
+      if (!cell_integral)
+        continue;
+
+      // Get local-to-global dof maps for cell
+      const std::size_t k = block_cells.size();
+      bool empty_dofmap = false;
+      for (std::size_t i = 0; i < form_rank; ++i)
+      {
+        block_dofs[k][i] = dofmaps[i]->cell_dofs(cell_index);
+        empty_dofmap = empty_dofmap || block_dofs[k][i].size() == 0;
+      }
+
+      // Skip if at least one dofmap is empty
+      if (empty_dofmap)
+        continue;
+
+      // Leave cell for next block if integral differs
+      if (integral && cell_integral != integral)
+        break;
+      integral = cell_integral;
+
+      // Get cell data and vertex coordinates
+      cells.get_cell_data(cell_index, block_ufc_cells[k]);
+      cells.get_vertex_coordinates(cell_index,
+                                   &block_vertex_coordinates[k*coordinate_size]);
+      block_cells.push_back(cell_index);
+    }
+
+    // Skip if block is empty
+    const std::size_t num_block_cells = block_cells.size();
+    if (num_block_cells == 0)
+      continue;
+    dolfin_assert(integral);
+
+    // Update coefficients for all cells in block
+    profile.start();
+    ufc.update(mesh, block_cells, block_vertex_coordinates, block_ufc_cells);
+    profile.stop(AssemblyProfile::update);
+
+    // Tabulate cell tensors
+    for (std::size_t k = 0; k < num_block_cells; ++k)
+    {
+      integral->tabulate_tensor(&block_A[k*tensor_size], ufc.block_w(k),
+                                &block_vertex_coordinates[k*coordinate_size],
+                                block_ufc_cells[k].orientation);
+    }
+    profile.stop(AssemblyProfile::tabulate);
+
+    // Add entries to global tensor. Either store values cell-by-cell
+    // (currently only available for functionals)
+    if (values && form_rank == 0)
+    {
+      for (std::size_t k = 0; k < num_block_cells; ++k)
+        (*values)[block_cells[k]] = block_A[k*tensor_size];
+    }
+    else if (_cache_values)
+    {
+      for (std::size_t k = 0; k < num_block_cells; ++k)
+      {
+        _cache->add_cell(_cache_values, block_cells[k],
+                         &block_A[k*tensor_size]);
+      }
+    }
+    else
+    {
+      for (std::size_t k = 0; k < num_block_cells; ++k)
+        A.add(&block_A[k*tensor_size], block_dofs[k]);
+    }
+    profile.stop(AssemblyProfile::insert);
+
+    for (std::size_t k = 0; k < num_block_cells; ++k)
+    {
+      profile.count(AssemblyProfile::cell);
+      profile.inserted(block_dofs[k]);
+      p++;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void Assembler::assemble_exterior_facets(GenericTensor& A,
                                          const Form& a,
                                          UFC& ufc,
@@ -218,7 +410,7 @@ void Assembler::assemble_exterior_facets(GenericTensor& A,
     dofmaps.push_back(a.function_space(i)->dofmap().get());
 
   // Vector to hold dof map for a cell
-  std::vector<const std::vector<dolfin::la_index>* > dofs(form_rank);
+  std::vector<ArrayView<const dolfin::la_index> > dofs(form_rank);
 
   // Exterior facet integral
   const ufc::exterior_facet_integral* integral
@@ -263,24 +455,33 @@ void Assembler::assemble_exterior_facets(GenericTensor& A,
     const std::size_t local_facet = mesh_cell.index(*facet);
 
     // Update UFC cell
+    profile.start();
     mesh_cell.get_cell_data(ufc_cell, local_facet);
     mesh_cell.get_vertex_coordinates(vertex_coordinates);
 
     // Update UFC object
     ufc.update(mesh_cell, vertex_coordinates, ufc_cell);
+    profile.stop(AssemblyProfile::update);
 
     // Get local-to-global dof maps for cell
     for (std::size_t i = 0; i < form_rank; ++i)
-      dofs[i] = &(dofmaps[i]->cell_dofs(mesh_cell.index()));
+      dofs[i] = dofmaps[i]->cell_dofs(mesh_cell.index());
 
     // Tabulate exterior facet tensor
     integral->tabulate_tensor(ufc.A.data(),
                               ufc.w(),
                               vertex_coordinates.data(),
                               local_facet);
+    profile.stop(AssemblyProfile::tabulate);
 
     // Add entries to global tensor
-    add_to_global_tensor(A, ufc.A, dofs);
+    if (_cache_values)
+      _cache->add_cell(_cache_values, mesh_cell.index(), ufc.A.data());
+    else
+      add_to_global_tensor(A, ufc.A, dofs);
+    profile.stop(AssemblyProfile::insert);
+    profile.count(AssemblyProfile::exterior_facet);
+    profile.inserted(dofs);
 
     p++;
   }
@@ -295,8 +496,6 @@ void Assembler::assemble_interior_facets(GenericTensor& A, const Form& a,
   if (!ufc.form.has_interior_facet_integrals())
     return;
 
-  not_working_in_parallel("Assembly over interior facets");
-
   // Set timer
   Timer timer("Assemble interior facets");
 
@@ -311,13 +510,9 @@ void Assembler::assemble_interior_facets(GenericTensor& A, const Form& a,
   for (std::size_t i = 0; i < form_rank; ++i)
     dofmaps.push_back(a.function_space(i)->dofmap().get());
 
-  // Vector to hold dofs for cells, and a vector holding pointers to same
+  // Vector to hold dofs for cells, and a vector holding views of same
   std::vector<std::vector<dolfin::la_index> > macro_dofs(form_rank);
-  std::vector<const std::vector<dolfin::la_index>* > macro_dof_ptrs(form_rank);
-  for (std::size_t i = 0; i < form_rank; i++)
-  {
-    macro_dof_ptrs[i] = &macro_dofs[i];
-  }
+  std::vector<ArrayView<const dolfin::la_index> > macro_dof_ptrs(form_rank);
 
   // Interior facet integral
   const ufc::interior_facet_integral* integral
@@ -351,8 +546,9 @@ void Assembler::assemble_interior_facets(GenericTensor& A, const Form& a,
              mesh.num_facets());
   for (FacetIterator facet(mesh); !facet.end(); ++facet)
   {
-    // Only consider interior facets
-    if (facet->exterior())
+    // Only consider interior facets with both cells on this process
+    // (facets on process boundaries are handled below)
+    if (facet->num_entities(D) != 2)
     {
       p++;
       continue;
@@ -377,6 +573,7 @@ void Assembler::assemble_interior_facets(GenericTensor& A, const Form& a,
     std::size_t local_facet1 = cell1.index(*facet);
 
     // Update to current pair of cells
+    profile.start();
     cell0.get_cell_data(ufc_cell[0], local_facet0);
     cell0.get_vertex_coordinates(vertex_coordinates[0]);
     cell1.get_cell_data(ufc_cell[1], local_facet1);
@@ -384,14 +581,15 @@ void Assembler::assemble_interior_facets(GenericTensor& A, const Form& a,
 
     ufc.update(cell0, vertex_coordinates[0], ufc_cell[0],
                cell1, vertex_coordinates[1], ufc_cell[1]);
+    profile.stop(AssemblyProfile::update);
 
     // Tabulate dofs for each dimension on macro element
     for (std::size_t i = 0; i < form_rank; i++)
     {
       // Get dofs for each cell
-      const std::vector<dolfin::la_index>& cell_dofs0
+      const ArrayView<const dolfin::la_index> cell_dofs0
         = dofmaps[i]->cell_dofs(cell0.index());
-      const std::vector<dolfin::la_index>& cell_dofs1
+      const ArrayView<const dolfin::la_index> cell_dofs1
         = dofmaps[i]->cell_dofs(cell1.index());
 
       // Create space in macro dof vector
@@ -402,6 +600,9 @@ void Assembler::assemble_interior_facets(GenericTensor& A, const Form& a,
                 macro_dofs[i].begin());
       std::copy(cell_dofs1.begin(), cell_dofs1.end(),
                 macro_dofs[i].begin() + cell_dofs0.size());
+
+      // Update view (storage may have been reallocated)
+      macro_dof_ptrs[i].set(macro_dofs[i]);
     }
 
     // Tabulate interior facet tensor on macro element
@@ -411,17 +612,255 @@ void Assembler::assemble_interior_facets(GenericTensor& A, const Form& a,
                               vertex_coordinates[1].data(),
                               local_facet0,
                               local_facet1);
+    profile.stop(AssemblyProfile::tabulate);
 
     // Add entries to global tensor
-    add_to_global_tensor(A, ufc.macro_A, macro_dof_ptrs);
+    if (_cache_values)
+    {
+      _cache->add_interior_facet(_cache_values, facet->index(),
+                                 ufc.macro_A.data());
+    }
+    else
+      add_to_global_tensor(A, ufc.macro_A, macro_dof_ptrs);
+    profile.stop(AssemblyProfile::insert);
+    profile.count(AssemblyProfile::interior_facet);
+    profile.inserted(macro_dof_ptrs);
 
     p++;
   }
+
+  // Assemble over interior facets on process boundaries
+  if (MPI::size(mesh.mpi_comm()) > 1)
+    assemble_shared_interior_facets(A, a, ufc, domains);
+}
+//-----------------------------------------------------------------------------
+void Assembler::assemble_shared_interior_facets(GenericTensor& A,
+                                                const Form& a,
+                                                UFC& ufc,
+                                      const MeshFunction<std::size_t>* domains)
+{
+  // Each interior facet on a process boundary is assembled by the
+  // process with the lower rank. The process with the higher rank
+  // sends the vertex coordinates, coefficients and dofs of its cell
+  // to the process that assembles the facet.
+
+  // Extract mesh
+  const Mesh& mesh = a.mesh();
+  const std::size_t D = mesh.topology().dim();
+
+  // MPI data
+  const MPI_Comm mpi_comm = mesh.mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+  const std::size_t process_number = MPI::rank(mpi_comm);
+
+  // Facet orientation refers to local cells only
+  if (mesh.data().exists("facet_orientation", D - 1))
+  {
+    dolfin_error("Assembler.cpp",
+                 "assemble form over interior facets",
+                 "User-defined facet orientation is not supported for facets on process boundaries");
+  }
+
+  // Form rank
+  const std::size_t form_rank = ufc.form.rank();
+
+  // Collect pointers to dof maps
+  std::vector<const GenericDofMap*> dofmaps;
+  for (std::size_t i = 0; i < form_rank; ++i)
+    dofmaps.push_back(a.function_space(i)->dofmap().get());
+
+  // Interior facet integral
+  const ufc::interior_facet_integral* integral
+    = ufc.default_interior_facet_integral.get();
+
+  // Check whether integral is domain-dependent
+  bool use_domains = domains && !domains->empty();
+
+  // Get shared facets, with sharing process and local index of facet
+  // on sharing process
+  const boost::unordered_map<unsigned int,
+                             std::vector<std::pair<unsigned int,
+                                                   unsigned int> > >
+    shared_facets = DistributedMeshTools::compute_shared_entities(mesh, D - 1);
+
+  // Number of vertex coordinates and coefficient values per cell
+  const std::size_t num_coordinates
+    = mesh.type().num_vertices(D)*mesh.geometry().dim();
+  std::vector<double> w;
+  ufc.get_coefficients(w);
+  const std::size_t num_coefficients = w.size();
+
+  // Pack data for facets that are assembled by the other process:
+  // indices (local facet index on receiving process, global cell
+  // index, local facet index in cell and, for each dofmap, number of
+  // dofs followed by the dofs) and values (vertex coordinates
+  // followed by coefficients)
+  std::vector<std::vector<std::size_t> > send_indices(num_processes);
+  std::vector<std::vector<double> > send_values(num_processes);
+  ufc::cell ufc_cell[2];
+  std::vector<double> vertex_coordinates[2];
+  boost::unordered_map<unsigned int,
+                       std::vector<std::pair<unsigned int,
+                                             unsigned int> > >::const_iterator
+    shared_facet;
+  for (shared_facet = shared_facets.begin();
+       shared_facet != shared_facets.end(); ++shared_facet)
+  {
+    // Skip facets that are not interior facets on a process boundary
+    const Facet facet(mesh, shared_facet->first);
+    if (shared_facet->second.size() != 1 || facet.num_entities(D) != 1
+        || facet.num_global_entities(D) != 2)
+    {
+      continue;
+    }
+
+    // Skip facets assembled by this process
+    const std::size_t dest = shared_facet->second[0].first;
+    if (dest > process_number)
+      continue;
+
+    // Get cell
+    const Cell cell(mesh, facet.entities(D)[0]);
+    const std::size_t local_facet = cell.index(facet);
+
+    // Restrict coefficients to cell
+    cell.get_cell_data(ufc_cell[0], local_facet);
+    cell.get_vertex_coordinates(vertex_coordinates[0]);
+    ufc.update(cell, vertex_coordinates[0], ufc_cell[0]);
+    ufc.get_coefficients(w);
+
+    // Pack indices
+    std::vector<std::size_t>& indices = send_indices[dest];
+    indices.push_back(shared_facet->second[0].second);
+    indices.push_back(cell.global_index());
+    indices.push_back(local_facet);
+    for (std::size_t i = 0; i < form_rank; ++i)
+    {
+      const ArrayView<const dolfin::la_index> dofs
+        = dofmaps[i]->cell_dofs(cell.index());
+      indices.push_back(dofs.size());
+      indices.insert(indices.end(), dofs.begin(), dofs.end());
+    }
+
+    // Pack values
+    send_values[dest].insert(send_values[dest].end(),
+                             vertex_coordinates[0].begin(),
+                             vertex_coordinates[0].end());
+    send_values[dest].insert(send_values[dest].end(), w.begin(), w.end());
+  }
+
+  // Send data to processes that assemble the facets
+  std::vector<std::vector<std::size_t> > recv_indices;
+  std::vector<std::vector<double> > recv_values;
+  MPI::all_to_all(mpi_comm, send_indices, recv_indices);
+  MPI::all_to_all(mpi_comm, send_values, recv_values);
+
+  // Vector to hold dofs for cells, and a vector holding views of same
+  std::vector<std::vector<dolfin::la_index> > remote_dofs(form_rank);
+  std::vector<std::vector<dolfin::la_index> > macro_dofs(form_rank);
+  std::vector<ArrayView<const dolfin::la_index> > macro_dof_ptrs(form_rank);
+  std::vector<double> remote_w;
+
+  // Assemble over received facets
+  for (std::size_t proc = 0; proc < num_processes; ++proc)
+  {
+    const std::vector<std::size_t>& indices = recv_indices[proc];
+    const std::vector<double>& values = recv_values[proc];
+    std::size_t index_pos = 0;
+    std::size_t value_pos = 0;
+    while (index_pos < indices.size())
+    {
+      // Unpack indices
+      const Facet facet(mesh, indices[index_pos++]);
+      const std::size_t remote_cell_index = indices[index_pos++];
+      const std::size_t remote_local_facet = indices[index_pos++];
+      for (std::size_t i = 0; i < form_rank; ++i)
+      {
+        const std::size_t num_dofs = indices[index_pos++];
+        remote_dofs[i].assign(indices.begin() + index_pos,
+                              indices.begin() + index_pos + num_dofs);
+        index_pos += num_dofs;
+      }
+
+      // Unpack values
+      dolfin_assert(value_pos + num_coordinates + num_coefficients
+                    <= values.size());
+      vertex_coordinates[1].assign(values.begin() + value_pos,
+                                   values.begin() + value_pos
+                                   + num_coordinates);
+      value_pos += num_coordinates;
+      remote_w.assign(values.begin() + value_pos,
+                      values.begin() + value_pos + num_coefficients);
+      value_pos += num_coefficients;
+
+      // Get integral for sub domain (if any)
+      if (use_domains)
+        integral = ufc.get_interior_facet_integral((*domains)[facet]);
+
+      // Skip integral if zero
+      if (!integral)
+        continue;
+
+      // Get local cell and restrict coefficients
+      profile.start();
+      dolfin_assert(facet.num_entities(D) == 1);
+      const Cell cell(mesh, facet.entities(D)[0]);
+      const std::size_t local_facet = cell.index(facet);
+      cell.get_cell_data(ufc_cell[0], local_facet);
+      cell.get_vertex_coordinates(vertex_coordinates[0]);
+      ufc.update(cell, vertex_coordinates[0], ufc_cell[0]);
+      ufc.get_coefficients(w);
+
+      // Order cells by global index, so that the restrictions do not
+      // depend on the partitioning
+      const bool local_first = cell.global_index() < remote_cell_index;
+      const std::size_t c0 = local_first ? 0 : 1;
+      const std::size_t c1 = local_first ? 1 : 0;
+      const std::size_t local_facets[2]
+        = {local_facet, remote_local_facet};
+      const double* cell_w[2] = {w.data(), remote_w.data()};
+
+      // Set coefficients on macro element
+      ufc.set_macro_coefficients(cell_w[c0], cell_w[c1]);
+      profile.stop(AssemblyProfile::update);
+
+      // Tabulate dofs for each dimension on macro element
+      for (std::size_t i = 0; i < form_rank; i++)
+      {
+        const ArrayView<const dolfin::la_index> local_dofs
+          = dofmaps[i]->cell_dofs(cell.index());
+        const ArrayView<const dolfin::la_index> cell_dofs[2]
+          = {local_dofs, ArrayView<const dolfin::la_index>(remote_dofs[i])};
+
+        macro_dofs[i].resize(local_dofs.size() + remote_dofs[i].size());
+        std::copy(cell_dofs[c0].begin(), cell_dofs[c0].end(),
+                  macro_dofs[i].begin());
+        std::copy(cell_dofs[c1].begin(), cell_dofs[c1].end(),
+                  macro_dofs[i].begin() + cell_dofs[c0].size());
+        macro_dof_ptrs[i].set(macro_dofs[i]);
+      }
+
+      // Tabulate interior facet tensor on macro element
+      integral->tabulate_tensor(ufc.macro_A.data(),
+                                ufc.macro_w(),
+                                vertex_coordinates[c0].data(),
+                                vertex_coordinates[c1].data(),
+                                local_facets[c0],
+                                local_facets[c1]);
+      profile.stop(AssemblyProfile::tabulate);
+
+      // Add entries to global tensor
+      add_to_global_tensor(A, ufc.macro_A, macro_dof_ptrs);
+      profile.stop(AssemblyProfile::insert);
+      profile.count(AssemblyProfile::interior_facet);
+      profile.inserted(macro_dof_ptrs);
+    }
+  }
 }
 //-----------------------------------------------------------------------------
 void Assembler::add_to_global_tensor(GenericTensor& A,
                                      std::vector<double>& cell_tensor,
-                                     std::vector<const std::vector<dolfin::la_index>* >& dofs)
+                                     std::vector<ArrayView<const dolfin::la_index> >& dofs)
 {
   A.add(&cell_tensor[0], dofs);
 }
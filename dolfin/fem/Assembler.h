@@ -20,18 +20,22 @@
 // Modified by Joachim B Haga 2012
 //
 // First added:  2007-01-17
-// Last changed: 2013-09-19
+// Last changed: 2014-03-18
 
 #ifndef __ASSEMBLER_H
 #define __ASSEMBLER_H
 
+#include <memory>
 #include <vector>
+#include <dolfin/common/ArrayView.h>
+#include <dolfin/common/types.h>
 #include "AssemblerBase.h"
 
 namespace dolfin
 {
 
   // Forward declarations
+  class AssemblyCache;
   class GenericTensor;
   class Form;
   class UFC;
@@ -56,7 +60,18 @@ namespace dolfin
   public:
 
     /// Constructor
-    Assembler() {}
+    Assembler() : cache_insertion_positions(false), _cache_values(0) {}
+
+    /// cache_insertion_positions (bool)
+    ///     Record the position of each cell tensor entry in the
+    ///     compressed storage of the matrix after the first assembly
+    ///     of a bilinear form, and add cell tensors directly to the
+    ///     matrix values when the same form is assembled again into
+    ///     the same matrix (with reset_sparsity false). Requires a
+    ///     linear algebra backend that provides access to its
+    ///     compressed storage (currently uBLAS) and is ignored
+    ///     otherwise. Default value is false.
+    bool cache_insertion_positions;
 
     /// Assemble tensor from given form
     ///
@@ -73,6 +88,17 @@ namespace dolfin
                         const MeshFunction<std::size_t>* domains,
                         std::vector<double>* values);
 
+    /// Assemble tensor from given form over cells, gathering the
+    /// data for blocks of cells in contiguous arrays and tabulating
+    /// the cell tensors of each block back to back before inserting
+    /// them in the global tensor. This function is called by
+    /// assemble_cells when the global parameter
+    /// "assembly_block_size" is larger than one.
+    void assemble_cell_blocks(GenericTensor& A, const Form& a, UFC& ufc,
+                              const MeshFunction<std::size_t>* domains,
+                              std::vector<double>* values,
+                              std::size_t block_size);
+
     /// Assemble tensor from given form over exterior facets. This
     /// function is provided for users who wish to build a customized
     /// assembler.
@@ -95,7 +121,22 @@ namespace dolfin
     /// to split the cell tensor into symmetric/antisymmetric parts.
     void add_to_global_tensor(GenericTensor& A,
                               std::vector<double>& cell_tensor,
-                              std::vector<const std::vector<dolfin::la_index>* >& dofs);
+                              std::vector<ArrayView<const dolfin::la_index> >& dofs);
+
+  private:
+
+    // Cache of insertion positions
+    std::shared_ptr<AssemblyCache> _cache;
+
+    // Values of matrix being assembled using the cache (NULL if the
+    // cache is not used)
+    double* _cache_values;
+
+    // Assemble over interior facets that are shared with another
+    // process (facets on process boundaries)
+    void assemble_shared_interior_facets(GenericTensor& A, const Form& a,
+                                         UFC& ufc,
+                                     const MeshFunction<std::size_t>* domains);
 
   };
 
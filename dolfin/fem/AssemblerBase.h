@@ -19,7 +19,7 @@
 // Modified by Ola Skavhaug, 2008.
 //
 // First added:  2007-01-17
-// Last changed: 2013-09-19
+// Last changed: 2014-03-21
 
 #ifndef __ASSEMBLER_BASE_H
 #define __ASSEMBLER_BASE_H
@@ -28,6 +28,7 @@
 #include <utility>
 #include <vector>
 #include <dolfin/common/types.h>
+#include "AssemblyProfile.h"
 
 namespace dolfin
 {
@@ -76,6 +77,12 @@ namespace dolfin
     ///     if the matrix is finalised.
     bool keep_diagonal;
 
+    /// profile (AssemblyProfile)
+    ///     Breakdown of the time spent in the last assembly. Only
+    ///     recorded if the global parameter "profile_assembly" is
+    ///     true.
+    AssemblyProfile profile;
+
     // Initialize global tensor
     void init_global_tensor(GenericTensor& A, const Form& a);
 
@@ -0,0 +1,224 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-18
+// Last changed: 2014-03-18
+
+#include <algorithm>
+#include <boost/tuple/tuple.hpp>
+
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/Timer.h>
+#include <dolfin/log/log.h>
+#include <dolfin/la/GenericMatrix.h>
+#include <dolfin/mesh/Cell.h>
+#include <dolfin/mesh/Facet.h>
+#include <dolfin/mesh/Mesh.h>
+#include <dolfin/mesh/MeshData.h>
+#include <dolfin/function/FunctionSpace.h>
+#include "Form.h"
+#include "GenericDofMap.h"
+#include "AssemblyCache.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+AssemblyCache::AssemblyCache() : _form(0), _mesh_id(0), _topology_version(0),
+                                 _values(0), _nnz(0)
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+AssemblyCache::~AssemblyCache()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+bool AssemblyCache::init(const Form& a, GenericMatrix& A)
+{
+  clear();
+
+  // Check that backend provides access to compressed storage (only
+  // possible with a single process)
+  const Mesh& mesh = a.mesh();
+  if (a.rank() != 2 || MPI::size(mesh.mpi_comm()) > 1 || !A.value_data())
+    return false;
+
+  Timer timer("Build assembly cache");
+
+  // Get compressed storage
+  boost::tuples::tuple<const std::size_t*, const std::size_t*,
+                       const double*, int> data = A.data();
+  const std::size_t* row_pointer = boost::tuples::get<0>(data);
+  const std::size_t* columns = boost::tuples::get<1>(data);
+
+  // Get dofmaps
+  std::shared_ptr<const GenericDofMap> dofmap0_ptr
+    = a.function_space(0)->dofmap();
+  std::shared_ptr<const GenericDofMap> dofmap1_ptr
+    = a.function_space(1)->dofmap();
+  const GenericDofMap& dofmap0 = *dofmap0_ptr;
+  const GenericDofMap& dofmap1 = *dofmap1_ptr;
+
+  std::vector<std::size_t> rows, cols;
+  bool complete = true;
+
+  // Compute positions for cell tensors (also used for exterior
+  // facets)
+  if (a.ufc_form()->has_cell_integrals()
+      || a.ufc_form()->has_exterior_facet_integrals())
+  {
+    _cell_offsets.resize(mesh.num_cells() + 1);
+    _cell_offsets[0] = 0;
+    for (std::size_t c = 0; c < mesh.num_cells() && complete; ++c)
+    {
+      const ArrayView<const dolfin::la_index> dofs0 = dofmap0.cell_dofs(c);
+      const ArrayView<const dolfin::la_index> dofs1 = dofmap1.cell_dofs(c);
+      rows.assign(dofs0.begin(), dofs0.end());
+      cols.assign(dofs1.begin(), dofs1.end());
+      complete = compute_positions(row_pointer, columns, rows, cols,
+                                   _cell_positions);
+      _cell_offsets[c + 1] = _cell_positions.size();
+    }
+  }
+
+  // Compute positions for interior facet tensors
+  if (a.ufc_form()->has_interior_facet_integrals() && complete)
+  {
+    const std::size_t D = mesh.topology().dim();
+    mesh.init(D - 1);
+    mesh.init(D - 1, D);
+
+    // Get interior facet directions (if any)
+    const std::vector<std::size_t>* facet_orientation = NULL;
+    if (mesh.data().exists("facet_orientation", D - 1))
+      facet_orientation = &(mesh.data().array("facet_orientation", D - 1));
+
+    _facet_offsets.resize(mesh.num_facets() + 1);
+    _facet_offsets[0] = 0;
+    for (FacetIterator facet(mesh); !facet.end() && complete; ++facet)
+    {
+      if (facet->num_entities(D) == 2)
+      {
+        // Get cells incident with facet (in assembly order)
+        std::pair<const Cell, const Cell>
+          cells = facet->adjacent_cells(facet_orientation);
+
+        // Get dofs on macro element
+        const ArrayView<const dolfin::la_index> rows0
+          = dofmap0.cell_dofs(cells.first.index());
+        const ArrayView<const dolfin::la_index> rows1
+          = dofmap0.cell_dofs(cells.second.index());
+        const ArrayView<const dolfin::la_index> cols0
+          = dofmap1.cell_dofs(cells.first.index());
+        const ArrayView<const dolfin::la_index> cols1
+          = dofmap1.cell_dofs(cells.second.index());
+        rows.assign(rows0.begin(), rows0.end());
+        rows.insert(rows.end(), rows1.begin(), rows1.end());
+        cols.assign(cols0.begin(), cols0.end());
+        cols.insert(cols.end(), cols1.begin(), cols1.end());
+
+        complete = compute_positions(row_pointer, columns, rows, cols,
+                                     _facet_positions);
+      }
+      _facet_offsets[facet->index() + 1] = _facet_positions.size();
+    }
+  }
+
+  // Give up if some entry is not in the nonzero structure
+  if (!complete)
+  {
+    clear();
+    return false;
+  }
+
+  // Store data identifying form and matrix
+  _form = &a;
+  _dofmaps[0] = dofmap0_ptr;
+  _dofmaps[1] = dofmap1_ptr;
+  _mesh_id = mesh.id();
+  _topology_version = mesh.topology().version();
+  _values = A.value_data();
+  _nnz = boost::tuples::get<3>(data);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool AssemblyCache::valid(const Form& a, GenericMatrix& A) const
+{
+  if (!_form || _form != &a || a.rank() != 2)
+    return false;
+
+  // Check that the form has the same dofmaps (a form may have been
+  // reallocated at the address of a deleted form, or its function
+  // spaces may have been replaced)
+  if (_dofmaps[0] != a.function_space(0)->dofmap()
+      || _dofmaps[1] != a.function_space(1)->dofmap())
+  {
+    return false;
+  }
+
+  // Check that the mesh has not been replaced or modified
+  const Mesh& mesh = a.mesh();
+  if (_mesh_id != mesh.id() || _topology_version != mesh.topology().version())
+    return false;
+
+  // Check that the storage of A has not been reallocated or changed
+  const double* values = A.value_data();
+  if (!values || values != _values)
+    return false;
+  return (std::size_t) boost::tuples::get<3>(A.data()) == _nnz;
+}
+//-----------------------------------------------------------------------------
+void AssemblyCache::clear()
+{
+  _cell_positions.clear();
+  _cell_offsets.clear();
+  _facet_positions.clear();
+  _facet_offsets.clear();
+  _form = 0;
+  _dofmaps[0].reset();
+  _dofmaps[1].reset();
+  _mesh_id = 0;
+  _topology_version = 0;
+  _values = 0;
+  _nnz = 0;
+}
+//-----------------------------------------------------------------------------
+bool AssemblyCache::compute_positions(const std::size_t* row_pointer,
+                                      const std::size_t* columns,
+                                      const std::vector<std::size_t>& rows,
+                                      const std::vector<std::size_t>& cols,
+                                      std::vector<std::size_t>& positions)
+{
+  for (std::size_t i = 0; i < rows.size(); ++i)
+  {
+    // Columns of each row are sorted in compressed row storage
+    const std::size_t* row_begin = columns + row_pointer[rows[i]];
+    const std::size_t* row_end = columns + row_pointer[rows[i] + 1];
+    for (std::size_t j = 0; j < cols.size(); ++j)
+    {
+      const std::size_t* entry = std::lower_bound(row_begin, row_end,
+                                                  cols[j]);
+      if (entry == row_end || *entry != cols[j])
+        return false;
+      positions.push_back(entry - columns);
+    }
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
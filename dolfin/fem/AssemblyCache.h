@@ -0,0 +1,124 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-18
+// Last changed: 2014-03-18
+
+#ifndef __ASSEMBLY_CACHE_H
+#define __ASSEMBLY_CACHE_H
+
+#include <memory>
+#include <vector>
+
+namespace dolfin
+{
+
+  class Form;
+  class GenericDofMap;
+  class GenericMatrix;
+
+  /// This class stores the position in the compressed storage of a
+  /// sparse matrix of each entry of the cell tensors and interior
+  /// facet tensors of a bilinear form. When a form is reassembled
+  /// into a matrix with an unchanged nonzero structure, the element
+  /// tensors can then be added directly to the matrix values,
+  /// bypassing the global index lookup of GenericMatrix::add.
+  ///
+  /// The cache requires a linear algebra backend that provides
+  /// access to its compressed storage (GenericMatrix::data and
+  /// GenericMatrix::value_data).
+
+  class AssemblyCache
+  {
+  public:
+
+    /// Create empty cache
+    AssemblyCache();
+
+    /// Destructor
+    ~AssemblyCache();
+
+    /// Compute positions for given form from the nonzero structure
+    /// of A. Returns false (and leaves the cache empty) if the
+    /// backend does not provide access to the compressed storage or
+    /// if an entry is missing from the nonzero structure.
+    bool init(const Form& a, GenericMatrix& A);
+
+    /// Return true if cache holds positions for given form and A,
+    /// i.e., if the form, its dofmaps, the mesh topology and the
+    /// storage of A are the same as when the cache was computed
+    bool valid(const Form& a, GenericMatrix& A) const;
+
+    /// Clear cache
+    void clear();
+
+    /// Add cell tensor of given cell to matrix values
+    void add_cell(double* values, std::size_t cell,
+                  const double* cell_tensor) const
+    {
+      for (std::size_t i = _cell_offsets[cell];
+           i < _cell_offsets[cell + 1]; ++i)
+      {
+        values[_cell_positions[i]] += cell_tensor[i - _cell_offsets[cell]];
+      }
+    }
+
+    /// Add macro element tensor of given interior facet to matrix
+    /// values
+    void add_interior_facet(double* values, std::size_t facet,
+                            const double* facet_tensor) const
+    {
+      for (std::size_t i = _facet_offsets[facet];
+           i < _facet_offsets[facet + 1]; ++i)
+      {
+        values[_facet_positions[i]]
+          += facet_tensor[i - _facet_offsets[facet]];
+      }
+    }
+
+  private:
+
+    // Compute position of each entry of the dense block rows x cols
+    // and append to positions. Returns false if an entry is missing.
+    static bool compute_positions(const std::size_t* row_pointer,
+                                  const std::size_t* columns,
+                                  const std::vector<std::size_t>& rows,
+                                  const std::vector<std::size_t>& cols,
+                                  std::vector<std::size_t>& positions);
+
+    // Positions of cell tensor entries, cell after cell
+    std::vector<std::size_t> _cell_positions;
+    std::vector<std::size_t> _cell_offsets;
+
+    // Positions of interior facet tensor entries, facet after facet
+    std::vector<std::size_t> _facet_positions;
+    std::vector<std::size_t> _facet_offsets;
+
+    // Data identifying the form and matrix the cache was built for
+    // (the dofmaps are held to prevent reuse of their addresses)
+    const Form* _form;
+    std::shared_ptr<const GenericDofMap> _dofmaps[2];
+    std::size_t _mesh_id;
+    std::size_t _topology_version;
+    const double* _values;
+    std::size_t _nnz;
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,115 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-21
+// Last changed: 2014-03-21
+
+#include <sstream>
+#include <dolfin/log/LogManager.h>
+#include <dolfin/parameter/GlobalParameters.h>
+#include "AssemblyProfile.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+AssemblyProfile::AssemblyProfile()
+{
+  reset(false);
+}
+//-----------------------------------------------------------------------------
+AssemblyProfile::~AssemblyProfile()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+void AssemblyProfile::reset(bool enabled)
+{
+  _enabled = enabled;
+  _t = 0.0;
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    _time[i] = 0.0;
+    _count[i] = 0;
+  }
+  _bytes = 0;
+}
+//-----------------------------------------------------------------------------
+void AssemblyProfile::add(const AssemblyProfile& profile)
+{
+  for (std::size_t i = 0; i < 3; ++i)
+  {
+    _time[i] += profile._time[i];
+    _count[i] += profile._count[i];
+  }
+  _bytes += profile._bytes;
+}
+//-----------------------------------------------------------------------------
+double AssemblyProfile::elapsed(Phase phase) const
+{
+  return _time[phase];
+}
+//-----------------------------------------------------------------------------
+std::size_t AssemblyProfile::num_entities(Entity entity) const
+{
+  return _count[entity];
+}
+//-----------------------------------------------------------------------------
+std::size_t AssemblyProfile::bytes_inserted() const
+{
+  return _bytes;
+}
+//-----------------------------------------------------------------------------
+void AssemblyProfile::register_timings() const
+{
+  if (!_enabled)
+    return;
+
+  // Prefix task names in the same way as Timer does
+  const std::string prefix = parameters["timer_prefix"];
+  LogManager::logger.register_timing(prefix + "Assembly: update coefficients",
+                                     _time[update]);
+  LogManager::logger.register_timing(prefix + "Assembly: tabulate tensor",
+                                     _time[tabulate]);
+  LogManager::logger.register_timing(prefix + "Assembly: insert in global tensor",
+                                     _time[insert]);
+}
+//-----------------------------------------------------------------------------
+Table AssemblyProfile::table() const
+{
+  Table t("Assembly profile");
+  t("update coefficients", "time") = _time[update];
+  t("tabulate tensor", "time") = _time[tabulate];
+  t("insert in global tensor", "time") = _time[insert];
+  t("cells", "count") = _count[cell];
+  t("exterior facets", "count") = _count[exterior_facet];
+  t("interior facets", "count") = _count[interior_facet];
+  t("bytes inserted", "count") = _bytes;
+  return t;
+}
+//-----------------------------------------------------------------------------
+std::string AssemblyProfile::str(bool verbose) const
+{
+  if (verbose)
+    return table().str(true);
+
+  std::stringstream s;
+  s << "<AssemblyProfile of " << _count[cell] << " cells, "
+    << _count[exterior_facet] << " exterior facets and "
+    << _count[interior_facet] << " interior facets>";
+  return s.str();
+}
+//-----------------------------------------------------------------------------
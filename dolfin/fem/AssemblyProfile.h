@@ -0,0 +1,157 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-21
+// Last changed: 2014-03-21
+
+#ifndef __ASSEMBLY_PROFILE_H
+#define __ASSEMBLY_PROFILE_H
+
+#include <string>
+#include <vector>
+#include <dolfin/common/timing.h>
+#include <dolfin/common/types.h>
+#include <dolfin/log/Table.h>
+
+namespace dolfin
+{
+
+  /// This class records a breakdown of the time spent by an
+  /// assembler in the different phases of local assembly (updating
+  /// coefficients, tabulating element tensors and inserting element
+  /// tensors in the global tensor), together with the number of
+  /// entities assembled and the number of bytes passed to the global
+  /// tensor. This makes it possible to tell whether assembly is
+  /// bound by the form or by the linear algebra backend.
+  ///
+  /// Profiling is enabled by setting the global parameter
+  /// "profile_assembly" to true. The times of each phase are then
+  /// registered with the logger after each assembly and reported by
+  /// list_timings(). For multithreaded assembly, the times are
+  /// summed over all threads.
+
+  class AssemblyProfile
+  {
+  public:
+
+    /// Phases of local assembly
+    enum Phase {update, tabulate, insert};
+
+    /// Types of assembled entities
+    enum Entity {cell, exterior_facet, interior_facet};
+
+    /// Create empty (disabled) profile
+    AssemblyProfile();
+
+    /// Destructor
+    ~AssemblyProfile();
+
+    /// Clear recorded data and enable or disable profiling
+    void reset(bool enabled);
+
+    /// Return true if profiling is enabled
+    bool enabled() const
+    { return _enabled; }
+
+    /// Start clock
+    void start()
+    {
+      if (_enabled)
+        _t = dolfin::time();
+    }
+
+    /// Add time elapsed since last call to start() or stop() to the
+    /// given phase, and restart clock
+    void stop(Phase phase)
+    {
+      if (_enabled)
+      {
+        const double t = dolfin::time();
+        _time[phase] += t - _t;
+        _t = t;
+      }
+    }
+
+    /// Count assembled entity
+    void count(Entity entity)
+    {
+      if (_enabled)
+        ++_count[entity];
+    }
+
+    /// Record insertion of an element tensor with the given global
+    /// dofs (for each dimension) in the global tensor
+    template <typename T>
+    void inserted(const std::vector<T>& dofs)
+    {
+      if (_enabled)
+      {
+        std::size_t num_values = 1;
+        for (std::size_t i = 0; i < dofs.size(); ++i)
+        {
+          num_values *= dofs[i].size();
+          _bytes += dofs[i].size()*sizeof(dolfin::la_index);
+        }
+        _bytes += num_values*sizeof(double);
+      }
+    }
+
+    /// Add recorded data of other profile (used to combine profiles
+    /// of threads)
+    void add(const AssemblyProfile& profile);
+
+    /// Return total time spent in given phase
+    double elapsed(Phase phase) const;
+
+    /// Return number of assembled entities of given type
+    std::size_t num_entities(Entity entity) const;
+
+    /// Return number of bytes passed to the global tensor
+    std::size_t bytes_inserted() const;
+
+    /// Register time of each phase with the logger (see
+    /// list_timings)
+    void register_timings() const;
+
+    /// Return recorded data as a table
+    Table table() const;
+
+    /// Return informal string representation (pretty-print)
+    std::string str(bool verbose) const;
+
+  private:
+
+    // True if profiling is enabled
+    bool _enabled;
+
+    // Time of last call to start() or stop()
+    double _t;
+
+    // Accumulated time of each phase
+    double _time[3];
+
+    // Number of assembled entities of each type
+    std::size_t _count[3];
+
+    // Number of bytes passed to global tensor
+    std::size_t _bytes;
+
+  };
+
+}
+
+#endif
@@ -0,0 +1,294 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-14
+// Last changed: 2014-03-27
+
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <dolfin/log/log.h>
+#include <dolfin/mesh/Mesh.h>
+#include <dolfin/mesh/MeshConnectivity.h>
+#include <dolfin/mesh/MeshTopology.h>
+#include "AssemblyScheduler.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+AssemblyScheduler::AssemblyScheduler(const Mesh& mesh, std::size_t dim,
+                                     const std::vector<std::size_t>& entities,
+                                     std::size_t chunk_size)
+  : _entities(entities)
+{
+  dolfin_assert(chunk_size > 0);
+
+  // Cells are scheduled by their vertices. Other entities need the
+  // connectivity to the cells they touch (facet-cell connectivity
+  // for interior facets). Cell-cell connectivity is never computed.
+  const std::size_t tdim = mesh.topology().dim();
+  dolfin_assert(dim <= tdim);
+  if (dim < tdim)
+  {
+    mesh.init(dim);
+    mesh.init(dim, tdim);
+  }
+  const MeshConnectivity& cell_vertices = mesh.topology()(tdim, 0);
+  const MeshConnectivity* entity_cells
+    = dim < tdim ? &mesh.topology()(dim, tdim) : 0;
+
+  // Split entities into chunks of consecutive entities
+  const std::size_t num_entities = _entities.size();
+  const std::size_t num_chunks = (num_entities + chunk_size - 1)/chunk_size;
+  _chunk_offsets.resize(num_chunks + 1);
+  for (std::size_t i = 0; i < num_chunks; ++i)
+    _chunk_offsets[i] = i*chunk_size;
+  _chunk_offsets[num_chunks] = num_entities;
+
+  // No conflicts are possible with a single chunk
+  if (num_chunks <= 1)
+  {
+    _successor_offsets.assign(num_chunks + 1, 0);
+    _num_predecessors.assign(num_chunks, 0);
+    reset();
+    return;
+  }
+
+  // Compute vertices touched by each chunk
+  std::vector<std::size_t> chunk_vertices;
+  std::vector<std::size_t> chunk_vertex_offsets(1, 0);
+  std::vector<std::size_t> vertices;
+  for (std::size_t i = 0; i < num_chunks; ++i)
+  {
+    vertices.clear();
+    for (std::size_t j = _chunk_offsets[i]; j < _chunk_offsets[i + 1]; ++j)
+    {
+      const std::size_t entity = _entities[j];
+      if (!entity_cells)
+      {
+        const unsigned int* v = cell_vertices(entity);
+        vertices.insert(vertices.end(), v, v + cell_vertices.size(entity));
+        continue;
+      }
+      const unsigned int* cells = (*entity_cells)(entity);
+      for (std::size_t c = 0; c < entity_cells->size(entity); ++c)
+      {
+        const unsigned int* v = cell_vertices(cells[c]);
+        vertices.insert(vertices.end(), v, v + cell_vertices.size(cells[c]));
+      }
+    }
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                   vertices.end());
+    chunk_vertices.insert(chunk_vertices.end(), vertices.begin(),
+                          vertices.end());
+    chunk_vertex_offsets.push_back(chunk_vertices.size());
+  }
+
+  // Build vertex-to-chunk map
+  const std::size_t num_vertices = mesh.num_vertices();
+  std::vector<std::size_t> vertex_chunk_offsets(num_vertices + 1, 0);
+  for (std::size_t i = 0; i < chunk_vertices.size(); ++i)
+    ++vertex_chunk_offsets[chunk_vertices[i] + 1];
+  for (std::size_t v = 0; v < num_vertices; ++v)
+    vertex_chunk_offsets[v + 1] += vertex_chunk_offsets[v];
+  std::vector<std::size_t> vertex_chunks(chunk_vertices.size());
+  std::vector<std::size_t> position(vertex_chunk_offsets.begin(),
+                                    vertex_chunk_offsets.end() - 1);
+  for (std::size_t i = 0; i < num_chunks; ++i)
+  {
+    for (std::size_t j = chunk_vertex_offsets[i];
+         j < chunk_vertex_offsets[i + 1]; ++j)
+    {
+      vertex_chunks[position[chunk_vertices[j]]++] = i;
+    }
+  }
+
+  // Build chunk conflict graph (chunks sharing a vertex)
+  std::vector<std::size_t> conflicts;
+  std::vector<std::size_t> conflict_offsets(1, 0);
+  std::vector<std::size_t> neighbours;
+  for (std::size_t i = 0; i < num_chunks; ++i)
+  {
+    neighbours.clear();
+    for (std::size_t j = chunk_vertex_offsets[i];
+         j < chunk_vertex_offsets[i + 1]; ++j)
+    {
+      const std::size_t v = chunk_vertices[j];
+      neighbours.insert(neighbours.end(),
+                        vertex_chunks.begin() + vertex_chunk_offsets[v],
+                        vertex_chunks.begin() + vertex_chunk_offsets[v + 1]);
+    }
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+                     neighbours.end());
+    for (std::size_t j = 0; j < neighbours.size(); ++j)
+    {
+      if (neighbours[j] != i)
+        conflicts.push_back(neighbours[j]);
+    }
+    conflict_offsets.push_back(conflicts.size());
+  }
+
+  // Color conflict graph greedily. Conflicting chunks are processed
+  // in order of (color, chunk), which makes the conflict graph a
+  // dependency graph. Consecutive chunks usually conflict, so
+  // ordering by chunk alone would serialize the assembly.
+  std::vector<std::size_t> colors(num_chunks, 0);
+  std::vector<std::size_t> used;
+  for (std::size_t i = 0; i < num_chunks; ++i)
+  {
+    used.clear();
+    for (std::size_t j = conflict_offsets[i]; j < conflict_offsets[i + 1]; ++j)
+    {
+      if (conflicts[j] < i)
+        used.push_back(colors[conflicts[j]]);
+    }
+    std::sort(used.begin(), used.end());
+    std::size_t color = 0;
+    for (std::size_t j = 0; j < used.size() && used[j] <= color; ++j)
+    {
+      if (used[j] == color)
+        ++color;
+    }
+    colors[i] = color;
+  }
+
+  // Build dependency graph: the successors of a chunk are the
+  // conflicting chunks that must wait for it
+  _successor_offsets.resize(1, 0);
+  _num_predecessors.assign(num_chunks, 0);
+  for (std::size_t i = 0; i < num_chunks; ++i)
+  {
+    for (std::size_t j = conflict_offsets[i]; j < conflict_offsets[i + 1]; ++j)
+    {
+      const std::size_t k = conflicts[j];
+      if (colors[i] < colors[k] || (colors[i] == colors[k] && i < k))
+      {
+        _successors.push_back(k);
+        ++_num_predecessors[k];
+      }
+    }
+    _successor_offsets.push_back(_successors.size());
+  }
+
+  // Initialise queue
+  reset();
+}
+//-----------------------------------------------------------------------------
+AssemblyScheduler::~AssemblyScheduler()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+bool AssemblyScheduler::acquire(std::size_t& chunk)
+{
+  const std::size_t n = num_chunks();
+  while (true)
+  {
+    // Wait for a ready chunk without locking
+    std::size_t begin, end;
+    #ifdef HAS_OPENMP
+    #pragma omp atomic read
+    #endif
+    begin = _ready_begin;
+    #ifdef HAS_OPENMP
+    #pragma omp atomic read
+    #endif
+    end = _ready_end;
+
+    // No more work
+    if (begin == n)
+      return false;
+
+    // Take first ready chunk (unless another thread was faster)
+    if (begin < end)
+    {
+      bool found = false;
+      #ifdef HAS_OPENMP
+      #pragma omp critical (dolfin_assembly_scheduler)
+      #endif
+      {
+        if (_ready_begin < _ready_end)
+        {
+          chunk = _ready[_ready_begin];
+          const std::size_t next = _ready_begin + 1;
+          #ifdef HAS_OPENMP
+          #pragma omp atomic write
+          #endif
+          _ready_begin = next;
+          found = true;
+        }
+      }
+      if (found)
+        return true;
+    }
+    else
+    {
+      // Chunks in conflict with the remaining ones are still being
+      // processed, so give up the core until some are released
+      boost::this_thread::yield();
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void AssemblyScheduler::release(std::size_t chunk)
+{
+  #ifdef HAS_OPENMP
+  #pragma omp critical (dolfin_assembly_scheduler)
+  #endif
+  {
+    // Chunks that no longer wait for any chunk become ready
+    std::size_t end = _ready_end;
+    for (std::size_t j = _successor_offsets[chunk];
+         j < _successor_offsets[chunk + 1]; ++j)
+    {
+      const std::size_t k = _successors[j];
+      dolfin_assert(_num_waiting[k] > 0);
+      if (--_num_waiting[k] == 0)
+        _ready[end++] = k;
+    }
+    #ifdef HAS_OPENMP
+    #pragma omp atomic write
+    #endif
+    _ready_end = end;
+  }
+}
+//-----------------------------------------------------------------------------
+void AssemblyScheduler::reset()
+{
+  const std::size_t n = num_chunks();
+  _num_waiting = _num_predecessors;
+  _ready.resize(n);
+  _ready_begin = 0;
+  _ready_end = 0;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    if (_num_waiting[i] == 0)
+      _ready[_ready_end++] = i;
+  }
+}
+//-----------------------------------------------------------------------------
+std::size_t AssemblyScheduler::default_chunk_size(std::size_t rows_per_entity)
+{
+  // Aim at roughly 2048 rows per chunk, which keeps the rows touched
+  // by a chunk in cache for typical sparse matrix backends
+  const std::size_t target_rows = 2048;
+  const std::size_t n = target_rows/std::max(rows_per_entity,
+                                             (std::size_t) 1);
+  return std::min(std::max(n, (std::size_t) 8), (std::size_t) 512);
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,126 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-14
+// Last changed: 2014-03-27
+
+#ifndef __ASSEMBLY_SCHEDULER_H
+#define __ASSEMBLY_SCHEDULER_H
+
+#include <vector>
+#include <dolfin/common/ArrayView.h>
+
+namespace dolfin
+{
+
+  class Mesh;
+
+  /// This class distributes mesh entities (cells or facets) between
+  /// threads for multi-threaded assembly. The entities are split
+  /// into chunks of consecutive entities, and two chunks are in
+  /// conflict if the cells touched by their entities share a
+  /// vertex. Conflicting chunks are processed one after the other,
+  /// in the order given by a greedy coloring of the chunks, so that
+  /// no two threads add to the same rows of the global tensor at
+  /// the same time. A chunk becomes ready as soon as the
+  /// conflicting chunks before it have been released; unlike
+  /// assembly over mesh colors, there is no barrier between groups
+  /// of entities.
+  ///
+  /// Typical usage (inside an OpenMP parallel region):
+  ///
+  ///    .. code-block:: c++
+  ///
+  ///        std::size_t chunk;
+  ///        while (scheduler.acquire(chunk))
+  ///        {
+  ///          const ArrayView<const std::size_t> entities
+  ///            = scheduler.chunk(chunk);
+  ///          ...
+  ///          scheduler.release(chunk);
+  ///        }
+
+  class AssemblyScheduler
+  {
+  public:
+
+    /// Create scheduler for given entities of dimension dim, with
+    /// (at most) chunk_size entities per chunk
+    AssemblyScheduler(const Mesh& mesh, std::size_t dim,
+                      const std::vector<std::size_t>& entities,
+                      std::size_t chunk_size);
+
+    /// Destructor
+    ~AssemblyScheduler();
+
+    /// Return number of chunks
+    std::size_t num_chunks() const
+    { return _chunk_offsets.size() - 1; }
+
+    /// Return entities of given chunk
+    ArrayView<const std::size_t> chunk(std::size_t i) const
+    {
+      return ArrayView<const std::size_t>(_chunk_offsets[i + 1]
+                                          - _chunk_offsets[i],
+                                          &_entities[_chunk_offsets[i]]);
+    }
+
+    /// Get next ready chunk, waiting until one becomes ready if
+    /// necessary. Returns false when there are no more chunks to
+    /// process. Thread-safe.
+    bool acquire(std::size_t& chunk);
+
+    /// Mark chunk as processed. Thread-safe.
+    void release(std::size_t chunk);
+
+    /// Mark all chunks as unprocessed (not thread-safe)
+    void reset();
+
+    /// Compute a chunk size from the number of global tensor rows
+    /// touched per entity, aiming at chunks whose rows fit in cache
+    static std::size_t default_chunk_size(std::size_t rows_per_entity);
+
+  private:
+
+    // Entities, chunk after chunk
+    std::vector<std::size_t> _entities;
+
+    // Offsets into _entities for each chunk (size num_chunks + 1)
+    std::vector<std::size_t> _chunk_offsets;
+
+    // Dependency graph of conflicting chunks (chunks that must wait
+    // for chunk i are _successors[_successor_offsets[i]] ... )
+    std::vector<std::size_t> _successors;
+    std::vector<std::size_t> _successor_offsets;
+
+    // Number of conflicting chunks that each chunk must wait for
+    std::vector<std::size_t> _num_predecessors;
+
+    // Number of those chunks that have not yet been released
+    std::vector<std::size_t> _num_waiting;
+
+    // Queue of chunks that are ready, from _ready_begin to _ready_end
+    // (every chunk enters the queue once)
+    std::vector<std::size_t> _ready;
+    std::size_t _ready_begin;
+    std::size_t _ready_end;
+
+  };
+
+}
+
+#endif
@@ -69,7 +69,7 @@ void CCFEMAssembler::assemble_cells(GenericTensor& A, const CCFEMForm& a)
   const std::size_t form_rank = a.rank();
 
   // Vector to hold dof map for a cell
-  std::vector<const std::vector<dolfin::la_index>* > dofs(form_rank);
+  std::vector<ArrayView<const dolfin::la_index> > dofs(form_rank);
 
   // Collect pointers to dof maps
   std::vector<const CCFEMDofMap*> dofmaps;
@@ -111,7 +111,7 @@ void CCFEMAssembler::assemble_cells(GenericTensor& A, const CCFEMForm& a)
 
       // Get local-to-global dof maps for cell
       for (std::size_t i = 0; i < form_rank; ++i)
-        dofs[i] = &(dofmaps[i]->cell_dofs(cell->index()));
+        dofs[i] = dofmaps[i]->cell_dofs(cell->index());
 
       // Tabulate cell tensor
       integral->tabulate_tensor(ufc.A.data(), ufc.w(),
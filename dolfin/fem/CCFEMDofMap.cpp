@@ -107,7 +107,7 @@ void CCFEMDofMap::build(const CCFEMFunctionSpace& function_space)
     for (CellIterator cell(mesh); !cell.end(); ++cell)
     {
       // Get dofs from dofmap on part
-      const std::vector<dolfin::la_index>& dofs
+      const ArrayView<const dolfin::la_index> dofs
         = _dofmaps[part]->cell_dofs(cell->index());
 
       // Compute new dofs by adding offset
@@ -197,11 +197,13 @@ CCFEMDofMap::off_process_owner() const
   return _dofmaps[_current_part]->off_process_owner();
 }
 //-----------------------------------------------------------------------------
-const std::vector<dolfin::la_index>&
+ArrayView<const dolfin::la_index>
 CCFEMDofMap::cell_dofs(std::size_t cell_index) const
 {
   dolfin_assert(cell_index < _dofmap[_current_part].size());
-  return _dofmap[_current_part][cell_index];
+  const std::vector<dolfin::la_index>& dofs
+    = _dofmap[_current_part][cell_index];
+  return ArrayView<const dolfin::la_index>(dofs.size(), dofs.data());
 }
 //-----------------------------------------------------------------------------
 void CCFEMDofMap::tabulate_facet_dofs(std::vector<std::size_t>& dofs,
@@ -129,7 +129,7 @@ namespace dolfin
       off_process_owner() const;
 
     /// Local-to-global mapping of dofs on a cell
-    const std::vector<dolfin::la_index>&
+    ArrayView<const dolfin::la_index>
       cell_dofs(std::size_t cell_index) const;
 
     /// Tabulate local-local facet dofs
@@ -847,7 +847,7 @@ void DirichletBC::compute_bc_topological(Map& boundary_values,
                  vertex_coordinates.data(), ufc_cell);
 
     // Tabulate dofs on cell
-    const std::vector<dolfin::la_index>& cell_dofs
+    const ArrayView<const dolfin::la_index> cell_dofs
       = dofmap.cell_dofs(cell.index());
 
     // Tabulate which dofs are on the facet
@@ -932,7 +932,7 @@ void DirichletBC::compute_bc_geometric(Map& boundary_values,
         bool interpolated = false;
 
         // Tabulate dofs on cell
-        const std::vector<dolfin::la_index>& cell_dofs
+        const ArrayView<const dolfin::la_index> cell_dofs
           = dofmap.cell_dofs(c->index());
 
         // Loop over all dofs on cell
@@ -1027,7 +1027,7 @@ void DirichletBC::compute_bc_pointwise(Map& boundary_values,
                                   *cell);
 
       // Tabulate dofs on cell
-      const std::vector<dolfin::la_index>& cell_dofs
+      const ArrayView<const dolfin::la_index> cell_dofs
         = dofmap.cell_dofs(cell->index());
 
       // Interpolate function only once and only on cells where necessary
@@ -1095,7 +1095,7 @@ void DirichletBC::compute_bc_pointwise(Map& boundary_values,
                     vertex_coordinates.data(), ufc_cell);
 
       // Tabulate dofs on cell
-      const std::vector<dolfin::la_index>& cell_dofs
+      const ArrayView<const dolfin::la_index> cell_dofs
         = dofmap.cell_dofs(cell.index());
 
       // Loop dofs on boundary of cell
@@ -148,9 +148,9 @@ DofMap::DofMap(boost::unordered_map<std::size_t, std::size_t>& collapsed_map,
   DofMapBuilder::build(*this, mesh, slave_master_mesh_entities, _restriction);
 
   // Dimension sanity checks
-  dolfin_assert(dofmap_view._dofmap.size() == mesh.num_cells());
+  dolfin_assert(dofmap_view._cell_offsets.size() == mesh.num_cells() + 1);
   dolfin_assert(global_dimension() == dofmap_view.global_dimension());
-  dolfin_assert(_dofmap.size() == mesh.num_cells());
+  dolfin_assert(_cell_offsets.size() == mesh.num_cells() + 1);
 
   // FIXME: Could we use a std::vector instead of std::map if the
   //        collapsed dof map is contiguous (0, . . . , n)?
@@ -159,9 +159,9 @@ DofMap::DofMap(boost::unordered_map<std::size_t, std::size_t>& collapsed_map,
   collapsed_map.clear();
   for (std::size_t i = 0; i < mesh.num_cells(); ++i)
   {
-    const std::vector<dolfin::la_index>& view_cell_dofs
-      = dofmap_view._dofmap[i];
-    const std::vector<dolfin::la_index>& cell_dofs = _dofmap[i];
+    const ArrayView<const dolfin::la_index> view_cell_dofs
+      = dofmap_view.cell_dofs(i);
+    const ArrayView<const dolfin::la_index> cell_dofs = this->cell_dofs(i);
     dolfin_assert(view_cell_dofs.size() == cell_dofs.size());
 
     for (std::size_t j = 0; j < view_cell_dofs.size(); ++j)
@@ -173,6 +173,7 @@ DofMap::DofMap(const DofMap& dofmap)
 {
   // Copy data
   _dofmap = dofmap._dofmap;
+  _cell_offsets = dofmap._cell_offsets;
   _ufc_dofmap = dofmap._ufc_dofmap;
   ufc_map_to_dofmap = dofmap.ufc_map_to_dofmap;
   _is_view = dofmap._is_view;
@@ -197,8 +198,8 @@ std::size_t DofMap::global_dimension() const
 //-----------------------------------------------------------------------------
 std::size_t DofMap::cell_dimension(std::size_t cell_index) const
 {
-  dolfin_assert(cell_index < _dofmap.size());
-  return _dofmap[cell_index].size();
+  dolfin_assert(cell_index + 1 < _cell_offsets.size());
+  return _cell_offsets[cell_index + 1] - _cell_offsets[cell_index];
 }
 //-----------------------------------------------------------------------------
 std::size_t DofMap::max_cell_dimension() const
@@ -329,7 +330,7 @@ std::vector<double> DofMap::tabulate_all_coordinates(const Mesh& mesh) const
     cell->get_vertex_coordinates(vertex_coordinates);
 
     // Get local-to-global map
-    const std::vector<dolfin::la_index>& dofs = cell_dofs(cell->index());
+    const ArrayView<const dolfin::la_index> dofs = cell_dofs(cell->index());
 
     // Tabulate dof coordinates on cell
     tabulate_coordinates(coordinates, vertex_coordinates, *cell);
@@ -412,7 +413,8 @@ std::vector<dolfin::la_index> DofMap::dof_to_vertex_map(const Mesh& mesh) const
     }
 
     // Get all cell dofs
-    const std::vector<dolfin::la_index>& _cell_dofs = cell_dofs(cell.index());
+    const ArrayView<const dolfin::la_index> _cell_dofs
+      = cell_dofs(cell.index());
 
     // Tabulate local to local map of dofs on local vertex
     _ufc_dofmap->tabulate_entity_dofs(local_to_local_map.data(), 0,
@@ -502,18 +504,15 @@ std::vector<dolfin::la_index> DofMap::dofs() const
 
   // Create vector to hold dofs
   std::vector<la_index> _dofs;
-  _dofs.reserve(_dofmap.size()*max_cell_dimension());
+  _dofs.reserve(_dofmap.size());
 
   // Insert all dofs into a vector (will contain duplicates)
-  std::vector<std::vector<dolfin::la_index> >::const_iterator cell_dofs;
-  for (cell_dofs = _dofmap.begin(); cell_dofs != _dofmap.end(); ++cell_dofs)
+  std::vector<dolfin::la_index>::const_iterator dof;
+  for (dof = _dofmap.begin(); dof != _dofmap.end(); ++dof)
   {
-    for (std::size_t i = 0; i < cell_dofs->size(); ++i)
-    {
-      const std::size_t dof = (*cell_dofs)[i];
-      if (dof >= r0 && dof < r1)
-        _dofs.push_back(dof);
-    }
+    const std::size_t _dof = *dof;
+    if (_dof >= r0 && _dof < r1)
+      _dofs.push_back(_dof);
   }
 
   // Sort dofs (required to later remove duplicates)
@@ -527,13 +526,9 @@ std::vector<dolfin::la_index> DofMap::dofs() const
 //-----------------------------------------------------------------------------
 void DofMap::set(GenericVector& x, double value) const
 {
-  std::vector<double> _value;
-  std::vector<std::vector<dolfin::la_index> >::const_iterator cell_dofs;
-  for (cell_dofs = _dofmap.begin(); cell_dofs != _dofmap.end(); ++cell_dofs)
-  {
-    _value.resize(cell_dofs->size(), value);
-    x.set(_value.data(), cell_dofs->size(), cell_dofs->data());
-  }
+  // All dofs are stored contiguously, so set them in one call
+  std::vector<double> _value(_dofmap.size(), value);
+  x.set(_value.data(), _dofmap.size(), _dofmap.data());
   x.apply("insert");
 }
 //-----------------------------------------------------------------------------
@@ -549,7 +544,7 @@ void DofMap::set_x(GenericVector& x, double value, std::size_t component,
     cell->get_vertex_coordinates(vertex_coordinates);
 
     // Get local-to-global map
-    const std::vector<dolfin::la_index>& dofs = cell_dofs(cell->index());
+    const ArrayView<const dolfin::la_index> dofs = cell_dofs(cell->index());
 
     // Tabulate dof coordinates
     tabulate_coordinates(coordinates, vertex_coordinates, *cell);
@@ -596,16 +591,17 @@ std::string DofMap::str(bool verbose) const
   if (verbose)
   {
     // Cell loop
-    for (std::size_t i = 0; i < _dofmap.size(); ++i)
+    for (std::size_t i = 0; i + 1 < _cell_offsets.size(); ++i)
     {
+      const ArrayView<const dolfin::la_index> dofs = cell_dofs(i);
       s << prefix.str() << "Local cell index, cell dofmap dimension: " << i
-        << ", " << _dofmap[i].size() << std::endl;
+        << ", " << dofs.size() << std::endl;
 
       // Local dof loop
-      for (std::size_t j = 0; j < _dofmap[i].size(); ++j)
+      for (std::size_t j = 0; j < dofs.size(); ++j)
       {
         s << prefix.str() <<  "  " << "Local, global dof indices: " << j
-          << ", " << _dofmap[i][j] << std::endl;
+          << ", " << dofs[j] << std::endl;
       }
     }
   }
@@ -37,6 +37,7 @@
 #include <boost/unordered_map.hpp>
 #include <ufc.h>
 
+#include <dolfin/common/ArrayView.h>
 #include <dolfin/common/types.h>
 #include <dolfin/mesh/Cell.h>
 #include "GenericDofMap.h"
@@ -230,12 +231,15 @@ namespace dolfin
     ///         The cell index.
     ///
     /// *Returns*
-    ///     std::vector<dolfin::la_index>
-    ///         Local-to-global mapping of dofs.
-    const std::vector<dolfin::la_index>& cell_dofs(std::size_t cell_index) const
+    ///     _ArrayView_ <dolfin::la_index>
+    ///         Local-to-global mapping of dofs (a view into the
+    ///         contiguous dof map storage).
+    ArrayView<const dolfin::la_index> cell_dofs(std::size_t cell_index) const
     {
-      dolfin_assert(cell_index < _dofmap.size());
-      return _dofmap[cell_index];
+      dolfin_assert(cell_index + 1 < _cell_offsets.size());
+      const std::size_t offset = _cell_offsets[cell_index];
+      return ArrayView<const dolfin::la_index>(
+        _cell_offsets[cell_index + 1] - offset, _dofmap.data() + offset);
     }
 
     /// Tabulate local-local facet dofs
@@ -400,15 +404,27 @@ namespace dolfin
     void set_x(GenericVector& x, double value, std::size_t component,
                const Mesh& mesh) const;
 
-    /// Return the underlying dof map data. Intended for internal library
-    /// use only.
+    /// Return the underlying dof map data. The dofs for cell i are
+    /// stored contiguously in the range [offsets[i], offsets[i + 1]),
+    /// where offsets is returned by cell_offsets(). Intended for
+    /// internal library use only.
     ///
     /// *Returns*
-    ///     std::vector<std::vector<dolfin::la_index> >
-    ///         The local-to-global map for each cell.
-    const std::vector<std::vector<dolfin::la_index> >& data() const
+    ///     std::vector<dolfin::la_index>
+    ///         The local-to-global map for all cells.
+    const std::vector<dolfin::la_index>& data() const
     { return _dofmap; }
 
+    /// Return offsets into the underlying dof map data for each
+    /// cell (size is number of cells + 1). Intended for internal
+    /// library use only.
+    ///
+    /// *Returns*
+    ///     std::vector<std::size_t>
+    ///         The cell offsets.
+    const std::vector<std::size_t>& cell_offsets() const
+    { return _cell_offsets; }
+
     /// Return informal string representation (pretty-print)
     ///
     /// *Arguments*
@@ -433,8 +449,13 @@ namespace dolfin
     static void check_provided_entities(const ufc::dofmap& dofmap,
                                         const Mesh& mesh);
 
-    // Local-to-global dof map (dofs for cell dofmap[i])
-    std::vector<std::vector<dolfin::la_index> > _dofmap;
+    // Local-to-global dof map, stored contiguously for all cells
+    // (dofs for cell i are _dofmap[_cell_offsets[i]],
+    // . . . , _dofmap[_cell_offsets[i + 1] - 1])
+    std::vector<dolfin::la_index> _dofmap;
+
+    // Offsets into _dofmap for each cell (size num_cells + 1)
+    std::vector<std::size_t> _cell_offsets;
 
     // UFC dof map
     std::shared_ptr<const ufc::dofmap> _ufc_dofmap;
@@ -139,9 +139,12 @@ void DofMapBuilder::build_sub_map(DofMap& sub_dofmap,
                    parent_dofmap.slave_master_mesh_entities, restriction);
 
   // Add offset to dofmap
-  for (std::size_t i = 0; i < sub_dofmap._dofmap.size(); ++i)
-    for (std::size_t j = 0; j < sub_dofmap._dofmap[i].size(); ++j)
-      sub_dofmap._dofmap[i][j] += offset;
+  std::vector<dolfin::la_index>::iterator dof;
+  for (dof = sub_dofmap._dofmap.begin(); dof != sub_dofmap._dofmap.end();
+       ++dof)
+  {
+    *dof += offset;
+  }
 
   // Correct dofmap for non-UFC numbering
   sub_dofmap.ufc_map_to_dofmap.clear();
@@ -151,39 +154,34 @@ void DofMapBuilder::build_sub_map(DofMap& sub_dofmap,
   if (!parent_dofmap.ufc_map_to_dofmap.empty())
   {
     boost::unordered_map<std::size_t, std::size_t>::const_iterator ufc_to_current_dof;
-    std::vector<std::vector<dolfin::la_index> >::iterator cell_map;
-    std::vector<dolfin::la_index>::iterator dof;
-    for (cell_map = sub_dofmap._dofmap.begin();
-        cell_map != sub_dofmap._dofmap.end(); ++cell_map)
+    for (dof = sub_dofmap._dofmap.begin(); dof != sub_dofmap._dofmap.end();
+         ++dof)
     {
-      for (dof = cell_map->begin(); dof != cell_map->end(); ++dof)
+      // Get dof index
+      ufc_to_current_dof = parent_dofmap.ufc_map_to_dofmap.find(*dof);
+      dolfin_assert(ufc_to_current_dof
+                    != parent_dofmap.ufc_map_to_dofmap.end());
+
+      // Add to ufc-to-current dof map
+      sub_dofmap.ufc_map_to_dofmap.insert(*ufc_to_current_dof);
+
+      // Set dof index
+      *dof = ufc_to_current_dof->second;
+
+      // Add to off-process dof owner map
+      boost::unordered_map<std::size_t, unsigned int>::const_iterator
+        parent_off_proc = parent_dofmap._off_process_owner.find(*dof);
+      if (parent_off_proc != parent_dofmap._off_process_owner.end())
+        sub_dofmap._off_process_owner.insert(*parent_off_proc);
+
+      // Add to shared-dof process map, and update the set of neighbours
+      boost::unordered_map<std::size_t, std::vector<unsigned int> >::const_iterator
+        parent_shared = parent_dofmap._shared_dofs.find(*dof);
+      if (parent_shared != parent_dofmap._shared_dofs.end())
       {
-        // Get dof index
-        ufc_to_current_dof = parent_dofmap.ufc_map_to_dofmap.find(*dof);
-        dolfin_assert(ufc_to_current_dof
-                      != parent_dofmap.ufc_map_to_dofmap.end());
-
-        // Add to ufc-to-current dof map
-        sub_dofmap.ufc_map_to_dofmap.insert(*ufc_to_current_dof);
-
-        // Set dof index
-        *dof = ufc_to_current_dof->second;
-
-        // Add to off-process dof owner map
-        boost::unordered_map<std::size_t, unsigned int>::const_iterator
-          parent_off_proc = parent_dofmap._off_process_owner.find(*dof);
-        if (parent_off_proc != parent_dofmap._off_process_owner.end())
-          sub_dofmap._off_process_owner.insert(*parent_off_proc);
-
-        // Add to shared-dof process map, and update the set of neighbours
-        boost::unordered_map<std::size_t, std::vector<unsigned int> >::const_iterator
-          parent_shared = parent_dofmap._shared_dofs.find(*dof);
-        if (parent_shared != parent_dofmap._shared_dofs.end())
-        {
-          sub_dofmap._shared_dofs.insert(*parent_shared);
-          sub_dofmap._neighbours.insert(parent_shared->second.begin(),
-                                        parent_shared->second.end());
-        }
+        sub_dofmap._shared_dofs.insert(*parent_shared);
+        sub_dofmap._neighbours.insert(parent_shared->second.begin(),
+                                      parent_shared->second.end());
       }
     }
   }
@@ -401,9 +399,9 @@ void DofMapBuilder::reorder_local(DofMap& dofmap, const Mesh& mesh,
   std::vector<dolfin::la_index> dofs_tmp;
   for (CellIterator cell(mesh); !cell.end(); ++cell)
   {
-    const std::vector<dolfin::la_index>& dofs0
+    const ArrayView<const dolfin::la_index> dofs0
       = dofmap.cell_dofs(cell->index());
-    const std::vector<dolfin::la_index>& dofs1
+    const ArrayView<const dolfin::la_index> dofs1
       = dofmap.cell_dofs(cell->index());
 
     dolfin_assert(dofs0.size() % block_size == 0);
@@ -456,18 +454,13 @@ void DofMapBuilder::reorder_local(DofMap& dofmap, const Mesh& mesh,
                  "The requested ordering library '%s' is unknown", ordering_library.c_str());
   }
 
-  // Re-number dofs for each cell
-  std::vector<std::vector<dolfin::la_index> >::iterator cell_map;
+  // Re-number dofs for all cells (stored contiguously)
   std::vector<dolfin::la_index>::iterator dof;
-  for (cell_map = dofmap._dofmap.begin(); cell_map != dofmap._dofmap.end();
-       ++cell_map)
+  for (dof = dofmap._dofmap.begin(); dof != dofmap._dofmap.end(); ++dof)
   {
-    for (dof = cell_map->begin(); dof != cell_map->end(); ++dof)
-    {
-      const std::size_t old_node = (*dof) % num_nodes;
-      const std::size_t new_node = block_remap[old_node];
-      *dof = new_node*block_size + (*dof)/num_nodes;
-    }
+    const std::size_t old_node = (*dof) % num_nodes;
+    const std::size_t new_node = block_remap[old_node];
+    *dof = new_node*block_size + (*dof)/num_nodes;
   }
 
   // Store re-ordering map (from UFC dofmap)
@@ -566,8 +559,6 @@ void DofMapBuilder::build_ufc_dofmap(
     }
   }
 
-  // Allocate space for dof map
-  dofmap._dofmap.resize(mesh.num_cells());
   dofmap._off_process_owner.clear();
   dolfin_assert(dofmap._ufc_dofmap);
 
@@ -580,6 +571,21 @@ void DofMapBuilder::build_ufc_dofmap(
   // Get standard local element dimension
   const std::size_t local_dim = dofmap._ufc_dofmap->local_dimension();
 
+  // Compute offsets into contiguous dof map storage (cells not
+  // included in the restriction have no dofs)
+  dofmap._cell_offsets.resize(mesh.num_cells() + 1);
+  dofmap._cell_offsets[0] = 0;
+  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  {
+    const std::size_t cell_dim
+      = (restriction && !restriction->contains(*cell)) ? 0 : local_dim;
+    dofmap._cell_offsets[cell->index() + 1]
+      = dofmap._cell_offsets[cell->index()] + cell_dim;
+  }
+
+  // Allocate space for dof map
+  dofmap._dofmap.resize(dofmap._cell_offsets.back());
+
   // Creat UFC cell and allocate memory
   ufc::cell ufc_cell;
   ufc_cell.entity_indices.resize(D + 1);
@@ -611,8 +617,9 @@ void DofMapBuilder::build_ufc_dofmap(
     ufc_cell.index = cell->index();
 
     // Get container for cell dofs
-    std::vector<dolfin::la_index>& cell_dofs = dofmap._dofmap[cell->index()];
-    cell_dofs.resize(local_dim);
+    dolfin_assert(dofmap.cell_dimension(cell->index()) == local_dim);
+    ArrayView<dolfin::la_index>
+      cell_dofs(local_dim, &dofmap._dofmap[dofmap._cell_offsets[cell->index()]]);
 
     // Tabulate standard UFC dof map
     ufc_dofs.resize(local_dim);
@@ -745,7 +752,7 @@ void DofMapBuilder::compute_node_ownership(boost::array<set, 3>& node_ownership,
         continue;
 
       // Tabulate dofs on cell
-      const std::vector<dolfin::la_index>& cell_dofs
+      const ArrayView<const dolfin::la_index> cell_dofs
         = dofmap.cell_dofs(c.index());
 
       // Tabulate which dofs are on the facet
@@ -857,7 +864,7 @@ void DofMapBuilder::compute_node_ownership(boost::array<set, 3>& node_ownership,
   // Mark all shared-and-owned dofs as owned by the processes
   for (CellIterator cell(mesh); !cell.end(); ++cell)
   {
-    const std::vector<dolfin::la_index>& cell_dofs
+    const ArrayView<const dolfin::la_index> cell_dofs
       = dofmap.cell_dofs(cell->index());
     for (std::size_t i = 0; i < cell_dofs.size(); ++i)
     {
@@ -931,10 +938,7 @@ void DofMapBuilder::parallel_renumber(
                  "The degree of freedom mapping cannot be renumbered twice");
   }
 
-  const std::vector<std::vector<dolfin::la_index> >& old_dofmap
-    = dofmap._dofmap;
-  std::vector<std::vector<dolfin::la_index> > new_dofmap(old_dofmap.size());
-  dolfin_assert(old_dofmap.size() == mesh.num_cells());
+  dolfin_assert(dofmap._cell_offsets.size() == mesh.num_cells() + 1);
 
   // Compute offset for owned and non-shared nodes
   const std::size_t process_offset
@@ -959,11 +963,11 @@ void DofMapBuilder::parallel_renumber(
     }
 
     // Build local graph, based on old dof map, with contiguous numbering
-    for (std::size_t cell = 0; cell < old_dofmap.size(); ++cell)
+    for (std::size_t cell = 0; cell < mesh.num_cells(); ++cell)
     {
       // Cell dofmaps with old indices
-      const std::vector<dolfin::la_index>& dofs0 = dofmap.cell_dofs(cell);
-      const std::vector<dolfin::la_index>& dofs1 = dofmap.cell_dofs(cell);
+      const ArrayView<const dolfin::la_index> dofs0 = dofmap.cell_dofs(cell);
+      const ArrayView<const dolfin::la_index> dofs1 = dofmap.cell_dofs(cell);
 
       dolfin_assert(dofs0.size() % block_size == 0);
       const std::size_t nodes_per_cell = dofs0.size()/block_size;
@@ -1137,31 +1141,17 @@ void DofMapBuilder::parallel_renumber(
     dofmap._neighbours.insert(it->second.begin(), it->second.end());
   }
 
-  // Build new dofmap
-  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  // Renumber dof map in-place (cells not included in a restriction
+  // have no entries in the contiguous storage)
+  std::vector<dolfin::la_index>::iterator dof;
+  for (dof = dofmap._dofmap.begin(); dof != dofmap._dofmap.end(); ++dof)
   {
-    // Skip cells not included in restriction
-    if (restriction && !restriction->contains(*cell))
-      continue;
-
-    // Get cell index and dimension
-    const std::size_t cell_index = cell->index();
-    const std::size_t cell_dimension = dofmap.cell_dimension(cell_index);
-
-    // Resize cell map and insert dofs
-    new_dofmap[cell_index].resize(cell_dimension);
-    for (std::size_t i = 0; i < cell_dimension; ++i)
-    {
-      const std::size_t old_index = old_dofmap[cell_index][i];
-      const std::size_t old_node  = old_index % num_nodes;
-      const std::size_t new_node  = old_to_new_node_index[old_node];
-      new_dofmap[cell_index][i]   = new_node*block_size + old_index/num_nodes;
-    }
+    const std::size_t old_index = *dof;
+    const std::size_t old_node  = old_index % num_nodes;
+    const std::size_t new_node  = old_to_new_node_index[old_node];
+    *dof = new_node*block_size + old_index/num_nodes;
   }
 
-  // Set new dof map
-  dofmap._dofmap = new_dofmap;
-
   // Set ownership range
   dofmap._ownership_range
     = std::make_pair(block_size*process_offset,
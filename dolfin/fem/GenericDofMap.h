@@ -32,6 +32,7 @@
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 
+#include <dolfin/common/ArrayView.h>
 #include <dolfin/common/types.h>
 #include <dolfin/common/Variable.h>
 
@@ -97,7 +98,7 @@ namespace dolfin
       off_process_owner() const = 0;
 
     /// Local-to-global mapping of dofs on a cell
-    virtual const std::vector<dolfin::la_index>&
+    virtual ArrayView<const dolfin::la_index>
       cell_dofs(std::size_t cell_index) const = 0;
 
     /// Tabulate local-local facet dofs
@@ -106,11 +106,11 @@ void LocalSolver::solve(GenericVector& x, const Form& a, const Form& L,
     ufc_L.update(*cell, vertex_coordinates, ufc_cell);
 
     // Get local-to-global dof maps for cell
-    const std::vector<dolfin::la_index>& dofs_a0
+    const ArrayView<const dolfin::la_index> dofs_a0
       = dofmap_a0->cell_dofs(cell->index());
-    const std::vector<dolfin::la_index>& dofs_a1
+    const ArrayView<const dolfin::la_index> dofs_a1
       = dofmap_a1->cell_dofs(cell->index());
-    const std::vector<dolfin::la_index>& dofs_L
+    const ArrayView<const dolfin::la_index> dofs_L
       = dofmap_L->cell_dofs(cell->index());
 
     // Check that local problem is square and a and L match
@@ -0,0 +1,455 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-18
+// Last changed: 2014-03-18
+
+#include <algorithm>
+#include <sstream>
+
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/NoDeleter.h>
+#include <dolfin/common/Timer.h>
+#include <dolfin/log/log.h>
+#include <dolfin/la/DefaultFactory.h>
+#include <dolfin/la/GenericVector.h>
+#include <dolfin/mesh/Cell.h>
+#include <dolfin/mesh/Facet.h>
+#include <dolfin/mesh/Mesh.h>
+#include <dolfin/mesh/MeshData.h>
+#include <dolfin/mesh/MeshFunction.h>
+#include <dolfin/function/FunctionSpace.h>
+#include <dolfin/function/GenericFunction.h>
+#include "Form.h"
+#include "GenericDofMap.h"
+#include "UFC.h"
+#include "MatrixFreeOperator.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+MatrixFreeOperator::MatrixFreeOperator(const Form& a)
+  : LinearOperator(*create_vector(a, 1), *create_vector(a, 0)),
+    _a(reference_to_no_delete_pointer(a))
+{
+  init();
+}
+//-----------------------------------------------------------------------------
+MatrixFreeOperator::MatrixFreeOperator(std::shared_ptr<const Form> a)
+  : LinearOperator(*create_vector(*a, 1), *create_vector(*a, 0)), _a(a)
+{
+  init();
+}
+//-----------------------------------------------------------------------------
+MatrixFreeOperator::~MatrixFreeOperator()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+std::size_t MatrixFreeOperator::size(std::size_t dim) const
+{
+  dolfin_assert(_a);
+  dolfin_assert(dim < 2);
+  dolfin_assert(_a->function_space(dim));
+  return _a->function_space(dim)->dim();
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::mult(const GenericVector& x, GenericVector& y) const
+{
+  Timer timer("Matrix-free operator action");
+
+  dolfin_assert(_a);
+  const Form& a = *_a;
+
+  // Check dimensions
+  if (x.size() != size(1) || y.size() != size(0))
+  {
+    dolfin_error("MatrixFreeOperator.cpp",
+                 "compute action of matrix-free operator",
+                 "Dimensions of vectors (%d, %d) do not match operator (%d, %d)",
+                 y.size(), x.size(), size(0), size(1));
+  }
+
+  // Update off-process coefficients
+  const std::vector<std::shared_ptr<const GenericFunction> >
+    coefficients = a.coefficients();
+  for (std::size_t i = 0; i < coefficients.size(); ++i)
+  {
+    if (!coefficients[i])
+    {
+      dolfin_error("MatrixFreeOperator.cpp",
+                   "compute action of matrix-free operator",
+                   "Coefficient number %d (\"%s\") has not been set",
+                   i, a.coefficient_name(i).c_str());
+    }
+    coefficients[i]->update();
+  }
+
+  // Gather the entries of x needed by the local cells
+  x.gather(_x_values, _x_indices);
+
+  // Create data structure for local assembly data
+  UFC ufc(a);
+
+  // Compute action
+  y.zero();
+  mult_cells(ufc, y);
+  mult_exterior_facets(ufc, y);
+  mult_interior_facets(ufc, y);
+  y.apply("add");
+}
+//-----------------------------------------------------------------------------
+std::string MatrixFreeOperator::str(bool verbose) const
+{
+  std::stringstream s;
+  s << "<MatrixFreeOperator of size " << size(0) << " x " << size(1) << ">";
+  return s.str();
+}
+//-----------------------------------------------------------------------------
+std::shared_ptr<GenericVector>
+MatrixFreeOperator::create_vector(const Form& a, std::size_t i)
+{
+  // Check rank here, before the function spaces are accessed
+  if (a.rank() != 2)
+  {
+    dolfin_error("MatrixFreeOperator.cpp",
+                 "create matrix-free operator",
+                 "Expecting a bilinear form (rank 2), not a form of rank %d",
+                 a.rank());
+  }
+
+  dolfin_assert(a.function_space(i));
+  dolfin_assert(a.function_space(i)->dofmap());
+  const GenericDofMap& dofmap = *a.function_space(i)->dofmap();
+
+  DefaultFactory factory;
+  std::shared_ptr<GenericVector> x = factory.create_vector();
+  x->init(a.mesh().mpi_comm(), dofmap.ownership_range());
+  return x;
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::init()
+{
+  dolfin_assert(_a);
+  const Form& a = *_a;
+
+  // Check form
+  dolfin_assert(a.ufc_form());
+  a.check();
+
+  // Interior facets on process boundaries are not handled
+  const Mesh& mesh = a.mesh();
+  if (a.ufc_form()->has_interior_facet_integrals()
+      && MPI::size(mesh.mpi_comm()) > 1)
+  {
+    dolfin_error("MatrixFreeOperator.cpp",
+                 "create matrix-free operator",
+                 "Interior facet integrals are not supported in parallel");
+  }
+
+  // Collect column dofs of all cells
+  const GenericDofMap& dofmap = *a.function_space(1)->dofmap();
+  const std::size_t num_cells = mesh.num_cells();
+  _x_offsets.resize(num_cells + 1);
+  _x_offsets[0] = 0;
+  for (std::size_t c = 0; c < num_cells; ++c)
+    _x_offsets[c + 1] = _x_offsets[c] + dofmap.cell_dofs(c).size();
+
+  _x_indices.resize(_x_offsets[num_cells]);
+  for (std::size_t c = 0; c < num_cells; ++c)
+  {
+    const ArrayView<const dolfin::la_index> dofs = dofmap.cell_dofs(c);
+    std::copy(dofs.begin(), dofs.end(), _x_indices.begin() + _x_offsets[c]);
+  }
+
+  // Compute position of each cell dof in the sorted list of unique
+  // column indices
+  std::vector<dolfin::la_index> cell_indices(_x_indices);
+  std::sort(_x_indices.begin(), _x_indices.end());
+  _x_indices.erase(std::unique(_x_indices.begin(), _x_indices.end()),
+                   _x_indices.end());
+  _x_positions.resize(cell_indices.size());
+  for (std::size_t i = 0; i < cell_indices.size(); ++i)
+  {
+    _x_positions[i] = std::lower_bound(_x_indices.begin(), _x_indices.end(),
+                                       cell_indices[i]) - _x_indices.begin();
+  }
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::mult_cells(UFC& ufc, GenericVector& y) const
+{
+  // Skip if there are no cell integrals
+  if (!ufc.form.has_cell_integrals())
+    return;
+
+  const Form& a = *_a;
+  const Mesh& mesh = a.mesh();
+  const GenericDofMap& dofmap0 = *a.function_space(0)->dofmap();
+
+  // Cell integral
+  ufc::cell_integral* integral = ufc.default_cell_integral.get();
+
+  // Check whether integral is domain-dependent
+  const MeshFunction<std::size_t>* domains = a.cell_domains().get();
+  const bool use_domains = domains && !domains->empty();
+
+  // Compute action over cells
+  ufc::cell ufc_cell;
+  std::vector<double> vertex_coordinates;
+  std::vector<double> y_cell;
+  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  {
+    // Get integral for sub domain (if any)
+    if (use_domains)
+      integral = ufc.get_cell_integral((*domains)[*cell]);
+
+    // Skip if no integral on current domain
+    if (!integral)
+      continue;
+
+    // Skip if dofmaps are empty
+    const ArrayView<const dolfin::la_index> rows
+      = dofmap0.cell_dofs(cell->index());
+    const std::size_t n = _x_offsets[cell->index() + 1]
+      - _x_offsets[cell->index()];
+    if (rows.empty() || n == 0)
+      continue;
+
+    // Update to current cell
+    cell->get_cell_data(ufc_cell);
+    cell->get_vertex_coordinates(vertex_coordinates);
+    ufc.update(*cell, vertex_coordinates, ufc_cell);
+
+    // Tabulate cell tensor
+    integral->tabulate_tensor(ufc.A.data(), ufc.w(),
+                              vertex_coordinates.data(),
+                              ufc_cell.orientation);
+
+    // Compute and add cell contribution to action
+    _x_cell.resize(n);
+    gather_cell_values(cell->index(), 0);
+    add_element_action(y, ufc.A, _x_cell, rows.data(), rows.size(), n,
+                       y_cell);
+  }
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::mult_exterior_facets(UFC& ufc,
+                                              GenericVector& y) const
+{
+  // Skip if there are no exterior facet integrals
+  if (!ufc.form.has_exterior_facet_integrals())
+    return;
+
+  const Form& a = *_a;
+  const Mesh& mesh = a.mesh();
+  const GenericDofMap& dofmap0 = *a.function_space(0)->dofmap();
+
+  // Exterior facet integral
+  const ufc::exterior_facet_integral* integral
+    = ufc.default_exterior_facet_integral.get();
+
+  // Check whether integral is domain-dependent
+  const MeshFunction<std::size_t>* domains
+    = a.exterior_facet_domains().get();
+  const bool use_domains = domains && !domains->empty();
+
+  // Compute facets and facet - cell connectivity if not already computed
+  const std::size_t D = mesh.topology().dim();
+  mesh.init(D - 1);
+  mesh.init(D - 1, D);
+  dolfin_assert(mesh.ordered());
+
+  // Compute action over exterior facets
+  ufc::cell ufc_cell;
+  std::vector<double> vertex_coordinates;
+  std::vector<double> y_cell;
+  for (FacetIterator facet(mesh); !facet.end(); ++facet)
+  {
+    // Only consider exterior facets
+    if (!facet->exterior())
+      continue;
+
+    // Get integral for sub domain (if any)
+    if (use_domains)
+      integral = ufc.get_exterior_facet_integral((*domains)[*facet]);
+
+    // Skip integral if zero
+    if (!integral)
+      continue;
+
+    // Get mesh cell to which mesh facet belongs (there is only one)
+    dolfin_assert(facet->num_entities(D) == 1);
+    Cell mesh_cell(mesh, facet->entities(D)[0]);
+
+    // Get local index of facet with respect to the cell
+    const std::size_t local_facet = mesh_cell.index(*facet);
+
+    // Update to current cell
+    mesh_cell.get_cell_data(ufc_cell, local_facet);
+    mesh_cell.get_vertex_coordinates(vertex_coordinates);
+    ufc.update(mesh_cell, vertex_coordinates, ufc_cell);
+
+    // Tabulate exterior facet tensor
+    integral->tabulate_tensor(ufc.A.data(), ufc.w(),
+                              vertex_coordinates.data(),
+                              local_facet);
+
+    // Compute and add facet contribution to action
+    const ArrayView<const dolfin::la_index> rows
+      = dofmap0.cell_dofs(mesh_cell.index());
+    const std::size_t n = _x_offsets[mesh_cell.index() + 1]
+      - _x_offsets[mesh_cell.index()];
+    _x_cell.resize(n);
+    gather_cell_values(mesh_cell.index(), 0);
+    add_element_action(y, ufc.A, _x_cell, rows.data(), rows.size(), n,
+                       y_cell);
+  }
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::mult_interior_facets(UFC& ufc,
+                                              GenericVector& y) const
+{
+  // Skip if there are no interior facet integrals
+  if (!ufc.form.has_interior_facet_integrals())
+    return;
+
+  const Form& a = *_a;
+  const Mesh& mesh = a.mesh();
+  const GenericDofMap& dofmap0 = *a.function_space(0)->dofmap();
+
+  // Interior facet integral
+  const ufc::interior_facet_integral* integral
+    = ufc.default_interior_facet_integral.get();
+
+  // Check whether integral is domain-dependent
+  const MeshFunction<std::size_t>* domains
+    = a.interior_facet_domains().get();
+  const bool use_domains = domains && !domains->empty();
+
+  // Compute facets and facet - cell connectivity if not already computed
+  const std::size_t D = mesh.topology().dim();
+  mesh.init(D - 1);
+  mesh.init(D - 1, D);
+  dolfin_assert(mesh.ordered());
+
+  // Get interior facet directions (if any)
+  const std::vector<std::size_t>* facet_orientation = NULL;
+  if (mesh.data().exists("facet_orientation", D - 1))
+    facet_orientation = &(mesh.data().array("facet_orientation", D - 1));
+
+  // Compute action over interior facets
+  ufc::cell ufc_cell[2];
+  std::vector<double> vertex_coordinates[2];
+  std::vector<dolfin::la_index> macro_rows;
+  std::vector<double> y_cell;
+  for (FacetIterator facet(mesh); !facet.end(); ++facet)
+  {
+    // Only consider interior facets
+    if (facet->num_entities(D) != 2)
+      continue;
+
+    // Get integral for sub domain (if any)
+    if (use_domains)
+      integral = ufc.get_interior_facet_integral((*domains)[*facet]);
+
+    // Skip integral if zero
+    if (!integral)
+      continue;
+
+    // Get cells incident with facet
+    std::pair<const Cell, const Cell>
+      cells = facet->adjacent_cells(facet_orientation);
+    const Cell& cell0 = cells.first;
+    const Cell& cell1 = cells.second;
+
+    // Get local index of facet with respect to each cell
+    const std::size_t local_facet0 = cell0.index(*facet);
+    const std::size_t local_facet1 = cell1.index(*facet);
+
+    // Update to current pair of cells
+    cell0.get_cell_data(ufc_cell[0], local_facet0);
+    cell0.get_vertex_coordinates(vertex_coordinates[0]);
+    cell1.get_cell_data(ufc_cell[1], local_facet1);
+    cell1.get_vertex_coordinates(vertex_coordinates[1]);
+    ufc.update(cell0, vertex_coordinates[0], ufc_cell[0],
+               cell1, vertex_coordinates[1], ufc_cell[1]);
+
+    // Tabulate interior facet tensor on macro element
+    integral->tabulate_tensor(ufc.macro_A.data(), ufc.macro_w(),
+                              vertex_coordinates[0].data(),
+                              vertex_coordinates[1].data(),
+                              local_facet0, local_facet1);
+
+    // Get row dofs on macro element
+    const ArrayView<const dolfin::la_index> rows0
+      = dofmap0.cell_dofs(cell0.index());
+    const ArrayView<const dolfin::la_index> rows1
+      = dofmap0.cell_dofs(cell1.index());
+    macro_rows.resize(rows0.size() + rows1.size());
+    std::copy(rows0.begin(), rows0.end(), macro_rows.begin());
+    std::copy(rows1.begin(), rows1.end(), macro_rows.begin() + rows0.size());
+
+    // Get entries of x on macro element
+    const std::size_t n0 = _x_offsets[cell0.index() + 1]
+      - _x_offsets[cell0.index()];
+    const std::size_t n1 = _x_offsets[cell1.index() + 1]
+      - _x_offsets[cell1.index()];
+    _x_cell.resize(n0 + n1);
+    gather_cell_values(cell0.index(), 0);
+    gather_cell_values(cell1.index(), n0);
+
+    // Compute and add facet contribution to action
+    add_element_action(y, ufc.macro_A, _x_cell, macro_rows.data(),
+                       macro_rows.size(), n0 + n1, y_cell);
+  }
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::gather_cell_values(std::size_t cell_index,
+                                            std::size_t offset) const
+{
+  const std::size_t* positions = &_x_positions[_x_offsets[cell_index]];
+  const std::size_t n = _x_offsets[cell_index + 1] - _x_offsets[cell_index];
+  dolfin_assert(offset + n <= _x_cell.size());
+  for (std::size_t j = 0; j < n; ++j)
+    _x_cell[offset + j] = _x_values[positions[j]];
+}
+//-----------------------------------------------------------------------------
+void MatrixFreeOperator::add_element_action(GenericVector& y,
+                                            const std::vector<double>& A,
+                                            const std::vector<double>& x,
+                                            const dolfin::la_index* rows,
+                                            std::size_t m, std::size_t n,
+                                            std::vector<double>& y_element)
+{
+  dolfin_assert(A.size() >= m*n);
+  dolfin_assert(x.size() == n);
+
+  // Compute y_element = A x (element tensor is row-major)
+  y_element.resize(m);
+  for (std::size_t i = 0; i < m; ++i)
+  {
+    const double* A_i = &A[i*n];
+    double sum = 0.0;
+    for (std::size_t j = 0; j < n; ++j)
+      sum += A_i[j]*x[j];
+    y_element[i] = sum;
+  }
+
+  // Add to global vector
+  y.add(y_element.data(), m, rows);
+}
+//-----------------------------------------------------------------------------
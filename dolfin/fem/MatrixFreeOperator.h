@@ -0,0 +1,128 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-18
+// Last changed: 2014-03-18
+
+#ifndef __MATRIX_FREE_OPERATOR_H
+#define __MATRIX_FREE_OPERATOR_H
+
+#include <memory>
+#include <vector>
+#include <dolfin/common/types.h>
+#include <dolfin/la/LinearOperator.h>
+
+namespace dolfin
+{
+
+  // Forward declarations
+  class Form;
+  class GenericVector;
+  class UFC;
+
+  /// This class defines a linear operator from a bilinear form. The
+  /// global matrix is never assembled; instead the action y = Ax is
+  /// computed cell by cell from the element tensors of the form,
+  /// which are tabulated on the fly. The memory required is thus
+  /// proportional to the size of a vector rather than to the number
+  /// of nonzeros of the matrix.
+  ///
+  /// The operator may be passed to any Krylov solver that supports
+  /// the _LinearOperator_ interface (PETSc and uBLAS).
+  ///
+  /// Cell, exterior facet and interior facet integrals are supported,
+  /// including integrals over subdomains. Interior facet integrals
+  /// are not yet supported in parallel.
+
+  class MatrixFreeOperator : public LinearOperator
+  {
+  public:
+
+    /// Create operator from bilinear form
+    explicit MatrixFreeOperator(const Form& a);
+
+    /// Create operator from bilinear form (shared pointer version)
+    explicit MatrixFreeOperator(std::shared_ptr<const Form> a);
+
+    /// Destructor
+    ~MatrixFreeOperator();
+
+    /// Return size of given dimension
+    std::size_t size(std::size_t dim) const;
+
+    /// Compute matrix-vector product y = Ax
+    void mult(const GenericVector& x, GenericVector& y) const;
+
+    /// Return informal string representation (pretty-print)
+    std::string str(bool verbose) const;
+
+  private:
+
+    // Create vector matching the parallel layout of the function
+    // space of the given form argument
+    static std::shared_ptr<GenericVector> create_vector(const Form& a,
+                                                        std::size_t i);
+
+    // Check form and compute positions of cell dofs in gathered
+    // vector
+    void init();
+
+    // Compute action of cell integrals
+    void mult_cells(UFC& ufc, GenericVector& y) const;
+
+    // Compute action of exterior facet integrals
+    void mult_exterior_facets(UFC& ufc, GenericVector& y) const;
+
+    // Compute action of interior facet integrals
+    void mult_interior_facets(UFC& ufc, GenericVector& y) const;
+
+    // Gather entries of x for the given cell into _x_cell (starting
+    // at position offset)
+    void gather_cell_values(std::size_t cell_index,
+                            std::size_t offset) const;
+
+    // Compute y = A x for an m x n element tensor, and add to y
+    static void add_element_action(GenericVector& y,
+                                   const std::vector<double>& A,
+                                   const std::vector<double>& x,
+                                   const dolfin::la_index* rows,
+                                   std::size_t m, std::size_t n,
+                                   std::vector<double>& y_element);
+
+    // The bilinear form
+    std::shared_ptr<const Form> _a;
+
+    // Global column indices needed to compute the action on the
+    // local cells (sorted)
+    std::vector<dolfin::la_index> _x_indices;
+
+    // Position of each cell column dof in _x_indices, cell after
+    // cell (offsets given by _x_offsets)
+    std::vector<std::size_t> _x_positions;
+    std::vector<std::size_t> _x_offsets;
+
+    // Values of x gathered from other processes (work array)
+    mutable std::vector<double> _x_values;
+
+    // Values of x restricted to a cell or macro cell (work array)
+    mutable std::vector<double> _x_cell;
+
+  };
+
+}
+
+#endif
@@ -21,13 +21,12 @@
 // Modified by Anders Logg 2010-2013
 //
 // First added:  2010-11-10
-// Last changed: 2013-02-26
+// Last changed: 2014-03-21
 
 #ifdef HAS_OPENMP
 
 #include <algorithm>
-#include <map>
-#include <utility>
+#include <numeric>
 #include <vector>
 #include <omp.h>
 
@@ -40,10 +39,9 @@
 #include <dolfin/mesh/Facet.h>
 #include <dolfin/mesh/MeshData.h>
 #include <dolfin/mesh/MeshFunction.h>
-#include <dolfin/mesh/SubDomain.h>
-#include <dolfin/mesh/SubsetIterator.h>
 #include <dolfin/function/GenericFunction.h>
 #include <dolfin/function/FunctionSpace.h>
+#include "AssemblyScheduler.h"
 #include "GenericDofMap.h"
 #include "Form.h"
 #include "UFC.h"
@@ -65,7 +63,7 @@ void OpenMpAssembler::assemble(GenericTensor& A, const Form& a)
                  "The OpenMp assembler has not been tested in combination with MPI");
   }
 
-   dolfin_assert(a.ufc_form());
+  dolfin_assert(a.ufc_form());
 
   // All assembler functions above end up calling this function, which
   // in turn calls the assembler functions below to assemble over
@@ -87,6 +85,9 @@ void OpenMpAssembler::assemble(GenericTensor& A, const Form& a)
   // Check form
   AssemblerBase::check(a);
 
+  // Clear profile from previous assembly
+  profile.reset(parameters["profile_assembly"]);
+
   // Create data structure for local assembly data
   UFC ufc(a);
 
@@ -99,152 +100,19 @@ void OpenMpAssembler::assemble(GenericTensor& A, const Form& a)
   // Initialize global tensor
   init_global_tensor(A, a);
 
-  // FIXME: The below selections should be made robust
-
-  if (a.ufc_form()->has_interior_facet_integrals())
-    assemble_interior_facets(A, a, ufc, interior_facet_domains, 0);
+  // Assemble over cells and exterior facets
+  assemble_cells_and_exterior_facets(A, a, ufc, cell_domains,
+                                     exterior_facet_domains, 0);
 
-  if (a.ufc_form()->has_exterior_facet_integrals())
-  {
-    assemble_cells_and_exterior_facets(A, a, ufc, cell_domains,
-                                       exterior_facet_domains, 0);
-  }
-  else
-    assemble_cells(A, a, ufc, cell_domains, 0);
+  // Assemble over interior facets
+  assemble_interior_facets(A, a, ufc, interior_facet_domains, 0);
 
   // Finalize assembly of global tensor
   if (finalize_tensor)
     A.apply("add");
-}
-//-----------------------------------------------------------------------------
-void OpenMpAssembler::assemble_cells(GenericTensor& A, const Form& a,
-                                     UFC& _ufc,
-                                     const MeshFunction<std::size_t>* domains,
-                                     std::vector<double>* values)
-{
-  // Skip assembly if there are no cell integrals
-  if (!_ufc.form.has_cell_integrals())
-    return;
-
-  Timer timer("Assemble cells");
-
-  // Set number of OpenMP threads (from parameter systems)
-  const std::size_t num_threads = parameters["num_threads"];
-  omp_set_num_threads(num_threads);
-
-  // Extract mesh
-  const Mesh& mesh = a.mesh();
-
-  // FIXME: Check that UFC copy constructor is dealing with copying
-  // pointers correctly
-  // Dummy UFC object since each thread needs to created its own UFC object
-  UFC ufc(_ufc);
-
-  // Form rank
-  const std::size_t form_rank = ufc.form.rank();
-
-  // Cell integral
-  const ufc::cell_integral* integral = ufc.default_cell_integral.get();
-
-  // Check whether integral is domain-dependent
-  bool use_domains = domains && !domains->empty();
-
-  // Collect pointers to dof maps
-  std::vector<const GenericDofMap*> dofmaps;
-  for (std::size_t i = 0; i < form_rank; ++i)
-    dofmaps.push_back(a.function_space(i)->dofmap().get());
-
-  // Vector to hold dof map for a cell
-  std::vector<const std::vector<dolfin::la_index>* > dofs(form_rank);
-
-  // Color mesh
-  std::vector<std::size_t> coloring_type = a.coloring(mesh.topology().dim());
-  mesh.color(coloring_type);
-
-  // Get coloring data
-  std::map<const std::vector<std::size_t>,
-           std::pair<std::vector<std::size_t>, std::vector<std::vector<std::size_t> > > >::const_iterator mesh_coloring;
-  mesh_coloring = mesh.topology().coloring.find(coloring_type);
-  if (mesh_coloring == mesh.topology().coloring.end())
-  {
-    dolfin_error("OpenMPAssembler.cpp",
-                 "perform multithreaded assembly using OpenMP assembler",
-                 "Requested mesh coloring has not been computed");
-  }
-
-  // Get coloring data
-  const std::vector<std::vector<std::size_t> >& entities_of_color
-    = mesh_coloring->second.second;
-
-  // If assembling a scalar we need to ensure each threads assemble
-  // its own scalar
-  std::vector<double> scalars(num_threads, 0.0);
-
-  // Assemble over cells (loop over colours, then cells of same color)
-  const std::size_t num_colors = entities_of_color.size();
-  Progress p("Assembling cells (threaded)", num_colors);
-  for (std::size_t color = 0; color < num_colors; ++color)
-  {
-    // Get the array of cell indices of current color
-    const std::vector<std::size_t>& colored_cells = entities_of_color[color];
-
-    // Number of cells of current color
-    const int num_cells = colored_cells.size();
 
-    ufc::cell ufc_cell;
-    std::vector<double> vertex_coordinates;
-
-    // OpenMP test loop over cells of the same color
-#pragma omp parallel for schedule(guided, 20) firstprivate(ufc, ufc_cell, vertex_coordinates, dofs, integral)
-    for (int cell_index = 0; cell_index < num_cells; ++cell_index)
-    {
-      // Cell index
-      const std::size_t index = colored_cells[cell_index];
-
-      // Create cell
-      const Cell cell(mesh, index);
-
-      // Get integral for sub domain (if any)
-      if (use_domains)
-        integral = ufc.get_cell_integral((*domains)[cell]);
-
-      // Skip integral if zero
-      if (!integral)
-        continue;
-
-      // Update to current cell
-      cell.get_cell_data(ufc_cell);
-      cell.get_vertex_coordinates(vertex_coordinates);
-      ufc.update(cell, vertex_coordinates, ufc_cell);
-
-      // Get local-to-global dof maps for cell
-      for (std::size_t i = 0; i < form_rank; ++i)
-        dofs[i] = &(dofmaps[i]->cell_dofs(index));
-
-      // Tabulate cell tensor
-      integral->tabulate_tensor(ufc.A.data(),
-                                ufc.w(),
-                                vertex_coordinates.data(),
-                                ufc_cell.orientation);
-
-      // Add entries to global tensor
-      if (values && form_rank == 0)
-        (*values)[cell_index] = ufc.A[0];
-      else if (form_rank == 0)
-        scalars[omp_get_thread_num()] += ufc.A[0];
-      else
-        A.add(ufc.A.data(), dofs);
-    }
-    p++;
-  }
-
-  // If we assemble a scalar we need to sum the contributions from each thread
-  if (form_rank == 0)
-  {
-    const double scalar_sum = std::accumulate(scalars.begin(), scalars.end(),
-                                              0.0);
-    A.add(&scalar_sum, dofs);
-  }
+  // Report time spent in each phase of local assembly
+  profile.register_timings();
 }
 //-----------------------------------------------------------------------------
 void OpenMpAssembler::assemble_cells_and_exterior_facets(GenericTensor& A,
@@ -253,39 +121,36 @@ void OpenMpAssembler::assemble_cells_and_exterior_facets(GenericTensor& A,
           const MeshFunction<std::size_t>* exterior_facet_domains,
           std::vector<double>* values)
 {
+  // Skip assembly if there are no cell or exterior facet integrals
+  const bool has_cell_integrals = _ufc.form.has_cell_integrals();
+  const bool has_facet_integrals = _ufc.form.has_exterior_facet_integrals();
+  if (!has_cell_integrals && !has_facet_integrals)
+    return;
+
   Timer timer("Assemble cells and exterior facets");
 
   // Set number of OpenMP threads (from parameter systems)
-  const int num_threads = parameters["num_threads"];
+  const std::size_t num_threads = parameters["num_threads"];
   omp_set_num_threads(num_threads);
 
   // Extract mesh
   const Mesh& mesh = a.mesh();
-
-  // Compute facets and facet - cell connectivity if not already computed
   const std::size_t D = mesh.topology().dim();
-  mesh.init(D - 1);
-  mesh.init(D - 1, D);
-  dolfin_assert(mesh.ordered());
-
-  // Get connectivity
-  const MeshConnectivity& connectivity = mesh.topology()(D, D - 1);
-  dolfin_assert(!connectivity.empty());
 
-  // Dummy UFC object since each thread needs to created its own UFC object
-  UFC ufc(_ufc);
+  // Compute facets and facet - cell connectivity if not already computed
+  if (has_facet_integrals)
+  {
+    mesh.init(D - 1);
+    mesh.init(D - 1, D);
+    dolfin_assert(mesh.ordered());
+  }
 
   // Form rank
-  const std::size_t form_rank = ufc.form.rank();
-
-  // Cell and facet integrals
-  ufc::cell_integral* cell_integral = ufc.default_cell_integral.get();
-  ufc::exterior_facet_integral* facet_integral
-    = ufc.default_exterior_facet_integral.get();
+  const std::size_t form_rank = _ufc.form.rank();
 
   // Check whether integrals are domain-dependent
-  bool use_cell_domains = cell_domains && !cell_domains->empty();
-  bool use_exterior_facet_domains
+  const bool use_cell_domains = cell_domains && !cell_domains->empty();
+  const bool use_exterior_facet_domains
     = exterior_facet_domains && !exterior_facet_domains->empty();
 
   // Collect pointers to dof maps
@@ -293,149 +158,178 @@ void OpenMpAssembler::assemble_cells_and_exterior_facets(GenericTensor& A,
   for (std::size_t i = 0; i < form_rank; ++i)
     dofmaps.push_back(a.function_space(i)->dofmap().get());
 
-  // Vector to hold dof maps for a cell
-  std::vector<const std::vector<dolfin::la_index>* > dofs(form_rank);
-
-  // FIXME: Pass or determine coloring type
-  // Define graph type
-  std::vector<std::size_t> coloring_type = a.coloring(mesh.topology().dim());
-  mesh.color(coloring_type);
-
-  // Get coloring data
-  std::map<const std::vector<std::size_t>,
-           std::pair<std::vector<std::size_t>,
-                     std::vector<std::vector<std::size_t> > > >::const_iterator
-    mesh_coloring;
-  mesh_coloring = mesh.topology().coloring.find(coloring_type);
-  if (mesh_coloring == mesh.topology().coloring.end())
-  {
-    dolfin_error("OpenMPAssembler.cpp",
-                 "perform multithreaded assembly using OpenMP assembler",
-                 "Requested mesh coloring has not been computed");
-  }
-
-  // Get coloring data
-  const std::vector<std::vector<std::size_t> >& entities_of_color
-  = mesh_coloring->second.second;
+  // Split cells into chunks
+  std::vector<std::size_t> cells(mesh.num_cells());
+  for (std::size_t i = 0; i < cells.size(); ++i)
+    cells[i] = i;
+  const std::size_t rows_per_cell
+    = form_rank > 0 ? dofmaps[0]->max_cell_dimension() : 1;
+  AssemblyScheduler scheduler(mesh, D, cells,
+                    AssemblyScheduler::default_chunk_size(rows_per_cell));
 
   // If assembling a scalar we need to ensure each threads assemble
   // its own scalar
   std::vector<double> scalars(num_threads, 0.0);
 
-  // UFC cell and vertex coordinates
-  ufc::cell ufc_cell;
-  std::vector<double> vertex_coordinates;
-
-  // Assemble over cells (loop over colors, then cells of same color)
-  const std::size_t num_colors = entities_of_color.size();
-  for (std::size_t color = 0; color < num_colors; ++color)
+  Progress p(AssemblerBase::progress_message(A.rank(),
+                                             "cells (threaded)"),
+             scheduler.num_chunks());
+  #pragma omp parallel
   {
-    // Get the array of cell indices of current color
-    const std::vector<std::size_t>& colored_cells = entities_of_color[color];
+    // Each thread needs its own UFC object
+    UFC ufc(_ufc);
 
-    // Number of cells of current color
-    const int num_cell_in_color = colored_cells.size();
+    // Each thread records its own profile
+    AssemblyProfile thread_profile;
+    thread_profile.reset(profile.enabled());
 
-    // OpenMP test loop over cells of the same color
-    Progress p(AssemblerBase::progress_message(A.rank(), "cells"), num_colors);
-#pragma omp parallel for schedule(guided, 20) firstprivate(ufc, ufc_cell, vertex_coordinates, dofs, cell_integral, facet_integral)
-    for (int index = 0; index < num_cell_in_color; ++index)
-    {
-      // Cell index
-      const std::size_t cell_index = colored_cells[index];
+    // Cell and facet integrals
+    ufc::cell_integral* cell_integral = ufc.default_cell_integral.get();
+    ufc::exterior_facet_integral* facet_integral
+      = ufc.default_exterior_facet_integral.get();
 
-      // Create cell
-      const Cell cell(mesh, cell_index);
-
-      // Get integral for sub domain (if any)
-      if (use_cell_domains)
-        cell_integral = ufc.get_cell_integral((*cell_domains)[cell_index]);
+    // Local data
+    ufc::cell ufc_cell;
+    std::vector<double> vertex_coordinates;
+    std::vector<ArrayView<const dolfin::la_index> > dofs(form_rank);
 
-      // Update to current cell
-      cell.get_cell_data(ufc_cell);
-      cell.get_vertex_coordinates(vertex_coordinates);
-      ufc.update(cell, vertex_coordinates, ufc_cell);
+    std::size_t chunk;
+    while (scheduler.acquire(chunk))
+    {
+      const ArrayView<const std::size_t> chunk_cells = scheduler.chunk(chunk);
+      for (std::size_t c = 0; c < chunk_cells.size(); ++c)
+      {
+        // Create cell
+        const std::size_t cell_index = chunk_cells[c];
+        const Cell cell(mesh, cell_index);
 
-      // Get local-to-global dof maps for cell
-      for (std::size_t i = 0; i < form_rank; ++i)
-        dofs[i] = &(dofmaps[i]->cell_dofs(cell_index));
+        // Get integral for sub domain (if any)
+        if (use_cell_domains)
+          cell_integral = ufc.get_cell_integral((*cell_domains)[cell_index]);
 
-      // Get number of entries in cell tensor
-      std::size_t dim = 1;
-      for (std::size_t i = 0; i < form_rank; ++i)
-        dim *= dofs[i]->size();
+        // Check if cell has any exterior facets
+        bool on_boundary = false;
+        if (has_facet_integrals)
+        {
+          for (FacetIterator facet(cell); !facet.end(); ++facet)
+          {
+            if (facet->exterior())
+            {
+              on_boundary = true;
+              break;
+            }
+          }
+        }
 
-      // Tabulate cell tensor if we have a cell_integral
-      if (cell_integral)
-      {
-        cell_integral->tabulate_tensor(ufc.A.data(),
-                                       ufc.w(),
-                                       vertex_coordinates.data(),
-                                       ufc_cell.orientation);
-      }
-      else
-        std::fill(ufc.A.begin(), ufc.A.end(), 0.0);
+        // Skip cell if there is nothing to compute
+        if (!cell_integral && !on_boundary)
+          continue;
 
-      // Assemble over external facet
-      for (FacetIterator facet(cell); !facet.end(); ++facet)
-      {
-        // Only consider exterior facets
-        if (!facet->exterior())
+        // Get local-to-global dof maps for cell
+        bool empty_dofmap = false;
+        for (std::size_t i = 0; i < form_rank; ++i)
         {
-          p++;
-          continue;
+          dofs[i] = dofmaps[i]->cell_dofs(cell_index);
+          empty_dofmap = empty_dofmap || dofs[i].size() == 0;
         }
+        if (empty_dofmap)
+          continue;
 
-        // Get local facet index
-        const std::size_t local_facet = cell.index(*facet);
+        // Get number of entries in cell tensor
+        std::size_t dim = 1;
+        for (std::size_t i = 0; i < form_rank; ++i)
+          dim *= dofs[i].size();
 
-        // Get integral for sub domain (if any)
-        if (use_exterior_facet_domains)
+        // Update to current cell
+        thread_profile.start();
+        cell.get_cell_data(ufc_cell);
+        cell.get_vertex_coordinates(vertex_coordinates);
+        ufc.update(cell, vertex_coordinates, ufc_cell);
+        thread_profile.stop(AssemblyProfile::update);
+
+        // Tabulate cell tensor if we have a cell integral
+        bool add = false;
+        if (cell_integral)
         {
-          // Get global facet index
-          const std::size_t facet_index = connectivity(cell_index)[local_facet];
-          facet_integral = ufc.get_exterior_facet_integral((*exterior_facet_domains)[facet_index]);
+          cell_integral->tabulate_tensor(ufc.A.data(), ufc.w(),
+                                         vertex_coordinates.data(),
+                                         ufc_cell.orientation);
+          thread_profile.count(AssemblyProfile::cell);
+          add = true;
         }
+        else
+          std::fill(ufc.A.begin(), ufc.A.end(), 0.0);
 
-        // Skip integral if zero
-        if (!facet_integral)
-          continue;
+        // Assemble over exterior facets of cell
+        if (on_boundary)
+        {
+          for (FacetIterator facet(cell); !facet.end(); ++facet)
+          {
+            // Only consider exterior facets
+            if (!facet->exterior())
+              continue;
+
+            // Get integral for sub domain (if any)
+            if (use_exterior_facet_domains)
+            {
+              facet_integral = ufc.get_exterior_facet_integral(
+                (*exterior_facet_domains)[facet->index()]);
+            }
+
+            // Skip integral if zero
+            if (!facet_integral)
+              continue;
+
+            // Tabulate tensor
+            const std::size_t local_facet = cell.index(*facet);
+            facet_integral->tabulate_tensor(ufc.A_facet.data(), ufc.w(),
+                                            vertex_coordinates.data(),
+                                            local_facet);
+
+            // Add facet contribution
+            for (std::size_t i = 0; i < dim; ++i)
+              ufc.A[i] += ufc.A_facet[i];
+            thread_profile.count(AssemblyProfile::exterior_facet);
+            add = true;
+          }
+        }
 
-        // FIXME: Do we really need an update version with the local
-        //        facet index?
-        // Update UFC object
-        ufc_cell.local_facet = local_facet;
-        ufc.update(cell, vertex_coordinates, ufc_cell);
+        thread_profile.stop(AssemblyProfile::tabulate);
 
-        // Tabulate tensor
-        facet_integral->tabulate_tensor(ufc.A_facet.data(),
-                                        ufc.w(),
-                                        vertex_coordinates.data(),
-                                        local_facet);
+        // Skip if nothing was computed
+        if (!add)
+          continue;
 
-        // Add facet contribution
-        for (std::size_t i = 0; i < dim; ++i)
-          ufc.A[i] += ufc.A_facet[i];
+        // Add entries to global tensor
+        if (values && form_rank == 0)
+          (*values)[cell_index] = ufc.A[0];
+        else if (form_rank == 0)
+          scalars[omp_get_thread_num()] += ufc.A[0];
+        else
+          A.add(ufc.A.data(), dofs);
+        thread_profile.stop(AssemblyProfile::insert);
+        thread_profile.inserted(dofs);
       }
 
-      // Add entries to global tensor
-      if (values && form_rank == 0)
-        (*values)[cell_index] = ufc.A[0];
-      else if (form_rank == 0)
-        scalars[omp_get_thread_num()] += ufc.A[0];
-      else
-        A.add(&ufc.A[0], dofs);
+      scheduler.release(chunk);
+
+      #pragma omp critical (dolfin_openmp_assembler_progress)
+      p++;
     }
 
-    p++;
+    // Combine profiles of threads
+    #pragma omp critical (dolfin_openmp_assembler_profile)
+    profile.add(thread_profile);
   }
 
-  // If we assemble a scalar we need to sum the contributions from each thread
-  if (form_rank == 0)
+  // If we assemble a scalar we need to sum the contributions from
+  // each thread
+  if (form_rank == 0 && !values)
   {
-    const double scalar_sum = std::accumulate(scalars.begin(),
-                                              scalars.end(), 0.0);
-    A.add(&scalar_sum, dofs);
+    const double scalar_sum = std::accumulate(scalars.begin(), scalars.end(),
+                                              0.0);
+    const std::vector<ArrayView<const dolfin::la_index> > no_dofs;
+    A.add(&scalar_sum, no_dofs);
   }
 }
 //-----------------------------------------------------------------------------
@@ -444,56 +338,23 @@ void OpenMpAssembler::assemble_interior_facets(GenericTensor& A, const Form& a,
                                        const MeshFunction<std::size_t>* domains,
                                        std::vector<double>* values)
 {
-  warning("OpenMpAssembler::assemble_interior_facets is untested.");
-
-  // Extract mesh
-  const Mesh& mesh = a.mesh();
-
-  // Topological dimension
-  const std::size_t D = mesh.topology().dim();
-
-  dolfin_assert(!values);
-
   // Skip assembly if there are no interior facet integrals
   if (!_ufc.form.has_interior_facet_integrals())
     return;
 
+  dolfin_assert(!values);
+
   Timer timer("Assemble interior facets");
 
   // Set number of OpenMP threads (from parameter systems)
-  omp_set_num_threads(parameters["num_threads"]);
-
-  // Get integral for sub domain (if any)
-
-  bool use_domains = domains && !domains->empty();
-  if (use_domains)
-  {
-    dolfin_error("OpenMPAssembler.cpp",
-                 "perform multithreaded assembly using OpenMP assembler",
-                 "Subdomains are not yet handled");
-  }
-
-  // Color mesh
-  std::vector<std::size_t> coloring_type = a.coloring(D - 1);
-  mesh.color(coloring_type);
-
-  // Dummy UFC object since each thread needs to created its own UFC object
-  UFC ufc(_ufc);
-
-  // Form rank
-  const std::size_t form_rank = ufc.form.rank();
-
-  // Collect pointers to dof maps
-  std::vector<const GenericDofMap*> dofmaps;
-  for (std::size_t i = 0; i < form_rank; ++i)
-    dofmaps.push_back(a.function_space(i)->dofmap().get());
+  const std::size_t num_threads = parameters["num_threads"];
+  omp_set_num_threads(num_threads);
 
-  // Vector to hold dofs for cells
-  std::vector<std::vector<dolfin::la_index> > macro_dofs(form_rank);
+  // Extract mesh
+  const Mesh& mesh = a.mesh();
 
-  // Interior facet integral
-  const ufc::interior_facet_integral* integral
-    = ufc.default_interior_facet_integral.get();
+  // Topological dimension
+  const std::size_t D = mesh.topology().dim();
 
   // Compute facets and facet - cell connectivity if not already computed
   mesh.init(D - 1);
@@ -513,117 +374,151 @@ void OpenMpAssembler::assemble_interior_facets(GenericTensor& A, const Form& a,
     }
   }
 
-  // Get coloring data
-  std::map<const std::vector<std::size_t>,
-           std::pair<std::vector<std::size_t>,
-                     std::vector<std::vector<std::size_t> > > >::const_iterator
-    mesh_coloring;
-  mesh_coloring = mesh.topology().coloring.find(coloring_type);
+  // Form rank
+  const std::size_t form_rank = _ufc.form.rank();
+
+  // Check whether integral is domain-dependent
+  const bool use_domains = domains && !domains->empty();
 
-  // Check that requested coloring has been computed
-  if (mesh_coloring == mesh.topology().coloring.end())
+  // Collect pointers to dof maps
+  std::vector<const GenericDofMap*> dofmaps;
+  for (std::size_t i = 0; i < form_rank; ++i)
+    dofmaps.push_back(a.function_space(i)->dofmap().get());
+
+  // Split interior facets into chunks
+  std::vector<std::size_t> facets;
+  for (FacetIterator facet(mesh); !facet.end(); ++facet)
   {
-    dolfin_error("OpenMPAssembler.cpp",
-                 "perform multithreaded assembly using OpenMP assembler",
-                 "Requested mesh coloring has not been computed");
+    if (!facet->exterior())
+      facets.push_back(facet->index());
   }
+  const std::size_t rows_per_facet
+    = form_rank > 0 ? 2*dofmaps[0]->max_cell_dimension() : 1;
+  AssemblyScheduler scheduler(mesh, D - 1, facets,
+                    AssemblyScheduler::default_chunk_size(rows_per_facet));
 
-  // Get coloring data
-  const std::vector<std::vector<std::size_t> >& entities_of_color
-    = mesh_coloring->second.second;
-
-  // UFC cells and vertex coordinates
-  ufc::cell ufc_cell0, ufc_cell1;
-  std::vector<double> vertex_coordinates0, vertex_coordinates1;
+  // If assembling a scalar we need to ensure each threads assemble
+  // its own scalar
+  std::vector<double> scalars(num_threads, 0.0);
 
-  // Assemble over interior facets (loop over colours, then cells of same color)
-  const std::size_t num_colors = entities_of_color.size();
-  for (std::size_t color = 0; color < num_colors; ++color)
+  Progress p(AssemblerBase::progress_message(A.rank(),
+                                             "interior facets (threaded)"),
+             scheduler.num_chunks());
+  #pragma omp parallel
   {
-    // Get the array of facet indices of current color
-    const std::vector<std::size_t>& colored_facets = entities_of_color[color];
+    // Each thread needs its own UFC object
+    UFC ufc(_ufc);
 
-    // Number of facets of current color
-    const int num_facets = colored_facets.size();
+    // Each thread records its own profile
+    AssemblyProfile thread_profile;
+    thread_profile.reset(profile.enabled());
 
-    // OpenMP test loop over cells of the same color
-    Progress p(AssemblerBase::progress_message(A.rank(), "interior facets"),
-               mesh.num_facets());
-#pragma omp parallel for schedule(guided, 20) firstprivate(ufc, ufc_cell0, ufc_cell1, vertex_coordinates0, vertex_coordinates1, macro_dofs, integral)
-    for (int facet_index = 0; facet_index < num_facets; ++facet_index)
-    {
-      // Facet index
-      const std::size_t index = colored_facets[facet_index];
+    // Interior facet integral
+    ufc::interior_facet_integral* integral
+      = ufc.default_interior_facet_integral.get();
 
-      // Create cell
-      const Facet facet(mesh, index);
+    // Local data
+    ufc::cell ufc_cell0, ufc_cell1;
+    std::vector<double> vertex_coordinates0, vertex_coordinates1;
+    std::vector<std::vector<dolfin::la_index> > macro_dofs(form_rank);
 
-      // Only consider interior facets
-      if (facet.exterior())
+    std::size_t chunk;
+    while (scheduler.acquire(chunk))
+    {
+      const ArrayView<const std::size_t> chunk_facets
+        = scheduler.chunk(chunk);
+      for (std::size_t f = 0; f < chunk_facets.size(); ++f)
       {
-        p++;
-        continue;
-      }
-
-      // Get integral for sub domain (if any)
-      if (use_domains)
-        integral = ufc.get_interior_facet_integral((*domains)[facet]);
-
-      // Skip integral if zero
-      if (!integral)
-        continue;
+        // Create facet
+        const Facet facet(mesh, chunk_facets[f]);
 
-      // Get cells incident with facet
-      std::pair<const Cell, const Cell> cells
-        = facet.adjacent_cells(facet_orientation);
-      const Cell& cell0 = cells.first;
-      const Cell& cell1 = cells.second;
-
-      // Get local index of facet with respect to each cell
-      const std::size_t local_facet0 = cell0.index(facet);
-      const std::size_t local_facet1 = cell1.index(facet);
+        // Get integral for sub domain (if any)
+        if (use_domains)
+          integral = ufc.get_interior_facet_integral((*domains)[facet]);
 
-      // Update UFC cell
-      cell0.get_vertex_coordinates(vertex_coordinates0);
-      cell0.get_cell_data(ufc_cell0, local_facet0);
-      cell1.get_vertex_coordinates(vertex_coordinates1);
-      cell1.get_cell_data(ufc_cell1, local_facet1);
+        // Skip integral if zero
+        if (!integral)
+          continue;
 
-      // Update to current pair of cells
-      ufc.update(cell0, vertex_coordinates0, ufc_cell0,
-                 cell1, vertex_coordinates1, ufc_cell1);
+        // Get cells incident with facet
+        std::pair<const Cell, const Cell> cells
+          = facet.adjacent_cells(facet_orientation);
+        const Cell& cell0 = cells.first;
+        const Cell& cell1 = cells.second;
+
+        // Get local index of facet with respect to each cell
+        const std::size_t local_facet0 = cell0.index(facet);
+        const std::size_t local_facet1 = cell1.index(facet);
+
+        // Update UFC cell
+        thread_profile.start();
+        cell0.get_vertex_coordinates(vertex_coordinates0);
+        cell0.get_cell_data(ufc_cell0, local_facet0);
+        cell1.get_vertex_coordinates(vertex_coordinates1);
+        cell1.get_cell_data(ufc_cell1, local_facet1);
+
+        // Update to current pair of cells
+        ufc.update(cell0, vertex_coordinates0, ufc_cell0,
+                   cell1, vertex_coordinates1, ufc_cell1);
+        thread_profile.stop(AssemblyProfile::update);
+
+        // Tabulate dofs for each dimension on macro element
+        for (std::size_t i = 0; i < form_rank; i++)
+        {
+          // Get dofs for each cell
+          const ArrayView<const dolfin::la_index> cell_dofs0
+            = dofmaps[i]->cell_dofs(cell0.index());
+          const ArrayView<const dolfin::la_index> cell_dofs1
+            = dofmaps[i]->cell_dofs(cell1.index());
+
+          // Create space in macro dof vector
+          macro_dofs[i].resize(cell_dofs0.size() + cell_dofs1.size());
+
+          // Copy cell dofs into macro dof vector
+          std::copy(cell_dofs0.begin(), cell_dofs0.end(),
+                    macro_dofs[i].begin());
+          std::copy(cell_dofs1.begin(), cell_dofs1.end(),
+                    macro_dofs[i].begin() + cell_dofs0.size());
+        }
 
-      // Tabulate dofs for each dimension on macro element
-      for (std::size_t i = 0; i < form_rank; i++)
-      {
-        // Get dofs for each cell
-        const std::vector<dolfin::la_index>& cell_dofs0
-          = dofmaps[i]->cell_dofs(cell0.index());
-        const std::vector<dolfin::la_index>& cell_dofs1
-          = dofmaps[i]->cell_dofs(cell1.index());
-
-        // Create space in macro dof vector
-        macro_dofs[i].resize(cell_dofs0.size() + cell_dofs1.size());
-
-        // Copy cell dofs into macro dof vector
-        std::copy(cell_dofs0.begin(), cell_dofs0.end(), macro_dofs[i].begin());
-        std::copy(cell_dofs1.begin(), cell_dofs1.end(),
-                  macro_dofs[i].begin() + cell_dofs0.size());
+        // Tabulate interior facet tensor on macro element
+        integral->tabulate_tensor(ufc.macro_A.data(),
+                                  ufc.macro_w(),
+                                  vertex_coordinates0.data(),
+                                  vertex_coordinates1.data(),
+                                  local_facet0,
+                                  local_facet1);
+        thread_profile.stop(AssemblyProfile::tabulate);
+
+        // Add entries to global tensor
+        if (form_rank == 0)
+          scalars[omp_get_thread_num()] += ufc.macro_A[0];
+        else
+          A.add(ufc.macro_A.data(), macro_dofs);
+        thread_profile.stop(AssemblyProfile::insert);
+        thread_profile.count(AssemblyProfile::interior_facet);
+        thread_profile.inserted(macro_dofs);
       }
 
-      // Tabulate exterior interior facet tensor on macro element
-      integral->tabulate_tensor(ufc.macro_A.data(),
-                                ufc.macro_w(),
-                                vertex_coordinates0.data(),
-                                vertex_coordinates1.data(),
-                                local_facet0,
-                                local_facet1);
-
-      // Add entries to global tensor
-      A.add(ufc.macro_A.data(), macro_dofs);
+      scheduler.release(chunk);
 
+      #pragma omp critical (dolfin_openmp_assembler_progress)
       p++;
     }
+
+    // Combine profiles of threads
+    #pragma omp critical (dolfin_openmp_assembler_profile)
+    profile.add(thread_profile);
+  }
+
+  // If we assemble a scalar we need to sum the contributions from
+  // each thread
+  if (form_rank == 0)
+  {
+    const double scalar_sum = std::accumulate(scalars.begin(), scalars.end(),
+                                              0.0);
+    const std::vector<ArrayView<const dolfin::la_index> > no_dofs;
+    A.add(&scalar_sum, no_dofs);
   }
 }
 //-----------------------------------------------------------------------------
@@ -19,7 +19,7 @@
 // Modified by Ola Skavhaug, 2008.
 //
 // First added:  2007-01-17
-// Last changed: 2011-09-29
+// Last changed: 2014-03-14
 
 #ifndef __OPENMP_ASSEMBLER_H
 #define __OPENMP_ASSEMBLER_H
@@ -38,9 +38,14 @@ namespace dolfin
   class UFC;
   template<typename T> class MeshFunction;
 
-  /// This class provides automated assembly of linear systems, or
-  /// more generally, assembly of a sparse tensor from a given
-  /// variational form.
+  /// This class provides automated multi-threaded assembly of
+  /// linear systems, or more generally, assembly of a sparse tensor
+  /// from a given variational form.
+  ///
+  /// Cells and interior facets are split into chunks which are
+  /// distributed between threads by an AssemblyScheduler, such that
+  /// no two threads insert into the same rows of the global tensor
+  /// at the same time.
   ///
   /// The MeshFunction arguments can be used to specify assembly over
   /// subdomains of the mesh cells, exterior facets or interior
@@ -60,16 +65,11 @@ namespace dolfin
 
   private:
 
-    // Assemble over cells
-    void assemble_cells(GenericTensor& A, const Form& a, UFC& ufc,
-                        const MeshFunction<std::size_t>* domains,
-                        std::vector<double>* values);
-
-    // Assemble over exterior facets
+    // Assemble over cells and exterior facets
     void assemble_cells_and_exterior_facets(GenericTensor& A,
           const Form& a, UFC& ufc, const MeshFunction<std::size_t>* cell_domains,
-				  const MeshFunction<std::size_t>* exterior_facet_domains,
-				  std::vector<double>* values);
+          const MeshFunction<std::size_t>* exterior_facet_domains,
+          std::vector<double>* values);
 
     // Assemble over interior facets
     void assemble_interior_facets(GenericTensor& A, const Form& a, UFC& ufc,
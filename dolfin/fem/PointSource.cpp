@@ -118,7 +118,7 @@ void PointSource::apply(GenericVector& b)
 
   // Compute local-to-global mapping
   dolfin_assert(_V->dofmap());
-  const std::vector<dolfin::la_index>& dofs
+  const ArrayView<const dolfin::la_index> dofs
     = _V->dofmap()->cell_dofs(cell.index());
 
   // Add values to vector
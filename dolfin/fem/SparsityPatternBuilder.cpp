@@ -19,12 +19,14 @@
 // Modified by Anders Logg 2008-2013
 //
 // First added:  2007-05-24
-// Last changed: 2013-09-24
+// Last changed: 2014-03-19
 
 #include <dolfin/common/timing.h>
 #include <dolfin/common/MPI.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include <dolfin/la/GenericSparsityPattern.h>
 #include <dolfin/mesh/Cell.h>
+#include <dolfin/mesh/DistributedMeshTools.h>
 #include <dolfin/mesh/Facet.h>
 #include <dolfin/mesh/Mesh.h>
 #include <dolfin/function/FunctionSpace.h>
@@ -74,7 +76,14 @@ void SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
     return;
 
   // Create vector to point to dofs
-  std::vector<const std::vector<dolfin::la_index>* > dofs(rank);
+  std::vector<ArrayView<const dolfin::la_index> > dofs(rank);
+
+  // The dofs of all cells and facets are collected as dense blocks
+  // and inserted at once, which allows the sparsity pattern to build
+  // its rows in compressed storage (possibly multi-threaded)
+  std::vector<std::vector<dolfin::la_index> > block_entries(rank);
+  std::vector<std::vector<std::size_t> >
+    block_offsets(rank, std::vector<std::size_t>(1, 0));
 
   // FIXME: We iterate over the entire mesh even if the function space
   // is restricted. This works out fine since the local dofmap
@@ -89,10 +98,10 @@ void SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
     {
       // Tabulate dofs for each dimension and get local dimensions
       for (std::size_t i = 0; i < rank; ++i)
-        dofs[i] = &dofmaps[i]->cell_dofs(cell->index());
+        dofs[i] = dofmaps[i]->cell_dofs(cell->index());
 
-      // Insert non-zeroes in sparsity pattern
-      sparsity_pattern.insert(dofs);
+      // Add block of non-zeroes
+      add_block(block_entries, block_offsets, dofs);
       p++;
     }
   }
@@ -134,12 +143,13 @@ void SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
 
         // Tabulate dofs for each dimension and get local dimensions
         for (std::size_t i = 0; i < rank; ++i)
-          dofs[i] = &dofmaps[i]->cell_dofs(cell.index());
+          dofs[i] = dofmaps[i]->cell_dofs(cell.index());
 
-        // Insert dofs
-        sparsity_pattern.insert(dofs);
+        // Add block of non-zeroes
+        add_block(block_entries, block_offsets, dofs);
       }
-      else if (interior_facets && !exterior_facet)
+      else if (interior_facets && !exterior_facet
+               && facet->num_entities(D) == 2)
       {
         // Get cells incident with facet
         Cell cell0(mesh, facet->entities(D)[0]);
@@ -149,8 +159,10 @@ void SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
         for (std::size_t i = 0; i < rank; i++)
         {
           // Get dofs for each cell
-          const std::vector<dolfin::la_index>& cell_dofs0 = dofmaps[i]->cell_dofs(cell0.index());
-          const std::vector<dolfin::la_index>& cell_dofs1 = dofmaps[i]->cell_dofs(cell1.index());
+          const ArrayView<const dolfin::la_index> cell_dofs0
+            = dofmaps[i]->cell_dofs(cell0.index());
+          const ArrayView<const dolfin::la_index> cell_dofs1
+            = dofmaps[i]->cell_dofs(cell1.index());
 
           // Create space in macro dof vector
           macro_dofs[i].resize(cell_dofs0.size() + cell_dofs1.size());
@@ -159,12 +171,12 @@ void SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
           std::copy(cell_dofs0.begin(), cell_dofs0.end(), macro_dofs[i].begin());
           std::copy(cell_dofs1.begin(), cell_dofs1.end(), macro_dofs[i].begin() + cell_dofs0.size());
 
-          // Store pointer to macro dofs
-          dofs[i] = &macro_dofs[i];
+          // Store view of macro dofs
+          dofs[i].set(macro_dofs[i]);
         }
 
-        // Insert dofs
-        sparsity_pattern.insert(dofs);
+        // Add block of non-zeroes
+        add_block(block_entries, block_offsets, dofs);
       }
 
       p++;
@@ -177,23 +189,135 @@ void SparsityPatternBuilder::build(GenericSparsityPattern& sparsity_pattern,
 
     std::vector<dolfin::la_index> diagonal_dof(1, 0);
     for (std::size_t i = 0; i < rank; ++i)
-      dofs[i] = &diagonal_dof;
+      dofs[i].set(diagonal_dof);
 
     for (std::size_t j = local_range[0].first; j < local_range[0].second; j++)
     {
       diagonal_dof[0] = j;
 
-      // Insert diagonal non-zeroes in sparsity pattern
-      sparsity_pattern.insert(dofs);
+      // Add diagonal non-zero
+      add_block(block_entries, block_offsets, dofs);
       p++;
     }
   }
 
+  // Insert all blocks in sparsity pattern
+  const std::size_t num_threads = parameters["num_threads"];
+  sparsity_pattern.insert_blocks(block_entries, block_offsets, num_threads);
+
+  // Interior facets on process boundaries
+  if (interior_facets && MPI::size(mesh.mpi_comm()) > 1)
+    insert_shared_interior_facets(sparsity_pattern, mesh, dofmaps);
+
   // Finalize sparsity pattern (communicate off-process terms)
   if (finalize)
     sparsity_pattern.apply();
 }
 //-----------------------------------------------------------------------------
+void SparsityPatternBuilder::add_block(
+  std::vector<std::vector<dolfin::la_index> >& block_entries,
+  std::vector<std::vector<std::size_t> >& block_offsets,
+  const std::vector<ArrayView<const dolfin::la_index> >& dofs)
+{
+  dolfin_assert(block_entries.size() == dofs.size());
+  for (std::size_t i = 0; i < dofs.size(); ++i)
+  {
+    block_entries[i].insert(block_entries[i].end(), dofs[i].begin(),
+                            dofs[i].end());
+    block_offsets[i].push_back(block_entries[i].size());
+  }
+}
+//-----------------------------------------------------------------------------
+void SparsityPatternBuilder::insert_shared_interior_facets(
+  GenericSparsityPattern& sparsity_pattern,
+  const Mesh& mesh,
+  const std::vector<const GenericDofMap*> dofmaps)
+{
+  // The process with the lower rank inserts the entries for an
+  // interior facet on a process boundary (as in Assembler). The
+  // process with the higher rank sends the dofs of its cell.
+
+  const std::size_t rank = dofmaps.size();
+  const std::size_t D = mesh.topology().dim();
+  const MPI_Comm mpi_comm = mesh.mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+  const std::size_t process_number = MPI::rank(mpi_comm);
+
+  // Get shared facets, with sharing process and local index of facet
+  // on sharing process
+  const boost::unordered_map<unsigned int,
+                             std::vector<std::pair<unsigned int,
+                                                   unsigned int> > >
+    shared_facets = DistributedMeshTools::compute_shared_entities(mesh, D - 1);
+
+  // Pack local facet index on receiving process and, for each dofmap,
+  // number of dofs followed by the dofs
+  std::vector<std::vector<std::size_t> > send_buffer(num_processes);
+  boost::unordered_map<unsigned int,
+                       std::vector<std::pair<unsigned int,
+                                             unsigned int> > >::const_iterator
+    shared_facet;
+  for (shared_facet = shared_facets.begin();
+       shared_facet != shared_facets.end(); ++shared_facet)
+  {
+    // Skip facets that are not interior facets on a process boundary
+    const Facet facet(mesh, shared_facet->first);
+    if (shared_facet->second.size() != 1 || facet.num_entities(D) != 1
+        || facet.num_global_entities(D) != 2)
+    {
+      continue;
+    }
+
+    // Skip facets handled by this process
+    const std::size_t dest = shared_facet->second[0].first;
+    if (dest > process_number)
+      continue;
+
+    const std::size_t cell_index = facet.entities(D)[0];
+    std::vector<std::size_t>& buffer = send_buffer[dest];
+    buffer.push_back(shared_facet->second[0].second);
+    for (std::size_t i = 0; i < rank; ++i)
+    {
+      const ArrayView<const dolfin::la_index> dofs
+        = dofmaps[i]->cell_dofs(cell_index);
+      buffer.push_back(dofs.size());
+      buffer.insert(buffer.end(), dofs.begin(), dofs.end());
+    }
+  }
+
+  std::vector<std::vector<std::size_t> > recv_buffer;
+  MPI::all_to_all(mpi_comm, send_buffer, recv_buffer);
+
+  // Insert macro dofs for received facets
+  std::vector<std::vector<dolfin::la_index> > macro_dofs(rank);
+  std::vector<ArrayView<const dolfin::la_index> > dofs(rank);
+  for (std::size_t proc = 0; proc < num_processes; ++proc)
+  {
+    const std::vector<std::size_t>& buffer = recv_buffer[proc];
+    std::size_t pos = 0;
+    while (pos < buffer.size())
+    {
+      const Facet facet(mesh, buffer[pos++]);
+      dolfin_assert(facet.num_entities(D) == 1);
+      const std::size_t cell_index = facet.entities(D)[0];
+      for (std::size_t i = 0; i < rank; ++i)
+      {
+        const ArrayView<const dolfin::la_index> local_dofs
+          = dofmaps[i]->cell_dofs(cell_index);
+        const std::size_t num_remote_dofs = buffer[pos++];
+        macro_dofs[i].assign(local_dofs.begin(), local_dofs.end());
+        macro_dofs[i].insert(macro_dofs[i].end(), buffer.begin() + pos,
+                             buffer.begin() + pos + num_remote_dofs);
+        pos += num_remote_dofs;
+        dofs[i].set(macro_dofs[i]);
+      }
+
+      // Insert dofs
+      sparsity_pattern.insert(dofs);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void SparsityPatternBuilder::build_ccfem(GenericSparsityPattern& sparsity_pattern,
                                          const CCFEMForm& form)
 {
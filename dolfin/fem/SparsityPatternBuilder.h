@@ -19,13 +19,14 @@
 // Modified by Anders Logg 2008-2013
 //
 // First added:  2007-05-24
-// Last changed: 2013-09-24
+// Last changed: 2014-03-19
 
 #ifndef __SPARSITY_PATTERN_BUILDER_H
 #define __SPARSITY_PATTERN_BUILDER_H
 
 #include <utility>
 #include <vector>
+#include "dolfin/common/ArrayView.h"
 #include "dolfin/common/types.h"
 
 namespace dolfin
@@ -57,6 +58,20 @@ namespace dolfin
     static void build_ccfem(GenericSparsityPattern& sparsity_pattern,
                             const CCFEMForm& form);
 
+  private:
+
+    // Append dofs of a dense block to block_entries
+    static void
+      add_block(std::vector<std::vector<dolfin::la_index> >& block_entries,
+                std::vector<std::vector<std::size_t> >& block_offsets,
+                const std::vector<ArrayView<const dolfin::la_index> >& dofs);
+
+    // Insert entries for interior facets on process boundaries
+    static void
+      insert_shared_interior_facets(GenericSparsityPattern& sparsity_pattern,
+                                    const Mesh& mesh,
+                              const std::vector<const GenericDofMap*> dofmaps);
+
   };
 
 }
@@ -21,10 +21,12 @@
 // Modified by Martin Alnaes 2013
 //
 // First added:  2009-06-22
-// Last changed: 2013-08-01
+// Last changed: 2014-03-27
 
+#include <algorithm>
 #include <Eigen/Dense>
 #include <boost/array.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <dolfin/common/Timer.h>
 #include <dolfin/function/GenericFunction.h>
 #include <dolfin/function/FunctionSpace.h>
@@ -36,7 +38,9 @@
 #include <dolfin/mesh/Facet.h>
 #include <dolfin/mesh/MeshFunction.h>
 #include <dolfin/mesh/SubDomain.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "AssemblerBase.h"
+#include "AssemblyScheduler.h"
 #include "DirichletBC.h"
 #include "FiniteElement.h"
 #include "Form.h"
@@ -46,6 +50,62 @@
 
 using namespace dolfin;
 
+// Helper class for SystemAssembler::cell_wise_assembly and
+// SystemAssembler::facet_wise_assembly. Hands out chunks of entities
+// from an AssemblyScheduler when assembling with threads, and all
+// entities as a single chunk (without a scheduler) otherwise.
+class SystemAssemblerChunks
+{
+public:
+
+  SystemAssemblerChunks(const Mesh& mesh, std::size_t dim,
+                        const std::vector<std::size_t>& entities,
+                        std::size_t num_threads, std::size_t rows_per_entity)
+    : _entities(entities), _done(false)
+  {
+    if (num_threads > 0)
+    {
+      const std::size_t chunk_size
+        = AssemblyScheduler::default_chunk_size(rows_per_entity);
+      _scheduler.reset(new AssemblyScheduler(mesh, dim, entities,
+                                             chunk_size));
+    }
+  }
+
+  std::size_t num_chunks() const
+  { return _scheduler ? _scheduler->num_chunks() : 1; }
+
+  bool acquire(std::size_t& chunk)
+  {
+    if (_scheduler)
+      return _scheduler->acquire(chunk);
+    chunk = 0;
+    const bool found = !_done;
+    _done = true;
+    return found;
+  }
+
+  ArrayView<const std::size_t> chunk(std::size_t i) const
+  {
+    if (_scheduler)
+      return _scheduler->chunk(i);
+    return ArrayView<const std::size_t>(_entities.size(), _entities.data());
+  }
+
+  void release(std::size_t chunk)
+  {
+    if (_scheduler)
+      _scheduler->release(chunk);
+  }
+
+private:
+
+  const std::vector<std::size_t>& _entities;
+  boost::scoped_ptr<AssemblyScheduler> _scheduler;
+  bool _done;
+
+};
+
 //-----------------------------------------------------------------------------
 SystemAssembler::SystemAssembler(const Form& a, const Form& L)
   : _a(reference_to_no_delete_pointer(a)),
@@ -200,6 +260,9 @@ subdomains in SystemAssembler. Taking subdomains from bilinear form");
   AssemblerBase::check(*_a);
   AssemblerBase::check(*_L);
 
+  // Clear profile from previous assembly
+  profile.reset(parameters["profile_assembly"]);
+
   // Check that we have a bilinear and a linear form
   dolfin_assert(_a->rank() == 2);
   dolfin_assert(_L->rank() == 1);
@@ -241,9 +304,6 @@ subdomains in SystemAssembler. Taking subdomains from bilinear form");
   // Gather tensors
   boost::array<GenericTensor*, 2> tensors = { {A, b} };
 
-  // Allocate data
-  Scratch data(*_a, *_L);
-
   // Get Dirichlet dofs and values for local mesh
   DirichletBC::Map boundary_values;
   for (std::size_t i = 0; i < _bcs.size(); ++i)
@@ -293,8 +353,8 @@ problems is untested");
       && !ufc[1]->form.has_interior_facet_integrals())
   {
     // Assemble cell-wise (no interior facet integrals)
-    cell_wise_assembly(tensors, ufc, data, boundary_values,
-                       cell_domains, exterior_facet_domains);
+    cell_wise_assembly(tensors, ufc, boundary_values,
+                       cell_domains, exterior_facet_domains, profile);
   }
   else
   {
@@ -302,9 +362,9 @@ problems is untested");
     not_working_in_parallel("System assembly over interior facets");
 
     // Assemble facet-wise (including cell assembly)
-    facet_wise_assembly(tensors, ufc, data, boundary_values,
+    facet_wise_assembly(tensors, ufc, boundary_values,
                         cell_domains, exterior_facet_domains,
-                        interior_facet_domains);
+                        interior_facet_domains, profile);
   }
 
   // Finalise assembly
@@ -315,23 +375,26 @@ problems is untested");
     if (b)
       b->apply("add");
   }
+
+  // Report time spent in each phase of local assembly
+  profile.register_timings();
 }
 //-----------------------------------------------------------------------------
 void
 SystemAssembler::cell_wise_assembly(boost::array<GenericTensor*, 2>& tensors,
-                                    boost::array<UFC*, 2>& ufc,
-                                    Scratch& data,
+                                    boost::array<UFC*, 2>& _ufc,
                                     const DirichletBC::Map& boundary_values,
                                     const MeshFunction<std::size_t>* cell_domains,
-                                    const MeshFunction<std::size_t>* exterior_facet_domains)
+                                    const MeshFunction<std::size_t>* exterior_facet_domains,
+                                    AssemblyProfile& profile)
 {
   // Extract mesh
-  const Mesh& mesh = ufc[0]->dolfin_form.mesh();
+  const Mesh& mesh = _ufc[0]->dolfin_form.mesh();
 
   // Initialize entities if using external facet integrals
   dolfin_assert(mesh.ordered());
-  bool has_exterior_facet_integrals=ufc[0]->form.has_exterior_facet_integrals()
-      || ufc[1]->form.has_exterior_facet_integrals();
+  bool has_exterior_facet_integrals=_ufc[0]->form.has_exterior_facet_integrals()
+      || _ufc[1]->form.has_exterior_facet_integrals();
   if (has_exterior_facet_integrals)
   {
     // Compute facets and facet-cell connectivity if not already computed
@@ -343,164 +406,219 @@ SystemAssembler::cell_wise_assembly(boost::array<GenericTensor*, 2>& tensors,
   // Collect pointers to dof maps
   boost::array<std::vector<const GenericDofMap*>, 2> dofmaps;
   for (std::size_t i = 0; i < 2; ++i)
-    dofmaps[0].push_back(ufc[0]->dolfin_form.function_space(i)->dofmap().get());
-  dofmaps[1].push_back(ufc[1]->dolfin_form.function_space(0)->dofmap().get());
-
-  // Vector to hold dof map for a cell
-  boost::array<std::vector<const std::vector<dolfin::la_index>* >, 2> cell_dofs
-    = { {std::vector<const std::vector<dolfin::la_index>* >(2),
-         std::vector<const std::vector<dolfin::la_index>* >(1)} };
-
-  // Create pointers to hold integral objects
-  boost::array<const ufc::cell_integral*, 2> cell_integrals
-    = { {ufc[0]->default_cell_integral.get(), ufc[1]->default_cell_integral.get()} };
-
-  boost::array<const ufc::exterior_facet_integral*, 2> exterior_facet_integrals
-    = { { ufc[0]->default_exterior_facet_integral.get(),
-          ufc[1]->default_exterior_facet_integral.get()} };
+    dofmaps[0].push_back(_ufc[0]->dolfin_form.function_space(i)->dofmap().get());
+  dofmaps[1].push_back(_ufc[1]->dolfin_form.function_space(0)->dofmap().get());
 
   // Check whether integrals are domain-dependent
   bool use_cell_domains = cell_domains && !cell_domains->empty();
   bool use_exterior_facet_domains
     = exterior_facet_domains && !exterior_facet_domains->empty();
 
-  // Iterate over all cells
-  ufc::cell ufc_cell;
-  std::vector<double> vertex_coordinates;
-  Progress p("Assembling system (cell-wise)", mesh.num_cells());
-  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  // Split cells into chunks of cells to be assembled by threads
+  std::vector<std::size_t> cells(mesh.num_cells());
+  for (std::size_t i = 0; i < cells.size(); ++i)
+    cells[i] = i;
+  const std::size_t num_threads = get_num_threads(mesh);
+  SystemAssemblerChunks scheduler(mesh, mesh.topology().dim(), cells,
+                                  num_threads,
+                                  dofmaps[0][0]->max_cell_dimension());
+
+  Progress p("Assembling system (cell-wise)", scheduler.num_chunks());
+  #ifdef HAS_OPENMP
+  #pragma omp parallel num_threads(std::max(num_threads, (std::size_t) 1)) \
+    if (num_threads > 0)
+  #endif
   {
-    // Get cell vertex coordinates
-    cell->get_vertex_coordinates(vertex_coordinates);
-
-    // Loop over lhs and then rhs contributions
-    for (std::size_t form = 0; form < 2; ++form)
+    // Each thread needs its own UFC objects and local tensors
+    UFC A_ufc(*_ufc[0]), b_ufc(*_ufc[1]);
+    boost::array<UFC*, 2> ufc = { {&A_ufc, &b_ufc} };
+    Scratch data(ufc[0]->dolfin_form, ufc[1]->dolfin_form);
+
+    // Each thread records its own profile
+    AssemblyProfile thread_profile;
+    thread_profile.reset(profile.enabled());
+
+    // Vector to hold dof map for a cell
+    boost::array<std::vector<ArrayView<const dolfin::la_index> >, 2> cell_dofs
+      = { {std::vector<ArrayView<const dolfin::la_index> >(2),
+           std::vector<ArrayView<const dolfin::la_index> >(1)} };
+
+    // Create pointers to hold integral objects
+    boost::array<const ufc::cell_integral*, 2> cell_integrals
+      = { {ufc[0]->default_cell_integral.get(),
+           ufc[1]->default_cell_integral.get()} };
+
+    boost::array<const ufc::exterior_facet_integral*, 2> exterior_facet_integrals
+      = { { ufc[0]->default_exterior_facet_integral.get(),
+            ufc[1]->default_exterior_facet_integral.get()} };
+
+    // Iterate over chunks of cells
+    ufc::cell ufc_cell;
+    std::vector<double> vertex_coordinates;
+    std::size_t chunk;
+    while (scheduler.acquire(chunk))
     {
-      // Get rank (lhs=2, rhs=1)
-      const std::size_t rank = (form == 0) ? 2 : 1;
-
-      // Zero data
-      std::fill(data.Ae[form].begin(), data.Ae[form].end(), 0.0);
-
-      // Get cell integrals for sub domain (if any)
-      if (use_cell_domains)
+      const ArrayView<const std::size_t> chunk_cells = scheduler.chunk(chunk);
+      for (std::size_t c = 0; c < chunk_cells.size(); ++c)
       {
-        const std::size_t domain = (*cell_domains)[*cell];
-        cell_integrals[form] = ufc[form]->get_cell_integral(domain);
-      }
-
-      // Get local-to-global dof maps for cell
-      for (std::size_t dim = 0; dim < rank; ++dim)
-        cell_dofs[form][dim] = &(dofmaps[form][dim]->cell_dofs(cell->index()));
-
-      // Compute cell tensor (if required)
-      bool tensor_required = tensors[form] && cell_integrals[form];
-      if (rank == 2)
-      {
-        dolfin_assert(cell_dofs[0][1]);
-        tensor_required = cell_matrix_required(tensors[0], cell_integrals[0],
-                                               boundary_values,
-                                               *cell_dofs[0][1]);
-      }
+        // Create cell
+        const Cell cell(mesh, chunk_cells[c]);
 
-      if (tensor_required)
-      {
-        // Update to current cell
-        cell->get_cell_data(ufc_cell);
-        ufc[form]->update(*cell, vertex_coordinates, ufc_cell);
-
-        // Tabulate cell tensor
-        cell_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
-                                              ufc[form]->w(),
-                                              vertex_coordinates.data(),
-                                              ufc_cell.orientation);
-        for (std::size_t i = 0; i < data.Ae[form].size(); ++i)
-          data.Ae[form][i] += ufc[form]->A[i];
-      }
+        // Get cell vertex coordinates
+        cell.get_vertex_coordinates(vertex_coordinates);
 
-      // Compute exterior facet integral if present
-      if (has_exterior_facet_integrals)
-      {
-        for (FacetIterator facet(*cell); !facet.end(); ++facet)
+        // Loop over lhs and then rhs contributions
+        for (std::size_t form = 0; form < 2; ++form)
         {
-          // Only consider exterior facets
-          if (!facet->exterior())
-            continue;
+          // Get rank (lhs=2, rhs=1)
+          const std::size_t rank = (form == 0) ? 2 : 1;
+
+          // Zero data
+          std::fill(data.Ae[form].begin(), data.Ae[form].end(), 0.0);
 
-          // Get exterior facet integrals for sub domain (if any)
-          if (use_exterior_facet_domains)
+          // Get cell integrals for sub domain (if any)
+          if (use_cell_domains)
           {
-            const std::size_t domain = (*exterior_facet_domains)[*facet];
-            exterior_facet_integrals[form]
-              = ufc[form]->get_exterior_facet_integral(domain);
+            const std::size_t domain = (*cell_domains)[cell];
+            cell_integrals[form] = ufc[form]->get_cell_integral(domain);
           }
 
-          // Skip if there are no integrals
-          if (!exterior_facet_integrals[form])
-            continue;
-
-          // Extract local facet index
-          const std::size_t local_facet = cell->index(*facet);
+          // Get local-to-global dof maps for cell
+          for (std::size_t dim = 0; dim < rank; ++dim)
+            cell_dofs[form][dim] = dofmaps[form][dim]->cell_dofs(cell.index());
 
-          // Determine if tensor needs to be computed
-          bool tensor_required = tensors[form];
+          // Compute cell tensor (if required)
+          bool tensor_required = tensors[form] && cell_integrals[form];
           if (rank == 2)
           {
-            dolfin_assert(cell_dofs[0][1]);
-            tensor_required = cell_matrix_required(tensors[0],
-                                                   exterior_facet_integrals[0],
+            tensor_required = cell_matrix_required(tensors[0], cell_integrals[0],
                                                    boundary_values,
-                                                   *cell_dofs[0][1]);
+                                                   cell_dofs[0][1]);
           }
 
-          // Add exterior facet tensor
           if (tensor_required)
           {
             // Update to current cell
-            cell->get_cell_data(ufc_cell);
-            ufc[form]->update(*cell, vertex_coordinates, ufc_cell);
+            thread_profile.start();
+            cell.get_cell_data(ufc_cell);
+            ufc[form]->update(cell, vertex_coordinates, ufc_cell);
+            thread_profile.stop(AssemblyProfile::update);
 
-            // Tabulate exterior facet tensor
-            exterior_facet_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
-                                                            ufc[form]->w(),
-                                                      vertex_coordinates.data(),
-                                                      local_facet);
-            for (std::size_t i = 0; i < data.Ae[form].size(); i++)
+            // Tabulate cell tensor
+            cell_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
+                                                  ufc[form]->w(),
+                                                  vertex_coordinates.data(),
+                                                  ufc_cell.orientation);
+            for (std::size_t i = 0; i < data.Ae[form].size(); ++i)
               data.Ae[form][i] += ufc[form]->A[i];
+            thread_profile.stop(AssemblyProfile::tabulate);
+          }
+
+          // Compute exterior facet integral if present
+          if (has_exterior_facet_integrals)
+          {
+            for (FacetIterator facet(cell); !facet.end(); ++facet)
+            {
+              // Only consider exterior facets
+              if (!facet->exterior())
+                continue;
+
+              // Get exterior facet integrals for sub domain (if any)
+              if (use_exterior_facet_domains)
+              {
+                const std::size_t domain = (*exterior_facet_domains)[*facet];
+                exterior_facet_integrals[form]
+                  = ufc[form]->get_exterior_facet_integral(domain);
+              }
+
+              // Skip if there are no integrals
+              if (!exterior_facet_integrals[form])
+                continue;
+
+              // Extract local facet index
+              const std::size_t local_facet = cell.index(*facet);
+
+              // Determine if tensor needs to be computed
+              bool tensor_required = tensors[form];
+              if (rank == 2)
+              {
+                tensor_required = cell_matrix_required(tensors[0],
+                                                       exterior_facet_integrals[0],
+                                                       boundary_values,
+                                                       cell_dofs[0][1]);
+              }
+
+              // Add exterior facet tensor
+              if (tensor_required)
+              {
+                // Update to current cell
+                thread_profile.start();
+                cell.get_cell_data(ufc_cell);
+                ufc[form]->update(cell, vertex_coordinates, ufc_cell);
+                thread_profile.stop(AssemblyProfile::update);
+
+                // Tabulate exterior facet tensor
+                exterior_facet_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
+                                                                ufc[form]->w(),
+                                                          vertex_coordinates.data(),
+                                                          local_facet);
+                for (std::size_t i = 0; i < data.Ae[form].size(); i++)
+                  data.Ae[form][i] += ufc[form]->A[i];
+                thread_profile.stop(AssemblyProfile::tabulate);
+                if (form == 0)
+                  thread_profile.count(AssemblyProfile::exterior_facet);
+              }
+            }
           }
         }
-      }
-    }
 
-    // Check dofmap is the same for LHS columns and RHS vector
-    dolfin_assert(cell_dofs[1][0] == cell_dofs[0][1]);
+        // Check dofmap is the same for LHS columns and RHS vector
 
-    // Modify local matrix/element for Dirichlet boundary conditions
-    apply_bc(data.Ae[0].data(), data.Ae[1].data(), boundary_values,
-             *cell_dofs[0][0], *cell_dofs[0][1]);
+        // Modify local matrix/element for Dirichlet boundary conditions
+        thread_profile.start();
+        apply_bc(data.Ae[0].data(), data.Ae[1].data(), boundary_values,
+                 cell_dofs[0][0], cell_dofs[0][1]);
 
-    // Add entries to global tensor
-    for (std::size_t form = 0; form < 2; ++form)
-    {
-      if (tensors[form])
-        tensors[form]->add(data.Ae[form].data(), cell_dofs[form]);
+        // Add entries to global tensor
+        for (std::size_t form = 0; form < 2; ++form)
+        {
+          if (tensors[form])
+          {
+            tensors[form]->add(data.Ae[form].data(), cell_dofs[form]);
+            thread_profile.inserted(cell_dofs[form]);
+          }
+        }
+        thread_profile.stop(AssemblyProfile::insert);
+        thread_profile.count(AssemblyProfile::cell);
+      }
+
+      scheduler.release(chunk);
+
+      #ifdef HAS_OPENMP
+      #pragma omp critical (dolfin_system_assembler_progress)
+      #endif
+      p++;
     }
 
-    p++;
+    // Combine profiles of threads
+    #ifdef HAS_OPENMP
+    #pragma omp critical (dolfin_system_assembler_profile)
+    #endif
+    profile.add(thread_profile);
   }
 }
 //-----------------------------------------------------------------------------
 void
 SystemAssembler::facet_wise_assembly(boost::array<GenericTensor*, 2>& tensors,
-                                     boost::array<UFC*, 2>& ufc,
-                                     Scratch& data,
+                                     boost::array<UFC*, 2>& _ufc,
                                      const DirichletBC::Map& boundary_values,
                       const MeshFunction<std::size_t>* cell_domains,
                       const MeshFunction<std::size_t>* exterior_facet_domains,
-                      const MeshFunction<std::size_t>* interior_facet_domains)
+                      const MeshFunction<std::size_t>* interior_facet_domains,
+                                     AssemblyProfile& profile)
 {
   // Extract mesh
-  const Mesh& mesh = ufc[0]->dolfin_form.mesh();
+  const Mesh& mesh = _ufc[0]->dolfin_form.mesh();
 
   // Compute facets and facet - cell connectivity if not already computed
   const std::size_t D = mesh.topology().dim();
@@ -519,383 +637,473 @@ assembler");
   // Collect pointers to dof maps
   boost::array<std::vector<const GenericDofMap*>, 2> dofmaps;
   for (std::size_t i = 0; i < 2; ++i)
-    dofmaps[0].push_back(ufc[0]->dolfin_form.function_space(i)->dofmap().get());
-  dofmaps[1].push_back(ufc[1]->dolfin_form.function_space(0)->dofmap().get());
-
-  // Cell dofmaps [form][cell][form dim]
-  boost::array<boost::array<std::vector<const std::vector<dolfin::la_index>* >,
-                            2 >, 2> cell_dofs;
-  cell_dofs[0][0].resize(2);
-  cell_dofs[0][1].resize(2);
-  cell_dofs[1][0].resize(1);
-  cell_dofs[1][1].resize(1);
-
-  boost::array<Cell, 2> cell;
-  boost::array<std::size_t, 2> cell_index;
-  boost::array<std::size_t, 2> local_facet;
-
-  // Vectors to hold dofs for macro cells
-  boost::array<std::vector<std::vector<dolfin::la_index> >, 2> macro_dofs;
-  macro_dofs[0].resize(2);
-  macro_dofs[1].resize(1);
-
-  // Holders for UFC integrals
-  boost::array<const ufc::cell_integral*, 2> cell_integrals;
-  boost::array<const ufc::exterior_facet_integral*, 2> exterior_facet_integrals;
-
-  // Holder for number of dofs in macro-dofmap
-  std::vector<std::size_t> num_dofs(2);
-
-  // Iterate over facets
-  ufc::cell ufc_cell[2];
-  std::vector<double> vertex_coordinates[2];
-  Progress p("Assembling system (facet-wise)", mesh.num_facets());
-  for (FacetIterator facet(mesh); !facet.end(); ++facet)
+    dofmaps[0].push_back(_ufc[0]->dolfin_form.function_space(i)->dofmap().get());
+  dofmaps[1].push_back(_ufc[1]->dolfin_form.function_space(0)->dofmap().get());
+
+  // Split facets into chunks of facets to be assembled by threads
+  std::vector<std::size_t> facets(mesh.num_facets());
+  for (std::size_t i = 0; i < facets.size(); ++i)
+    facets[i] = i;
+  const std::size_t num_threads = get_num_threads(mesh);
+  SystemAssemblerChunks scheduler(mesh, D - 1, facets, num_threads,
+                                  2*dofmaps[0][0]->max_cell_dimension());
+
+  Progress p("Assembling system (facet-wise)", scheduler.num_chunks());
+  #ifdef HAS_OPENMP
+  #pragma omp parallel num_threads(std::max(num_threads, (std::size_t) 1)) \
+    if (num_threads > 0)
+  #endif
   {
-    // Number of cells sharing facet
-    const std::size_t num_cells = facet->num_entities(mesh.topology().dim());
-
-    // Interior facet
-    if (num_cells == 2)
+    // Each thread needs its own UFC objects and local tensors
+    UFC A_ufc(*_ufc[0]), b_ufc(*_ufc[1]);
+    boost::array<UFC*, 2> ufc = { {&A_ufc, &b_ufc} };
+    Scratch data(ufc[0]->dolfin_form, ufc[1]->dolfin_form);
+
+    // Each thread records its own profile
+    AssemblyProfile thread_profile;
+    thread_profile.reset(profile.enabled());
+
+    // Cell dofmaps [form][cell][form dim]
+    boost::array<boost::array<std::vector<ArrayView<const dolfin::la_index> >,
+                              2 >, 2> cell_dofs;
+    cell_dofs[0][0].resize(2);
+    cell_dofs[0][1].resize(2);
+    cell_dofs[1][0].resize(1);
+    cell_dofs[1][1].resize(1);
+
+    boost::array<Cell, 2> cell;
+    boost::array<std::size_t, 2> cell_index;
+    boost::array<std::size_t, 2> local_facet;
+
+    // Vectors to hold dofs for macro cells
+    boost::array<std::vector<std::vector<dolfin::la_index> >, 2> macro_dofs;
+    macro_dofs[0].resize(2);
+    macro_dofs[1].resize(1);
+
+    // Holders for UFC integrals
+    boost::array<const ufc::cell_integral*, 2> cell_integrals;
+    boost::array<const ufc::exterior_facet_integral*, 2> exterior_facet_integrals;
+
+    // Holder for number of dofs in macro-dofmap
+    std::vector<std::size_t> num_dofs(2);
+
+    // Iterate over chunks of facets
+    ufc::cell ufc_cell[2];
+    std::vector<double> vertex_coordinates[2];
+    std::size_t chunk;
+    while (scheduler.acquire(chunk))
     {
-      // Get cells incident with facet and assoiated data
-      for (std::size_t c = 0; c < 2; ++c)
+      const ArrayView<const std::size_t> chunk_facets = scheduler.chunk(chunk);
+      for (std::size_t f = 0; f < chunk_facets.size(); ++f)
       {
-        cell[c] = Cell(mesh, facet->entities(mesh.topology().dim())[c]);
-        cell_index[c] = cell[c].index();
-        local_facet[c] = cell[c].index(*facet);
-        cell[c].get_vertex_coordinates(vertex_coordinates[c]);
-        cell[c].get_cell_data(ufc_cell[c], local_facet[c]);
-      }
+        // Create facet
+        const Facet facet(mesh, chunk_facets[f]);
 
-      // Loop over lhs and then rhs facet contributions
-      for (std::size_t form = 0; form < 2; ++form)
-      {
-        // Get rank (lhs=2, rhs=1)
-        const std::size_t rank = (form == 0) ? 2 : 1;
-
-        // Reset some temp data
-        std::fill(ufc[form]->macro_A.begin(), ufc[form]->macro_A.end(), 0.0);
-
-        // Update UFC object
-        ufc[form]->update(cell[0], vertex_coordinates[0], ufc_cell[0],
-                          cell[1], vertex_coordinates[1], ufc_cell[1]);
+        // Number of cells sharing facet
+        const std::size_t num_cells = facet.num_entities(mesh.topology().dim());
 
-        // Compute number of dofs in macro dofmap
-        std::fill(num_dofs.begin(), num_dofs.begin() + rank, 0);
-        for (std::size_t c = 0; c < num_cells; ++c)
+        // Interior facet
+        if (num_cells == 2)
         {
-          for (std::size_t dim = 0; dim < rank; ++dim)
+          // Get cells incident with facet and assoiated data
+          for (std::size_t c = 0; c < 2; ++c)
           {
-            cell_dofs[form][c][dim]
-              = &(dofmaps[form][dim]->cell_dofs(cell_index[c]));
-            num_dofs[dim] += cell_dofs[form][c][dim]->size();
+            cell[c] = Cell(mesh, facet.entities(mesh.topology().dim())[c]);
+            cell_index[c] = cell[c].index();
+            local_facet[c] = cell[c].index(facet);
+            cell[c].get_vertex_coordinates(vertex_coordinates[c]);
+            cell[c].get_cell_data(ufc_cell[c], local_facet[c]);
           }
-        }
 
-        // Resize macro dof vector
-        for (std::size_t dim = 0; dim < rank; ++dim)
-          macro_dofs[form][dim].resize(num_dofs[dim]);
+          // Loop over lhs and then rhs facet contributions
+          for (std::size_t form = 0; form < 2; ++form)
+          {
+            // Get rank (lhs=2, rhs=1)
+            const std::size_t rank = (form == 0) ? 2 : 1;
 
-        // Facet integral
-        ufc::interior_facet_integral* interior_facet_integral
-          = ufc[form]->default_interior_facet_integral.get();
+            // Reset some temp data
+            std::fill(ufc[form]->macro_A.begin(), ufc[form]->macro_A.end(), 0.0);
 
-        // Get integral for sub domain (if any)
-        if (interior_facet_domains && !interior_facet_domains->empty())
-        {
-          const std::size_t domain = (*interior_facet_domains)[*facet];
-          interior_facet_integral
-            = ufc[form]->get_interior_facet_integral(domain);
-        }
+            // Update UFC object
+            thread_profile.start();
+            ufc[form]->update(cell[0], vertex_coordinates[0], ufc_cell[0],
+                              cell[1], vertex_coordinates[1], ufc_cell[1]);
+            thread_profile.stop(AssemblyProfile::update);
 
-        // Check if facet tensor is required
-        bool facet_tensor_required = tensors[form] && interior_facet_integral;
-        if (rank == 2)
-        {
-          for (std::size_t c =0; c < 2; ++c)
-          {
-            dolfin_assert(cell_dofs[form][c][1]);
-            facet_tensor_required = cell_matrix_required(tensors[form],
-                                                        interior_facet_integral,
-                                                        boundary_values,
-                                                        *cell_dofs[form][c][1]);
-            if (facet_tensor_required)
-              break;
-          }
-        }
+            // Compute number of dofs in macro dofmap
+            std::fill(num_dofs.begin(), num_dofs.begin() + rank, 0);
+            for (std::size_t c = 0; c < num_cells; ++c)
+            {
+              for (std::size_t dim = 0; dim < rank; ++dim)
+              {
+                cell_dofs[form][c][dim]
+                  = dofmaps[form][dim]->cell_dofs(cell_index[c]);
+                num_dofs[dim] += cell_dofs[form][c][dim].size();
+              }
+            }
 
-        // Compute facet contribution to tensor, if required
-        if (facet_tensor_required)
-        {
-          // Update to current pair of cells
-          ufc[form]->update(cell[0], vertex_coordinates[0], ufc_cell[0],
-                            cell[1], vertex_coordinates[1], ufc_cell[1]);
-
-          // Integrate over facet
-          interior_facet_integral->tabulate_tensor(ufc[form]->macro_A.data(),
-                                                   ufc[form]->macro_w(),
-                                                   vertex_coordinates[0].data(),
-                                                   vertex_coordinates[1].data(),
-                                                   local_facet[0],
-                                                   local_facet[1]);
-        }
+            // Resize macro dof vector
+            for (std::size_t dim = 0; dim < rank; ++dim)
+              macro_dofs[form][dim].resize(num_dofs[dim]);
 
-        // If we have local facet 0 for cell[i], compute cell
-        // contribution
-        for (std::size_t c = 0; c < num_cells; ++c)
-        {
-          if (local_facet[c] == 0)
-          {
-            // Cell integrals
-            cell_integrals[form] = ufc[form]->default_cell_integral.get();
+            // Facet integral
+            ufc::interior_facet_integral* interior_facet_integral
+              = ufc[form]->default_interior_facet_integral.get();
 
-            // Get cell integrals for sub domain (if any)
-            if (cell_domains && !cell_domains->empty())
+            // Get integral for sub domain (if any)
+            if (interior_facet_domains && !interior_facet_domains->empty())
             {
-              const std::size_t domain = (*cell_domains)[cell[c]];
-              cell_integrals[form] = ufc[form]->get_cell_integral(domain);
+              const std::size_t domain = (*interior_facet_domains)[facet];
+              interior_facet_integral
+                = ufc[form]->get_interior_facet_integral(domain);
             }
 
             // Check if facet tensor is required
-            bool cell_tensor_required = tensors[form] && cell_integrals[form];
+            bool facet_tensor_required = tensors[form] && interior_facet_integral;
             if (rank == 2)
             {
-              dolfin_assert(cell_dofs[form][c][1]);
-              cell_tensor_required
-                = cell_matrix_required(tensors[form],
-                                       cell_integrals[form],
-                                       boundary_values,
-                                       *cell_dofs[form][c][1]);
+              for (std::size_t c =0; c < 2; ++c)
+              {
+                facet_tensor_required = cell_matrix_required(tensors[form],
+                                                            interior_facet_integral,
+                                                            boundary_values,
+                                                            cell_dofs[form][c][1]);
+                if (facet_tensor_required)
+                  break;
+              }
             }
 
-            // Compute cell tensor, if required
-            if (cell_tensor_required)
+            // Compute facet contribution to tensor, if required
+            if (facet_tensor_required)
             {
-              ufc[form]->update(cell[c], vertex_coordinates[c], ufc_cell[c]);
-              cell_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
-                                                  ufc[form]->w(),
-                                                  vertex_coordinates[c].data(),
-                                                  ufc_cell[c].orientation);
+              // Update to current pair of cells
+              thread_profile.start();
+              ufc[form]->update(cell[0], vertex_coordinates[0], ufc_cell[0],
+                                cell[1], vertex_coordinates[1], ufc_cell[1]);
+              thread_profile.stop(AssemblyProfile::update);
+
+              // Integrate over facet
+              interior_facet_integral->tabulate_tensor(ufc[form]->macro_A.data(),
+                                                       ufc[form]->macro_w(),
+                                                       vertex_coordinates[0].data(),
+                                                       vertex_coordinates[1].data(),
+                                                       local_facet[0],
+                                                       local_facet[1]);
+              thread_profile.stop(AssemblyProfile::tabulate);
+            }
 
-              // FIXME: Can the below two block be consolidated?
-              const std::size_t nn = cell_dofs[form][c][0]->size();
-              if (form == 0)
+            // If we have local facet 0 for cell[i], compute cell
+            // contribution
+            for (std::size_t c = 0; c < num_cells; ++c)
+            {
+              if (local_facet[c] == 0)
               {
-                const std::size_t mm = cell_dofs[form][c][1]->size();
-                for (std::size_t i = 0; i < mm; i++)
+                // Cell integrals
+                cell_integrals[form] = ufc[form]->default_cell_integral.get();
+
+                // Get cell integrals for sub domain (if any)
+                if (cell_domains && !cell_domains->empty())
                 {
-                  for (std::size_t j = 0; j < nn; j++)
+                  const std::size_t domain = (*cell_domains)[cell[c]];
+                  cell_integrals[form] = ufc[form]->get_cell_integral(domain);
+                }
+
+                // Check if facet tensor is required
+                bool cell_tensor_required = tensors[form] && cell_integrals[form];
+                if (rank == 2)
+                {
+                  cell_tensor_required
+                    = cell_matrix_required(tensors[form],
+                                           cell_integrals[form],
+                                           boundary_values,
+                                           cell_dofs[form][c][1]);
+                }
+
+                // Compute cell tensor, if required
+                if (cell_tensor_required)
+                {
+                  thread_profile.start();
+                  ufc[form]->update(cell[c], vertex_coordinates[c], ufc_cell[c]);
+                  thread_profile.stop(AssemblyProfile::update);
+                  cell_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
+                                                      ufc[form]->w(),
+                                                      vertex_coordinates[c].data(),
+                                                      ufc_cell[c].orientation);
+
+                  // FIXME: Can the below two block be consolidated?
+                  const std::size_t nn = cell_dofs[form][c][0].size();
+                  if (form == 0)
                   {
-                    ufc[form]->macro_A[2*nn*mm*c + num_cells*i*nn + nn*c + j]
-                      += ufc[form]->A[i*nn + j];
+                    const std::size_t mm = cell_dofs[form][c][1].size();
+                    for (std::size_t i = 0; i < mm; i++)
+                    {
+                      for (std::size_t j = 0; j < nn; j++)
+                      {
+                        ufc[form]->macro_A[2*nn*mm*c + num_cells*i*nn + nn*c + j]
+                          += ufc[form]->A[i*nn + j];
+                      }
+                    }
                   }
+                  else
+                  {
+                    for (std::size_t i = 0; i < cell_dofs[form][c][0].size(); i++)
+                      ufc[form]->macro_A[nn*c + i] += ufc[form]->A[i];
+                  }
+                  thread_profile.stop(AssemblyProfile::tabulate);
                 }
+
+                if (form == 0)
+                  thread_profile.count(AssemblyProfile::cell);
               }
-              else
+
+              // Tabulate dofs on macro element
+              for (std::size_t dim = 0; dim < rank; ++dim)
               {
-                for (std::size_t i = 0; i < cell_dofs[form][c][0]->size(); i++)
-                  ufc[form]->macro_A[nn*c + i] += ufc[form]->A[i];
+                std::copy(cell_dofs[form][c][dim].begin(),
+                          cell_dofs[form][c][dim].end(),
+                          macro_dofs[form][dim].begin()
+                          + c*cell_dofs[form][0][dim].size());
               }
-            }
-          }
-
-          // Tabulate dofs on macro element
-          for (std::size_t dim = 0; dim < rank; ++dim)
+            } // End loop over cells sharing facet (c)
+          } // End loop over form (form)
+
+          // Modify local tensor for bcs
+          thread_profile.start();
+          apply_bc(ufc[0]->macro_A.data(), ufc[1]->macro_A.data(),
+                   boundary_values,
+                   ArrayView<const dolfin::la_index>(macro_dofs[0][0]),
+                   ArrayView<const dolfin::la_index>(macro_dofs[0][1]));
+
+          // Add entries to global tensor
+          for (std::size_t form = 0; form < 2; ++form)
           {
-            std::copy(cell_dofs[form][c][dim]->begin(), cell_dofs[form][c][dim]->end(),
-                      macro_dofs[form][dim].begin() + c*cell_dofs[form][0][dim]->size());
-          }
-        } // End loop over cells sharing facet (c)
-      } // End loop over form (form)
-
-      // Modify local tensor for bcs
-      apply_bc(ufc[0]->macro_A.data(), ufc[1]->macro_A.data(), boundary_values,
-               macro_dofs[0][0], macro_dofs[0][1]);
+            bool add_macro_element = true;
+            if (form==0) // bilinear form
+              add_macro_element = ufc[0]->form.has_interior_facet_integrals();
 
-      // Add entries to global tensor
-      for (std::size_t form = 0; form < 2; ++form)
-      {
-        bool add_macro_element = true;
-        if (form==0) // bilinear form
-          add_macro_element = ufc[0]->form.has_interior_facet_integrals();
-
-        if (tensors[form] && add_macro_element)
-        {
-          tensors[form]->add(ufc[form]->macro_A.data(), macro_dofs[form]);
-        }
-        else if (tensors[form] && !add_macro_element) // only true for the bilinear form
-        {
-          // the sparsity pattern may not support the macro element
-          // so instead extract back out the diagonal cell blocks and add them individually
-          for (std::size_t c = 0; c < num_cells; ++c)
-          {
-            if (local_facet[c] == 0)
+            if (tensors[form] && add_macro_element)
             {
-              // Cell integrals
-              cell_integrals[form] = ufc[form]->default_cell_integral.get();
-
-              // Get cell integrals for sub domain (if any)
-              if (cell_domains && !cell_domains->empty())
+              tensors[form]->add(ufc[form]->macro_A.data(), macro_dofs[form]);
+              thread_profile.inserted(macro_dofs[form]);
+            }
+            else if (tensors[form] && !add_macro_element) // only true for the bilinear form
+            {
+              // the sparsity pattern may not support the macro element
+              // so instead extract back out the diagonal cell blocks and add them individually
+              for (std::size_t c = 0; c < num_cells; ++c)
               {
-                const std::size_t domain = (*cell_domains)[cell[c]];
-                cell_integrals[form] = ufc[form]->get_cell_integral(domain);
-              }
+                if (local_facet[c] == 0)
+                {
+                  // Cell integrals
+                  cell_integrals[form] = ufc[form]->default_cell_integral.get();
 
-              // Check if cell tensor was assembled - not necessary but saves inserting 0s
-              bool cell_tensor_required
-                = cell_matrix_required(tensors[form],
-                                       cell_integrals[form],
-                                       boundary_values,
-                                       *cell_dofs[form][c][1]);
+                  // Get cell integrals for sub domain (if any)
+                  if (cell_domains && !cell_domains->empty())
+                  {
+                    const std::size_t domain = (*cell_domains)[cell[c]];
+                    cell_integrals[form] = ufc[form]->get_cell_integral(domain);
+                  }
 
-              // Add cell tensor, if required
-              if (cell_tensor_required)
-              {
-                data.zero_cell();
-                const std::size_t nn = cell_dofs[form][c][0]->size();
-                const std::size_t mm = cell_dofs[form][c][1]->size();
-                for (std::size_t i = 0; i < mm; i++)
-                {
-                  for (std::size_t j = 0; j < nn; j++)
+                  // Check if cell tensor was assembled - not necessary but saves inserting 0s
+                  bool cell_tensor_required
+                    = cell_matrix_required(tensors[form],
+                                           cell_integrals[form],
+                                           boundary_values,
+                                           cell_dofs[form][c][1]);
+
+                  // Add cell tensor, if required
+                  if (cell_tensor_required)
                   {
-                    data.Ae[form][i*nn + j] 
-                       = ufc[form]->macro_A[2*nn*mm*c + num_cells*i*nn + nn*c +j];
+                    data.zero_cell();
+                    const std::size_t nn = cell_dofs[form][c][0].size();
+                    const std::size_t mm = cell_dofs[form][c][1].size();
+                    for (std::size_t i = 0; i < mm; i++)
+                    {
+                      for (std::size_t j = 0; j < nn; j++)
+                      {
+                        data.Ae[form][i*nn + j] 
+                           = ufc[form]->macro_A[2*nn*mm*c + num_cells*i*nn + nn*c +j];
+                      }
+                    }
+                    tensors[form]->add(data.Ae[form].data(), cell_dofs[form][c]);
+                    thread_profile.inserted(cell_dofs[form][c]);
                   }
                 }
-                tensors[form]->add(data.Ae[form].data(), cell_dofs[form][c]);
-              }
+              } // End loop over cells sharing facet (c)
             }
-          } // End loop over cells sharing facet (c)
+          } // End loop over form (form)
+          thread_profile.stop(AssemblyProfile::insert);
+          thread_profile.count(AssemblyProfile::interior_facet);
         }
-      } // End loop over form (form)
-    }
-    else // Exterior facet
-    {
-      // Get mesh cell to which mesh facet belongs (pick first, there
-      // is only one)
-      Cell cell(mesh, facet->entities(mesh.topology().dim())[0]);
+        else // Exterior facet
+        {
+          // Get mesh cell to which mesh facet belongs (pick first, there
+          // is only one)
+          Cell cell(mesh, facet.entities(mesh.topology().dim())[0]);
 
-      // Get local index of facet with respect to the cell
-      const std::size_t local_facet = cell.index(*facet);
+          // Get local index of facet with respect to the cell
+          const std::size_t local_facet = cell.index(facet);
 
-      // Get cell data
-      cell.get_vertex_coordinates(vertex_coordinates[0]);
-      cell.get_cell_data(ufc_cell[0], local_facet);
+          // Get cell data
+          cell.get_vertex_coordinates(vertex_coordinates[0]);
+          cell.get_cell_data(ufc_cell[0], local_facet);
 
-      // Initialize macro element matrix/vector to zero
-      data.zero_cell();
+          // Initialize macro element matrix/vector to zero
+          data.zero_cell();
 
-      // Loop over lhs and then rhs facet contributions
-      for (std::size_t form = 0; form < 2; ++form)
-      {
-        // Get rank (lhs=2, rhs=1)
-        const std::size_t rank = (form == 0) ? 2 : 1;
+          // Loop over lhs and then rhs facet contributions
+          for (std::size_t form = 0; form < 2; ++form)
+          {
+            // Get rank (lhs=2, rhs=1)
+            const std::size_t rank = (form == 0) ? 2 : 1;
 
-        // Get local-to-global dof maps for cell
-        for (std::size_t dim = 0; dim < rank; ++dim)
-        {
-          cell_dofs[form][0][dim]
-            = &(dofmaps[form][dim]->cell_dofs(cell.index()));
-        }
+            // Get local-to-global dof maps for cell
+            for (std::size_t dim = 0; dim < rank; ++dim)
+            {
+              cell_dofs[form][0][dim]
+                = dofmaps[form][dim]->cell_dofs(cell.index());
+            }
 
-        // Reset some temp data
-        std::fill(ufc[form]->A.begin(), ufc[form]->A.end(), 0.0);
+            // Reset some temp data
+            std::fill(ufc[form]->A.begin(), ufc[form]->A.end(), 0.0);
 
-        // Get exterior facer integral
-        exterior_facet_integrals[form]
-          = ufc[form]->default_exterior_facet_integral.get();
+            // Get exterior facer integral
+            exterior_facet_integrals[form]
+              = ufc[form]->default_exterior_facet_integral.get();
 
-        // Get exterior facet integrals for sub domain (if any)
-        if (exterior_facet_domains && !exterior_facet_domains->empty())
-        {
-          const std::size_t domain = (*exterior_facet_domains)[*facet];
-          exterior_facet_integrals[form]
-            = ufc[form]->get_exterior_facet_integral(domain);
-        }
+            // Get exterior facet integrals for sub domain (if any)
+            if (exterior_facet_domains && !exterior_facet_domains->empty())
+            {
+              const std::size_t domain = (*exterior_facet_domains)[facet];
+              exterior_facet_integrals[form]
+                = ufc[form]->get_exterior_facet_integral(domain);
+            }
 
-        // Check if facet tensor is required
-        bool facet_tensor_required
-          = (tensors[form] && exterior_facet_integrals[form]);
-        if (rank == 2)
-        {
-          dolfin_assert(cell_dofs[form][0][1]);
-          facet_tensor_required
-            = cell_matrix_required(tensors[form],
-                                   exterior_facet_integrals[form],
-                                   boundary_values,
-                                   *cell_dofs[form][0][1]);
-        }
+            // Check if facet tensor is required
+            bool facet_tensor_required
+              = (tensors[form] && exterior_facet_integrals[form]);
+            if (rank == 2)
+            {
+              facet_tensor_required
+                = cell_matrix_required(tensors[form],
+                                       exterior_facet_integrals[form],
+                                       boundary_values,
+                                       cell_dofs[form][0][1]);
+            }
 
-        // Compute facet integral,if required
-        if (facet_tensor_required)
-        {
-          // Update UFC object
-          ufc[form]->update(cell, vertex_coordinates[0], ufc_cell[0]);
-          exterior_facet_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
-                                                  ufc[form]->w(),
-                                                  vertex_coordinates[0].data(),
-                                                  local_facet);
-          for (std::size_t i = 0; i < data.Ae[form].size(); i++)
-            data.Ae[form][i] += ufc[form]->A[i];
-        }
+            // Compute facet integral,if required
+            if (facet_tensor_required)
+            {
+              // Update UFC object
+              thread_profile.start();
+              ufc[form]->update(cell, vertex_coordinates[0], ufc_cell[0]);
+              thread_profile.stop(AssemblyProfile::update);
+              exterior_facet_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
+                                                      ufc[form]->w(),
+                                                      vertex_coordinates[0].data(),
+                                                      local_facet);
+              for (std::size_t i = 0; i < data.Ae[form].size(); i++)
+                data.Ae[form][i] += ufc[form]->A[i];
+              thread_profile.stop(AssemblyProfile::tabulate);
+            }
 
-        // If we have local facet 0, assemble cell integral
-        if (local_facet == 0)
-        {
-          cell_integrals[form] = ufc[form]->default_cell_integral.get();
+            // If we have local facet 0, assemble cell integral
+            if (local_facet == 0)
+            {
+              cell_integrals[form] = ufc[form]->default_cell_integral.get();
 
-          // Get cell integrals for sub domain (if any)
-          if (cell_domains && !cell_domains->empty())
-          {
-            const std::size_t domain = (*cell_domains)[cell];
-            cell_integrals[form] = ufc[form]->get_cell_integral(domain);
-          }
+              // Get cell integrals for sub domain (if any)
+              if (cell_domains && !cell_domains->empty())
+              {
+                const std::size_t domain = (*cell_domains)[cell];
+                cell_integrals[form] = ufc[form]->get_cell_integral(domain);
+              }
 
-          // Check if facet tensor is required
-          bool cell_tensor_required = tensors[form] && cell_integrals[form];
-          if (rank == 2)
-          {
-            dolfin_assert(cell_dofs[form][0][1]);
-            cell_tensor_required = cell_matrix_required(tensors[form],
-                                                        cell_integrals[form],
-                                                        boundary_values,
-                                                        *cell_dofs[form][0][1]);
-          }
+              // Check if facet tensor is required
+              bool cell_tensor_required = tensors[form] && cell_integrals[form];
+              if (rank == 2)
+              {
+                cell_tensor_required = cell_matrix_required(tensors[form],
+                                                            cell_integrals[form],
+                                                            boundary_values,
+                                                            cell_dofs[form][0][1]);
+              }
 
-          // Compute cell integral, if required
-          if (cell_tensor_required)
+              // Compute cell integral, if required
+              if (cell_tensor_required)
+              {
+                thread_profile.start();
+                ufc[form]->update(cell, vertex_coordinates[0], ufc_cell[0]);
+                thread_profile.stop(AssemblyProfile::update);
+                cell_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
+                                                      ufc[form]->w(),
+                                                      vertex_coordinates[0].data(),
+                                                      ufc_cell[0].orientation);
+                for (std::size_t i = 0; i < data.Ae[form].size(); i++)
+                  data.Ae[form][i] += ufc[form]->A[i];
+                thread_profile.stop(AssemblyProfile::tabulate);
+              }
+
+              if (form == 0)
+                thread_profile.count(AssemblyProfile::cell);
+            }
+          } // End loop over forms [form]
+
+          // Modify local matrix/element for Dirichlet boundary conditions
+          thread_profile.start();
+          apply_bc(data.Ae[0].data(), data.Ae[1].data(), boundary_values,
+                   cell_dofs[0][0][0], cell_dofs[0][0][1]);
+
+          // Add entries to global tensor
+          for (std::size_t form = 0; form < 2; ++form)
           {
-            ufc[form]->update(cell, vertex_coordinates[0], ufc_cell[0]);
-            cell_integrals[form]->tabulate_tensor(ufc[form]->A.data(),
-                                                  ufc[form]->w(),
-                                                  vertex_coordinates[0].data(),
-                                                  ufc_cell[0].orientation);
-            for (std::size_t i = 0; i < data.Ae[form].size(); i++)
-              data.Ae[form][i] += ufc[form]->A[i];
+            if (tensors[form])
+            {
+              tensors[form]->add(data.Ae[form].data(), cell_dofs[form][0]);
+              thread_profile.inserted(cell_dofs[form][0]);
+            }
           }
+          thread_profile.stop(AssemblyProfile::insert);
+          thread_profile.count(AssemblyProfile::exterior_facet);
         }
-      } // End loop over forms [form]
+      }
 
-      // Modify local matrix/element for Dirichlet boundary conditions
-      apply_bc(data.Ae[0].data(), data.Ae[1].data(), boundary_values,
-               *cell_dofs[0][0][0], *cell_dofs[0][0][1]);
+      scheduler.release(chunk);
 
-      // Add entries to global tensor
-      for (std::size_t form = 0; form < 2; ++form)
-      {
-        if (tensors[form])
-          tensors[form]->add(data.Ae[form].data(), cell_dofs[form][0]);
-      }
+      #ifdef HAS_OPENMP
+      #pragma omp critical (dolfin_system_assembler_progress)
+      #endif
+      p++;
     }
-    p++;
+
+    // Combine profiles of threads
+    #ifdef HAS_OPENMP
+    #pragma omp critical (dolfin_system_assembler_profile)
+    #endif
+    profile.add(thread_profile);
+  }
+}
+//-----------------------------------------------------------------------------
+std::size_t SystemAssembler::get_num_threads(const Mesh& mesh)
+{
+  #ifdef HAS_OPENMP
+  std::size_t num_threads = parameters["num_threads"];
+  if (num_threads > 0 && MPI::size(mesh.mpi_comm()) > 1)
+  {
+    warning("Multi-threaded system assembly is not supported in combination \
+with MPI. Using one thread per process");
+    num_threads = 0;
   }
+  return num_threads;
+  #else
+  return 0;
+  #endif
 }
 //-----------------------------------------------------------------------------
 inline void SystemAssembler::apply_bc(double* A, double* b,
                                       const DirichletBC::Map& boundary_values,
-                                      const std::vector<dolfin::la_index>& global_dofs0,
-                                      const std::vector<dolfin::la_index>& global_dofs1)
+                          const ArrayView<const dolfin::la_index>& global_dofs0,
+                          const ArrayView<const dolfin::la_index>& global_dofs1)
 {
   dolfin_assert(A);
   dolfin_assert(b);
@@ -936,10 +1144,10 @@ inline void SystemAssembler::apply_bc(double* A, double* b,
 }
 //-----------------------------------------------------------------------------
 bool SystemAssembler::has_bc(const DirichletBC::Map& boundary_values,
-                             const std::vector<dolfin::la_index>& dofs)
+                             const ArrayView<const dolfin::la_index>& dofs)
 {
   // Loop over dofs and check if bc is applied
-  std::vector<dolfin::la_index>::const_iterator dof;
+  const dolfin::la_index* dof;
   for (dof = dofs.begin(); dof != dofs.end(); ++dof)
   {
     DirichletBC::Map::const_iterator bc_value = boundary_values.find(*dof);
@@ -953,7 +1161,7 @@ bool SystemAssembler::has_bc(const DirichletBC::Map& boundary_values,
 inline bool SystemAssembler::cell_matrix_required(const GenericTensor* A,
                                        const void* integral,
                                        const DirichletBC::Map& boundary_values,
-                                       const std::vector<dolfin::la_index>& dofs)
+                                const ArrayView<const dolfin::la_index>& dofs)
 {
   if (A && integral)
     return true;
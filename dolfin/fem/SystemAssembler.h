@@ -18,7 +18,7 @@
 // Modified by Anders Logg 2008-2011
 //
 // First added:  2009-06-22
-// Last changed: 2013-04-23
+// Last changed: 2014-03-21
 
 #ifndef __SYSTEM_ASSEMBLER_H
 #define __SYSTEM_ASSEMBLER_H
@@ -27,6 +27,7 @@
 #include <vector>
 #include <boost/array.hpp>
 #include <memory>
+#include <dolfin/common/ArrayView.h>
 #include "DirichletBC.h"
 #include "AssemblerBase.h"
 
@@ -44,6 +45,7 @@ namespace dolfin
   class Form;
   class GenericMatrix;
   class GenericVector;
+  class Mesh;
   template<typename T> class MeshFunction;
   class UFC;
 
@@ -120,35 +122,39 @@ namespace dolfin
     static void
       cell_wise_assembly(boost::array<GenericTensor*, 2>& tensors,
                          boost::array<UFC*, 2>& ufc,
-                         Scratch& data,
                          const DirichletBC::Map& boundary_values,
                          const MeshFunction<std::size_t>* cell_domains,
-                       const MeshFunction<std::size_t>* exterior_facet_domains);
+                       const MeshFunction<std::size_t>* exterior_facet_domains,
+                         AssemblyProfile& profile);
 
     static void
     facet_wise_assembly(boost::array<GenericTensor*, 2>& tensors,
                         boost::array<UFC*, 2>& ufc,
-                        Scratch& data,
                         const DirichletBC::Map& boundary_values,
                         const MeshFunction<std::size_t>* cell_domains,
                         const MeshFunction<std::size_t>* exterior_facet_domains,
-                       const MeshFunction<std::size_t>* interior_facet_domains);
+                       const MeshFunction<std::size_t>* interior_facet_domains,
+                        AssemblyProfile& profile);
+
+    // Return number of threads to use for assembly (0 for serial
+    // assembly)
+    static std::size_t get_num_threads(const Mesh& mesh);
 
     static void apply_bc(double* A, double* b,
                          const DirichletBC::Map& boundary_values,
-                         const std::vector<dolfin::la_index>& global_dofs0,
-                         const std::vector<dolfin::la_index>& global_dofs1);
+                         const ArrayView<const dolfin::la_index>& global_dofs0,
+                         const ArrayView<const dolfin::la_index>& global_dofs1);
 
     // Return true if cell has an Dirichlet/essential boundary
     // condition applied
     static bool has_bc(const DirichletBC::Map& boundary_values,
-                       const std::vector<dolfin::la_index>& dofs);
+                       const ArrayView<const dolfin::la_index>& dofs);
 
     // Return true if element matrix is required
     static bool cell_matrix_required(const GenericTensor* A,
                                      const void* integral,
                                      const DirichletBC::Map& boundary_values,
-                                     const std::vector<dolfin::la_index>& dofs);
+                               const ArrayView<const dolfin::la_index>& dofs);
 
     // Class to hold temporary data
     class Scratch
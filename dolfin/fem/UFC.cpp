@@ -19,11 +19,14 @@
 // Modified by Garth N. Wells, 2010
 //
 // First added:  2007-01-17
-// Last changed: 2013-09-24
+// Last changed: 2014-03-17
 
+#include <algorithm>
 #include <dolfin/common/types.h>
 #include <dolfin/function/FunctionSpace.h>
 #include <dolfin/function/GenericFunction.h>
+#include <dolfin/mesh/Cell.h>
+#include <dolfin/mesh/Mesh.h>
 #include "GenericDofMap.h"
 #include "FiniteElement.h"
 #include "Form.h"
@@ -126,6 +129,9 @@ void UFC::init(const Form& a)
     _macro_w[i].resize(n);
     macro_w_pointer[i] = &_macro_w[i][0];
   }
+
+  // Coefficients for blocks of cells are allocated on first use
+  _block_w.resize(form.num_coefficients());
 }
 //-----------------------------------------------------------------------------
 void UFC::update(const Cell& c, const std::vector<double>& vertex_coordinates,
@@ -157,3 +163,60 @@ void UFC::update(const Cell& c0, const std::vector<double>& vertex_coordinates0,
   }
 }
 //-----------------------------------------------------------------------------
+void UFC::get_coefficients(std::vector<double>& w) const
+{
+  w.clear();
+  for (std::size_t i = 0; i < _w.size(); ++i)
+    w.insert(w.end(), _w[i].begin(), _w[i].end());
+}
+//-----------------------------------------------------------------------------
+void UFC::set_macro_coefficients(const double* w0, const double* w1)
+{
+  for (std::size_t i = 0; i < _macro_w.size(); ++i)
+  {
+    const std::size_t n = coefficient_elements[i].space_dimension();
+    std::copy(w0, w0 + n, _macro_w[i].begin());
+    std::copy(w1, w1 + n, _macro_w[i].begin() + n);
+    w0 += n;
+    w1 += n;
+  }
+}
+//-----------------------------------------------------------------------------
+void UFC::update(const Mesh& mesh, const std::vector<std::size_t>& cells,
+                 const std::vector<double>& vertex_coordinates,
+                 const std::vector<ufc::cell>& ufc_cells)
+{
+  const std::size_t num_cells = cells.size();
+  const std::size_t num_coefficients = coefficients.size();
+  dolfin_assert(ufc_cells.size() >= num_cells);
+  if (num_cells == 0)
+    return;
+
+  // Vertex coordinates are stored cell after cell
+  const std::size_t tdim = mesh.topology().dim();
+  const std::size_t stride
+    = mesh.type().num_vertices(tdim)*mesh.geometry().dim();
+  dolfin_assert(vertex_coordinates.size() >= num_cells*stride);
+
+  // Restrict coefficients, one coefficient at a time so that
+  // consecutive calls to restrict dispatch to the same function
+  block_w_pointer.resize(num_cells*num_coefficients);
+  for (std::size_t i = 0; i < num_coefficients; ++i)
+  {
+    dolfin_assert(coefficients[i]);
+    const std::size_t dim = coefficient_elements[i].space_dimension();
+    if (_block_w[i].size() < num_cells*dim)
+      _block_w[i].resize(num_cells*dim);
+
+    for (std::size_t k = 0; k < num_cells; ++k)
+    {
+      double* w = _block_w[i].data() + k*dim;
+      const Cell cell(mesh, cells[k]);
+      coefficients[i]->restrict(w, coefficient_elements[i], cell,
+                                vertex_coordinates.data() + k*stride,
+                                ufc_cells[k]);
+      block_w_pointer[k*num_coefficients + i] = w;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
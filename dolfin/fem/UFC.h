@@ -18,7 +18,7 @@
 // Modified by Garth N. Wells 2009
 //
 // First added:  2007-01-17
-// Last changed: 2013-02-26
+// Last changed: 2014-03-17
 
 #ifndef __UFC_DATA_H
 #define __UFC_DATA_H
@@ -72,6 +72,29 @@ namespace dolfin
                 const std::vector<double>& vertex_coordinates1,
                 const ufc::cell& ufc_cell1);
 
+    /// Copy coefficients on current cell (see update) into w, stored
+    /// coefficient after coefficient
+    void get_coefficients(std::vector<double>& w) const;
+
+    /// Set coefficients on current pair of cells for macro element
+    /// from the coefficients on each cell, stored coefficient after
+    /// coefficient (see get_coefficients). Used when one of the
+    /// cells lives on another process.
+    void set_macro_coefficients(const double* w0, const double* w1);
+
+    /// Update coefficients for a block of cells. The vertex
+    /// coordinates of the cells are stored contiguously, cell after
+    /// cell. The coefficients on cell k of the block are accessed
+    /// through block_w(k).
+    void update(const Mesh& mesh, const std::vector<std::size_t>& cells,
+                const std::vector<double>& vertex_coordinates,
+                const std::vector<ufc::cell>& ufc_cells);
+
+    /// Pointer to coefficient data for cell k of the current block
+    /// of cells. Used to support UFC interface.
+    const double* const * block_w(std::size_t k) const
+    { return block_w_pointer.data() + k*_block_w.size(); }
+
     /// Pointer to coefficient data. Used to support UFC interface.
     const double* const * w() const
     { return &w_pointer[0]; }
@@ -207,6 +230,12 @@ namespace dolfin
     std::vector<std::vector<double> > _macro_w;
     std::vector<double*> macro_w_pointer;
 
+    // Coefficients for a block of cells, stored cell after cell for
+    // each coefficient (std::vector<double*> is used to interface
+    // with UFC)
+    std::vector<std::vector<double> > _block_w;
+    std::vector<double*> block_w_pointer;
+
     // Coefficient functions
     const std::vector<std::shared_ptr<const GenericFunction> > coefficients;
 
@@ -15,10 +15,12 @@
 #include <dolfin/fem/LocalSolver.h>
 #include <dolfin/fem/solve.h>
 #include <dolfin/fem/Form.h>
+#include <dolfin/fem/AssemblyProfile.h>
 #include <dolfin/fem/AssemblerBase.h>
 #include <dolfin/fem/Assembler.h>
 #include <dolfin/fem/SparsityPatternBuilder.h>
 #include <dolfin/fem/SystemAssembler.h>
+#include <dolfin/fem/MatrixFreeOperator.h>
 #include <dolfin/fem/LinearVariationalProblem.h>
 #include <dolfin/fem/LinearVariationalSolver.h>
 #include <dolfin/fem/NonlinearVariationalProblem.h>
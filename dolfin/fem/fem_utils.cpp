@@ -116,7 +116,7 @@ dolfin::vertex_to_dof_map(const FunctionSpace& space)
     }
 
     // Get all cell dofs
-    const std::vector<dolfin::la_index>& cell_dofs
+    const ArrayView<const dolfin::la_index> cell_dofs
       = dofmap.cell_dofs(cell.index());
 
     // Tabulate local to local map of dofs on local vertex
@@ -0,0 +1,96 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-27
+// Last changed: 2014-03-27
+
+#ifndef __DOF_EVALUATION_H
+#define __DOF_EVALUATION_H
+
+#include <algorithm>
+#include <vector>
+#include <dolfin/log/log.h>
+#include <ufc.h>
+
+namespace dolfin
+{
+
+  // These classes are used internally (by GenericFunction and
+  // Function) to evaluate the dofs of an element in two passes: the
+  // first pass records the points at which the dofs evaluate a
+  // function, the points are then evaluated all at once, and the
+  // second pass returns the computed values to the dofs.
+
+  /// This class records the points at which an element evaluates a
+  /// function (the values are set to zero). Points are appended to
+  /// the given vector.
+  class DofPointRecorder : public ufc::function
+  {
+  public:
+
+    /// Create recorder for function with given value size
+    DofPointRecorder(std::size_t value_size, std::vector<double>& points)
+      : _value_size(value_size), _points(points) {}
+
+    /// Record point and set values to zero
+    void evaluate(double* values, const double* coordinates,
+                  const ufc::cell& cell) const
+    {
+      _points.insert(_points.end(), coordinates,
+                     coordinates + cell.geometric_dimension);
+      std::fill(values, values + _value_size, 0.0);
+    }
+
+  private:
+
+    const std::size_t _value_size;
+    std::vector<double>& _points;
+
+  };
+
+  /// This class returns precomputed values, in the order in which the
+  /// points were recorded by a DofPointRecorder.
+  class DofValueReplayer : public ufc::function
+  {
+  public:
+
+    /// Create replayer for function with given value size
+    DofValueReplayer(std::size_t value_size,
+                     const std::vector<double>& values)
+      : _value_size(value_size), _values(values), _position(0) {}
+
+    /// Return next precomputed values
+    void evaluate(double* values, const double* coordinates,
+                  const ufc::cell& cell) const
+    {
+      dolfin_assert(_position + _value_size <= _values.size());
+      std::copy(_values.begin() + _position,
+                _values.begin() + _position + _value_size, values);
+      _position += _value_size;
+    }
+
+  private:
+
+    const std::size_t _value_size;
+    const std::vector<double>& _values;
+    mutable std::size_t _position;
+
+  };
+
+}
+
+#endif
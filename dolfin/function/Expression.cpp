@@ -18,7 +18,7 @@
 // Modified by Johan Hake, 2009.
 //
 // First added:  2009-09-28
-// Last changed: 2011-11-14
+// Last changed: 2014-03-20
 
 #include <dolfin/log/log.h>
 #include <dolfin/mesh/Cell.h>
@@ -112,33 +112,37 @@ void Expression::compute_vertex_values(std::vector<double>& vertex_values,
 {
   // Local data for vertex values
   const std::size_t size = value_size();
-  Array<double> local_vertex_values(size);
+  const std::size_t num_cell_vertices
+    = mesh.type().num_vertices(mesh.topology().dim());
+  std::vector<double> local_vertex_values(num_cell_vertices*size);
+  Array<double> _local_vertex_values(local_vertex_values.size(),
+                                     local_vertex_values.data());
 
   // Resize vertex_values
   vertex_values.resize(size*mesh.num_vertices());
 
   // Iterate over cells, overwriting values when repeatedly visiting vertices
   ufc::cell ufc_cell;
+  std::vector<double> vertex_coordinates;
   for (CellIterator cell(mesh); !cell.end(); ++cell)
   {
     // Update cell data
     cell->get_cell_data(ufc_cell);
+    cell->get_vertex_coordinates(vertex_coordinates);
 
-    // Iterate over cell vertices
-    for (VertexIterator vertex(*cell); !vertex.end(); ++vertex)
-    {
-      // Wrap coordinate data
-      const Array<double> x(mesh.geometry().dim(),
-                            const_cast<double*>(vertex->x()));
-
-      // Evaluate at vertex
-      eval(local_vertex_values, x, ufc_cell);
+    // Evaluate at all vertices of cell
+    const Array<double> x(vertex_coordinates.size(),
+                          vertex_coordinates.data());
+    eval_batch(_local_vertex_values, x, ufc_cell);
 
-      // Copy to array
+    // Copy to array
+    const unsigned int* vertices = cell->entities(0);
+    for (std::size_t v = 0; v < num_cell_vertices; ++v)
+    {
       for (std::size_t i = 0; i < size; i++)
       {
-        const std::size_t global_index = i*mesh.num_vertices() + vertex->index();
-        vertex_values[global_index] = local_vertex_values[i];
+        const std::size_t global_index = i*mesh.num_vertices() + vertices[v];
+        vertex_values[global_index] = local_vertex_values[v*size + i];
       }
     }
   }
@@ -20,9 +20,10 @@
 // Modified by Andre Massing 2009
 //
 // First added:  2003-11-28
-// Last changed: 2013-10-25
+// Last changed: 2014-03-27
 
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <utility>
 #include <vector>
@@ -30,6 +31,7 @@
 
 #include <dolfin/adaptivity/Extrapolation.h>
 #include <dolfin/common/Array.h>
+#include <dolfin/common/MPI.h>
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/utils.h>
 #include <dolfin/fem/FiniteElement.h>
@@ -42,10 +44,12 @@
 #include <dolfin/la/DefaultFactory.h>
 #include <dolfin/log/log.h>
 #include <dolfin/mesh/Mesh.h>
+#include <dolfin/mesh/MeshRenumbering.h>
 #include <dolfin/mesh/Vertex.h>
 #include <dolfin/mesh/Restriction.h>
 #include <dolfin/parameter/GlobalParameters.h>
 #include <dolfin/geometry/BoundingBoxTree.h>
+#include "DofEvaluation.h"
 #include "Expression.h"
 #include "FunctionSpace.h"
 #include "Function.h"
@@ -449,6 +453,319 @@ void Function::eval(Array<double>& values, const Array<double>& x,
   }
 }
 //-----------------------------------------------------------------------------
+void Function::eval_points(Array<double>& values,
+                           const Array<double>& x) const
+{
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  const Mesh& mesh = *_function_space->mesh();
+
+  // Get dimensions
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t value_size_loc = value_size();
+  if (x.size() % gdim != 0)
+  {
+    dolfin_error("Function.cpp",
+                 "evaluate function at points",
+                 "Size of coordinate array (%d) is not a multiple of the geometric dimension (%d)",
+                 x.size(), gdim);
+  }
+  const std::size_t num_points = x.size()/gdim;
+  if (values.size() != num_points*value_size_loc)
+  {
+    dolfin_error("Function.cpp",
+                 "evaluate function at points",
+                 "Size of value array (%d) does not match number of points times value size (%d)",
+                 values.size(), num_points*value_size_loc);
+  }
+  if (num_points == 0)
+    return;
+
+  // Locate cells containing the points and evaluate
+  std::vector<unsigned int> cells;
+  locate_points(cells, x.data(), num_points, allow_extrapolation);
+  const unsigned int not_found = std::numeric_limits<unsigned int>::max();
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    if (cells[i] == not_found)
+    {
+      const Point point(gdim, x.data() + i*gdim);
+      cout << point << endl;
+      dolfin_error("Function.cpp",
+                   "evaluate function at points",
+                   "The point is not inside the domain. Consider setting \"allow_extrapolation\" to allow extrapolation");
+    }
+  }
+  eval_points(values.data(), x.data(), cells);
+}
+//-----------------------------------------------------------------------------
+void Function::locate_points(std::vector<unsigned int>& cells,
+                             const double* x, std::size_t num_points,
+                             bool extrapolate) const
+{
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  const Mesh& mesh = *_function_space->mesh();
+  const std::size_t gdim = mesh.geometry().dim();
+  cells.resize(num_points);
+  if (num_points == 0)
+    return;
+
+  // Order points along a space-filling curve so that consecutive
+  // points are likely to be found in the same or neighbouring cells
+  std::vector<std::size_t> order;
+  MeshRenumbering::compute_curve_order(order, x, num_points, gdim, false);
+
+  // Locate cells containing the points. The cell found for the
+  // previous point is checked first, and the tree is only searched
+  // when that fails.
+  std::shared_ptr<BoundingBoxTree> tree = mesh.bounding_box_tree();
+  const unsigned int not_found = std::numeric_limits<unsigned int>::max();
+  std::size_t num_extrapolated = 0;
+  unsigned int previous = not_found;
+  for (std::size_t k = 0; k < num_points; ++k)
+  {
+    const std::size_t i = order[k];
+    const Point point(gdim, x + i*gdim);
+
+    unsigned int id = not_found;
+    if (previous != not_found && Cell(mesh, previous).contains(point))
+      id = previous;
+    else
+      id = tree->compute_first_entity_collision(point);
+
+    // If not found, use the closest cell
+    if (id == not_found && extrapolate)
+    {
+      id = tree->compute_closest_entity(point).first;
+      num_extrapolated++;
+    }
+
+    cells[i] = id;
+    if (id != not_found)
+      previous = id;
+  }
+
+  if (num_extrapolated > 0)
+  {
+    warning("Extrapolating function values at %d points (not inside domain).",
+            num_extrapolated);
+  }
+}
+//-----------------------------------------------------------------------------
+void Function::eval_points(double* values, const double* x,
+                           const std::vector<unsigned int>& cells) const
+{
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  dolfin_assert(_function_space->element());
+  const Mesh& mesh = *_function_space->mesh();
+  const FiniteElement& element = *_function_space->element();
+
+  // Get dimensions
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t value_size_loc = value_size();
+  const std::size_t space_dim = element.space_dimension();
+  const std::size_t num_points = cells.size();
+
+  // Group points by cell
+  std::vector<std::pair<unsigned int, std::size_t> > point_cells(num_points);
+  for (std::size_t i = 0; i < num_points; ++i)
+    point_cells[i] = std::make_pair(cells[i], i);
+  std::sort(point_cells.begin(), point_cells.end());
+
+  // Work arrays
+  std::vector<double> coefficients(space_dim);
+  std::vector<double> basis(space_dim*value_size_loc);
+  std::vector<double> vertex_coordinates;
+  ufc::cell ufc_cell;
+  const int cell_orientation = 0;
+
+  // Evaluate cell by cell
+  std::size_t k = 0;
+  while (k < num_points)
+  {
+    // Restrict function to cell
+    const Cell cell(mesh, point_cells[k].first);
+    cell.get_cell_data(ufc_cell);
+    cell.get_vertex_coordinates(vertex_coordinates);
+    restrict(coefficients.data(), element, cell,
+             vertex_coordinates.data(), ufc_cell);
+
+    // Evaluate all points in cell
+    for (; k < num_points && point_cells[k].first == cell.index(); ++k)
+    {
+      const std::size_t i = point_cells[k].second;
+      element.evaluate_basis_all(basis.data(), x + i*gdim,
+                                 vertex_coordinates.data(),
+                                 cell_orientation);
+
+      double* _values = values + i*value_size_loc;
+      for (std::size_t j = 0; j < value_size_loc; ++j)
+        _values[j] = 0.0;
+      for (std::size_t s = 0; s < space_dim; ++s)
+        for (std::size_t j = 0; j < value_size_loc; ++j)
+          _values[j] += coefficients[s]*basis[s*value_size_loc + j];
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void Function::eval_points_collective(Array<double>& values,
+                                      const Array<double>& x) const
+{
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  const Mesh& mesh = *_function_space->mesh();
+  const MPI_Comm mpi_comm = mesh.mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+
+  // Get dimensions
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t value_size_loc = value_size();
+  if (x.size() % gdim != 0)
+  {
+    dolfin_error("Function.cpp",
+                 "evaluate function at points",
+                 "Size of coordinate array (%d) is not a multiple of the geometric dimension (%d)",
+                 x.size(), gdim);
+  }
+  const std::size_t num_points = x.size()/gdim;
+  if (values.size() != num_points*value_size_loc)
+  {
+    dolfin_error("Function.cpp",
+                 "evaluate function at points",
+                 "Size of value array (%d) does not match number of points times value size (%d)",
+                 values.size(), num_points*value_size_loc);
+  }
+
+  // Build tree of process bounding boxes (collective)
+  std::shared_ptr<BoundingBoxTree> tree = mesh.bounding_box_tree();
+  tree->build_global_tree();
+
+  // Send each point to the processes whose bounding box contains it
+  std::vector<std::vector<double> > send_points(num_processes);
+  std::vector<std::vector<std::size_t> > send_indices(num_processes);
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    const Point point(gdim, x.data() + i*gdim);
+    const std::vector<unsigned int> processes
+      = tree->compute_process_collisions(point);
+    for (std::size_t j = 0; j < processes.size(); ++j)
+    {
+      const unsigned int p = processes[j];
+      send_points[p].insert(send_points[p].end(), x.data() + i*gdim,
+                            x.data() + (i + 1)*gdim);
+      send_indices[p].push_back(i);
+    }
+  }
+  std::vector<std::vector<double> > recv_points;
+  MPI::all_to_all(mpi_comm, send_points, recv_points);
+
+  // Locate all received points in the local mesh at once
+  std::vector<double> received_points;
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    received_points.insert(received_points.end(), recv_points[p].begin(),
+                           recv_points[p].end());
+  }
+  std::vector<unsigned int> received_cells;
+  locate_points(received_cells, received_points.data(),
+                received_points.size()/gdim, false);
+
+  // Keep the points which are inside the local mesh, with their cells
+  const unsigned int not_found = std::numeric_limits<unsigned int>::max();
+  std::vector<std::vector<std::size_t> > send_found(num_processes);
+  std::vector<double> found_points;
+  std::vector<unsigned int> found_cells;
+  std::size_t r = 0;
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    for (std::size_t j = 0; j < recv_points[p].size()/gdim; ++j, ++r)
+    {
+      if (received_cells[r] == not_found)
+        continue;
+      found_points.insert(found_points.end(),
+                          received_points.begin() + r*gdim,
+                          received_points.begin() + (r + 1)*gdim);
+      found_cells.push_back(received_cells[r]);
+      send_found[p].push_back(j);
+    }
+  }
+
+  // Evaluate function at all found points at once
+  std::vector<double> found_values(found_cells.size()*value_size_loc);
+  eval_points(found_values.data(), found_points.data(), found_cells);
+
+  // Send values back to the processes that asked for them
+  std::vector<std::vector<double> > send_values(num_processes);
+  std::vector<double>::const_iterator value = found_values.begin();
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    const std::size_t n = send_found[p].size()*value_size_loc;
+    send_values[p].assign(value, value + n);
+    value += n;
+  }
+  std::vector<std::vector<std::size_t> > recv_found;
+  std::vector<std::vector<double> > recv_values;
+  MPI::all_to_all(mpi_comm, send_found, recv_found);
+  MPI::all_to_all(mpi_comm, send_values, recv_values);
+
+  // Set values, using the first process that found each point
+  std::vector<bool> found(num_points, false);
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    for (std::size_t k = 0; k < recv_found[p].size(); ++k)
+    {
+      const std::size_t i = send_indices[p][recv_found[p][k]];
+      if (found[i])
+        continue;
+      std::copy(recv_values[p].begin() + k*value_size_loc,
+                recv_values[p].begin() + (k + 1)*value_size_loc,
+                values.data() + i*value_size_loc);
+      found[i] = true;
+    }
+  }
+
+  // Handle points not found on any process
+  std::vector<std::size_t> missing;
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    if (!found[i])
+      missing.push_back(i);
+  }
+  if (!missing.empty())
+  {
+    if (!allow_extrapolation)
+    {
+      const Point point(gdim, x.data() + missing[0]*gdim);
+      cout << point << endl;
+      dolfin_error("Function.cpp",
+                   "evaluate function at points",
+                   "The point is not inside the domain. Consider setting \"allow_extrapolation\" to allow extrapolation");
+    }
+
+    // Extrapolate from the local mesh
+    std::vector<double> missing_points(missing.size()*gdim);
+    for (std::size_t k = 0; k < missing.size(); ++k)
+    {
+      std::copy(x.data() + missing[k]*gdim, x.data() + (missing[k] + 1)*gdim,
+                missing_points.begin() + k*gdim);
+    }
+    std::vector<double> missing_values(missing.size()*value_size_loc);
+    Array<double> _missing_values(missing_values.size(),
+                                  missing_values.data());
+    const Array<double> _missing_points(missing_points.size(),
+                                        missing_points.data());
+    eval_points(_missing_values, _missing_points);
+    for (std::size_t k = 0; k < missing.size(); ++k)
+    {
+      std::copy(missing_values.begin() + k*value_size_loc,
+                missing_values.begin() + (k + 1)*value_size_loc,
+                values.data() + missing[k]*value_size_loc);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void Function::interpolate(const GenericFunction& v)
 {
   dolfin_assert(_vector);
@@ -457,10 +774,85 @@ void Function::interpolate(const GenericFunction& v)
   // Gather off-process dofs
   v.update();
 
+  // Interpolate Function on a different distributed mesh by
+  // evaluating it collectively
+  const Function* u = dynamic_cast<const Function*>(&v);
+  if (u && u->_function_space->mesh() != _function_space->mesh()
+      && MPI::size(_function_space->mesh()->mpi_comm()) > 1)
+  {
+    interpolate_nonmatching(*u);
+    return;
+  }
+
   // Interpolate
   _function_space->interpolate(*_vector, v);
 }
 //-----------------------------------------------------------------------------
+void Function::interpolate_nonmatching(const Function& v)
+{
+  dolfin_assert(_vector);
+  dolfin_assert(_function_space);
+  dolfin_assert(_function_space->mesh());
+  dolfin_assert(_function_space->element());
+  dolfin_assert(_function_space->dofmap());
+  const Mesh& mesh = *_function_space->mesh();
+  const FiniteElement& element = *_function_space->element();
+  const GenericDofMap& dofmap = *_function_space->dofmap();
+
+  // Check that value sizes match
+  const std::size_t size = value_size();
+  if (v.value_size() != size)
+  {
+    dolfin_error("Function.cpp",
+                 "interpolate function",
+                 "Value size of function (%d) does not match value size of function space (%d)",
+                 v.value_size(), size);
+  }
+
+  // Record the points at which the dofs evaluate the function
+  const int cell_orientation = 0;
+  std::vector<double> cell_coefficients(dofmap.max_cell_dimension());
+  std::vector<double> vertex_coordinates;
+  ufc::cell ufc_cell;
+  std::vector<double> points;
+  DofPointRecorder recorder(size, points);
+  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  {
+    cell->get_vertex_coordinates(vertex_coordinates);
+    cell->get_cell_data(ufc_cell);
+    element.evaluate_dofs(cell_coefficients.data(), recorder,
+                          vertex_coordinates.data(), cell_orientation,
+                          ufc_cell);
+  }
+
+  // Evaluate function at all points (collective)
+  std::vector<double> values(points.size()/mesh.geometry().dim()*size);
+  Array<double> _values(values.size(), values.data());
+  const Array<double> _points(points.size(), points.data());
+  v.eval_points_collective(_values, _points);
+
+  // Evaluate dofs to get the expansion coefficients
+  _vector->zero();
+  DofValueReplayer replayer(size, values);
+  for (CellIterator cell(mesh); !cell.end(); ++cell)
+  {
+    cell->get_vertex_coordinates(vertex_coordinates);
+    cell->get_cell_data(ufc_cell);
+    element.evaluate_dofs(cell_coefficients.data(), replayer,
+                          vertex_coordinates.data(), cell_orientation,
+                          ufc_cell);
+
+    // Copy dofs to vector
+    const ArrayView<const dolfin::la_index> cell_dofs
+      = dofmap.cell_dofs(cell->index());
+    _vector->set(cell_coefficients.data(), dofmap.cell_dimension(cell->index()),
+                 cell_dofs.data());
+  }
+
+  // Finalise changes
+  _vector->apply("insert");
+}
+//-----------------------------------------------------------------------------
 void Function::extrapolate(const Function& v)
 {
   Extrapolation::extrapolate(*this, v);
@@ -565,7 +957,7 @@ void Function::restrict(double* w, const FiniteElement& element,
   {
     // Get dofmap for cell
     const GenericDofMap& dofmap = *_function_space->dofmap();
-    const std::vector<dolfin::la_index>& dofs
+    const ArrayView<const dolfin::la_index> dofs
       = dofmap.cell_dofs(dolfin_cell.index());
 
     if (dofs.size() > 0)
@@ -754,7 +1146,7 @@ Function::compute_ghost_indices(std::pair<std::size_t, std::size_t> range,
   for (CellIterator cell(mesh); !cell.end(); ++cell)
   {
     // Get dofs on cell
-    const std::vector<dolfin::la_index>& dofs = dofmap.cell_dofs(cell->index());
+    const ArrayView<const dolfin::la_index> dofs = dofmap.cell_dofs(cell->index());
     for (std::size_t d = 0; d < dofs.size(); ++d)
     {
       const std::size_t dof = dofs[d];
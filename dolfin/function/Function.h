@@ -21,7 +21,7 @@
 // Modified by Andre Massing, 2009.
 //
 // First added:  2003-11-28
-// Last changed: 2013-10-22
+// Last changed: 2014-03-27
 
 #ifndef __FUNCTION_H
 #define __FUNCTION_H
@@ -264,6 +264,36 @@ namespace dolfin
     ///         The coordinates.
     void eval(Array<double>& values, const Array<double>& x) const;
 
+    /// Evaluate function at multiple points. The coordinates of point
+    /// i are x[i*gdim], ..., x[(i + 1)*gdim - 1] and its values are
+    /// stored in values[i*value_size()], ... . The points are ordered
+    /// along a space-filling curve before the containing cells are
+    /// located, and the expansion coefficients are computed only
+    /// once for each cell, which makes this function considerably
+    /// faster than calling eval() point by point.
+    ///
+    /// *Arguments*
+    ///     values (_Array_ <double>)
+    ///         The values at the points.
+    ///     x (_Array_ <double>)
+    ///         The coordinates of the points.
+    void eval_points(Array<double>& values, const Array<double>& x) const;
+
+    /// Evaluate function at multiple points located anywhere in a
+    /// distributed mesh. This function is collective; each process
+    /// passes its own points (in the same layout as for
+    /// eval_points()). Points are sent to the processes whose local
+    /// mesh bounding box contains them, evaluated there in batches
+    /// and the values are returned to the calling process.
+    ///
+    /// *Arguments*
+    ///     values (_Array_ <double>)
+    ///         The values at the points.
+    ///     x (_Array_ <double>)
+    ///         The coordinates of the points.
+    void eval_points_collective(Array<double>& values,
+                                const Array<double>& x) const;
+
     /// Evaluate function at given coordinates in given cell
     ///
     /// *Arguments*
@@ -280,7 +310,9 @@ namespace dolfin
               const Cell& dolfin_cell,
               const ufc::cell& ufc_cell) const;
 
-    /// Interpolate function (on possibly non-matching meshes)
+    /// Interpolate function (on possibly non-matching meshes). If v
+    /// is a _Function_ on a different mesh and the mesh is
+    /// distributed, this function is collective.
     ///
     /// *Arguments*
     ///     v (_GenericFunction_)
@@ -384,6 +416,21 @@ namespace dolfin
     // Collection of sub-functions which share data with the function
     mutable boost::ptr_map<std::size_t, Function> sub_functions;
 
+    // Interpolate function on a different (distributed) mesh
+    void interpolate_nonmatching(const Function& v);
+
+    // Locate the cells containing num_points points with coordinates
+    // x. Points outside the mesh are assigned the closest cell if
+    // extrapolate is true, otherwise the maximum unsigned int.
+    void locate_points(std::vector<unsigned int>& cells,
+                       const double* x, std::size_t num_points,
+                       bool extrapolate) const;
+
+    // Evaluate function at points with coordinates x, located in the
+    // given cells
+    void eval_points(double* values, const double* x,
+                     const std::vector<unsigned int>& cells) const;
+
     // Compute lists of off-process dofs
     void compute_off_process_dofs() const;
 
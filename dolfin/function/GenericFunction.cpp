@@ -16,11 +16,18 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2009-09-28
-// Last changed: 2013-02-27
+// Last changed: 2014-03-27
 
+#include <algorithm>
 #include <string>
+#include <vector>
+#ifdef HAS_OPENMP
+#include <omp.h>
+#endif
 #include <dolfin/fem/FiniteElement.h>
 #include <dolfin/geometry/Point.h>
+#include <dolfin/parameter/GlobalParameters.h>
+#include "DofEvaluation.h"
 #include "GenericFunction.h"
 
 using namespace dolfin;
@@ -28,7 +35,12 @@ using namespace dolfin;
 //-----------------------------------------------------------------------------
 GenericFunction::GenericFunction() : Variable("u", "a function")
 {
-  // Do nothing
+  // Allocate restriction buffers for each thread that may assemble
+  int num_threads = parameters["num_threads"];
+#ifdef HAS_OPENMP
+  num_threads = std::max(num_threads, omp_get_max_threads());
+#endif
+  _restrict_buffers.resize(std::max(num_threads, 1));
 }
 //-----------------------------------------------------------------------------
 GenericFunction::~GenericFunction()
@@ -163,6 +175,25 @@ void GenericFunction::operator() (Array<double>& values, const Point& p)
   (*this)(values, p.x(), p.y(), p.z());
 }
 //-----------------------------------------------------------------------------
+void GenericFunction::eval_batch(Array<double>& values,
+                                 const Array<double>& x,
+                                 const ufc::cell& cell) const
+{
+  const std::size_t gdim = cell.geometric_dimension;
+  const std::size_t size = value_size();
+  dolfin_assert(gdim > 0);
+  const std::size_t num_points = x.size()/gdim;
+  dolfin_assert(values.size() == num_points*size);
+
+  // Evaluate point by point
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    Array<double> _values(size, values.data() + i*size);
+    const Array<double> _x(gdim, const_cast<double*>(x.data() + i*gdim));
+    eval(_values, _x, cell);
+  }
+}
+//-----------------------------------------------------------------------------
 std::size_t GenericFunction::value_size() const
 {
   std::size_t size = 1;
@@ -194,10 +225,38 @@ void GenericFunction::restrict_as_ufc_function(double* w,
                                                const ufc::cell& ufc_cell) const
 {
   dolfin_assert(w);
+  const int cell_orientation = 0;
+  const std::size_t size = value_size();
+
+  // Get buffers of this thread (use temporary buffers for threads
+  // beyond those allocated for)
+  std::size_t thread = 0;
+#ifdef HAS_OPENMP
+  thread = omp_get_thread_num();
+#endif
+  std::vector<double> tmp_points, tmp_values;
+  const bool have_buffers = thread < _restrict_buffers.size();
+  std::vector<double>& points
+    = have_buffers ? _restrict_buffers[thread].first : tmp_points;
+  std::vector<double>& values
+    = have_buffers ? _restrict_buffers[thread].second : tmp_values;
+
+  // Record the points at which the dofs evaluate the function
+  points.clear();
+  DofPointRecorder recorder(size, points);
+  element.evaluate_dofs(w, recorder, vertex_coordinates, cell_orientation,
+                        ufc_cell);
+
+  // Evaluate function at all points at once
+  const std::size_t num_points = points.size()/ufc_cell.geometric_dimension;
+  values.resize(num_points*size);
+  Array<double> _values(values.size(), values.data());
+  const Array<double> _points(points.size(), points.data());
+  eval_batch(_values, _points, ufc_cell);
 
   // Evaluate dofs to get the expansion coefficients
-  const int cell_orientation = 0;
-  element.evaluate_dofs(w, *this, vertex_coordinates, cell_orientation,
+  DofValueReplayer replayer(size, values);
+  element.evaluate_dofs(w, replayer, vertex_coordinates, cell_orientation,
                         ufc_cell);
 }
 //-----------------------------------------------------------------------------
@@ -18,11 +18,13 @@
 // Modified by Garth N. Wells, 2009.
 //
 // First added:  2009-09-28
-// Last changed: 2011-01-19
+// Last changed: 2014-03-27
 
 #ifndef __GENERIC_FUNCTION_H
 #define __GENERIC_FUNCTION_H
 
+#include <utility>
+#include <vector>
 #include <ufc.h>
 #include <dolfin/common/Array.h>
 #include <dolfin/common/Variable.h>
@@ -71,6 +73,15 @@ namespace dolfin
     /// Evaluate at given point
     virtual void eval(Array<double>& values, const Array<double>& x) const;
 
+    /// Evaluate at multiple points in given cell. The coordinates of
+    /// point i are x[i*gdim], ..., x[(i + 1)*gdim - 1] (gdim is the
+    /// geometric dimension of the cell) and its values are stored in
+    /// values[i*value_size()], ... . The default implementation
+    /// calls eval() for each point. Sub-classes may overload this
+    /// function to avoid the overhead of evaluating point by point.
+    virtual void eval_batch(Array<double>& values, const Array<double>& x,
+                            const ufc::cell& cell) const;
+
     /// Restrict function to local cell (compute expansion coefficients w)
     virtual void restrict(double* w,
                           const FiniteElement& element,
@@ -127,13 +138,21 @@ namespace dolfin
 
   protected:
 
-    // Restrict as UFC function (by calling eval)
+    // Restrict as UFC function (by calling eval_batch for all points
+    // at which the element evaluates the function)
     void restrict_as_ufc_function(double* w,
                                   const FiniteElement& element,
                                   const Cell& dolfin_cell,
                                   const double* vertex_coordinates,
                                   const ufc::cell& ufc_cell) const;
 
+  private:
+
+    // Points and values used by restrict_as_ufc_function, kept
+    // between calls to avoid allocation (one pair per thread)
+    mutable std::vector<std::pair<std::vector<double>,
+                                  std::vector<double> > > _restrict_buffers;
+
   };
 
 }
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-04-09
-// Last changed: 2014-02-06
+// Last changed: 2014-03-27
 
 #include <dolfin/common/NoDeleter.h>
 #include <dolfin/geometry/Point.h>
@@ -100,6 +100,24 @@ void BoundingBoxTree::build(const std::vector<Point>& points, std::size_t gdim)
   _tree->build(points);
 }
 //-----------------------------------------------------------------------------
+bool BoundingBoxTree::refit(double max_degradation)
+{
+  // Check that tree has been built
+  check_built();
+
+  // Refit only possible for trees built for mesh entities
+  if (!_mesh)
+  {
+    dolfin_error("BoundingBoxTree.cpp",
+                 "refit bounding box tree",
+                 "Refit is only implemented for bounding box trees of mesh entities");
+  }
+
+  // Delegate call to implementation
+  dolfin_assert(_tree);
+  return _tree->refit(*_mesh, max_degradation);
+}
+//-----------------------------------------------------------------------------
 std::vector<unsigned int>
 BoundingBoxTree::compute_collisions(const Point& point) const
 {
@@ -195,6 +213,28 @@ BoundingBoxTree::compute_closest_point(const Point& point) const
   return _tree->compute_closest_point(point);
 }
 //-----------------------------------------------------------------------------
+void BoundingBoxTree::build_global_tree() const
+{
+  // Check that tree has been built
+  check_built();
+
+  // Delegate call to implementation
+  dolfin_assert(_tree);
+  dolfin_assert(_mesh);
+  _tree->build_global_tree(*_mesh);
+}
+//-----------------------------------------------------------------------------
+std::vector<unsigned int>
+BoundingBoxTree::compute_process_collisions(const Point& point) const
+{
+  // Check that tree has been built
+  check_built();
+
+  // Delegate call to implementation
+  dolfin_assert(_tree);
+  return _tree->compute_process_collisions(point);
+}
+//-----------------------------------------------------------------------------
 void BoundingBoxTree::check_built() const
 {
   if (!_tree)
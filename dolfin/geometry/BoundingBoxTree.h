@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-04-09
-// Last changed: 2014-02-06
+// Last changed: 2014-03-27
 
 #ifndef __BOUNDING_BOX_TREE_H
 #define __BOUNDING_BOX_TREE_H
@@ -74,6 +74,25 @@ namespace dolfin
     ///         The geometric dimension.
     void build(const std::vector<Point>& points, std::size_t gdim);
 
+    /// Update the bounding boxes after the mesh coordinates have
+    /// changed (but not the mesh topology). The hierarchy of the
+    /// tree is kept and the bounding boxes are recomputed from the
+    /// leaves up. The tree is instead rebuilt if the number of
+    /// entities has changed or if the quality of the refitted tree
+    /// has degraded by more than the given factor. The quality is
+    /// measured by the total surface area of all internal bounding
+    /// boxes relative to the root bounding box.
+    ///
+    /// *Arguments*
+    ///     max_degradation (double)
+    ///         Largest allowed increase of the cost of the tree
+    ///         compared to when it was built (default 2.0).
+    ///
+    /// *Returns*
+    ///     bool
+    ///         True if the tree was refitted, false if it was rebuilt.
+    bool refit(double max_degradation=2.0);
+
     /// Compute all collisions between bounding boxes and _Point_.
     ///
     /// *Returns*
@@ -226,6 +245,26 @@ namespace dolfin
     std::pair<unsigned int, double>
     compute_closest_point(const Point& point) const;
 
+    /// Build tree of the bounding boxes of the local meshes on all
+    /// processes. This function is collective and must be called on
+    /// all processes before compute_process_collisions(). The tree
+    /// is rebuilt on every call.
+    void build_global_tree() const;
+
+    /// Compute all processes with local mesh bounding boxes that
+    /// collide with (contain) _Point_. The global tree must have been
+    /// built by build_global_tree().
+    ///
+    /// *Returns*
+    ///     std::vector<unsigned int>
+    ///         A list of process numbers.
+    ///
+    /// *Arguments*
+    ///     point (_Point_)
+    ///         The point.
+    std::vector<unsigned int>
+    compute_process_collisions(const Point& point) const;
+
   private:
 
     // Check that tree has been built
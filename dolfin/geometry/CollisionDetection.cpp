@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2014-02-03
-// Last changed: 2014-02-24
+// Last changed: 2014-03-27
 //
 //-----------------------------------------------------------------------------
 // Special note regarding the function collides_tetrahedron_tetrahedron
@@ -216,6 +216,17 @@ bool CollisionDetection::collides_triangle_point(const MeshEntity& triangle,
 
   const MeshGeometry& geometry = triangle.mesh().geometry();
   const unsigned int* vertices = triangle.entities(0);
+
+  // Use coordinates directly for triangles in the plane
+  if (geometry.dim() == 2)
+  {
+    const double point_x[2] = {point.x(), point.y()};
+    return collides_triangle_point_2d(geometry.x(vertices[0]),
+                                      geometry.x(vertices[1]),
+                                      geometry.x(vertices[2]),
+                                      point_x);
+  }
+
   return collides_triangle_point(geometry.point(vertices[0]),
 				 geometry.point(vertices[1]),
 				 geometry.point(vertices[2]),
@@ -249,15 +260,15 @@ CollisionDetection::collides_tetrahedron_point(const MeshEntity& tetrahedron,
 {
   dolfin_assert(tetrahedron.mesh().topology().dim() == 3);
 
-  // Get the vertices as points
+  // Get the vertex coordinates
   const MeshGeometry& geometry = tetrahedron.mesh().geometry();
   const unsigned int* vertices = tetrahedron.entities(0);
 
-  return collides_tetrahedron_point(geometry.point(vertices[0]),
-				    geometry.point(vertices[1]),
-				    geometry.point(vertices[2]),
-				    geometry.point(vertices[3]),
-				    point);
+  return collides_tetrahedron_point(geometry.x(vertices[0]),
+                                    geometry.x(vertices[1]),
+                                    geometry.x(vertices[2]),
+                                    geometry.x(vertices[3]),
+                                    point.coordinates());
 }
 //-----------------------------------------------------------------------------
 bool
@@ -496,6 +507,33 @@ bool CollisionDetection::collides_triangle_point(const Point& p0,
   return x1 >= -eps && x2 >= -eps && x1 + x2 <= 1.0 + eps;
 }
 //-----------------------------------------------------------------------------
+bool CollisionDetection::collides_triangle_point_2d(const double* p0,
+                                                    const double* p1,
+                                                    const double* p2,
+                                                    const double* point)
+{
+  // Same test as collides_triangle_point, but for triangles in the
+  // plane the coefficients are computed directly by Cramer's rule
+
+  // Compute vectors
+  const double v1[2] = {p1[0] - p0[0], p1[1] - p0[1]};
+  const double v2[2] = {p2[0] - p0[0], p2[1] - p0[1]};
+  const double v[2] = {point[0] - p0[0], point[1] - p0[1]};
+
+  // Solve linear system
+  const double inv_det = 1.0/(v1[0]*v2[1] - v1[1]*v2[0]);
+  const double x1 = inv_det*(v[0]*v2[1] - v[1]*v2[0]);
+  const double x2 = inv_det*(v1[0]*v[1] - v1[1]*v[0]);
+
+  // Tolerance for numeric test (using vector v1)
+  const double dx = std::abs(v1[0]);
+  const double dy = std::abs(v1[1]);
+  const double eps = std::max(DOLFIN_EPS_LARGE, DOLFIN_EPS_LARGE*std::max(dx, dy));
+
+  // Check if point is inside
+  return (x1 >= -eps) & (x2 >= -eps) & (x1 + x2 <= 1.0 + eps);
+}
+//-----------------------------------------------------------------------------
 bool
 CollisionDetection::collides_triangle_triangle(const Point& p0,
 					       const Point& p1,
@@ -646,53 +684,56 @@ CollisionDetection::collides_tetrahedron_point(const Point& p0,
 					       const Point& p3,
 					       const Point& point)
 {
-  // Algorithm from http://www.blackpawn.com/texts/pointinpoly/
-  // See also "Real-Time Collision Detection" by Christer Ericson.
-  //
+  return collides_tetrahedron_point(p0.coordinates(), p1.coordinates(),
+                                    p2.coordinates(), p3.coordinates(),
+                                    point.coordinates());
+}
+//-----------------------------------------------------------------------------
+bool
+CollisionDetection::collides_tetrahedron_point(const double* p0,
+                                               const double* p1,
+                                               const double* p2,
+                                               const double* p3,
+                                               const double* point)
+{
   // We express AP as a linear combination of the vectors AB, AC and
-  // AD. Point is inside triangle iff AP is a convex combination.
+  // AD. Point is inside tetrahedron iff AP is a convex combination.
+  // The coefficients are computed by Cramer's rule, with all
+  // arithmetic done without branches so that it may be vectorized.
 
   // Compute vectors
-  const Point v1 = p1 - p0;
-  const Point v2 = p2 - p0;
-  const Point v3 = p3 - p0;
-  const Point v = point - p0;
-
-  // Compute entries of linear system
-  const double a11 = v1.dot(v1);
-  const double a12 = v1.dot(v2);
-  const double a13 = v1.dot(v3);
-  const double a22 = v2.dot(v2);
-  const double a23 = v2.dot(v3);
-  const double a33 = v3.dot(v3);
-  const double b1 = v.dot(v1);
-  const double b2 = v.dot(v2);
-  const double b3 = v.dot(v3);
-
-  // Compute subdeterminants
-  const double d11 = a22*a33 - a23*a23;
-  const double d12 = a12*a33 - a23*a13;
-  const double d13 = a12*a23 - a22*a13;
-  const double d22 = a11*a33 - a13*a13;
-  const double d23 = a11*a23 - a12*a13;
-  const double d33 = a11*a22 - a12*a12;
-
-  // Compute inverse of determinant determinant
-  const double inv_det = 1.0 / (a11*d11 - a12*d12 + a13*d13);
+  const double v1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+  const double v2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+  const double v3[3] = {p3[0] - p0[0], p3[1] - p0[1], p3[2] - p0[2]};
+  const double v[3] = {point[0] - p0[0], point[1] - p0[1], point[2] - p0[2]};
+
+  // Compute cross products v2 x v3, v3 x v1 and v1 x v2
+  const double c1[3] = {v2[1]*v3[2] - v2[2]*v3[1],
+                        v2[2]*v3[0] - v2[0]*v3[2],
+                        v2[0]*v3[1] - v2[1]*v3[0]};
+  const double c2[3] = {v3[1]*v1[2] - v3[2]*v1[1],
+                        v3[2]*v1[0] - v3[0]*v1[2],
+                        v3[0]*v1[1] - v3[1]*v1[0]};
+  const double c3[3] = {v1[1]*v2[2] - v1[2]*v2[1],
+                        v1[2]*v2[0] - v1[0]*v2[2],
+                        v1[0]*v2[1] - v1[1]*v2[0]};
+
+  // Compute inverse of determinant
+  const double inv_det = 1.0/(v1[0]*c1[0] + v1[1]*c1[1] + v1[2]*c1[2]);
 
   // Solve linear system
-  const double x1 = inv_det*( d11*b1 - d12*b2 + d13*b3);
-  const double x2 = inv_det*(-d12*b1 + d22*b2 - d23*b3);
-  const double x3 = inv_det*( d13*b1 - d23*b2 + d33*b3);
+  const double x1 = inv_det*(v[0]*c1[0] + v[1]*c1[1] + v[2]*c1[2]);
+  const double x2 = inv_det*(v[0]*c2[0] + v[1]*c2[1] + v[2]*c2[2]);
+  const double x3 = inv_det*(v[0]*c3[0] + v[1]*c3[1] + v[2]*c3[2]);
 
   // Tolerance for numeric test (using vector v1)
-  const double dx = std::abs(v1.x());
-  const double dy = std::abs(v1.y());
-  const double dz = std::abs(v1.z());
+  const double dx = std::abs(v1[0]);
+  const double dy = std::abs(v1[1]);
+  const double dz = std::abs(v1[2]);
   const double eps = std::max(DOLFIN_EPS_LARGE, DOLFIN_EPS_LARGE*std::max(dx, std::max(dy, dz)));
 
   // Check if point is inside cell
-  return x1 >= -eps && x2 >= -eps && x3 >= -eps && x1 + x2 + x3 <= 1.0 + eps;
+  return (x1 >= -eps) & (x2 >= -eps) & (x3 >= -eps) & (x1 + x2 + x3 <= 1.0 + eps);
 }
 //-----------------------------------------------------------------------------
 bool
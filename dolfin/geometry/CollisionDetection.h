@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2014-02-03
-// Last changed: 2014-02-24
+// Last changed: 2014-03-27
 
 #include <vector>
 #include <dolfin/log/log.h>
@@ -190,6 +190,21 @@ namespace dolfin
 					   const Point& p3,
 					   const Point& point);
 
+    // Point-in-triangle test for triangles in the plane (raw
+    // coordinates, without branches in the arithmetic)
+    static bool collides_triangle_point_2d(const double* p0,
+                                           const double* p1,
+                                           const double* p2,
+                                           const double* point);
+
+    // Point-in-tetrahedron test (raw coordinates, without branches
+    // in the arithmetic)
+    static bool collides_tetrahedron_point(const double* p0,
+                                           const double* p1,
+                                           const double* p2,
+                                           const double* p3,
+                                           const double* point);
+
     // The implementation of collides_tetrahedron_triangle
     static bool collides_tetrahedron_triangle(const Point& p0,
 					      const Point& p1,
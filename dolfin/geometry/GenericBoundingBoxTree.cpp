@@ -16,18 +16,31 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-05-02
-// Last changed: 2014-02-06
+// Last changed: 2014-03-27
 
 // Define a maximum dimension used for a local array in the recursive
 // build function. Speeds things up compared to allocating it in each
 // recursion and is more convenient than sending it around.
 #define MAX_DIM 6
 
+// Number of bins used for evaluating the surface area heuristic
+#define SAH_NUM_BINS 16
+
+// Size of the stack used for searching wide nodes. A search pushes
+// at most three more children than it pops per level, so trees of
+// height up to (WIDE_STACK_SIZE - 1)/3 wide nodes may be searched.
+// Wide nodes are not used for deeper trees.
+#define WIDE_STACK_SIZE 256
+
+#include <dolfin/common/MPI.h>
+#include <dolfin/common/constants.h>
 #include <dolfin/geometry/Point.h>
 #include <dolfin/mesh/Mesh.h>
 #include <dolfin/mesh/Cell.h>
 #include <dolfin/mesh/MeshEntity.h>
 #include <dolfin/mesh/MeshEntityIterator.h>
+#include <dolfin/mesh/MeshEntityRange.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "BoundingBoxTree1D.h" // used for internal point search tree
 #include "BoundingBoxTree2D.h" // used for internal point search tree
 #include "BoundingBoxTree3D.h" // used for internal point search tree
@@ -35,8 +48,98 @@
 
 using namespace dolfin;
 
+// Helper class for GenericBoundingBoxTree::split_sah. Accumulates
+// the number and the bounding box of bounding boxes in a bin.
+class SAHBin
+{
+public:
+
+  SAHBin(std::size_t gdim) : count(0), _gdim(gdim)
+  {
+    std::fill(_b, _b + gdim, std::numeric_limits<double>::max());
+    std::fill(_b + gdim, _b + 2*gdim, -std::numeric_limits<double>::max());
+  }
+
+  // Add bounding box
+  void add(const double* b)
+  {
+    for (std::size_t j = 0; j < _gdim; ++j)
+    {
+      _b[j] = std::min(_b[j], b[j]);
+      _b[_gdim + j] = std::max(_b[_gdim + j], b[_gdim + j]);
+    }
+    ++count;
+  }
+
+  // Add bin
+  void add(const SAHBin& bin)
+  {
+    for (std::size_t j = 0; j < _gdim; ++j)
+    {
+      _b[j] = std::min(_b[j], bin._b[j]);
+      _b[_gdim + j] = std::max(_b[_gdim + j], bin._b[_gdim + j]);
+    }
+    count += bin.count;
+  }
+
+  // Return half the surface area of bounding box (length in 1D)
+  double half_area() const
+  {
+    if (_gdim == 1)
+      return _b[1] - _b[0];
+    double area = 0.0;
+    for (std::size_t i = 0; i < _gdim; ++i)
+      for (std::size_t j = i + 1; j < _gdim; ++j)
+        area += (_b[_gdim + i] - _b[i])*(_b[_gdim + j] - _b[j]);
+    return area;
+  }
+
+  std::size_t count;
+
+private:
+
+  const std::size_t _gdim;
+  double _b[MAX_DIM];
+
+};
+
+// Helper class for GenericBoundingBoxTree::split_sah. Checks whether
+// the midpoint of a bounding box falls in a bin below the split.
+class SAHBinLess
+{
+public:
+
+  SAHBinLess(const std::vector<double>& leaf_bboxes, std::size_t gdim,
+             std::size_t axis, double c_min, double scale, std::size_t split)
+    : _leaf_bboxes(leaf_bboxes), _gdim(gdim), _axis(axis), _c_min(c_min),
+      _scale(scale), _split(split) {}
+
+  // Compute bin of bounding box
+  std::size_t bin(unsigned int i) const
+  {
+    const double* b = _leaf_bboxes.data() + 2*_gdim*i;
+    const double c = b[_axis] + b[_gdim + _axis];
+    const std::size_t k = static_cast<std::size_t>((c - _c_min)*_scale);
+    return std::min<std::size_t>(k, SAH_NUM_BINS - 1);
+  }
+
+  bool operator()(unsigned int i) const
+  { return bin(i) < _split; }
+
+private:
+
+  const std::vector<double>& _leaf_bboxes;
+  const std::size_t _gdim;
+  const std::size_t _axis;
+  const double _c_min;
+  const double _scale;
+  const std::size_t _split;
+
+};
+
 //-----------------------------------------------------------------------------
-GenericBoundingBoxTree::GenericBoundingBoxTree() : _tdim(0)
+GenericBoundingBoxTree::GenericBoundingBoxTree()
+  : _tdim(0), _built_from_mesh(false), _cost(0.0)
 {
   // Do nothing
 }
@@ -58,6 +161,7 @@ void GenericBoundingBoxTree::build(const Mesh& mesh, std::size_t tdim)
   // Store topological dimension (only used for checking that entity
   // collisions can only be computed with cells)
   _tdim = tdim;
+  _built_from_mesh = true;
 
   // Initialize entities of given dimension if they don't exist
   mesh.init(tdim);
@@ -66,16 +170,23 @@ void GenericBoundingBoxTree::build(const Mesh& mesh, std::size_t tdim)
   const std::size_t _gdim = gdim();
   const unsigned int num_leaves = mesh.num_entities(tdim);
   std::vector<double> leaf_bboxes(2*_gdim*num_leaves);
-  for (MeshEntityIterator it(mesh, tdim); !it.end(); ++it)
-    compute_bbox_of_entity(leaf_bboxes.data() + 2*_gdim*it->index(), *it, _gdim);
+  #ifdef HAS_OPENMP
+  const std::size_t num_threads = MeshEntityRange::num_threads();
+  #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t i = 0; i < num_leaves; ++i)
+  {
+    const MeshEntity entity(mesh, tdim, i);
+    compute_bbox_of_entity(leaf_bboxes.data() + 2*_gdim*i, entity, _gdim);
+  }
 
   // Create leaf partition (to be sorted)
   std::vector<unsigned int> leaf_partition(num_leaves);
   for (unsigned int i = 0; i < num_leaves; ++i)
     leaf_partition[i] = i;
 
-  // Recursively build the bounding box tree from the leaves
-  _build(leaf_bboxes, leaf_partition.begin(), leaf_partition.end(), _gdim);
+  // Build the bounding box tree from the leaves
+  build_tree(leaf_bboxes, leaf_partition, _gdim);
 
   log(PROGRESS,
       "Computed bounding box tree with %d nodes for %d entities.",
@@ -100,12 +211,91 @@ void GenericBoundingBoxTree::build(const std::vector<Point>& points)
        num_bboxes(), num_leaves);
 }
 //-----------------------------------------------------------------------------
+bool GenericBoundingBoxTree::refit(const Mesh& mesh, double max_degradation)
+{
+  // Refit only implemented for trees of mesh entities
+  if (!_built_from_mesh)
+  {
+    dolfin_error("GenericBoundingBoxTree.cpp",
+                 "refit bounding box tree",
+                 "Bounding box tree was built from a point cloud, not from mesh entities");
+  }
+
+  // Rebuild tree if the number of entities has changed
+  const std::size_t tdim = _tdim;
+  const std::size_t num_nodes = num_bboxes();
+  if (num_nodes == 0 || mesh.num_entities(tdim) != (num_nodes + 1)/2)
+  {
+    build(mesh, tdim);
+    return false;
+  }
+
+  // Recompute bounding boxes of leaves
+  const std::size_t _gdim = gdim();
+  #ifdef HAS_OPENMP
+  const std::size_t num_threads = MeshEntityRange::num_threads();
+  #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t node = 0; node < num_nodes; ++node)
+  {
+    const BBox& bbox = _bboxes[node];
+    if (is_leaf(bbox, node))
+    {
+      const MeshEntity entity(mesh, tdim, bbox.child_1);
+      compute_bbox_of_entity(_bbox_coordinates.data() + 2*_gdim*node,
+                             entity, _gdim);
+    }
+  }
+
+  // Propagate bounds to internal nodes. Children are always stored
+  // before their parent, so one sweep over the nodes is enough.
+  for (std::size_t node = 0; node < num_nodes; ++node)
+  {
+    const BBox& bbox = _bboxes[node];
+    if (is_leaf(bbox, node))
+      continue;
+
+    double* b = _bbox_coordinates.data() + 2*_gdim*node;
+    const double* b0 = _bbox_coordinates.data() + 2*_gdim*bbox.child_0;
+    const double* b1 = _bbox_coordinates.data() + 2*_gdim*bbox.child_1;
+    for (std::size_t j = 0; j < _gdim; ++j)
+    {
+      b[j] = std::min(b0[j], b1[j]);
+      b[_gdim + j] = std::max(b0[_gdim + j], b1[_gdim + j]);
+    }
+  }
+
+  // Search trees built from the old coordinates are no longer valid
+  _point_search_tree.reset();
+  _global_tree.reset();
+
+  // Rebuild tree if quality has degraded too much
+  const double cost = compute_cost();
+  if (cost > max_degradation*_cost)
+  {
+    log(PROGRESS,
+        "Rebuilding bounding box tree (cost increased from %g to %g).",
+        _cost, cost);
+    build(mesh, tdim);
+    return false;
+  }
+
+  // Update wide nodes
+  build_wide_nodes();
+
+  return true;
+}
+//-----------------------------------------------------------------------------
 std::vector<unsigned int>
 GenericBoundingBoxTree::compute_collisions(const Point& point) const
 {
-  // Call recursive find function
+  // Search wide nodes if available, otherwise call recursive find
+  // function
   std::vector<unsigned int> entities;
-  _compute_collisions(*this, point, num_bboxes() - 1, entities, 0);
+  if (!_wide_children.empty())
+    compute_collisions_wide(point, &entities, 0);
+  else
+    _compute_collisions(*this, point, num_bboxes() - 1, entities, 0);
 
   return entities;
 }
@@ -141,9 +331,13 @@ GenericBoundingBoxTree::compute_entity_collisions(const Point& point,
                  "Point-in-entity is only implemented for cells");
   }
 
-  // Call recursive find function to compute bounding box candidates
+  // Search wide nodes if available, otherwise call recursive find
+  // function
   std::vector<unsigned int> entities;
-  _compute_collisions(*this, point, num_bboxes() - 1, entities, &mesh);
+  if (!_wide_children.empty())
+    compute_collisions_wide(point, &entities, &mesh);
+  else
+    _compute_collisions(*this, point, num_bboxes() - 1, entities, &mesh);
 
   return entities;
 }
@@ -172,6 +366,10 @@ GenericBoundingBoxTree::compute_entity_collisions(const GenericBoundingBoxTree&
 unsigned int
 GenericBoundingBoxTree::compute_first_collision(const Point& point) const
 {
+  // Search wide nodes if available
+  if (!_wide_children.empty())
+    return compute_collisions_wide(point, 0, 0);
+
   // Call recursive find function
   return _compute_first_collision(*this, point, num_bboxes() - 1);
 }
@@ -188,6 +386,10 @@ GenericBoundingBoxTree::compute_first_entity_collision(const Point& point,
                  "Point-in-entity is only implemented for cells");
   }
 
+  // Search wide nodes if available
+  if (!_wide_children.empty())
+    return compute_collisions_wide(point, 0, &mesh);
+
   // Call recursive find function
   return _compute_first_entity_collision(*this, point, num_bboxes() - 1, mesh);
 }
@@ -252,24 +454,167 @@ GenericBoundingBoxTree::compute_closest_point(const Point& point) const
   return ret;
 }
 //-----------------------------------------------------------------------------
+void GenericBoundingBoxTree::build_global_tree(const Mesh& mesh) const
+{
+  const MPI_Comm mpi_comm = mesh.mpi_comm();
+  const std::size_t num_processes = MPI::size(mpi_comm);
+  const std::size_t _gdim = gdim();
+
+  // Get bounding box of local mesh (root bounding box). Processes
+  // with an empty tree send a dummy box and are not added to the
+  // global tree.
+  std::vector<double> local_bbox(2*_gdim + 1, 0.0);
+  if (num_bboxes() > 0)
+  {
+    const double* b = get_bbox_coordinates(num_bboxes() - 1);
+    std::copy(b, b + 2*_gdim, local_bbox.begin());
+    local_bbox[2*_gdim] = 1.0;
+  }
+
+  // Gather bounding boxes from all processes
+  std::vector<double> bboxes;
+  MPI::all_gather(mpi_comm, local_bbox, bboxes);
+
+  // Extract leaf bounding boxes, indexed by process number
+  std::vector<double> leaf_bboxes(2*_gdim*num_processes);
+  std::vector<unsigned int> leaf_partition;
+  for (std::size_t p = 0; p < num_processes; ++p)
+  {
+    const double* b = bboxes.data() + p*(2*_gdim + 1);
+    std::copy(b, b + 2*_gdim, leaf_bboxes.begin() + 2*_gdim*p);
+    if (b[2*_gdim] > 0.0)
+      leaf_partition.push_back(p);
+  }
+
+  // Select implementation
+  switch (_gdim)
+  {
+  case 1:
+    _global_tree.reset(new BoundingBoxTree1D());
+    break;
+  case 2:
+    _global_tree.reset(new BoundingBoxTree2D());
+    break;
+  case 3:
+    _global_tree.reset(new BoundingBoxTree3D());
+    break;
+  default:
+    dolfin_error("GenericBoundingBoxTree.cpp",
+                 "build global bounding box tree",
+                 "Not implemented for geometric dimension %d",
+                 _gdim);
+  }
+
+  // Build tree
+  dolfin_assert(_global_tree);
+  if (!leaf_partition.empty())
+  {
+    _global_tree->build_tree(leaf_bboxes, leaf_partition, _gdim);
+  }
+
+  log(PROGRESS,
+      "Computed global bounding box tree with %d nodes for %d processes.",
+      _global_tree->num_bboxes(), leaf_partition.size());
+}
+//-----------------------------------------------------------------------------
+std::vector<unsigned int>
+GenericBoundingBoxTree::compute_process_collisions(const Point& point) const
+{
+  if (!_global_tree)
+  {
+    dolfin_error("GenericBoundingBoxTree.cpp",
+                 "compute collisions between point and processes",
+                 "Global bounding box tree has not been built. You need to call build_global_tree()");
+  }
+
+  // Call recursive find function
+  std::vector<unsigned int> processes;
+  if (_global_tree->num_bboxes() > 0)
+  {
+    _compute_collisions(*_global_tree, point,
+                        _global_tree->num_bboxes() - 1, processes, 0);
+  }
+
+  return processes;
+}
+//-----------------------------------------------------------------------------
 // Implementation of protected functions
 //-----------------------------------------------------------------------------
 void GenericBoundingBoxTree::clear()
 {
   _tdim = 0;
+  _built_from_mesh = false;
   _bboxes.clear();
   _bbox_coordinates.clear();
   _point_search_tree.reset();
+  _global_tree.reset();
+  _wide_bbox_coordinates.clear();
+  _wide_children.clear();
 }
 //-----------------------------------------------------------------------------
-unsigned int
+void
+GenericBoundingBoxTree::build_tree(const std::vector<double>& leaf_bboxes,
+                                   std::vector<unsigned int>& leaf_partition,
+                                   std::size_t gdim)
+{
+  // Allocate nodes (a binary tree with n leaves has 2n - 1 nodes)
+  const unsigned int num_leaves = leaf_partition.size();
+  dolfin_assert(num_leaves > 0);
+  const unsigned int num_nodes = 2*num_leaves - 1;
+  _bboxes.resize(num_nodes);
+  _bbox_coordinates.resize(2*gdim*num_nodes);
+
+  // Get split strategy
+  const std::string split = parameters["bounding_box_tree_split"];
+  const bool sah = (split == "sah");
+
+  // Build top of tree, leaving a few subtrees per thread to be built
+  // in parallel (or the whole tree if running serially)
+  const std::size_t num_threads = MeshEntityRange::num_threads();
+  std::size_t subtree_size = num_leaves;
+  if (num_threads > 1)
+    subtree_size = std::max<std::size_t>(num_leaves/(8*num_threads), 64);
+  std::vector<Subtree> subtrees;
+  _build(leaf_bboxes, leaf_partition.begin(), leaf_partition.end(), gdim,
+         num_nodes - 1, sah, &subtrees, subtree_size);
+
+  // Build subtrees
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t i = 0; i < subtrees.size(); ++i)
+  {
+    _build(leaf_bboxes, subtrees[i].begin, subtrees[i].end, gdim,
+           subtrees[i].node, sah, 0, 0);
+  }
+
+  // Store cost for checking quality of refitted tree
+  _cost = compute_cost();
+
+  // Build wide nodes for point queries
+  build_wide_nodes();
+}
+//-----------------------------------------------------------------------------
+void
 GenericBoundingBoxTree::_build(const std::vector<double>& leaf_bboxes,
                                const std::vector<unsigned int>::iterator& begin,
                                const std::vector<unsigned int>::iterator& end,
-                               std::size_t gdim)
+                               std::size_t gdim,
+                               unsigned int node,
+                               bool sah,
+                               std::vector<Subtree>* subtrees,
+                               std::size_t subtree_size)
 {
   dolfin_assert(begin < end);
 
+  // Leave subtree to be built later
+  if (subtrees && static_cast<std::size_t>(end - begin) <= subtree_size)
+  {
+    const Subtree subtree = {begin, end, node};
+    subtrees->push_back(subtree);
+    return;
+  }
+
   // Create empty bounding box data
   BBox bbox;
 
@@ -281,9 +626,10 @@ GenericBoundingBoxTree::_build(const std::vector<double>& leaf_bboxes,
     const double* b = leaf_bboxes.data() + 2*gdim*entity_index;
 
     // Store bounding box data
-    bbox.child_0 = num_bboxes(); // child_0 == node denotes a leaf
+    bbox.child_0 = node;         // child_0 == node denotes a leaf
     bbox.child_1 = entity_index; // index of entity contained in leaf
-    return add_bbox(bbox, b, gdim);
+    set_bbox(node, bbox, b, gdim);
+    return;
   }
 
   // Compute bounding box of all bounding boxes
@@ -291,16 +637,30 @@ GenericBoundingBoxTree::_build(const std::vector<double>& leaf_bboxes,
   std::size_t axis;
   compute_bbox_of_bboxes(b, axis, leaf_bboxes, begin, end);
 
-  // Sort bounding boxes along longest axis
-  std::vector<unsigned int>::iterator middle = begin + (end - begin) / 2;
-  sort_bboxes(axis, leaf_bboxes, begin, middle, end);
-
-  // Split bounding boxes into two groups and call recursively
-  bbox.child_0 = _build(leaf_bboxes, begin, middle, gdim);
-  bbox.child_1 = _build(leaf_bboxes, middle, end, gdim);
+  // Split by the surface area heuristic if requested, otherwise (or
+  // if that fails) sort bounding boxes along longest axis
+  std::vector<unsigned int>::iterator middle = end;
+  if (sah)
+    middle = split_sah(leaf_bboxes, begin, end, gdim);
+  if (middle == begin || middle == end)
+  {
+    middle = begin + (end - begin) / 2;
+    sort_bboxes(axis, leaf_bboxes, begin, middle, end);
+  }
 
-  // Store bounding box data. Note that root box will be added last.
-  return add_bbox(bbox, b, gdim);
+  // Split bounding boxes into two groups and call recursively. The
+  // right subtree ends just before this node and the left subtree
+  // just before the right subtree.
+  const unsigned int num_right = end - middle;
+  bbox.child_0 = node - 2*num_right;
+  bbox.child_1 = node - 1;
+  _build(leaf_bboxes, begin, middle, gdim, bbox.child_0, sah,
+         subtrees, subtree_size);
+  _build(leaf_bboxes, middle, end, gdim, bbox.child_1, sah,
+         subtrees, subtree_size);
+
+  // Store bounding box data
+  set_bbox(node, bbox, b, gdim);
 }
 //-----------------------------------------------------------------------------
 unsigned int
@@ -637,6 +997,217 @@ GenericBoundingBoxTree::_compute_closest_point(const GenericBoundingBoxTree& tre
   }
 }
 //-----------------------------------------------------------------------------
+void GenericBoundingBoxTree::build_wide_nodes()
+{
+  _wide_bbox_coordinates.clear();
+  _wide_children.clear();
+  if (num_bboxes() == 0)
+    return;
+
+  // Collapsing two levels gives roughly half as many wide nodes as
+  // there are leaves
+  const unsigned int num_leaves = (num_bboxes() + 1)/2;
+  _wide_children.reserve(4*(num_leaves/2 + 1));
+  _wide_bbox_coordinates.reserve(8*gdim()*(num_leaves/2 + 1));
+
+  // Build recursively from root (root becomes wide node 0)
+  std::size_t height = 0;
+  _build_wide_node(num_bboxes() - 1, 1, height);
+
+  // Don't use wide nodes if the search stack may overflow
+  if (3*height + 1 > WIDE_STACK_SIZE)
+  {
+    std::vector<double>().swap(_wide_bbox_coordinates);
+    std::vector<unsigned int>().swap(_wide_children);
+  }
+}
+//-----------------------------------------------------------------------------
+unsigned int GenericBoundingBoxTree::_build_wide_node(unsigned int node,
+                                                      std::size_t depth,
+                                                      std::size_t& height)
+{
+  height = std::max(height, depth);
+  const unsigned int leaf_flag = 1u << 31;
+  const std::size_t _gdim = gdim();
+
+  // Collect children of the children of the node (or the children
+  // themselves when they are leaves)
+  unsigned int children[4];
+  std::size_t num_children = 0;
+  const BBox& bbox = get_bbox(node);
+  if (is_leaf(bbox, node))
+    children[num_children++] = node;
+  else
+  {
+    const unsigned int c[2] = {bbox.child_0, bbox.child_1};
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+      const BBox& child = get_bbox(c[i]);
+      if (is_leaf(child, c[i]))
+        children[num_children++] = c[i];
+      else
+      {
+        children[num_children++] = child.child_0;
+        children[num_children++] = child.child_1;
+      }
+    }
+  }
+
+  // Add wide node with empty boxes
+  const unsigned int wide_node = _wide_children.size()/4;
+  _wide_children.resize(_wide_children.size() + 4, 0);
+  const std::size_t offset = _wide_bbox_coordinates.size();
+  _wide_bbox_coordinates.resize(offset + 8*_gdim);
+  std::fill(_wide_bbox_coordinates.begin() + offset,
+            _wide_bbox_coordinates.begin() + offset + 4*_gdim,
+            std::numeric_limits<double>::max());
+  std::fill(_wide_bbox_coordinates.begin() + offset + 4*_gdim,
+            _wide_bbox_coordinates.end(),
+            -std::numeric_limits<double>::max());
+
+  // Store (expanded) bounding boxes of children
+  for (std::size_t k = 0; k < num_children; ++k)
+  {
+    const double* b = get_bbox_coordinates(children[k]);
+    for (std::size_t j = 0; j < _gdim; ++j)
+    {
+      const double eps = DOLFIN_EPS_LARGE*(b[_gdim + j] - b[j]);
+      _wide_bbox_coordinates[offset + 4*j + k] = b[j] - eps;
+      _wide_bbox_coordinates[offset + 4*(_gdim + j) + k] = b[_gdim + j] + eps;
+    }
+  }
+
+  // Add children (note that recursion appends to the arrays)
+  for (std::size_t k = 0; k < num_children; ++k)
+  {
+    const BBox& child = get_bbox(children[k]);
+    unsigned int c = 0;
+    if (is_leaf(child, children[k]))
+    {
+      dolfin_assert(child.child_1 < leaf_flag);
+      c = leaf_flag | child.child_1;
+    }
+    else
+      c = _build_wide_node(children[k], depth + 1, height);
+    _wide_children[4*wide_node + k] = c;
+  }
+
+  return wide_node;
+}
+//-----------------------------------------------------------------------------
+unsigned int
+GenericBoundingBoxTree::compute_collisions_wide(const Point& point,
+                                                std::vector<unsigned int>* entities,
+                                                const Mesh* mesh) const
+{
+  switch (gdim())
+  {
+  case 1:
+    return _compute_collisions_wide<1>(point, entities, mesh);
+  case 2:
+    return _compute_collisions_wide<2>(point, entities, mesh);
+  case 3:
+    return _compute_collisions_wide<3>(point, entities, mesh);
+  default:
+    dolfin_error("GenericBoundingBoxTree.cpp",
+                 "compute collisions with point",
+                 "Not implemented for geometric dimension %d",
+                 gdim());
+  }
+
+  return std::numeric_limits<unsigned int>::max();
+}
+//-----------------------------------------------------------------------------
+template <std::size_t gdim>
+unsigned int
+GenericBoundingBoxTree::_compute_collisions_wide(const Point& point,
+                                                 std::vector<unsigned int>* entities,
+                                                 const Mesh* mesh) const
+{
+  const unsigned int leaf_flag = 1u << 31;
+  const double* x = point.coordinates();
+
+  // Stack of children to visit, processed depth-first in the same
+  // order as the recursive search of the binary tree (the size is
+  // checked against the height of the tree in build_wide_nodes)
+  unsigned int stack[WIDE_STACK_SIZE];
+  std::size_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0)
+  {
+    const unsigned int child = stack[--stack_size];
+
+    // Check entity of leaf
+    if (child & leaf_flag)
+    {
+      const unsigned int entity_index = child & ~leaf_flag;
+      if (!mesh || Cell(*mesh, entity_index).collides(point))
+      {
+        if (!entities)
+          return entity_index;
+        entities->push_back(entity_index);
+      }
+      continue;
+    }
+
+    // Test point against all four child boxes at once (written
+    // without branches so that the loops may be vectorized)
+    const double* b = _wide_bbox_coordinates.data() + 8*gdim*child;
+    int inside[4] = {1, 1, 1, 1};
+    for (std::size_t j = 0; j < gdim; ++j)
+    {
+      const double* b_min = b + 4*j;
+      const double* b_max = b + 4*(gdim + j);
+      for (std::size_t k = 0; k < 4; ++k)
+        inside[k] &= (b_min[k] <= x[j]) & (x[j] <= b_max[k]);
+    }
+
+    // Push colliding children in reverse order
+    const unsigned int* children = _wide_children.data() + 4*child;
+    for (std::size_t k = 4; k-- > 0; )
+    {
+      if (inside[k])
+      {
+        dolfin_assert(stack_size < WIDE_STACK_SIZE);
+        stack[stack_size++] = children[k];
+      }
+    }
+  }
+
+  return std::numeric_limits<unsigned int>::max();
+}
+//-----------------------------------------------------------------------------
+double GenericBoundingBoxTree::compute_cost() const
+{
+  const std::size_t num_nodes = num_bboxes();
+  if (num_nodes == 0)
+    return 0.0;
+
+  // Compute half the surface area of all boxes (length in 1D)
+  const std::size_t _gdim = gdim();
+  double root_area = 0.0;
+  double sum = 0.0;
+  for (std::size_t node = 0; node < num_nodes; ++node)
+  {
+    if (is_leaf(_bboxes[node], node))
+      continue;
+
+    const double* b = _bbox_coordinates.data() + 2*_gdim*node;
+    double area = 0.0;
+    if (_gdim == 1)
+      area = b[1] - b[0];
+    for (std::size_t i = 0; i < _gdim; ++i)
+      for (std::size_t j = i + 1; j < _gdim; ++j)
+        area += (b[_gdim + i] - b[i])*(b[_gdim + j] - b[j]);
+
+    sum += area;
+    if (node == num_nodes - 1)
+      root_area = area;
+  }
+
+  return root_area > 0.0 ? sum/root_area : 0.0;
+}
+//-----------------------------------------------------------------------------
 void GenericBoundingBoxTree::build_point_search_tree(const Mesh& mesh) const
 {
   // Don't build search tree if it already exists
@@ -705,6 +1276,83 @@ void GenericBoundingBoxTree::compute_bbox_of_entity(double* b,
   }
 }
 //-----------------------------------------------------------------------------
+std::vector<unsigned int>::iterator
+GenericBoundingBoxTree::split_sah(const std::vector<double>& leaf_bboxes,
+                                  const std::vector<unsigned int>::iterator& begin,
+                                  const std::vector<unsigned int>::iterator& end,
+                                  std::size_t gdim) const
+{
+  typedef std::vector<unsigned int>::iterator iterator;
+
+  // Compute bounds of bounding box midpoints (times two)
+  double c_min[MAX_DIM/2];
+  double c_max[MAX_DIM/2];
+  std::fill(c_min, c_min + gdim, std::numeric_limits<double>::max());
+  std::fill(c_max, c_max + gdim, -std::numeric_limits<double>::max());
+  for (iterator it = begin; it != end; ++it)
+  {
+    const double* b = leaf_bboxes.data() + 2*gdim*(*it);
+    for (std::size_t j = 0; j < gdim; ++j)
+    {
+      const double c = b[j] + b[gdim + j];
+      c_min[j] = std::min(c_min[j], c);
+      c_max[j] = std::max(c_max[j], c);
+    }
+  }
+
+  // Split along axis with largest spread of midpoints
+  std::size_t axis = 0;
+  for (std::size_t j = 1; j < gdim; ++j)
+  {
+    if (c_max[j] - c_min[j] > c_max[axis] - c_min[axis])
+      axis = j;
+  }
+  const double extent = c_max[axis] - c_min[axis];
+  if (extent <= 0.0)
+    return end;
+
+  // Sort bounding boxes into bins by midpoint
+  const SAHBinLess binning(leaf_bboxes, gdim, axis, c_min[axis],
+                           SAH_NUM_BINS/extent, 0);
+  std::vector<SAHBin> bins(SAH_NUM_BINS, SAHBin(gdim));
+  for (iterator it = begin; it != end; ++it)
+    bins[binning.bin(*it)].add(leaf_bboxes.data() + 2*gdim*(*it));
+
+  // Sweep from the right to compute the cost of the right part for
+  // each split (split i is between bin i - 1 and bin i)
+  std::vector<double> right_cost(SAH_NUM_BINS, 0.0);
+  SAHBin right(gdim);
+  for (std::size_t i = SAH_NUM_BINS - 1; i > 0; --i)
+  {
+    right.add(bins[i]);
+    right_cost[i] = right.half_area()*right.count;
+  }
+
+  // Sweep from the left and find the split with the lowest cost
+  std::size_t best_split = 0;
+  double best_cost = std::numeric_limits<double>::max();
+  SAHBin left(gdim);
+  for (std::size_t i = 1; i < SAH_NUM_BINS; ++i)
+  {
+    left.add(bins[i - 1]);
+    if (left.count == 0 || left.count == static_cast<std::size_t>(end - begin))
+      continue;
+    const double cost = left.half_area()*left.count + right_cost[i];
+    if (cost < best_cost)
+    {
+      best_cost = cost;
+      best_split = i;
+    }
+  }
+  if (best_split == 0)
+    return end;
+
+  // Partition bounding boxes
+  return std::partition(begin, end,
+                        SAHBinLess(leaf_bboxes, gdim, axis, c_min[axis],
+                                   SAH_NUM_BINS/extent, best_split));
+}
+//-----------------------------------------------------------------------------
 void
 GenericBoundingBoxTree::sort_points(std::size_t axis,
                                     const std::vector<Point>& points,
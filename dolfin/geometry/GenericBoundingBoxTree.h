@@ -16,11 +16,12 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-04-23
-// Last changed: 2014-02-06
+// Last changed: 2014-03-27
 
 #ifndef __GENERIC_BOUNDING_BOX_TREE_H
 #define __GENERIC_BOUNDING_BOX_TREE_H
 
+#include <algorithm>
 #include <vector>
 #include <set>
 #include <dolfin/geometry/Point.h>
@@ -51,6 +52,12 @@ namespace dolfin
     /// Build bounding box tree for point cloud
     void build(const std::vector<Point>& points);
 
+    /// Recompute bounding boxes for mesh entities of the tree after
+    /// the coordinates have changed, rebuilding the tree if its
+    /// quality has degraded by more than the given factor. Returns
+    /// true if the tree was refitted, false if it was rebuilt.
+    bool refit(const Mesh& mesh, double max_degradation);
+
     /// Compute all collisions between bounding boxes and _Point_
     std::vector<unsigned int>
     compute_collisions(const Point& point) const;
@@ -83,6 +90,15 @@ namespace dolfin
     /// Compute closest point and distance to _Point_
     std::pair<unsigned int, double> compute_closest_point(const Point& point) const;
 
+    /// Build tree of bounding boxes of the local meshes on all
+    /// processes (collective)
+    void build_global_tree(const Mesh& mesh) const;
+
+    /// Compute all processes with local mesh bounding boxes colliding
+    /// with _Point_
+    std::vector<unsigned int>
+    compute_process_collisions(const Point& point) const;
+
   protected:
 
     // Bounding box data. Leaf nodes are indicated by setting child_0
@@ -97,25 +113,76 @@ namespace dolfin
     // Topological dimension of leaf entities
     std::size_t _tdim;
 
+    // True if tree was built from mesh entities (not a point cloud)
+    bool _built_from_mesh;
+
     // List of bounding boxes (parent-child-entity relations)
     std::vector<BBox> _bboxes;
 
     // List of bounding box coordinates
     std::vector<double> _bbox_coordinates;
 
+    // Cost of tree when it was built (see compute_cost)
+    double _cost;
+
+    // Wide (4-ary) nodes used to accelerate point queries, built
+    // from the binary tree by collapsing every other level. Each wide
+    // node stores the bounding boxes of its (up to) four children in
+    // structure-of-arrays layout, so that a point is tested against
+    // all children at once: along axis j, child k covers
+    // [b[4*j + k], b[4*(gdim + j) + k]]. The boxes are expanded by
+    // the same tolerance as in point_in_bbox(). Unused slots hold
+    // empty boxes.
+    std::vector<double> _wide_bbox_coordinates;
+
+    // Children of wide nodes (four per node). Leaves are marked by
+    // the highest bit, with the remaining bits holding the entity.
+    std::vector<unsigned int> _wide_children;
+
     // Point search tree used to accelerate distance queries
     mutable boost::scoped_ptr<GenericBoundingBoxTree> _point_search_tree;
 
+    // Tree of local mesh bounding boxes on all processes, with leaf
+    // entities being process numbers
+    mutable boost::scoped_ptr<GenericBoundingBoxTree> _global_tree;
+
+    // Subtree to be built, given by its range of leaves and the
+    // index of its root node
+    struct Subtree
+    {
+      std::vector<unsigned int>::iterator begin;
+      std::vector<unsigned int>::iterator end;
+      unsigned int node;
+    };
+
     // Clear existing data if any
     void clear();
 
+    // Build bounding box tree from leaf bounding boxes. The top of
+    // the tree is built serially and the remaining subtrees in
+    // parallel (parameter "num_threads"). Nodes are split at the
+    // median or by the surface area heuristic (parameter
+    // "bounding_box_tree_split").
+    void build_tree(const std::vector<double>& leaf_bboxes,
+                    std::vector<unsigned int>& leaf_partition,
+                    std::size_t gdim);
+
     //--- Recursive build functions ---
 
-    // Build bounding box tree for entities (recursive)
-    unsigned int _build(const std::vector<double>& leaf_bboxes,
-                        const std::vector<unsigned int>::iterator& begin,
-                        const std::vector<unsigned int>::iterator& end,
-                        std::size_t gdim);
+    // Build bounding box tree for entities (recursive). The subtree
+    // for m leaves occupies the 2m - 1 nodes ending at the given
+    // root node, in the same order as if the nodes were appended
+    // depth-first, so subtrees may be built independently. If
+    // subtrees is nonzero, recursion stops at subtrees with at most
+    // subtree_size leaves, which are added to the list instead.
+    void _build(const std::vector<double>& leaf_bboxes,
+                const std::vector<unsigned int>::iterator& begin,
+                const std::vector<unsigned int>::iterator& end,
+                std::size_t gdim,
+                unsigned int node,
+                bool sah,
+                std::vector<Subtree>* subtrees,
+                std::size_t subtree_size);
 
     // Build bounding box tree for points (recursive)
     unsigned int _build(const std::vector<Point>& points,
@@ -178,6 +245,35 @@ namespace dolfin
 
     //--- Utility functions ---
 
+    // Compute cost of tree, measured by the sum of the surface areas
+    // of all internal bounding boxes relative to the root bounding
+    // box. The cost increases as the overlap between boxes grows.
+    double compute_cost() const;
+
+    // Build wide nodes from binary tree
+    void build_wide_nodes();
+
+    // Build wide node for given binary node at given depth
+    // (recursive), updating the height of the wide tree
+    unsigned int _build_wide_node(unsigned int node, std::size_t depth,
+                                  std::size_t& height);
+
+    // Compute collisions with point using wide nodes. Entities are
+    // checked if mesh is nonzero. If entities is nonzero, all
+    // collisions are added to it; otherwise the search stops at the
+    // first collision, which is returned (or
+    // std::numeric_limits<unsigned int>::max() if none).
+    unsigned int compute_collisions_wide(const Point& point,
+                                         std::vector<unsigned int>* entities,
+                                         const Mesh* mesh) const;
+
+    // Compute collisions with point using wide nodes (implementation
+    // for given geometric dimension)
+    template <std::size_t gdim>
+    unsigned int _compute_collisions_wide(const Point& point,
+                                          std::vector<unsigned int>* entities,
+                                          const Mesh* mesh) const;
+
     // Compute point search tree if not already done
     void build_point_search_tree(const Mesh& mesh) const;
 
@@ -186,6 +282,14 @@ namespace dolfin
                                 const MeshEntity& entity,
                                 std::size_t gdim) const;
 
+    // Partition leaf bounding boxes by the surface area heuristic
+    // and return the split position (end if no useful split found)
+    std::vector<unsigned int>::iterator
+    split_sah(const std::vector<double>& leaf_bboxes,
+              const std::vector<unsigned int>::iterator& begin,
+              const std::vector<unsigned int>::iterator& end,
+              std::size_t gdim) const;
+
     // Sort points along given axis
     void sort_points(std::size_t axis,
                      const std::vector<Point>& points,
@@ -208,6 +312,16 @@ namespace dolfin
       return _bboxes.size() - 1;
     }
 
+    // Set bounding box and coordinates for given node
+    inline void set_bbox(unsigned int node,
+                         const BBox& bbox,
+                         const double* b,
+                         std::size_t gdim)
+    {
+      _bboxes[node] = bbox;
+      std::copy(b, b + 2*gdim, _bbox_coordinates.begin() + 2*gdim*node);
+    }
+
     // Return bounding box for given node
     inline const BBox& get_bbox(unsigned int node) const
     {
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2009-11-11
-// Last changed: 2011-11-23
+// Last changed: 2014-03-24
 
 #include <fstream>
 #include <istream>
@@ -109,6 +109,7 @@ void BinaryFile::operator>> (Mesh& mesh)
         read_array(size, &(c._connections)[0]);
         c.index_to_position.resize(num_entities + 1);
         read_array(c.index_to_position.size(), c.index_to_position.data());
+        c.compress();
       }
     }
   }
@@ -120,10 +121,6 @@ void BinaryFile::operator>> (Mesh& mesh)
   g.coordinates.resize(g._dim*size);
   read_array(g._dim*size, g.coordinates.data());
 
-  g.local_index_to_position.resize(size);
-  for (std::size_t i = 0; i < size; ++i)
-    g.local_index_to_position[i] = i;
-
   // Read cell type
   mesh._cell_type = CellType::create(static_cast<CellType::Type>(read_uint()));
 
@@ -200,9 +197,12 @@ void BinaryFile::operator<< (const Mesh& mesh)
         write_uint(c.size());
         if (!c.empty())
         {
-          write_uint(c.index_to_position.size() - 1);
+          std::vector<unsigned int> offsets(c.num_entities() + 1);
+          for (std::size_t e = 0; e < offsets.size(); e++)
+            offsets[e] = c.offset(e);
+          write_uint(c.num_entities());
           write_array(c.size(), c._connections.data());
-          write_array(c.index_to_position.size(), c.index_to_position.data());
+          write_array(offsets.size(), offsets.data());
         }
       }
       else
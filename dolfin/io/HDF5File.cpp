@@ -753,7 +753,7 @@ void HDF5File::write(const Function& u, const std::string name)
   for (std::size_t i = 0; i != mesh.num_cells(); ++i)
   {
     x_cell_dofs.push_back(cell_dofs.size());
-    const std::vector<dolfin::la_index>& cell_dofs_i = dofmap.cell_dofs(i);
+    const ArrayView<const dolfin::la_index> cell_dofs_i = dofmap.cell_dofs(i);
     cell_dofs.insert(cell_dofs.end(), cell_dofs_i.begin(), cell_dofs_i.end());
   }
 
@@ -148,7 +148,7 @@ void HDF5Utility::get_global_dof(
     const std::vector<std::size_t>& rdof = receive_cell_dofs[i];
     for (std::size_t j = 0; j < rdof.size(); j += 2)
     {
-      const std::vector<dolfin::la_index>& dmap = dofmap.cell_dofs(rdof[j]);
+      const ArrayView<const dolfin::la_index> dmap = dofmap.cell_dofs(rdof[j]);
       dolfin_assert(rdof[j + 1] < dmap.size());
       send_global_dof_back[i].push_back(dmap[rdof[j + 1]]);
     }
@@ -138,9 +138,8 @@ void GenericMatrix::compressed(GenericMatrix& B) const
   offset[0] = 0;
   std::vector<dolfin::la_index> thisrow(1);
   std::vector<dolfin::la_index> thiscolumn;
-  std::vector<const std::vector<dolfin::la_index>* > dofs(2);
-  dofs[0] = &thisrow;
-  dofs[1] = &thiscolumn;
+  std::vector<ArrayView<const dolfin::la_index> > dofs(2);
+  dofs[0].set(thisrow);
 
   // Iterate over rows
   for (std::size_t i = 0; i < m; i++)
@@ -166,7 +165,9 @@ void GenericMatrix::compressed(GenericMatrix& B) const
     thisrow[0] = global_row;
     offset[i + 1] = offset[i] + count;
 
-    // Build new compressed sparsity pattern
+    // Build new compressed sparsity pattern (update view since
+    // thiscolumn may have been reallocated)
+    dofs[1].set(thiscolumn);
     new_sparsity_pattern.insert(dofs);
   }
 
@@ -23,7 +23,7 @@
 // Modified by Mikael Mortensen 2011
 //
 // First added:  2006-04-24
-// Last changed: 2012-08-20
+// Last changed: 2014-03-18
 
 #ifndef __GENERIC_MATRIX_H
 #define __GENERIC_MATRIX_H
@@ -79,10 +79,10 @@ namespace dolfin
     /// Add block of values
     virtual void
       add(const double* block,
-          const std::vector<const std::vector<dolfin::la_index>* >& rows)
+          const std::vector<ArrayView<const dolfin::la_index> >& rows)
     {
-      add(block, (rows[0])->size(), &(*rows[0])[0], (rows[1])->size(),
-          &(*rows[1])[0]);
+      add(block, rows[0].size(), rows[0].data(), rows[1].size(),
+          rows[1].data());
     }
 
     /// Add block of values
@@ -202,6 +202,13 @@ namespace dolfin
                                   const double*, int>(0, 0, 0, 0);
    }
 
+    /// Return pointer to the values of the underlying compressed
+    /// storage (matrix_values in data()), or NULL if the backend does
+    /// not provide direct access. The values may be modified, but
+    /// not the nonzero structure. Intended for library use only.
+    virtual double* value_data()
+    { return 0; }
+
     //--- Convenience functions ---
 
     /// Get value of given entry
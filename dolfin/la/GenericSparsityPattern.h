@@ -20,7 +20,7 @@
 // Modified by Garth N. Wells, 2010.
 //
 // First added:  2007-11-30
-// Last changed: 2010-12-30
+// Last changed: 2014-03-19
 
 #ifndef __GENERIC_SPARSITY_PATTERN_H
 #define __GENERIC_SPARSITY_PATTERN_H
@@ -29,6 +29,7 @@
 #include <vector>
 #include <boost/unordered_map.hpp>
 
+#include <dolfin/common/ArrayView.h>
 #include <dolfin/common/types.h>
 #include <dolfin/common/MPI.h>
 #include <dolfin/common/Variable.h>
@@ -61,7 +62,31 @@ namespace dolfin
            unsigned int>* > off_process_owner) = 0;
 
     /// Insert non-zero entries
-    virtual void insert(const std::vector<const std::vector<dolfin::la_index>* >& entries) = 0;
+    virtual void
+      insert(const std::vector<ArrayView<const dolfin::la_index> >& entries) = 0;
+
+    /// Insert non-zero entries for a collection of dense blocks. The
+    /// indices of block k for dimension i are entries[i][j] for
+    /// offsets[i][k] <= j < offsets[i][k + 1]. Implementations may
+    /// use up to num_threads threads (0 means serial).
+    virtual void
+      insert_blocks(const std::vector<std::vector<dolfin::la_index> >& entries,
+                    const std::vector<std::vector<std::size_t> >& offsets,
+                    std::size_t num_threads)
+    {
+      dolfin_assert(!offsets.empty());
+      const std::size_t num_blocks = offsets[0].size() - 1;
+      std::vector<ArrayView<const dolfin::la_index> > block(entries.size());
+      for (std::size_t k = 0; k < num_blocks; ++k)
+      {
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+          block[i].set(offsets[i][k + 1] - offsets[i][k],
+                       entries[i].data() + offsets[i][k]);
+        }
+        insert(block);
+      }
+    }
 
     /// Add edges (vertex = [index, owning process])
     virtual void
@@ -29,6 +29,7 @@
 #include <typeinfo>
 #include <memory>
 #include <dolfin/log/log.h>
+#include <dolfin/common/ArrayView.h>
 #include <dolfin/common/MPI.h>
 #include <dolfin/common/types.h>
 #include "LinearAlgebraObject.h"
@@ -77,7 +78,7 @@ namespace dolfin
     /// Add block of values
     virtual
       void add(const double* block,
-           const std::vector<const std::vector<dolfin::la_index>* >& rows) = 0;
+           const std::vector<ArrayView<const dolfin::la_index> >& rows) = 0;
 
     /// Add block of values
     virtual
@@ -90,8 +90,8 @@ namespace dolfin
     /// Add block of values
     virtual void
       add(const double* block,
-          const std::vector<const std::vector<dolfin::la_index>* >& rows)
-    { add(block, rows[0]->size(), &(*rows[0])[0]); }
+          const std::vector<ArrayView<const dolfin::la_index> >& rows)
+    { add(block, rows[0].size(), rows[0].data()); }
 
     /// Add block of values
     virtual void add(const double* block,
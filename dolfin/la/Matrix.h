@@ -20,7 +20,7 @@
 // Modified by Martin Sandve Alnes, 2008.
 //
 // First added:  2006-05-15
-// Last changed: 2009-09-08
+// Last changed: 2014-03-18
 
 #ifndef __MATRIX_H
 #define __MATRIX_H
@@ -185,6 +185,11 @@ namespace dolfin
       const double*, int> data() const
     { return matrix->data(); }
 
+    /// Return pointer to values of underlying compressed storage.
+    /// See GenericMatrix for documentation.
+    virtual double* value_data()
+    { return matrix->value_data(); }
+
     //--- Special functions ---
 
     /// Return linear algebra backend factory
@@ -112,7 +112,7 @@ namespace dolfin
 
     /// Add block of values
     void add(const double* block,
-             const std::vector<const std::vector<dolfin::la_index>* >& rows)
+             const std::vector<ArrayView<const dolfin::la_index> >& rows)
     {
       dolfin_assert(block);
       _value += block[0];
@@ -20,7 +20,7 @@
 // Modified by Ola Skavhaug, 2009.
 //
 // First added:  2007-03-13
-// Last changed: 2011-01-02
+// Last changed: 2014-03-27
 
 #include <algorithm>
 
@@ -67,8 +67,9 @@ void SparsityPattern::init(
   dolfin_assert(dims.size() == off_process_owner.size());
 
   // Clear sparsity pattern data
-  diagonal.clear();
-  off_diagonal.clear();
+  row_offsets.clear();
+  columns.clear();
+  unsorted.clear();
   non_local.clear();
   _off_process_owner.clear();
 
@@ -91,61 +92,57 @@ void SparsityPattern::init(
                  "Primary dimension must be less than 2 (0=row major, 1=column major");
   }
 
-  // Resize diagonal block
+  // Create empty local rows
   dolfin_assert(_local_range[_primary_dim].second
                 > _local_range[_primary_dim].first);
-  diagonal.resize(_local_range[_primary_dim].second
-                  - _local_range[_primary_dim].first);
-
-  // Resize off-diagonal block (only needed when local range != global range)
-  off_diagonal.resize(_local_range[_primary_dim].second
-                      - _local_range[_primary_dim].first);
+  row_offsets.resize(_local_range[_primary_dim].second
+                     - _local_range[_primary_dim].first + 1, 0);
 }
 //-----------------------------------------------------------------------------
-void SparsityPattern::insert(const std::vector<const std::vector<dolfin::la_index>* >& entries)
+void SparsityPattern::insert(
+  const std::vector<ArrayView<const dolfin::la_index> >& entries)
 {
   dolfin_assert(entries.size() == 2);
-  dolfin_assert(entries[0]);
-  dolfin_assert(entries[1]);
 
   const std::size_t _primary_dim = primary_dim();
 
-  const std::vector<dolfin::la_index>* map_i;
-  const std::vector<dolfin::la_index>* map_j;
-  std::size_t primary_codim;
+  const ArrayView<const dolfin::la_index>* map_i;
+  const ArrayView<const dolfin::la_index>* map_j;
   dolfin_assert(_primary_dim < 2);
   if (_primary_dim == 0)
   {
-    primary_codim = 1;
-    map_i = entries[0];
-    map_j = entries[1];
+    map_i = &entries[0];
+    map_j = &entries[1];
   }
   else
   {
-    primary_codim = 0;
-    map_i = entries[1];
-    map_j = entries[0];
+    map_i = &entries[1];
+    map_j = &entries[0];
   }
 
   const std::pair<dolfin::la_index, dolfin::la_index>
     local_range0(_local_range[_primary_dim].first,
                  _local_range[_primary_dim].second);
-  const std::pair<dolfin::la_index, dolfin::la_index>
-    local_range1(_local_range[primary_codim].first,
-                 _local_range[primary_codim].second);
 
   // Check local range
   if (MPI::size(_mpi_comm) == 1)
   {
     // Sequential mode, do simple insertion
-    std::vector<dolfin::la_index>::const_iterator i_index;
+    const dolfin::la_index* i_index;
     for (i_index = map_i->begin(); i_index != map_i->end(); ++i_index)
-      diagonal[*i_index].insert(map_j->begin(), map_j->end());
+    {
+      const dolfin::la_index* j_index;
+      for (j_index = map_j->begin(); j_index != map_j->end(); ++j_index)
+      {
+        unsorted.push_back(*i_index);
+        unsorted.push_back(*j_index);
+      }
+    }
   }
   else
   {
     // Parallel mode, use either diagonal, off_diagonal or non_local
-    std::vector<dolfin::la_index>::const_iterator i_index;
+    const dolfin::la_index* i_index;
     for (i_index = map_i->begin(); i_index != map_i->end(); ++i_index)
     {
       if (local_range0.first <= *i_index && *i_index < local_range0.second)
@@ -153,26 +150,18 @@ void SparsityPattern::insert(const std::vector<const std::vector<dolfin::la_inde
         // Subtract offset
         const std::size_t I = *i_index - local_range0.first;
 
-        // Store local entry in diagonal or off-diagonal block
-        std::vector<dolfin::la_index>::const_iterator j_index;
+        // Store local entry (diagonal or off-diagonal block)
+        const dolfin::la_index* j_index;
         for (j_index = map_j->begin(); j_index != map_j->end(); ++j_index)
         {
-          if (local_range1.first <= *j_index && *j_index < local_range1.second)
-          {
-            dolfin_assert(I < diagonal.size());
-            diagonal[I].insert(*j_index);
-          }
-          else
-          {
-            dolfin_assert(I < off_diagonal.size());
-            off_diagonal[I].insert(*j_index);
-          }
+          unsorted.push_back(I);
+          unsorted.push_back(*j_index);
         }
       }
       else
       {
         // Store non-local entry (communicated later during apply())
-        std::vector<dolfin::la_index>::const_iterator j_index;
+        const dolfin::la_index* j_index;
         for (j_index = map_j->begin(); j_index != map_j->end(); ++j_index)
         {
           non_local.push_back(*i_index);
@@ -181,6 +170,60 @@ void SparsityPattern::insert(const std::vector<const std::vector<dolfin::la_inde
       }
     }
   }
+
+  // Merge buffered entries when the buffer is large compared to the
+  // rows, which bounds the memory used by duplicate entries
+  if (unsorted.size() > std::max(columns.size(), (std::size_t) 1 << 20))
+    compress();
+}
+//-----------------------------------------------------------------------------
+void SparsityPattern::insert_blocks(
+  const std::vector<std::vector<dolfin::la_index> >& entries,
+  const std::vector<std::vector<std::size_t> >& offsets,
+  std::size_t num_threads)
+{
+  dolfin_assert(entries.size() == 2);
+  dolfin_assert(offsets.size() == 2);
+
+  const std::size_t _primary_dim = primary_dim();
+  dolfin_assert(_primary_dim < 2);
+  const std::size_t primary_codim = (_primary_dim == 0) ? 1 : 0;
+
+  // Get rows and columns of blocks
+  const std::vector<dolfin::la_index>& rows = entries[_primary_dim];
+  const std::vector<dolfin::la_index>& cols = entries[primary_codim];
+  const std::vector<std::size_t>& block_row_offsets = offsets[_primary_dim];
+  const std::vector<std::size_t>& block_col_offsets = offsets[primary_codim];
+  dolfin_assert(!block_row_offsets.empty());
+  dolfin_assert(block_row_offsets.size() == block_col_offsets.size());
+  const std::size_t num_blocks = block_row_offsets.size() - 1;
+
+  // Merge local entries into rows
+  compress(rows, cols, block_row_offsets, block_col_offsets, num_threads);
+
+  // Store non-local entries (communicated later during apply())
+  if (MPI::size(_mpi_comm) > 1)
+  {
+    const std::size_t row_begin = _local_range[_primary_dim].first;
+    const std::size_t row_end = _local_range[_primary_dim].second;
+    for (std::size_t k = 0; k < num_blocks; ++k)
+    {
+      for (std::size_t i = block_row_offsets[k];
+           i < block_row_offsets[k + 1]; ++i)
+      {
+        const std::size_t I = rows[i];
+        if (I < row_begin || I >= row_end)
+        {
+          for (std::size_t j = block_col_offsets[k];
+               j < block_col_offsets[k + 1]; ++j)
+          {
+            non_local.push_back(I);
+            non_local.push_back(cols[j]);
+          }
+        }
+      }
+    }
+  }
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::add_edges(const std::pair<dolfin::la_index,
@@ -201,9 +244,9 @@ void SparsityPattern::add_edges(const std::pair<dolfin::la_index,
 
   // Add edges
   std::vector<dolfin::la_index> dofs0(1, vertex.first);
-  std::vector<const std::vector<dolfin::la_index>* > entries(2);
-  entries[0] = &dofs0;
-  entries[1] = &edges;
+  std::vector<ArrayView<const dolfin::la_index> > entries(2);
+  entries[0].set(dofs0);
+  entries[1].set(edges);
   insert(entries);
 }
 //-----------------------------------------------------------------------------
@@ -221,99 +264,80 @@ std::pair<std::size_t, std::size_t>
 //-----------------------------------------------------------------------------
 std::size_t SparsityPattern::num_nonzeros() const
 {
-  std::size_t nz = 0;
-  typedef std::vector<set_type>::const_iterator slice_it;
-  for (slice_it slice = diagonal.begin(); slice != diagonal.end(); ++slice)
-    nz += slice->size();
-  for (slice_it slice = off_diagonal.begin(); slice != off_diagonal.end();
-       ++slice)
-  {
-    nz += slice->size();
-  }
-  return nz;
+  check_compressed("compute number of nonzeros");
+  return columns.size();
 }
 //-----------------------------------------------------------------------------
 void  SparsityPattern::num_nonzeros_diagonal(std::vector<std::size_t>& num_nonzeros) const
 {
+  check_compressed("compute number of nonzeros in diagonal block");
+
   // Resize vector
-  num_nonzeros.resize(diagonal.size());
+  num_nonzeros.resize(row_offsets.size() - 1);
 
   // Get number of nonzeros per generalised row
-  typedef std::vector<set_type>::const_iterator slice_it;
-  for (slice_it slice = diagonal.begin(); slice != diagonal.end(); ++slice)
-    num_nonzeros[slice - diagonal.begin()] = slice->size();
+  for (std::size_t r = 0; r < num_nonzeros.size(); ++r)
+  {
+    const std::pair<const std::size_t*, const std::size_t*>
+      entries = diagonal_entries(r);
+    num_nonzeros[r] = entries.second - entries.first;
+  }
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::num_nonzeros_off_diagonal(std::vector<std::size_t>& num_nonzeros) const
 {
+  check_compressed("compute number of nonzeros in off-diagonal block");
+
   // Resize vector
-  num_nonzeros.resize(off_diagonal.size());
+  num_nonzeros.resize(row_offsets.size() - 1);
 
   // Compute number of nonzeros per generalised row
-  typedef std::vector<set_type>::const_iterator slice_it;
-  for (slice_it slice = off_diagonal.begin(); slice != off_diagonal.end();
-       ++slice)
+  for (std::size_t r = 0; r < num_nonzeros.size(); ++r)
   {
-    num_nonzeros[slice - off_diagonal.begin()] = slice->size();
+    const std::pair<const std::size_t*, const std::size_t*>
+      entries = diagonal_entries(r);
+    num_nonzeros[r] = (row_offsets[r + 1] - row_offsets[r])
+      - (entries.second - entries.first);
   }
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::num_local_nonzeros(std::vector<std::size_t>& num_nonzeros) const
 {
-  num_nonzeros_diagonal(num_nonzeros);
-  if (!off_diagonal.empty())
-  {
-    std::vector<std::size_t> tmp;
-    num_nonzeros_off_diagonal(tmp);
-    dolfin_assert(num_nonzeros.size() == tmp.size());
-    std::transform(num_nonzeros.begin(), num_nonzeros.end(), tmp.begin(),
-                   num_nonzeros.begin(), std::plus<std::size_t>());
-  }
+  check_compressed("compute number of local nonzeros");
+
+  num_nonzeros.resize(row_offsets.size() - 1);
+  for (std::size_t r = 0; r < num_nonzeros.size(); ++r)
+    num_nonzeros[r] = row_offsets[r + 1] - row_offsets[r];
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::get_edges(std::size_t vertex,
                                 std::vector<dolfin::la_index>& edges) const
 {
+  check_compressed("get edges of sparsity pattern");
+
   dolfin_assert(vertex >= _local_range[0].first && vertex
                 < _local_range[0].second);
 
   const std::size_t local_vertex = vertex - _local_range[0].first;
-  dolfin_assert(local_vertex < diagonal.size());
-  std::size_t size = diagonal[local_vertex].size();
-  if (!off_diagonal.empty())
-  {
-    dolfin_assert(local_vertex < off_diagonal.size());
-    size += off_diagonal[local_vertex].size();
-  }
-  edges.resize(size);
-
-  std::copy(diagonal[local_vertex].begin(), diagonal[local_vertex].end(),
-            edges.begin());
-  if (!off_diagonal.empty())
-  {
-    std::copy(off_diagonal[local_vertex].begin(),
-              off_diagonal[local_vertex].end(),
-              edges.begin() + diagonal[local_vertex].size());
-  }
+  dolfin_assert(local_vertex + 1 < row_offsets.size());
+  edges.assign(columns.begin() + row_offsets[local_vertex],
+               columns.begin() + row_offsets[local_vertex + 1]);
 }
 //-----------------------------------------------------------------------------
 void SparsityPattern::apply()
 {
   const std::size_t _primary_dim = primary_dim();
-
-  std::size_t primary_codim;
   dolfin_assert(_primary_dim < 2);
-  if (_primary_dim == 0)
-    primary_codim = 1;
-  else
-    primary_codim = 0;
 
   const std::size_t num_processes = MPI::size(_mpi_comm);
   const std::size_t proc_number = MPI::rank(_mpi_comm);
 
   // Print some useful information
   if (get_log_level() <= DBG)
+  {
+    compress();
     info_statistics();
+  }
 
   // Communicate non-local blocks if any
   if (MPI::size(_mpi_comm) > 1)
@@ -322,6 +346,12 @@ void SparsityPattern::apply()
     dolfin_assert(non_local.size() % 2 == 0);
     std::vector<std::vector<std::size_t> > non_local_send(num_processes);
 
+    // Ownership range end of each process, used for rows that are
+    // not in the off-process owner map (e.g. rows of cells on the
+    // other side of a process boundary)
+    std::vector<std::size_t> range_ends;
+    MPI::all_gather(_mpi_comm, _local_range[_primary_dim].second, range_ends);
+
     for (std::size_t i = 0; i < non_local.size(); i += 2)
     {
       // Get generalised row for non-local entry
@@ -329,10 +359,16 @@ void SparsityPattern::apply()
       const std::size_t J = non_local[i + 1];
 
       // Figure out which process owns the row
+      std::size_t p;
       boost::unordered_map<std::size_t, unsigned int>::const_iterator
         non_local_index = _off_process_owner[_primary_dim].find(I);
-      dolfin_assert(non_local_index != _off_process_owner[_primary_dim].end());
-      const std::size_t p = non_local_index->second;
+      if (non_local_index != _off_process_owner[_primary_dim].end())
+        p = non_local_index->second;
+      else
+      {
+        p = std::upper_bound(range_ends.begin(), range_ends.end(), I)
+          - range_ends.begin();
+      }
 
       dolfin_assert(p < num_processes);
       dolfin_assert(p != proc_number);
@@ -373,38 +409,35 @@ void SparsityPattern::apply()
         I -= _local_range[_primary_dim].first;
 
         // Insert in diagonal or off-diagonal block
-        if (_local_range[primary_codim].first <= J &&
-            J < _local_range[primary_codim].second)
-        {
-          dolfin_assert(I < diagonal.size());
-          diagonal[I].insert(J);
-        }
-        else
-        {
-          dolfin_assert(I < off_diagonal.size());
-          off_diagonal[I].insert(J);
-        }
+        unsorted.push_back(I);
+        unsorted.push_back(J);
       }
     }
   }
 
   // Clear non-local entries
   non_local.clear();
+
+  // Merge local entries into rows
+  compress();
 }
 //-----------------------------------------------------------------------------
 std::string SparsityPattern::str(bool verbose) const
 {
+  check_compressed("print sparsity pattern");
+
   // Print each row
   std::stringstream s;
-  typedef set_type::const_iterator entry_it;
-  for (std::size_t i = 0; i < diagonal.size(); i++)
+  for (std::size_t i = 0; i < row_offsets.size() - 1; i++)
   {
     if (primary_dim() == 0)
       s << "Row " << i << ":";
     else
       s << "Col " << i << ":";
 
-    for (entry_it entry = diagonal[i].begin(); entry != diagonal[i].end();
+    const std::pair<const std::size_t*, const std::size_t*>
+      entries = diagonal_entries(i);
+    for (const std::size_t* entry = entries.first; entry != entries.second;
          ++entry)
     {
       s << " " << *entry;
@@ -418,14 +451,15 @@ std::string SparsityPattern::str(bool verbose) const
 std::vector<std::vector<std::size_t> >
   SparsityPattern::diagonal_pattern(Type type) const
 {
-  std::vector<std::vector<std::size_t> > v(diagonal.size());
-  for (std::size_t i = 0; i < diagonal.size(); ++i)
-    v[i].insert(v[i].begin(), diagonal[i].begin(), diagonal[i].end());
+  check_compressed("get diagonal sparsity pattern");
 
-  if (type == sorted)
+  // Rows are sorted, so the pattern is sorted for both types
+  std::vector<std::vector<std::size_t> > v(row_offsets.size() - 1);
+  for (std::size_t i = 0; i < v.size(); ++i)
   {
-    for (std::size_t i = 0; i < v.size(); ++i)
-      std::sort(v[i].begin(), v[i].end());
+    const std::pair<const std::size_t*, const std::size_t*>
+      entries = diagonal_entries(i);
+    v[i].assign(entries.first, entries.second);
   }
 
   return v;
@@ -434,14 +468,18 @@ std::vector<std::vector<std::size_t> >
 std::vector<std::vector<std::size_t> >
   SparsityPattern::off_diagonal_pattern(Type type) const
 {
-  std::vector<std::vector<std::size_t> > v(off_diagonal.size());
-  for (std::size_t i = 0; i < off_diagonal.size(); ++i)
-    v[i].insert(v[i].begin(), off_diagonal[i].begin(), off_diagonal[i].end());
+  check_compressed("get off-diagonal sparsity pattern");
 
-  if (type == sorted)
+  // Rows are sorted, so the pattern is sorted for both types
+  std::vector<std::vector<std::size_t> > v(row_offsets.size() - 1);
+  for (std::size_t i = 0; i < v.size(); ++i)
   {
-    for (std::size_t i = 0; i < v.size(); ++i)
-      std::sort(v[i].begin(), v[i].end());
+    const std::pair<const std::size_t*, const std::size_t*>
+      entries = diagonal_entries(i);
+    v[i].assign(columns.begin() + row_offsets[i],
+                columns.begin() + (entries.first - columns.data()));
+    v[i].insert(v[i].end(), columns.begin() + (entries.second - columns.data()),
+                columns.begin() + row_offsets[i + 1]);
   }
 
   return v;
@@ -451,13 +489,16 @@ void SparsityPattern::info_statistics() const
 {
   // Count nonzeros in diagonal block
   std::size_t num_nonzeros_diagonal = 0;
-  for (std::size_t i = 0; i < diagonal.size(); ++i)
-    num_nonzeros_diagonal += diagonal[i].size();
+  for (std::size_t i = 0; i < row_offsets.size() - 1; ++i)
+  {
+    const std::pair<const std::size_t*, const std::size_t*>
+      entries = diagonal_entries(i);
+    num_nonzeros_diagonal += entries.second - entries.first;
+  }
 
   // Count nonzeros in off-diagonal block
-  std::size_t num_nonzeros_off_diagonal = 0;
-  for (std::size_t i = 0; i < off_diagonal.size(); ++i)
-    num_nonzeros_off_diagonal += off_diagonal[i].size();
+  const std::size_t num_nonzeros_off_diagonal
+    = columns.size() - num_nonzeros_diagonal;
 
   // Count nonzeros in non-local block
   const std::size_t num_nonzeros_non_local = non_local.size()/2;
@@ -490,3 +531,164 @@ void SparsityPattern::info_statistics() const
   }
 }
 //-----------------------------------------------------------------------------
+void SparsityPattern::compress(
+  const std::vector<dolfin::la_index>& block_rows,
+  const std::vector<dolfin::la_index>& block_cols,
+  const std::vector<std::size_t>& block_row_offsets,
+  const std::vector<std::size_t>& block_col_offsets,
+  std::size_t num_threads)
+{
+  dolfin_assert(!block_row_offsets.empty());
+  dolfin_assert(block_row_offsets.size() == block_col_offsets.size());
+  dolfin_assert(!row_offsets.empty());
+  dolfin_assert(unsorted.size() % 2 == 0);
+
+  const std::size_t num_blocks = block_row_offsets.size() - 1;
+  const std::size_t num_local_rows = row_offsets.size() - 1;
+  const std::size_t row_begin = _local_range[primary_dim()].first;
+  const std::size_t row_end = _local_range[primary_dim()].second;
+  #ifdef HAS_OPENMP
+  const std::size_t _num_threads = std::max(num_threads, (std::size_t) 1);
+  #endif
+
+  // Count number of entries (including duplicates) for each local
+  // row: entries already in the row, buffered entries and entries of
+  // blocks
+  std::vector<std::size_t> new_row_offsets(num_local_rows + 1, 0);
+  for (std::size_t r = 0; r < num_local_rows; ++r)
+    new_row_offsets[r + 1] = row_offsets[r + 1] - row_offsets[r];
+  for (std::size_t i = 0; i < unsorted.size(); i += 2)
+  {
+    dolfin_assert(unsorted[i] < num_local_rows);
+    ++new_row_offsets[unsorted[i] + 1];
+  }
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(_num_threads)
+  #endif
+  for (std::size_t k = 0; k < num_blocks; ++k)
+  {
+    const std::size_t n = block_col_offsets[k + 1] - block_col_offsets[k];
+    for (std::size_t i = block_row_offsets[k]; i < block_row_offsets[k + 1];
+         ++i)
+    {
+      const std::size_t I = block_rows[i];
+      if (row_begin <= I && I < row_end)
+      {
+        #ifdef HAS_OPENMP
+        #pragma omp atomic
+        #endif
+        new_row_offsets[I - row_begin + 1] += n;
+      }
+    }
+  }
+  for (std::size_t r = 0; r < num_local_rows; ++r)
+    new_row_offsets[r + 1] += new_row_offsets[r];
+
+  // Fill rows, starting with entries already in the rows and
+  // buffered entries (storage of which is then released)
+  std::vector<std::size_t> new_columns(new_row_offsets[num_local_rows]);
+  std::vector<std::size_t> position(new_row_offsets.begin(),
+                                    new_row_offsets.end() - 1);
+  for (std::size_t r = 0; r < num_local_rows; ++r)
+  {
+    position[r] = std::copy(columns.begin() + row_offsets[r],
+                            columns.begin() + row_offsets[r + 1],
+                            new_columns.begin() + position[r])
+      - new_columns.begin();
+  }
+  for (std::size_t i = 0; i < unsorted.size(); i += 2)
+    new_columns[position[unsorted[i]]++] = unsorted[i + 1];
+  std::vector<std::size_t>().swap(columns);
+  std::vector<std::size_t>().swap(unsorted);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(_num_threads)
+  #endif
+  for (std::size_t k = 0; k < num_blocks; ++k)
+  {
+    const std::size_t n = block_col_offsets[k + 1] - block_col_offsets[k];
+    const dolfin::la_index* cols = block_cols.data() + block_col_offsets[k];
+    for (std::size_t i = block_row_offsets[k]; i < block_row_offsets[k + 1];
+         ++i)
+    {
+      const std::size_t I = block_rows[i];
+      if (row_begin <= I && I < row_end)
+      {
+        std::size_t p;
+        #ifdef HAS_OPENMP
+        #pragma omp atomic capture
+        #endif
+        { p = position[I - row_begin]; position[I - row_begin] += n; }
+        std::copy(cols, cols + n, new_columns.begin() + p);
+      }
+    }
+  }
+
+  // Sort rows and remove duplicates
+  std::vector<std::size_t> row_size(num_local_rows);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(_num_threads)
+  #endif
+  for (std::size_t r = 0; r < num_local_rows; ++r)
+  {
+    std::vector<std::size_t>::iterator begin
+      = new_columns.begin() + new_row_offsets[r];
+    std::vector<std::size_t>::iterator end
+      = new_columns.begin() + new_row_offsets[r + 1];
+    std::sort(begin, end);
+    row_size[r] = std::unique(begin, end) - begin;
+  }
+
+  // Remove gaps left by duplicates (rows only move towards the front)
+  std::size_t size = 0;
+  for (std::size_t r = 0; r < num_local_rows; ++r)
+  {
+    const std::size_t begin = new_row_offsets[r];
+    new_row_offsets[r] = size;
+    if (begin != size)
+    {
+      std::copy(new_columns.begin() + begin,
+                new_columns.begin() + begin + row_size[r],
+                new_columns.begin() + size);
+    }
+    size += row_size[r];
+  }
+  new_row_offsets[num_local_rows] = size;
+  new_columns.resize(size);
+
+  // Store rows (copy to release unused capacity)
+  std::vector<std::size_t>(new_columns).swap(columns);
+  row_offsets.swap(new_row_offsets);
+}
+//-----------------------------------------------------------------------------
+void SparsityPattern::compress()
+{
+  if (unsorted.empty())
+    return;
+
+  const std::vector<dolfin::la_index> no_entries;
+  const std::vector<std::size_t> no_offsets(1, 0);
+  compress(no_entries, no_entries, no_offsets, no_offsets, 0);
+}
+//-----------------------------------------------------------------------------
+void SparsityPattern::check_compressed(std::string task) const
+{
+  if (!unsorted.empty())
+  {
+    dolfin_error("SparsityPattern.cpp",
+                 task,
+                 "Sparsity pattern has not been finalized (call apply())");
+  }
+}
+//-----------------------------------------------------------------------------
+std::pair<const std::size_t*, const std::size_t*>
+SparsityPattern::diagonal_entries(std::size_t r) const
+{
+  dolfin_assert(r + 1 < row_offsets.size());
+  const std::size_t primary_codim = (primary_dim() == 0) ? 1 : 0;
+  const std::size_t* begin = columns.data() + row_offsets[r];
+  const std::size_t* end = columns.data() + row_offsets[r + 1];
+  begin = std::lower_bound(begin, end, _local_range[primary_codim].first);
+  end = std::lower_bound(begin, end, _local_range[primary_codim].second);
+  return std::make_pair(begin, end);
+}
+//-----------------------------------------------------------------------------
@@ -18,7 +18,7 @@
 // Modified by Anders Logg, 2007-2009.
 //
 // First added:  2007-03-13
-// Last changed: 2011-01-02
+// Last changed: 2014-03-27
 
 #ifndef __SPARSITY_PATTERN_H
 #define __SPARSITY_PATTERN_H
@@ -27,7 +27,6 @@
 #include <utility>
 #include <vector>
 
-#include "dolfin/common/Set.h"
 #include "dolfin/common/types.h"
 #include "GenericSparsityPattern.h"
 #include <boost/unordered_map.hpp>
@@ -37,15 +36,15 @@ namespace dolfin
 
   /// This class implements the GenericSparsityPattern interface.
   /// It is used by most linear algebra backends.
+  ///
+  /// The local rows (diagonal and off-diagonal blocks) are stored in
+  /// compressed row storage as sorted column indices without
+  /// duplicates. Entries added by insert() are buffered and merged
+  /// into the rows by apply(), which must be called before the
+  /// pattern is accessed.
 
   class SparsityPattern : public GenericSparsityPattern
   {
-
-    // NOTE: Do not change this typedef without performing careful
-    //       performance profiling
-    // Set type used for the rows of the sparsity pattern
-    typedef dolfin::Set<std::size_t> set_type;
-
   public:
 
     /// Create empty sparsity pattern
@@ -70,7 +69,16 @@ namespace dolfin
 
     /// Insert non-zero entries
     void
-      insert(const std::vector<const std::vector<dolfin::la_index>* >& entries);
+      insert(const std::vector<ArrayView<const dolfin::la_index> >& entries);
+
+    /// Insert non-zero entries for a collection of dense blocks (see
+    /// GenericSparsityPattern). The local rows are rebuilt in
+    /// compressed row storage (count, allocate, fill, then sort and
+    /// remove duplicates) using up to num_threads threads.
+    void
+      insert_blocks(const std::vector<std::vector<dolfin::la_index> >& entries,
+                    const std::vector<std::vector<std::size_t> >& offsets,
+                    std::size_t num_threads);
 
     /// Add edges (vertex = [index, owning process])
     void add_edges(const std::pair<dolfin::la_index, std::size_t>& vertex,
@@ -127,15 +135,42 @@ namespace dolfin
     // Print some useful information
     void info_statistics() const;
 
+    // Merge buffered entries and local entries of dense blocks into
+    // the compressed rows. The (generalised) rows of block k are
+    // block_rows[j] for block_row_offsets[k] <= j <
+    // block_row_offsets[k + 1], and similarly for the columns.
+    void compress(const std::vector<dolfin::la_index>& block_rows,
+                  const std::vector<dolfin::la_index>& block_cols,
+                  const std::vector<std::size_t>& block_row_offsets,
+                  const std::vector<std::size_t>& block_col_offsets,
+                  std::size_t num_threads);
+
+    // Merge buffered entries into the compressed rows
+    void compress();
+
+    // Check that there are no buffered entries
+    void check_compressed(std::string task) const;
+
+    // Return the entries of local row r that are in the diagonal
+    // block [first, second)
+    std::pair<const std::size_t*, const std::size_t*>
+      diagonal_entries(std::size_t r) const;
+
     // MPI communicator
     MPI_Comm _mpi_comm;
 
     // Ownership range for each dimension
     std::vector<std::pair<std::size_t, std::size_t> > _local_range;
 
-    // Sparsity patterns for diagonal and off-diagonal blocks
-    std::vector<set_type> diagonal;
-    std::vector<set_type> off_diagonal;
+    // Sparsity pattern for local rows (diagonal and off-diagonal
+    // blocks). The sorted column indices of row r are
+    // columns[row_offsets[r]] ... columns[row_offsets[r + 1] - 1].
+    std::vector<std::size_t> row_offsets;
+    std::vector<std::size_t> columns;
+
+    // Local entries not yet merged into the rows, stored as
+    // [i0, j0, i1, j1, ...] (i is the local row index)
+    std::vector<std::size_t> unsorted;
 
     // Sparsity pattern for non-local entries stored as [i0, j0, i1, j1, ...]
     std::vector<std::size_t> non_local;
@@ -22,7 +22,7 @@
 // Modified by Dag Lindbo 2008
 //
 // First added:  2006-07-05
-// Last changed: 2012-08-20
+// Last changed: 2014-03-18
 
 #ifndef __UBLAS_MATRIX_H
 #define __UBLAS_MATRIX_H
@@ -184,6 +184,10 @@ namespace dolfin
     virtual boost::tuples::tuple<const std::size_t*, const std::size_t*,
       const double*, int> data() const;
 
+    /// Return pointer to values of underlying compressed storage.
+    /// See GenericMatrix for documentation.
+    virtual double* value_data();
+
     //--- Special functions ---
 
     /// Return linear algebra backend factory
@@ -633,7 +637,7 @@ namespace dolfin
 
     // Add entries
     std::vector<std::vector<std::size_t> >::const_iterator row;
-    Set<std::size_t>::const_iterator element;
+    std::vector<std::size_t>::const_iterator element;
     for(row = pattern.begin(); row != pattern.end(); ++row)
       for(element = row->begin(); element != row->end(); ++element)
         _A.push_back(row - pattern.begin(), *element, 0.0);
@@ -700,6 +704,20 @@ namespace dolfin
                                 int>(0, 0, 0, 0);
   }
   //---------------------------------------------------------------------------
+  template <>
+  inline double* uBLASMatrix<ublas_sparse_matrix>::value_data()
+  {
+    // Make sure compressed storage is complete
+    _A.complete_index1_data();
+    return _A.nnz() > 0 ? &_A.value_data()[0] : 0;
+  }
+  //---------------------------------------------------------------------------
+  template <typename Mat>
+  inline double* uBLASMatrix<Mat>::value_data()
+  {
+    return 0;
+  }
+  //---------------------------------------------------------------------------
   template<typename Mat> template<typename B>
   void uBLASMatrix<Mat>::solve_in_place(B& X)
   {
@@ -21,8 +21,9 @@
 // Modified by Oeyvind Evju, 2013
 //
 // First added:  2006-06-21
-// Last changed: 2014-02-06
+// Last changed: 2014-03-26
 
+#include <algorithm>
 #include <dolfin/common/timing.h>
 
 #include <dolfin/log/dolfin_log.h>
@@ -31,8 +32,10 @@
 #include "Facet.h"
 #include "Mesh.h"
 #include "MeshData.h"
+#include "MeshConnectivity.h"
 #include "MeshEditor.h"
 #include "MeshEntity.h"
+#include "MeshEntityRange.h"
 #include "MeshFunction.h"
 #include "MeshGeometry.h"
 #include "MeshTopology.h"
@@ -77,12 +80,6 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
   // Generate facet - cell connectivity if not generated
   mesh.init(D - 1, D);
 
-  // Temporary arrays for assignment of indices to vertices on the boundary
-  std::map<std::size_t, std::size_t> boundary_vertices;
-
-  // Map of index "owners" (process responsible for assigning global index)
-  std::map< std::size_t, std::size_t > global_index_owner;
-
   // Shared vertices for full mesh
   // FIXME: const_cast
   const std::map<unsigned int, std::set<unsigned int> > &
@@ -172,81 +169,79 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
     shared_boundary_vertices = shared_vertices;
   }
 
-  // Determine boundary facet, count boundary vertices and facets, and
-  // assign vertex indices
-  std::size_t num_boundary_vertices = 0;
-  std::size_t num_owned_vertices = 0;
-  std::size_t num_boundary_cells = 0;
-
-  MeshFunction<bool> boundary_facet(mesh, D - 1, false);
-  for (FacetIterator f(mesh); !f.end(); ++f)
+  // Number of threads used for the facet loops
+  #ifdef HAS_OPENMP
+  const std::size_t num_threads = MeshEntityRange::num_threads();
+  #endif
+
+  // Determine boundary facets (in parallel). Boundary facets are
+  // connected to exactly one cell.
+  const std::size_t num_facets = mesh.num_facets();
+  const MeshConnectivity& facet_cells = mesh.topology()(D - 1, D);
+  std::vector<char> boundary_facet(num_facets, 0);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t f = 0; f < num_facets; ++f)
   {
-    // Boundary facets are connected to exactly one cell
-    if (f->num_entities(D) == 1)
+    if (facet_cells.size(f) == 1)
     {
-      const bool global_exterior_facet =  (f->num_global_entities(D) == 1);
-      if (global_exterior_facet && exterior)
-        boundary_facet[*f] = true;
-      else if (!global_exterior_facet && interior)
-        boundary_facet[*f] = true;
+      const bool global_exterior_facet = (facet_cells.size_global(f) == 1);
+      boundary_facet[f] = (global_exterior_facet ? exterior : interior);
+    }
+  }
 
-      if (boundary_facet[*f])
-      {
-        // Count boundary vertices and assign indices
-        for (VertexIterator v(*f); !v.end(); ++v)
-        {
-          const std::size_t local_mesh_index = v->index();
-
-          if (boundary_vertices.find(local_mesh_index)
-              == boundary_vertices.end())
-          {
-            const std::size_t local_boundary_index = num_boundary_vertices;
-            boundary_vertices[local_mesh_index] = local_boundary_index;
-
-            // Determine "owner" of global_mesh_index
-            std::size_t owner = my_rank;
-
-            std::map<unsigned int, std::set<unsigned int> >::const_iterator
-              other_processes_it
-              = shared_boundary_vertices.find(local_mesh_index);
-            if (other_processes_it != shared_boundary_vertices.end() && D > 1)
-            {
-              const std::set<unsigned int>& other_processes
-                = other_processes_it->second;
-              const std::size_t min_process
-                = *std::min_element(other_processes.begin(),
-                                    other_processes.end());
-              boundary.topology().shared_entities(0)[local_boundary_index]
-                = other_processes;
-
-              // FIXME: More sophisticated ownership determination
-              if (min_process < owner)
-                owner = min_process;
-            }
-            const std::size_t global_mesh_index
-              = mesh.topology().global_indices(0)[local_mesh_index];
-            global_index_owner[global_mesh_index] = owner;
-
-            // Update counts
-            if (owner == my_rank)
-              num_owned_vertices++;
-            num_boundary_vertices++;
-          }
-        }
+  // Number boundary cells (facets of the mesh) and boundary vertices
+  // in order of appearance, and determine "owner" of each boundary
+  // vertex (process responsible for assigning global index)
+  const MeshEntityRange facets(mesh, D - 1);
+  std::vector<std::size_t> boundary_cells;
+  std::vector<std::size_t> boundary_vertices;
+  std::vector<std::size_t> boundary_vertex_owners;
+  std::vector<int> boundary_vertex_indices(mesh.num_vertices(), -1);
+  std::size_t num_owned_vertices = 0;
+  for (std::size_t f = 0; f < num_facets; ++f)
+  {
+    if (!boundary_facet[f])
+      continue;
+    boundary_cells.push_back(f);
 
-        // Count boundary cells (facets of the mesh)
-        num_boundary_cells++;
+    const unsigned int* vertices = facets.vertices(f);
+    for (std::size_t i = 0; i < facets.num_vertices(f); ++i)
+    {
+      const std::size_t local_mesh_index = vertices[i];
+      if (boundary_vertex_indices[local_mesh_index] != -1)
+        continue;
+
+      const std::size_t local_boundary_index = boundary_vertices.size();
+      boundary_vertex_indices[local_mesh_index] = local_boundary_index;
+      boundary_vertices.push_back(local_mesh_index);
+
+      // Determine owner
+      std::size_t owner = my_rank;
+      std::map<unsigned int, std::set<unsigned int> >::const_iterator
+        other_processes_it = shared_boundary_vertices.find(local_mesh_index);
+      if (other_processes_it != shared_boundary_vertices.end() && D > 1)
+      {
+        const std::set<unsigned int>& other_processes
+          = other_processes_it->second;
+        const std::size_t min_process
+          = *std::min_element(other_processes.begin(),
+                              other_processes.end());
+        boundary.topology().shared_entities(0)[local_boundary_index]
+          = other_processes;
+
+        // FIXME: More sophisticated ownership determination
+        if (min_process < owner)
+          owner = min_process;
       }
+      boundary_vertex_owners.push_back(owner);
+      if (owner == my_rank)
+        num_owned_vertices++;
     }
   }
-
-  // Initiate boundary topology
-  /*
-  boundary.topology().init(0, num_boundary_vertices,
-                           MPI::sum(mesh.mpi_comm(), num_owned_vertices));
-  boundary.topology().init(D - 1, num_boundary_cells,
-                           MPI::sum(mesh.mpi_comm(), num_boundary_cells));
-  */
+  const std::size_t num_boundary_vertices = boundary_vertices.size();
+  const std::size_t num_boundary_cells = boundary_cells.size();
 
   // Specify number of vertices and cells
   editor.init_vertices_global(num_boundary_vertices, MPI::sum(mesh.mpi_comm(),
@@ -258,9 +253,8 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
   MeshFunction<std::size_t>& vertex_map = boundary.entity_map(0);
   if (num_boundary_vertices > 0)
     vertex_map.init(boundary, 0, num_boundary_vertices);
-  std::map<std::size_t, std::size_t>::const_iterator it;
-  for (it = boundary_vertices.begin(); it != boundary_vertices.end(); ++it)
-    vertex_map[it->second] = it->first;
+  for (std::size_t i = 0; i < num_boundary_vertices; i++)
+    vertex_map[i] = boundary_vertices[i];
 
   // Get vertex ownership distribution, and find index to start global
   // numbering from
@@ -271,23 +265,37 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
     start_index += ownership_distribution[j];
 
   // Set global indices of owned vertices, request global indices for
-  // vertices owned elsewhere
-  std::map<std::size_t, std::size_t> global_indices;
+  // vertices owned elsewhere. Only shared vertices can be requested
+  // by other processes.
+  const std::vector<std::size_t>& global_vertex_indices
+    = mesh.topology().global_indices(0);
+  std::vector<std::size_t> global_indices(num_boundary_vertices);
+  std::map<std::size_t, std::size_t> shared_global_indices;
   std::vector<std::vector<std::size_t> > request_global_indices(num_processes);
-
+  std::vector<std::vector<std::size_t> > request_local_indices(num_processes);
   std::size_t current_index = start_index;
   for (std::size_t local_boundary_index = 0;
-       local_boundary_index<num_boundary_vertices; local_boundary_index++)
+       local_boundary_index < num_boundary_vertices; local_boundary_index++)
   {
-    const std::size_t local_mesh_index = vertex_map[local_boundary_index];
+    const std::size_t local_mesh_index = boundary_vertices[local_boundary_index];
     const std::size_t global_mesh_index
-      = mesh.topology().global_indices(0)[local_mesh_index];
-
-    const std::size_t owner = global_index_owner[global_mesh_index];
+      = global_vertex_indices[local_mesh_index];
+    const std::size_t owner = boundary_vertex_owners[local_boundary_index];
     if (owner != my_rank)
+    {
       request_global_indices[owner].push_back(global_mesh_index);
+      request_local_indices[owner].push_back(local_boundary_index);
+    }
     else
-      global_indices[global_mesh_index] = current_index++;
+    {
+      global_indices[local_boundary_index] = current_index++;
+      if (shared_boundary_vertices.find(local_mesh_index)
+          != shared_boundary_vertices.end())
+      {
+        shared_global_indices[global_mesh_index]
+          = global_indices[local_boundary_index];
+      }
+    }
   }
 
   // Send and receive requests from other processes
@@ -303,8 +311,12 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
     respond_global_indices[i].resize(N);
 
     for (std::size_t j = 0; j < N; j++)
+    {
+      dolfin_assert(shared_global_indices.find(global_index_requests[i][j])
+                    != shared_global_indices.end());
       respond_global_indices[i][j]
-        = global_indices[global_index_requests[i][j]];
+        = shared_global_indices[global_index_requests[i][j]];
+    }
   }
 
   // Scatter responses back to requesting processes
@@ -312,34 +324,23 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
   MPI::all_to_all(mesh.mpi_comm(), respond_global_indices,
                   global_index_responses);
 
-  // Update global_indices
+  // Update global indices
   for (std::size_t i = 0; i < num_processes; i++)
   {
-    const std::size_t N = global_index_responses[i].size();
     // Check that responses are the same size as the requests made
     dolfin_assert(global_index_responses[i].size()
                   == request_global_indices[i].size());
-    for (std::size_t j = 0; j < N; j++)
-    {
-      const std::size_t global_mesh_index = request_global_indices[i][j];
-      const std::size_t global_boundary_index = global_index_responses[i][j];
-      global_indices[global_mesh_index] = global_boundary_index;
-    }
+    for (std::size_t j = 0; j < global_index_responses[i].size(); j++)
+      global_indices[request_local_indices[i][j]] = global_index_responses[i][j];
   }
 
   // Create vertices
   for (std::size_t local_boundary_index = 0;
        local_boundary_index < num_boundary_vertices; local_boundary_index++)
   {
-    const std::size_t local_mesh_index = vertex_map[local_boundary_index];
-    const std::size_t global_mesh_index
-      = mesh.topology().global_indices(0)[local_mesh_index];
-    const std::size_t global_boundary_index = global_indices[global_mesh_index];
-
-    Vertex v(mesh, local_mesh_index);
-
-    editor.add_vertex_global(local_boundary_index, global_boundary_index,
-                             v.point());
+    editor.add_vertex_global(local_boundary_index,
+                             global_indices[local_boundary_index],
+                             mesh.geometry().point(boundary_vertices[local_boundary_index]));
   }
 
   // Find global index to start cell numbering from for current process
@@ -349,65 +350,104 @@ void BoundaryComputation::compute_boundary(const Mesh& mesh,
   for (std::size_t i = 0; i < my_rank; i++)
     start_cell_index += cell_distribution[i];
 
-  // Create cells (facets) and map between boundary mesh cells and facets parent
+  // Compute new vertex numbers for cells, and reorder vertices so
+  // facets are right-oriented w.r.t. facet normal (in parallel)
+  const std::size_t num_cell_vertices
+    = boundary.type().num_vertices(boundary.topology().dim());
+  std::vector<std::size_t> cells(num_boundary_cells*num_cell_vertices);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t c = 0; c < num_boundary_cells; ++c)
+  {
+    const unsigned int* vertices = facets.vertices(boundary_cells[c]);
+    std::size_t* cell = &cells[c*num_cell_vertices];
+    for (std::size_t i = 0; i < num_cell_vertices; i++)
+      cell[i] = boundary_vertex_indices[vertices[i]];
+    reorder(cell, mesh, boundary_cells[c]);
+  }
+
+  // Create cells (facets) and map between boundary mesh cells and
+  // facets parent
   MeshFunction<std::size_t>& cell_map = boundary.entity_map(D - 1);
   if (num_boundary_cells > 0)
     cell_map.init(boundary, D - 1, num_boundary_cells);
-  std::vector<std::size_t>
-    cell(boundary.type().num_vertices(boundary.topology().dim()));
-  std::size_t current_cell = 0;
-  for (FacetIterator f(mesh); !f.end(); ++f)
+  std::vector<std::size_t> cell(num_cell_vertices);
+  for (std::size_t c = 0; c < num_boundary_cells; ++c)
   {
-    if (boundary_facet[*f])
-    {
-      // Compute new vertex numbers for cell
-      const unsigned int* vertices = f->entities(0);
-      for (std::size_t i = 0; i < cell.size(); i++)
-        cell[i] = boundary_vertices[vertices[i]];
-
-      // Reorder vertices so facet is right-oriented w.r.t. facet
-      // normal
-      reorder(cell, *f);
-
-      // Create mapping from boundary cell to mesh facet if requested
-      if (!cell_map.empty())
-        cell_map[current_cell] = f->index();
-
-      // Add cell
-      editor.add_cell(current_cell, start_cell_index+current_cell, cell);
-      current_cell++;
-    }
+    std::copy(cells.begin() + c*num_cell_vertices,
+              cells.begin() + (c + 1)*num_cell_vertices, cell.begin());
+    cell_map[c] = boundary_cells[c];
+    editor.add_cell(c, start_cell_index + c, cell);
   }
 
   // Close mesh editor. Note the argument order=false to prevent
   // ordering from destroying the orientation of facets accomplished
-  // by calling reorder() below.
+  // by calling reorder() above.
   editor.close(false);
 }
 //-----------------------------------------------------------------------------
-void BoundaryComputation::reorder(std::vector<std::size_t>& vertices,
-                                  const Facet& facet)
+void BoundaryComputation::update_coordinates(const Mesh& mesh,
+                                             BoundaryMesh& boundary)
 {
-  // Get mesh
-  const Mesh& mesh = facet.mesh();
+  const std::size_t gdim = boundary.geometry().dim();
+  const std::size_t num_vertices = boundary.num_vertices();
+  const MeshFunction<std::size_t>& vertex_map = boundary.entity_map(0);
+
+  // Check that boundary mesh matches mesh
+  bool match = (mesh.geometry().dim() == gdim
+                && vertex_map.size() == num_vertices);
+  for (std::size_t i = 0; i < num_vertices && match; i++)
+    match = (vertex_map[i] < mesh.num_vertices());
+  if (!match)
+  {
+    dolfin_error("BoundaryComputation.cpp",
+                 "update coordinates of boundary mesh",
+                 "Boundary mesh was not computed from given mesh");
+  }
+
+  // Copy coordinates of boundary vertices (in parallel)
+  #ifdef HAS_OPENMP
+  const std::size_t num_threads = MeshEntityRange::num_threads();
+  #endif
+  const std::vector<double>& x = mesh.geometry().x();
+  std::vector<double>& boundary_x = boundary.geometry().x();
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t i = 0; i < num_vertices; i++)
+  {
+    const std::size_t v = vertex_map[i];
+    for (std::size_t j = 0; j < gdim; j++)
+      boundary_x[i*gdim + j] = x[v*gdim + j];
+  }
+}
+//-----------------------------------------------------------------------------
+void BoundaryComputation::reorder(std::size_t* vertices, const Mesh& mesh,
+                                  std::size_t facet)
+{
+  // Intervals need no reordering
+  if (mesh.type().cell_type() == CellType::interval)
+    return;
+
+  // Get vertices of facet and of the cell it belongs to
+  const std::size_t D = mesh.topology().dim();
+  const MeshConnectivity& facet_vertices = mesh.topology()(D - 1, 0);
+  const MeshConnectivity& cell_vertices = mesh.topology()(D, 0);
+  const unsigned int* fv = facet_vertices(facet);
+  const std::size_t num_facet_vertices = facet_vertices.size(facet);
+  const std::size_t cell = mesh.topology()(D - 1, D)(facet)[0];
 
   // Get the vertex opposite to the facet (the one we remove)
   std::size_t vertex = 0;
-  const Cell cell(mesh, facet.entities(mesh.topology().dim())[0]);
-  for (std::size_t i = 0; i < cell.num_entities(0); i++)
+  for (std::size_t i = 0; i < cell_vertices.size(cell); i++)
   {
-    bool not_in_facet = true;
-    vertex = cell.entities(0)[i];
-    for (std::size_t j = 0; j < facet.num_entities(0); j++)
+    vertex = cell_vertices(cell)[i];
+    if (std::find(fv, fv + num_facet_vertices, vertex)
+        == fv + num_facet_vertices)
     {
-      if (vertex == facet.entities(0)[j])
-      {
-        not_in_facet = false;
-        break;
-      }
-    }
-    if (not_in_facet)
       break;
+    }
   }
   const Point p = mesh.geometry().point(vertex);
 
@@ -419,10 +459,10 @@ void BoundaryComputation::reorder(std::vector<std::size_t>& vertices,
     break;
   case CellType::triangle:
     {
-      dolfin_assert(facet.num_entities(0) == 2);
+      dolfin_assert(num_facet_vertices == 2);
 
-      const Point p0 = mesh.geometry().point(facet.entities(0)[0]);
-      const Point p1 = mesh.geometry().point(facet.entities(0)[1]);
+      const Point p0 = mesh.geometry().point(fv[0]);
+      const Point p1 = mesh.geometry().point(fv[1]);
       const Point v = p1 - p0;
       const Point n(v.y(), -v.x());
 
@@ -436,11 +476,11 @@ void BoundaryComputation::reorder(std::vector<std::size_t>& vertices,
     break;
   case CellType::tetrahedron:
     {
-      dolfin_assert(facet.num_entities(0) == 3);
+      dolfin_assert(num_facet_vertices == 3);
 
-      const Point p0 = mesh.geometry().point(facet.entities(0)[0]);
-      const Point p1 = mesh.geometry().point(facet.entities(0)[1]);
-      const Point p2 = mesh.geometry().point(facet.entities(0)[2]);
+      const Point p0 = mesh.geometry().point(fv[0]);
+      const Point p1 = mesh.geometry().point(fv[1]);
+      const Point p2 = mesh.geometry().point(fv[2]);
       const Point v1 = p1 - p0;
       const Point v2 = p2 - p0;
       const Point n  = v1.cross(v2);
@@ -18,7 +18,7 @@
 // Modified by Niclas Jansson 2009.
 //
 // First added:  2006-06-21
-// Last changed: 2013-02-21
+// Last changed: 2014-03-26
 
 #ifndef __BOUNDARY_COMPUTATION_H
 #define __BOUNDARY_COMPUTATION_H
@@ -30,9 +30,7 @@ namespace dolfin
 {
 
   class BoundaryMesh;
-  class Facet;
   class Mesh;
-  template <typename T> class MeshFunction;
 
   /// This class implements provides a set of basic algorithms for
   /// the computation of boundaries.
@@ -41,20 +39,24 @@ namespace dolfin
   {
   public:
 
-    /// Compute the exterior boundary of a given mesh
+    /// Compute the boundary of a given mesh. The boundary facets
+    /// are found, numbered and oriented in parallel (parameter
+    /// "num_threads").
     static void compute_boundary(const Mesh& mesh,
-                                          const std::string type,
-                                          BoundaryMesh& boundary);
+                                 const std::string type,
+                                 BoundaryMesh& boundary);
 
-    /// Compute the boundary of a given mesh
-    static void compute_boundary_common(const Mesh& mesh,
-					                              BoundaryMesh& boundary,
-					                              bool interior_boundary);
+    /// Update the vertex coordinates of a boundary mesh from the
+    /// mesh it was computed from, when only the coordinates of the
+    /// mesh have changed
+    static void update_coordinates(const Mesh& mesh, BoundaryMesh& boundary);
 
   private:
 
-    /// Reorder vertices so facet is right-oriented w.r.t. facet normal
-    static void reorder(std::vector<std::size_t>& vertices, const Facet& facet);
+    // Reorder vertices of boundary cell so that the given facet is
+    // right-oriented w.r.t. facet normal
+    static void reorder(std::size_t* vertices, const Mesh& mesh,
+                        std::size_t facet);
 
   };
 
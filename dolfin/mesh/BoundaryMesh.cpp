@@ -19,7 +19,7 @@
 // Modified by Joachim B Haga 2012.
 //
 // First added:  2006-06-21
-// Last changed: 2012-09-05
+// Last changed: 2014-03-26
 
 #include <iostream>
 
@@ -80,3 +80,8 @@ const MeshFunction<std::size_t>& BoundaryMesh::entity_map(std::size_t d) const
   return _cell_map;
 }
 //-----------------------------------------------------------------------------
+void BoundaryMesh::update_coordinates(const Mesh& mesh)
+{
+  BoundaryComputation::update_coordinates(mesh, *this);
+}
+//-----------------------------------------------------------------------------
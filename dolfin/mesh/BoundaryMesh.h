@@ -19,7 +19,7 @@
 // Modified by Joachim B Haga 2012.
 //
 // First added:  2006-06-21
-// Last changed: 2012-10-30
+// Last changed: 2014-03-26
 
 #ifndef __BOUNDARY_MESH_H
 #define __BOUNDARY_MESH_H
@@ -71,6 +71,17 @@ namespace dolfin
     /// to the entity in the original full mesh (const version)
     const MeshFunction<std::size_t>& entity_map(std::size_t d) const;
 
+    /// Update vertex coordinates from the mesh the boundary mesh was
+    /// computed from. This is much cheaper than recomputing the
+    /// boundary mesh when only the coordinates of the mesh have
+    /// changed (e.g. for a moving mesh). The orientation of the
+    /// boundary cells is not recomputed.
+    ///
+    /// *Arguments*
+    ///     mesh (_Mesh_)
+    ///         The mesh the boundary mesh was computed from.
+    void update_coordinates(const Mesh& mesh);
+
   private:
 
     BoundaryMesh() {}
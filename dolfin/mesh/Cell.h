@@ -324,8 +324,18 @@ namespace dolfin
     {
       const std::size_t gdim = _mesh->geometry().dim();
       const std::size_t num_vertices = this->num_entities(0);
-      const unsigned int* vertices = this->entities(0);
       coordinates.resize(num_vertices*gdim);
+      get_vertex_coordinates(coordinates.data());
+    }
+
+    // FIXME: This function is part of a UFC transition
+    /// Get cell vertex coordinates (not coordinate dofs) into a
+    /// pre-allocated array of length num_vertices*gdim
+    void get_vertex_coordinates(double* coordinates) const
+    {
+      const std::size_t gdim = _mesh->geometry().dim();
+      const std::size_t num_vertices = this->num_entities(0);
+      const unsigned int* vertices = this->entities(0);
       for (std::size_t i = 0; i < num_vertices; i++)
         for (std::size_t j = 0; j < gdim; j++)
           coordinates[i*gdim + j] = _mesh->geometry().x(vertices[i])[j];
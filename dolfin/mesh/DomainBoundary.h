@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2008-05-23
-// Last changed: 2008-05-23
+// Last changed: 2014-03-27
 
 #ifndef __DOMAIN_BOUNDARY_H
 #define __DOMAIN_BOUNDARY_H
@@ -45,6 +45,10 @@ namespace dolfin
     virtual bool inside(const Array<double>& x, bool on_boundary) const
     { return on_boundary; }
 
+    /// Return true (inside() may be called from several threads)
+    virtual bool thread_safe() const
+    { return true; }
+
   };
 
 }
@@ -26,7 +26,7 @@
 // Modified by Jan Blechta 2013
 //
 // First added:  2006-05-09
-// Last changed: 2013-06-27
+// Last changed: 2014-03-27
 
 #include <dolfin/ale/ALE.h>
 #include <dolfin/common/Array.h>
@@ -169,6 +169,8 @@ const Mesh& Mesh::operator=(const Mesh& mesh)
   if (mesh._cell_type)
     _cell_type = CellType::create(mesh._cell_type->cell_type());
   _cell_orientations = mesh._cell_orientations;
+  _hash = mesh._hash;
+  _hash_versions = mesh._hash_versions;
 
   // Rename
   rename(mesh.name(), mesh.label());
@@ -335,6 +337,11 @@ dolfin::Mesh Mesh::renumber_by_color() const
   return MeshRenumbering::renumber_by_color(*this, coloring_type);
 }
 //-----------------------------------------------------------------------------
+dolfin::Mesh Mesh::renumber_by_locality(std::string method) const
+{
+  return MeshRenumbering::renumber_by_locality(*this, method);
+}
+//-----------------------------------------------------------------------------
 void Mesh::translate(const Point& point)
 {
   MeshTransformation::translate(*this, point);
@@ -415,12 +422,19 @@ Mesh::color(std::vector<std::size_t> coloring_type) const
 //-----------------------------------------------------------------------------
 std::shared_ptr<BoundingBoxTree> Mesh::bounding_box_tree() const
 {
-  // Allocate and build tree if necessary
-  if (!_tree)
+  const std::pair<std::size_t, std::size_t>
+    versions(_topology.version(), _geometry.version());
+
+  // Allocate and build tree if necessary, rebuild it if the topology
+  // has changed and refit it if only the coordinates have changed
+  if (!_tree || versions.first != _tree_versions.first)
   {
     _tree.reset(new BoundingBoxTree());
     _tree->build(*this);
   }
+  else if (versions.second != _tree_versions.second)
+    _tree->refit();
+  _tree_versions = versions;
 
   return _tree;
 }
@@ -467,6 +481,16 @@ double Mesh::rmax() const
 //-----------------------------------------------------------------------------
 std::size_t Mesh::hash() const
 {
+  // Check whether topology or geometry has changed on any process
+  // (hash_global is collective, so all processes must agree)
+  const std::pair<std::size_t, std::size_t>
+    versions(_topology.version(), _geometry.version());
+  std::size_t changed = versions != _hash_versions ? 1 : 0;
+  if (MPI::size(_mpi_comm) > 1)
+    changed = MPI::max(_mpi_comm, changed);
+  if (!changed)
+    return _hash;
+
   // Get local hashes
   const std::size_t kt_local = _topology.hash();
   const std::size_t kg_local = _geometry.hash();
@@ -476,7 +500,10 @@ std::size_t Mesh::hash() const
   const std::size_t kg = hash_global(_mpi_comm, kg_local);
 
   // Compute hash based on the Cantor pairing function
-  return (kt + kg)*(kt + kg + 1)/2 + kg;
+  _hash = (kt + kg)*(kt + kg + 1)/2 + kg;
+  _hash_versions = versions;
+
+  return _hash;
 }
 //-----------------------------------------------------------------------------
 std::string Mesh::str(bool verbose) const
@@ -26,7 +26,7 @@
 // Modified by Jan Blechta 2013
 //
 // First added:  2006-05-08
-// Last changed: 2013-06-27
+// Last changed: 2014-03-27
 
 #ifndef __MESH_H
 #define __MESH_H
@@ -348,10 +348,12 @@ namespace dolfin
     /// Get bounding box tree for mesh. The bounding box tree is
     /// initialized and built upon the first call to this
     /// function. The bounding box tree can be used to compute
-    /// collisions between the mesh and other objects. It is the
-    /// responsibility of the caller to use (and possibly rebuild) the
-    /// tree. It is stored as a (mutable) member of the mesh to enable
-    /// sharing of the bounding box tree data structure.
+    /// collisions between the mesh and other objects. It is stored
+    /// as a (mutable) member of the mesh to enable sharing of the
+    /// bounding box tree data structure. The tree is rebuilt if the
+    /// mesh topology has changed since it was built, and refitted
+    /// (see BoundingBoxTree::refit) if only the coordinates have
+    /// changed.
     std::shared_ptr<BoundingBoxTree> bounding_box_tree() const;
 
     /// Get mesh data.
@@ -430,6 +432,20 @@ namespace dolfin
     /// cell-vertex connectivity exists as part of the mesh.
     Mesh renumber_by_color() const;
 
+    /// Renumber cells and vertices to improve data locality, by
+    /// ordering cells along a space-filling curve ("hilbert" or
+    /// "morton") or by reverse Cuthill-McKee ordering of the dual
+    /// graph ("rcm"). See MeshRenumbering::renumber_by_locality.
+    ///
+    /// *Arguments*
+    ///     method (std::string)
+    ///         Renumbering method ("hilbert", "morton" or "rcm").
+    ///
+    /// *Returns*
+    ///     _Mesh_
+    ///         The renumbered mesh.
+    Mesh renumber_by_locality(std::string method="hilbert") const;
+
     /// Translate mesh according to a given vector.
     ///
     /// *Arguments*
@@ -608,7 +624,10 @@ namespace dolfin
     double rmax() const;
 
     /// Compute hash of mesh, currently based on the has of the mesh
-    /// geometry and mesh topology.
+    /// geometry and mesh topology. The hash is cached and only
+    /// recomputed when the version of the topology or geometry has
+    /// changed (see MeshTopology::version and MeshGeometry::version)
+    /// on some process.
     ///
     /// *Returns*
     ///     std::size_t
@@ -684,6 +703,10 @@ namespace dolfin
     // and is allocated and built when bounding_box_tree() is called.
     mutable std::shared_ptr<BoundingBoxTree> _tree;
 
+    // Versions of topology and geometry the bounding box tree was
+    // built or refitted for
+    mutable std::pair<std::size_t, std::size_t> _tree_versions;
+
     // Cell type
     CellType* _cell_type;
 
@@ -696,6 +719,12 @@ namespace dolfin
     // MPI communicator
     MPI_Comm _mpi_comm;
 
+    // Cached hash and the versions of topology and geometry it was
+    // computed for. Versions are unique, so the initial pair (0, 0)
+    // never matches.
+    mutable std::size_t _hash;
+    mutable std::pair<std::size_t, std::size_t> _hash_versions;
+
   };
 }
 
@@ -18,7 +18,7 @@
 // Modified by Mikael Mortensen 2014
 //
 // First added:  2006-05-09
-// Last changed: 2014-01-09
+// Last changed: 2014-03-22
 
 #include <sstream>
 #include <boost/functional/hash.hpp>
@@ -29,13 +29,13 @@ using namespace dolfin;
 
 //-----------------------------------------------------------------------------
 MeshConnectivity::MeshConnectivity(std::size_t d0, std::size_t d1)
-  : _d0(d0), _d1(d1)
+  : _d0(d0), _d1(d1), _num_connections(0), _num_entities(0)
 {
   // Do nothing
 }
 //-----------------------------------------------------------------------------
 MeshConnectivity::MeshConnectivity(const MeshConnectivity& connectivity)
-  : _d0(0), _d1(0)
+  : _d0(0), _d1(0), _num_connections(0), _num_entities(0)
 {
   *this = connectivity;
 }
@@ -57,6 +57,8 @@ MeshConnectivity::operator= (const MeshConnectivity& connectivity)
   _connections = connectivity._connections;
   _num_global_connections = connectivity._num_global_connections;
   index_to_position = connectivity.index_to_position;
+  _num_connections = connectivity._num_connections;
+  _num_entities = connectivity._num_entities;
 
   return *this;
 }
@@ -65,6 +67,8 @@ void MeshConnectivity::clear()
 {
   std::vector<unsigned int>().swap(_connections);
   std::vector<unsigned int>().swap(index_to_position);
+  _num_connections = 0;
+  _num_entities = 0;
 }
 //-----------------------------------------------------------------------------
 void MeshConnectivity::init(std::size_t num_entities,
@@ -79,11 +83,48 @@ void MeshConnectivity::init(std::size_t num_entities,
   // Allocate
   _connections.resize(size);
   std::fill(_connections.begin(), _connections.end(), 0);
-  index_to_position.resize(num_entities + 1);
 
-  // Initialize data
-  for (std::size_t e = 0; e < index_to_position.size(); e++)
-    index_to_position[e] = e*num_connections;
+  // Initialize data (offsets are only needed if there are no
+  // connections)
+  if (num_connections > 0)
+  {
+    _num_connections = num_connections;
+    _num_entities = num_entities;
+  }
+  else
+    index_to_position.assign(num_entities + 1, 0);
+}
+//-----------------------------------------------------------------------------
+void MeshConnectivity::swap(std::vector<unsigned int>& connections,
+                            std::size_t num_connections)
+{
+  dolfin_assert(num_connections > 0);
+  dolfin_assert(connections.size() % num_connections == 0);
+
+  // Clear old data if any
+  clear();
+
+  // Take over connections
+  _connections.swap(connections);
+  _num_connections = num_connections;
+  _num_entities = _connections.size()/num_connections;
+}
+//-----------------------------------------------------------------------------
+void MeshConnectivity::swap(std::vector<unsigned int>& connections,
+                            std::vector<unsigned int>& offsets)
+{
+  dolfin_assert(!offsets.empty());
+  dolfin_assert(offsets.back() == connections.size());
+
+  // Clear old data if any
+  clear();
+
+  // Take over connections and offsets
+  _connections.swap(connections);
+  index_to_position.swap(offsets);
+
+  // Drop offsets if possible
+  compress();
 }
 //-----------------------------------------------------------------------------
 void MeshConnectivity::init(std::vector<std::size_t>& num_connections)
@@ -105,39 +146,39 @@ void MeshConnectivity::init(std::vector<std::size_t>& num_connections)
   // Initialize connections
   _connections.resize(size);
   std::fill(_connections.begin(), _connections.end(), 0);
+
+  // Drop offsets if possible
+  compress();
 }
 //-----------------------------------------------------------------------------
 void MeshConnectivity::set(std::size_t entity, std::size_t connection,
                            std::size_t pos)
 {
-  dolfin_assert((entity + 1) < index_to_position.size());
-  dolfin_assert(pos < index_to_position[entity + 1]
-                - index_to_position[entity]);
-  _connections[index_to_position[entity] + pos] = connection;
+  dolfin_assert(entity < num_entities());
+  dolfin_assert(pos < size(entity));
+  _connections[offset(entity) + pos] = connection;
 }
 //-----------------------------------------------------------------------------
 void MeshConnectivity::set(std::size_t entity,
                            const std::vector<std::size_t>& connections)
 {
-  dolfin_assert((entity + 1) < index_to_position.size());
-  dolfin_assert(connections.size()
-                == index_to_position[entity + 1] - index_to_position[entity]);
+  dolfin_assert(entity < num_entities());
+  dolfin_assert(connections.size() == size(entity));
 
   // Copy data
   std::copy(connections.begin(), connections.end(),
-            _connections.begin() + index_to_position[entity]);
+            _connections.begin() + offset(entity));
 }
 //-----------------------------------------------------------------------------
 void MeshConnectivity::set(std::size_t entity, std::size_t* connections)
 {
-  dolfin_assert((entity + 1) < index_to_position.size());
+  dolfin_assert(entity < num_entities());
   dolfin_assert(connections);
 
   // Copy data
-  const std::size_t num_connections
-    = index_to_position[entity + 1] - index_to_position[entity];
+  const std::size_t num_connections = size(entity);
   std::copy(connections, connections + num_connections,
-            _connections.begin() + index_to_position[entity]);
+            _connections.begin() + offset(entity));
 }
 //-----------------------------------------------------------------------------
 std::size_t MeshConnectivity::hash() const
@@ -147,6 +188,13 @@ std::size_t MeshConnectivity::hash() const
   return uhash(_connections);
 }
 //-----------------------------------------------------------------------------
+std::size_t MeshConnectivity::memory_usage() const
+{
+  return sizeof(unsigned int)*(_connections.capacity()
+                               + index_to_position.capacity()
+                               + _num_global_connections.capacity());
+}
+//-----------------------------------------------------------------------------
 std::string MeshConnectivity::str(bool verbose) const
 {
   std::stringstream s;
@@ -154,14 +202,11 @@ std::string MeshConnectivity::str(bool verbose) const
   if (verbose)
   {
     s << str(false) << std::endl << std::endl;
-    for (std::size_t e = 0; e < index_to_position.size() - 1; e++)
+    for (std::size_t e = 0; e < num_entities(); e++)
     {
       s << "  " << e << ":";
-      for (std::size_t i = index_to_position[e]; i < index_to_position[e + 1];
-           i++)
-      {
+      for (std::size_t i = offset(e); i < offset(e) + size(e); i++)
         s << " " << _connections[i];
-      }
       s << std::endl;
     }
   }
@@ -174,3 +219,23 @@ std::string MeshConnectivity::str(bool verbose) const
   return s.str();
 }
 //-----------------------------------------------------------------------------
+void MeshConnectivity::compress()
+{
+  // Check that all entities have the same number of connections
+  if (_num_connections > 0 || index_to_position.size() < 2)
+    return;
+  const std::size_t num_connections = index_to_position[1];
+  if (num_connections == 0)
+    return;
+  for (std::size_t e = 1; e < index_to_position.size(); e++)
+  {
+    if (index_to_position[e] != e*num_connections)
+      return;
+  }
+
+  // Drop offsets
+  _num_connections = num_connections;
+  _num_entities = index_to_position.size() - 1;
+  std::vector<unsigned int>().swap(index_to_position);
+}
+//-----------------------------------------------------------------------------
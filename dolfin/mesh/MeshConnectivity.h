@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2006-05-09
-// Last changed: 2010-11-28
+// Last changed: 2014-03-22
 
 #ifndef __MESH_CONNECTIVITY_H
 #define __MESH_CONNECTIVITY_H
@@ -35,6 +35,9 @@ namespace dolfin
   /// number of entities and the number of connections for each entity,
   /// which may either be equal for all entities or different, or by
   /// giving the entire (sparse) connectivity pattern.
+  ///
+  /// If all entities have the same number of connections, no offsets
+  /// are stored for the entities.
 
   class MeshConnectivity
   {
@@ -63,10 +66,20 @@ namespace dolfin
     /// Return number of connections for given entity
     std::size_t size(std::size_t entity) const
     {
+      if (_num_connections > 0)
+        return (entity < _num_entities ? _num_connections : 0);
       return ( (entity + 1) < index_to_position.size()
           ? index_to_position[entity + 1] - index_to_position[entity] : 0);
     }
 
+    /// Return number of entities
+    std::size_t num_entities() const
+    {
+      if (_num_connections > 0)
+        return _num_entities;
+      return index_to_position.empty() ? 0 : index_to_position.size() - 1;
+    }
+
     /// Return global number of connections for given entity
     std::size_t size_global(std::size_t entity) const
     {
@@ -82,6 +95,11 @@ namespace dolfin
     /// Return array of connections for given entity
     const unsigned int* operator() (std::size_t entity) const
     {
+      if (_num_connections > 0)
+      {
+        return (entity < _num_entities
+                ? &_connections[entity*_num_connections] : 0);
+      }
       return ((entity + 1) < index_to_position.size()
         ? &_connections[index_to_position[entity]] : 0);
     }
@@ -110,6 +128,20 @@ namespace dolfin
     /// Set all connections for given entity
     void set(std::size_t entity, std::size_t* connections);
 
+    /// Set all connections for all entities from a contiguous array
+    /// with the same number of connections for each entity. The
+    /// array is swapped into the connectivity (to avoid a copy) and
+    /// is left empty.
+    void swap(std::vector<unsigned int>& connections,
+              std::size_t num_connections);
+
+    /// Set all connections for all entities from a contiguous array
+    /// and the offset of the first connection of each entity (with
+    /// one extra offset at the end). The arrays are swapped into the
+    /// connectivity (to avoid a copy) and are left empty.
+    void swap(std::vector<unsigned int>& connections,
+              std::vector<unsigned int>& offsets);
+
     /// Set all connections for all entities (T is a container, e.g.
     /// a std::vector<std::size_t>, std::set<std::size_t>, etc)
     template <typename T>
@@ -133,20 +165,25 @@ namespace dolfin
       typename std::vector<T>::const_iterator e;
       for (e = connections.begin(); e != connections.end(); ++e)
         _connections.insert(_connections.end(), e->begin(), e->end());
+
+      // Drop offsets if possible
+      compress();
     }
 
     /// Set global number of connections for all local entities
     void
       set_global_size(const std::vector<unsigned int>& num_global_connections)
     {
-      dolfin_assert(num_global_connections.size()
-                    == index_to_position.size() - 1);
+      dolfin_assert(num_global_connections.size() == num_entities());
       _num_global_connections = num_global_connections;
     }
 
     /// Hash of connections
     std::size_t hash() const;
 
+    /// Return memory used by connectivity (in bytes)
+    std::size_t memory_usage() const;
+
     /// Return informal string representation (pretty-print)
     std::string str(bool verbose) const;
 
@@ -156,6 +193,17 @@ namespace dolfin
     friend class BinaryFile;
     friend class MeshRenumbering;
 
+    // Return position of first connection for given entity
+    std::size_t offset(std::size_t entity) const
+    {
+      return (_num_connections > 0 ? entity*_num_connections
+              : index_to_position[entity]);
+    }
+
+    // Drop offsets if all entities have the same (nonzero) number of
+    // connections
+    void compress();
+
     // Dimensions (only used for pretty-printing)
     std::size_t _d0, _d1;
 
@@ -166,9 +214,18 @@ namespace dolfin
     // computed)
     std::vector<unsigned int> _num_global_connections;
 
-    // Position of first connection for each entity (using local index)
+    // Position of first connection for each entity (using local
+    // index), empty if all entities have the same number of
+    // connections
     std::vector<unsigned int> index_to_position;
 
+    // Number of connections for each entity if equal for all
+    // entities, otherwise zero
+    std::size_t _num_connections;
+
+    // Number of entities (only used if _num_connections is nonzero)
+    std::size_t _num_entities;
+
   };
 
 }
@@ -19,7 +19,7 @@
 // Modified by Garth N. Wells, 2011.
 //
 // First added:  2008-05-19
-// Last changed: 2011-09-15
+// Last changed: 2014-03-25
 
 #ifndef __MESH_DATA_H
 #define __MESH_DATA_H
@@ -186,6 +186,7 @@ namespace dolfin
 
     /// Friends
     friend class XMLMesh;
+    friend class MeshRenumbering;
 
   private:
 
@@ -18,7 +18,7 @@
 // Modified by Benjamin Kehlet, 2012
 //
 // First added:  2006-05-16
-// Last changed: 2014-02-06
+// Last changed: 2014-03-27
 
 #include <dolfin/log/log.h>
 #include <dolfin/geometry/Point.h>
@@ -258,6 +258,7 @@ void MeshEditor::add_cell(std::size_t local_index, std::size_t global_index,
   // Set data
   _mesh->_topology(_tdim, 0).set(local_index, v);
   _mesh->_topology.set_global_index(_tdim, local_index, global_index);
+  _mesh->_topology._changed = true;
 }
 //-----------------------------------------------------------------------------
 void MeshEditor::close(bool order)
@@ -0,0 +1,134 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-24
+// Last changed: 2014-03-27
+
+#include <algorithm>
+#include <sstream>
+#include <ufc.h>
+#include <dolfin/parameter/GlobalParameters.h>
+#include "Mesh.h"
+#include "MeshEntityRange.h"
+
+using namespace dolfin;
+
+//-----------------------------------------------------------------------------
+MeshEntityRange::MeshEntityRange(const Mesh& mesh, std::size_t dim)
+  : _mesh(&mesh), _dim(dim), _begin(0), _end(0), _gdim(0), _connectivity(0),
+    _x(0)
+{
+  init(0, mesh.init(dim));
+}
+//-----------------------------------------------------------------------------
+MeshEntityRange::MeshEntityRange(const Mesh& mesh, std::size_t dim,
+                                 std::size_t begin, std::size_t end)
+  : _mesh(&mesh), _dim(dim), _begin(0), _end(0), _gdim(0), _connectivity(0),
+    _x(0)
+{
+  const std::size_t num_entities = mesh.init(dim);
+  if (begin > end || end > num_entities)
+  {
+    dolfin_error("MeshEntityRange.cpp",
+                 "create range of mesh entities",
+                 "Range [%d, %d) is not contained in [0, %d)",
+                 begin, end, num_entities);
+  }
+  init(begin, end);
+}
+//-----------------------------------------------------------------------------
+MeshEntityRange::~MeshEntityRange()
+{
+  // Do nothing
+}
+//-----------------------------------------------------------------------------
+void MeshEntityRange::midpoint(std::size_t entity, double* x) const
+{
+  const unsigned int* v = vertices(entity);
+  const std::size_t n = num_vertices(entity);
+  for (std::size_t j = 0; j < _gdim; ++j)
+    x[j] = 0.0;
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t j = 0; j < _gdim; ++j)
+      x[j] += _x[v[i]*_gdim + j];
+  for (std::size_t j = 0; j < _gdim; ++j)
+    x[j] /= static_cast<double>(n);
+}
+//-----------------------------------------------------------------------------
+void MeshEntityRange::get_cell_data(std::size_t cell, ufc::cell& ufc_cell,
+                                    int local_facet) const
+{
+  dolfin_assert(_dim == _mesh->topology().dim());
+  ufc_cell.geometric_dimension = _gdim;
+  ufc_cell.local_facet = local_facet;
+  ufc_cell.orientation = _mesh->cell_orientations()[cell];
+  ufc_cell.mesh_identifier = _mesh->id();
+  ufc_cell.index = cell;
+}
+//-----------------------------------------------------------------------------
+MeshEntityRange MeshEntityRange::block(std::size_t i,
+                                       std::size_t num_blocks) const
+{
+  dolfin_assert(i < num_blocks);
+
+  // Distribute remainder over the first blocks
+  const std::size_t n = size()/num_blocks;
+  const std::size_t r = size() % num_blocks;
+
+  MeshEntityRange range(*this);
+  range._begin = _begin + i*n + std::min(i, r);
+  range._end = range._begin + n + (i < r ? 1 : 0);
+  return range;
+}
+//-----------------------------------------------------------------------------
+std::size_t MeshEntityRange::num_threads()
+{
+  const int num_threads = parameters["num_threads"];
+  return num_threads > 1 ? num_threads : 1;
+}
+//-----------------------------------------------------------------------------
+std::string MeshEntityRange::str(bool verbose) const
+{
+  std::stringstream s;
+  s << "<MeshEntityRange of topological dimension " << _dim
+    << " over entities [" << _begin << ", " << _end << ")>";
+  return s.str();
+}
+//-----------------------------------------------------------------------------
+void MeshEntityRange::init(std::size_t begin, std::size_t end)
+{
+  _begin = begin;
+  _end = end;
+  _gdim = _mesh->geometry().dim();
+
+  // Connectivity (0, 0) is the vertex neighbours, so each vertex is
+  // instead connected to itself
+  if (_dim == 0)
+  {
+    const std::size_t num_vertices = _mesh->num_vertices();
+    std::vector<unsigned int> vertices(num_vertices);
+    for (std::size_t v = 0; v < num_vertices; ++v)
+      vertices[v] = v;
+    _identity.reset(new MeshConnectivity(0, 0));
+    _identity->swap(vertices, 1);
+    _connectivity = _identity.get();
+  }
+  else
+    _connectivity = &_mesh->topology()(_dim, 0);
+  _x = _mesh->geometry().x().empty() ? 0 : &_mesh->geometry().x()[0];
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,213 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-24
+// Last changed: 2014-03-27
+
+#ifndef __MESH_ENTITY_RANGE_H
+#define __MESH_ENTITY_RANGE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <dolfin/log/log.h>
+#include "MeshConnectivity.h"
+
+namespace ufc
+{
+  class cell;
+}
+
+namespace dolfin
+{
+
+  class Mesh;
+
+  /// MeshEntityRange provides direct access to the vertex indices
+  /// and vertex coordinates of a contiguous range of mesh entities of
+  /// a given topological dimension. It is intended for tight loops
+  /// where the overhead of creating a _MeshEntity_ for each step of a
+  /// _MeshEntityIterator_ is significant. A vertex is treated as an
+  /// entity with a single vertex (itself).
+  ///
+  /// *Example*
+  ///
+  ///     The following example shows how to sum the first vertex
+  ///     coordinate over the vertices of all cells:
+  ///
+  ///     .. code-block:: c++
+  ///
+  ///         MeshEntityRange cells(mesh, mesh.topology().dim());
+  ///         double sum = 0.0;
+  ///         for (std::size_t c = cells.begin(); c < cells.end(); ++c)
+  ///         {
+  ///           const unsigned int* vertices = cells.vertices(c);
+  ///           for (std::size_t i = 0; i < cells.num_vertices(c); ++i)
+  ///             sum += cells.x(vertices[i])[0];
+  ///         }
+  ///
+  ///     The loop may be run in parallel by calling parallel_for()
+  ///     with one kernel (function object) per thread. Each kernel
+  ///     may hold its own scratch data and partial results:
+  ///
+  ///     .. code-block:: c++
+  ///
+  ///         std::vector<Kernel> kernels(MeshEntityRange::num_threads());
+  ///         cells.parallel_for(kernels);
+
+  class MeshEntityRange
+  {
+  public:
+
+    /// Create range of all entities of given topological dimension
+    MeshEntityRange(const Mesh& mesh, std::size_t dim);
+
+    /// Create range of entities [begin, end) of given topological
+    /// dimension
+    MeshEntityRange(const Mesh& mesh, std::size_t dim,
+                    std::size_t begin, std::size_t end);
+
+    /// Destructor
+    ~MeshEntityRange();
+
+    /// Return mesh
+    const Mesh& mesh() const
+    { return *_mesh; }
+
+    /// Return topological dimension of entities
+    std::size_t dim() const
+    { return _dim; }
+
+    /// Return index of first entity in range
+    std::size_t begin() const
+    { return _begin; }
+
+    /// Return index past last entity in range
+    std::size_t end() const
+    { return _end; }
+
+    /// Return number of entities in range
+    std::size_t size() const
+    { return _end - _begin; }
+
+    /// Return geometric dimension of vertex coordinates
+    std::size_t gdim() const
+    { return _gdim; }
+
+    /// Return number of vertices of given entity
+    std::size_t num_vertices(std::size_t entity) const
+    { return _connectivity->size(entity); }
+
+    /// Return array of vertex indices of given entity
+    const unsigned int* vertices(std::size_t entity) const
+    { return (*_connectivity)(entity); }
+
+    /// Return array of coordinates of given vertex
+    const double* x(std::size_t vertex) const
+    { return _x + vertex*_gdim; }
+
+    /// Copy vertex coordinates of given entity (vertex after vertex)
+    /// into a pre-allocated array of length num_vertices*gdim
+    void get_vertex_coordinates(std::size_t entity, double* coordinates) const
+    {
+      const unsigned int* v = vertices(entity);
+      const std::size_t n = num_vertices(entity);
+      for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t j = 0; j < _gdim; ++j)
+          coordinates[i*_gdim + j] = _x[v[i]*_gdim + j];
+    }
+
+    /// Compute midpoint of given entity into a pre-allocated array
+    /// of length gdim
+    void midpoint(std::size_t entity, double* x) const;
+
+    /// Fill UFC cell with miscellaneous data for given cell, as
+    /// Cell::get_cell_data (only for ranges of cells)
+    void get_cell_data(std::size_t cell, ufc::cell& ufc_cell,
+                       int local_facet=-1) const;
+
+    /// Return block i of num_blocks (nearly) equal-sized contiguous
+    /// blocks of the range
+    MeshEntityRange block(std::size_t i, std::size_t num_blocks) const;
+
+    /// Apply kernels to all entities of the range, splitting the
+    /// range into one contiguous block per kernel. Kernel i is called
+    /// as kernels[i](range, entity) for each entity of block i, and
+    /// the blocks are processed in parallel (if DOLFIN is compiled
+    /// with OpenMP). A kernel is any type providing
+    ///
+    ///     void operator() (const MeshEntityRange&, std::size_t)
+    ///
+    /// Results computed by the kernels must be combined by the
+    /// caller.
+    template <typename Kernel>
+    void parallel_for(std::vector<Kernel>& kernels) const
+    {
+      const std::size_t num_blocks = kernels.size();
+      if (num_blocks == 0)
+        return;
+
+      #ifdef HAS_OPENMP
+      #pragma omp parallel for schedule(static) num_threads(num_blocks) if (num_blocks > 1)
+      #endif
+      for (std::size_t i = 0; i < num_blocks; ++i)
+      {
+        const MeshEntityRange range = block(i, num_blocks);
+        Kernel& kernel = kernels[i];
+        for (std::size_t e = range._begin; e < range._end; ++e)
+          kernel(range, e);
+      }
+    }
+
+    /// Return number of threads to use for parallel_for (parameter
+    /// "num_threads", at least 1)
+    static std::size_t num_threads();
+
+    /// Return informal string representation (pretty-print)
+    std::string str(bool verbose) const;
+
+  private:
+
+    // Initialize data
+    void init(std::size_t begin, std::size_t end);
+
+    // The mesh
+    const Mesh* _mesh;
+
+    // Topological dimension of entities
+    std::size_t _dim;
+
+    // Range of entities
+    std::size_t _begin, _end;
+
+    // Geometric dimension
+    std::size_t _gdim;
+
+    // Entity-vertex connectivity
+    const MeshConnectivity* _connectivity;
+
+    // Vertex-vertex identity connectivity (only used for vertices)
+    std::shared_ptr<MeshConnectivity> _identity;
+
+    // Vertex coordinates
+    const double* _x;
+
+  };
+
+}
+
+#endif
@@ -19,23 +19,26 @@
 // Modified by Kristoffer Selim, 2008.
 //
 // First added:  2006-05-19
-// Last changed: 2010-04-29
+// Last changed: 2014-03-27
 
 #include <sstream>
 #include <boost/functional/hash.hpp>
 
+#include <dolfin/common/UniqueIdGenerator.h>
 #include <dolfin/log/log.h>
 #include "MeshGeometry.h"
 
 using namespace dolfin;
 
 //-----------------------------------------------------------------------------
-MeshGeometry::MeshGeometry() : _dim(0)
+MeshGeometry::MeshGeometry() : _dim(0), _version(0), _version_hash(0),
+                               _changed(true), _accessed(false)
 {
   // Do nothing
 }
 //-----------------------------------------------------------------------------
-MeshGeometry::MeshGeometry(const MeshGeometry& geometry) : _dim(0)
+MeshGeometry::MeshGeometry(const MeshGeometry& geometry)
+  : _dim(0), _version(0), _version_hash(0), _changed(true), _accessed(false)
 {
   *this = geometry;
 }
@@ -49,9 +52,13 @@ const MeshGeometry& MeshGeometry::operator= (const MeshGeometry& geometry)
 {
   // Copy data
   _dim = geometry._dim;
-  coordinates             = geometry.coordinates;
-  position_to_local_index = geometry.position_to_local_index;
-  local_index_to_position = geometry.local_index_to_position;
+  coordinates = geometry.coordinates;
+
+  // Equal coordinates share version
+  _version = geometry.version();
+  _version_hash = geometry._version_hash;
+  _changed = false;
+  _accessed = false;
 
   return *this;
 }
@@ -77,8 +84,7 @@ void MeshGeometry::clear()
 {
   _dim  = 0;
   coordinates.clear();
-  position_to_local_index.clear();
-  local_index_to_position.clear();
+  _changed = true;
 }
 //-----------------------------------------------------------------------------
 void MeshGeometry::init(std::size_t dim, std::size_t size)
@@ -89,10 +95,6 @@ void MeshGeometry::init(std::size_t dim, std::size_t size)
   // Allocate new data
   coordinates.resize(dim*size);
 
-  // Allocate new data
-  position_to_local_index.resize(size);
-  local_index_to_position.resize(size);
-
   // Save dimension and size
   _dim = dim;
 }
@@ -101,13 +103,9 @@ void MeshGeometry::set(std::size_t local_index,
                        const std::vector<double>& x)
 {
   dolfin_assert(x.size() == _dim);
+  dolfin_assert((local_index + 1)*_dim <= coordinates.size());
   std::copy(x.begin(), x.end(), coordinates.begin() + local_index*_dim);
-
-  dolfin_assert(local_index < position_to_local_index.size());
-  position_to_local_index[local_index] = local_index;
-
-  dolfin_assert(local_index < local_index_to_position.size());
-  local_index_to_position[local_index] = local_index;
+  _changed = true;
 }
 //-----------------------------------------------------------------------------
 std::size_t MeshGeometry::hash() const
@@ -118,6 +116,24 @@ std::size_t MeshGeometry::hash() const
   return local_hash;
 }
 //-----------------------------------------------------------------------------
+std::size_t MeshGeometry::version() const
+{
+  // Coordinates accessed through a non-const accessor have only been
+  // modified if they differ from the coordinates when the version
+  // was assigned
+  if (_accessed && !_changed)
+    _changed = hash() != _version_hash;
+  _accessed = false;
+
+  if (_changed)
+  {
+    _version = UniqueIdGenerator::id();
+    _version_hash = hash();
+    _changed = false;
+  }
+  return _version;
+}
+//-----------------------------------------------------------------------------
 std::string MeshGeometry::str(bool verbose) const
 {
   std::stringstream s;
@@ -18,7 +18,7 @@
 // Modified by Garth N. Wells, 2008.
 //
 // First added:  2006-05-08
-// Last changed: 2010-11-29
+// Last changed: 2014-03-27
 
 #ifndef __MESH_GEOMETRY_H
 #define __MESH_GEOMETRY_H
@@ -34,6 +34,20 @@ namespace dolfin
   /// MeshGeometry stores the geometry imposed on a mesh. Currently,
   /// the geometry is represented by the set of coordinates for the
   /// vertices of a mesh, but other representations are possible.
+  ///
+  /// The coordinates of the vertex with local index n are stored
+  /// contiguously at position n*dim in the coordinate array.
+  ///
+  /// The geometry keeps a version number which changes whenever the
+  /// coordinates are initialized or set, and when they have been
+  /// modified through one of the non-const accessors x(). Since a
+  /// non-const accessor may also be used only for reading, the
+  /// coordinates are then compared (by hash) with the coordinates
+  /// when the version was assigned, so read-only access does not
+  /// change the version. Data computed from the coordinates may thus
+  /// be validated by comparing versions. Note that modifications made
+  /// through a reference kept from an earlier call to x() are not
+  /// detected once the version has been computed.
 
   class Function;
 
@@ -67,36 +81,41 @@ namespace dolfin
     /// Return value of coordinate with local index n in direction i
     double& x(std::size_t n, std::size_t i)
     {
-      dolfin_assert(n < local_index_to_position.size());
+      dolfin_assert((n + 1)*_dim <= coordinates.size());
       dolfin_assert(i < _dim);
-      return coordinates[local_index_to_position[n]*_dim + i];
+      _accessed = true;
+      return coordinates[n*_dim + i];
     }
 
     /// Return value of coordinate with local index n in direction i
     double x(std::size_t n, std::size_t i) const
     {
-      dolfin_assert(n < local_index_to_position.size());
+      dolfin_assert((n + 1)*_dim <= coordinates.size());
       dolfin_assert(i < _dim);
-      return coordinates[local_index_to_position[n]*_dim + i];
+      return coordinates[n*_dim + i];
     }
 
     /// Return array of values for coordinate with local index n
     double* x(std::size_t n)
     {
-      dolfin_assert(n < local_index_to_position.size());
-      return &coordinates[local_index_to_position[n]*_dim];
+      dolfin_assert((n + 1)*_dim <= coordinates.size());
+      _accessed = true;
+      return &coordinates[n*_dim];
     }
 
     /// Return array of values for coordinate with local index n
     const double* x(std::size_t n) const
     {
-      dolfin_assert(n < local_index_to_position.size());
-      return &coordinates[local_index_to_position[n]*_dim];
+      dolfin_assert((n + 1)*_dim <= coordinates.size());
+      return &coordinates[n*_dim];
     }
 
     /// Return array of values for all coordinates
     std::vector<double>& x()
-    { return coordinates; }
+    {
+      _accessed = true;
+      return coordinates;
+    }
 
     /// Return array of values for all coordinates
     const std::vector<double>& x() const
@@ -123,6 +142,11 @@ namespace dolfin
     ///
     std::size_t hash() const;
 
+    /// Return version of coordinates. The version is unique in the
+    /// lifetime of the program and changes (only) when the
+    /// coordinates have been modified.
+    std::size_t version() const;
+
     /// Return informal string representation (pretty-print)
     std::string str(bool verbose) const;
 
@@ -138,11 +162,19 @@ namespace dolfin
     // Coordinates for all vertices stored as a contiguous array
     std::vector<double> coordinates;
 
-    // Local coordinate indices (array position -> index)
-    std::vector<unsigned int> position_to_local_index;
+    // Version of coordinates (assigned lazily when changed)
+    mutable std::size_t _version;
+
+    // Local hash of coordinates when version was assigned
+    mutable std::size_t _version_hash;
+
+    // True if coordinates have been initialized or set since version
+    // was assigned
+    mutable bool _changed;
 
-    // Local coordinate indices (local index -> array position)
-    std::vector<unsigned int> local_index_to_position;
+    // True if coordinates have been accessed through a non-const
+    // accessor since version was assigned
+    mutable bool _accessed;
 
   };
 
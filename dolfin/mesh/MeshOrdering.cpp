@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2007-01-30
-// Last changed: 2012-06-25
+// Last changed: 2014-03-27
 
 #include <vector>
 #include <memory>
@@ -53,6 +53,9 @@ void MeshOrdering::order(Mesh& mesh)
     cell->order(local_to_global_vertex_indices);
     p++;
   }
+
+  // Ordering permutes the cell-vertex connectivity
+  mesh._topology._changed = true;
 }
 //-----------------------------------------------------------------------------
 bool MeshOrdering::ordered(const Mesh& mesh)
@@ -16,17 +16,102 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-10-07
-// Last changed:
+// Last changed: 2014-03-27
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
 #include <dolfin/common/MPI.h>
+#include <dolfin/common/constants.h>
+#include <dolfin/geometry/Point.h>
 #include "Cell.h"
 #include "Mesh.h"
+#include "MeshEntityRange.h"
 #include "MeshFunction.h"
 #include "MeshQuality.h"
 
 using namespace dolfin;
 
+// Number of cell quality measures
+static const std::size_t num_measures = 3;
+
+// Names of cell quality measures
+static const char* measure_names[] = {"radius_ratio", "aspect_ratio",
+                                      "dihedral_angle"};
+
+namespace dolfin
+{
+  namespace
+  {
+
+// Helper class for MeshQuality::compute_statistics. Accumulates the
+// minimum, maximum, sum and histogram of the quality measures of the
+// cells it is applied to.
+class QualityStatistics
+{
+public:
+
+  QualityStatistics(std::size_t num_bins, const std::vector<double>& scale)
+    : data(num_measures*(3 + num_bins), 0.0), _num_bins(num_bins),
+      _scale(scale)
+  {
+    for (std::size_t i = 0; i < num_measures; ++i)
+    {
+      data[i] = std::numeric_limits<double>::max();
+      data[num_measures + i] = -std::numeric_limits<double>::max();
+    }
+  }
+
+  void operator() (const MeshEntityRange& cells, std::size_t c)
+  {
+    double x[12];
+    double q[num_measures];
+    cells.get_vertex_coordinates(c, x);
+    MeshQuality::cell_quality(q, x, cells.mesh().topology().dim(),
+                              cells.gdim());
+
+    double* counts = &data[3*num_measures];
+    for (std::size_t i = 0; i < num_measures; ++i)
+    {
+      data[i] = std::min(data[i], q[i]);
+      data[num_measures + i] = std::max(data[num_measures + i], q[i]);
+      data[2*num_measures + i] += q[i];
+
+      // Compute bin index, and handle special case of upper bound
+      const std::size_t bin
+        = std::min(static_cast<std::size_t>(q[i]*_scale[i]), _num_bins - 1);
+      counts[i*_num_bins + bin] += 1.0;
+    }
+  }
+
+  void add(const QualityStatistics& other)
+  {
+    for (std::size_t i = 0; i < num_measures; ++i)
+    {
+      data[i] = std::min(data[i], other.data[i]);
+      data[num_measures + i] = std::max(data[num_measures + i],
+                                        other.data[num_measures + i]);
+    }
+    for (std::size_t i = 2*num_measures; i < data.size(); ++i)
+      data[i] += other.data[i];
+  }
+
+  // Minimum, maximum, sum and histogram of each measure
+  std::vector<double> data;
+
+private:
+
+  const std::size_t _num_bins;
+
+  // Number of bins per unit of each measure
+  const std::vector<double> _scale;
+
+};
+
+  }
+}
+
 //-----------------------------------------------------------------------------
 dolfin::CellFunction<double>
 MeshQuality::radius_ratios(std::shared_ptr<const Mesh> mesh)
@@ -34,55 +119,38 @@ MeshQuality::radius_ratios(std::shared_ptr<const Mesh> mesh)
   // Create CellFunction
   CellFunction<double> cf(mesh, 0.0);
 
-  // Compute radius ration
-  for (CellIterator cell(*mesh); !cell.end(); ++cell)
-    cf[*cell] = cell->radius_ratio();
+  // Compute radius ratio directly from vertex coordinates
+  const std::size_t tdim = mesh->topology().dim();
+  const MeshEntityRange cells(*mesh, tdim);
+  const std::size_t gdim = cells.gdim();
+  double* values = cf.values();
+  #ifdef HAS_OPENMP
+  const std::size_t num_threads = MeshEntityRange::num_threads();
+  #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t c = 0; c < cells.size(); ++c)
+  {
+    double x[12];
+    double q[num_measures];
+    cells.get_vertex_coordinates(c, x);
+    cell_quality(q, x, tdim, gdim);
+    values[c] = q[0];
+  }
 
   return cf;
 }
 //-----------------------------------------------------------------------------
 std::pair<double, double> MeshQuality::radius_ratio_min_max(const Mesh& mesh)
 {
-  CellIterator cell(mesh);
-  double qmin = cell->radius_ratio();
-  double qmax = cell->radius_ratio();
-  for (; !cell.end(); ++cell)
-  {
-    qmin = std::min(qmin, cell->radius_ratio());
-    qmax = std::max(qmax, cell->radius_ratio());
-  }
-
-  qmin = MPI::min(mesh.mpi_comm(), qmin);
-  qmax = MPI::max(mesh.mpi_comm(), qmax);
-  return std::make_pair(qmin, qmax);
+  const std::vector<double> data = compute_statistics(mesh, 1);
+  return std::make_pair(data[0], data[num_measures]);
 }
 //-----------------------------------------------------------------------------
 std::pair<std::vector<double>, std::vector<double> >
 MeshQuality::radius_ratio_histogram_data(const Mesh& mesh,
                                          std::size_t num_bins)
 {
-  std::vector<double> bins(num_bins), values(num_bins, 0.0);
-  dolfin_assert(radius_ratio_min_max(mesh).second <= 1.0);
-
-  const double interval = 1.0/static_cast<double>(num_bins);
-  for (std::size_t i = 0; i < num_bins; ++i)
-    bins[i] = static_cast<double>(i)*interval + interval/2.0;
-
-  for (CellIterator cell(mesh); !cell.end(); ++cell)
-  {
-    const double ratio = cell->radius_ratio();
-
-    // Compute 'bin' index, and handle special case that ratio = 1.0
-    const std::size_t slot
-      = std::min(static_cast<std::size_t>(ratio/interval), num_bins -1);
-
-    values[slot] += 1.0;
-  }
-
-  for (std::size_t i = 0; i < values.size(); ++i)
-    values[i] = MPI::sum(mesh.mpi_comm(), values[i]);
-
-  return std::make_pair(bins, values);
+  return histogram_data(mesh, "radius_ratio", num_bins);
 }
 //-----------------------------------------------------------------------------
 std::string
@@ -133,3 +201,231 @@ MeshQuality::radius_ratio_matplotlib_histogram(const Mesh& mesh,
   return matplotlib.str();
 }
 //-----------------------------------------------------------------------------
+std::pair<std::vector<double>, std::vector<double> >
+MeshQuality::histogram_data(const Mesh& mesh, std::string measure,
+                            std::size_t num_bins)
+{
+  const std::size_t m = measure_index(mesh, measure);
+  const std::vector<double> data = compute_statistics(mesh, num_bins);
+
+  // Bin midpoints and number of cells in each bin
+  const double interval = upper_bound(m)/static_cast<double>(num_bins);
+  std::vector<double> bins(num_bins);
+  for (std::size_t i = 0; i < num_bins; ++i)
+    bins[i] = static_cast<double>(i)*interval + interval/2.0;
+  const std::vector<double>::const_iterator counts
+    = data.begin() + 3*num_measures + m*num_bins;
+  std::vector<double> values(counts, counts + num_bins);
+
+  return std::make_pair(bins, values);
+}
+//-----------------------------------------------------------------------------
+Table MeshQuality::statistics(const Mesh& mesh)
+{
+  const std::vector<double> data = compute_statistics(mesh, 1);
+  const double num_cells = data[3*num_measures];
+
+  // Dihedral angles are not defined for intervals
+  const std::size_t n = mesh.topology().dim() > 1 ? num_measures : 2;
+
+  Table t("Mesh quality");
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    t(measure_names[i], "min") = data[i];
+    t(measure_names[i], "mean") = num_cells > 0.0
+      ? data[2*num_measures + i]/num_cells : 0.0;
+    t(measure_names[i], "max") = data[num_measures + i];
+  }
+  return t;
+}
+//-----------------------------------------------------------------------------
+void MeshQuality::cell_quality(double* quality, const double* x,
+                               std::size_t tdim, std::size_t gdim)
+{
+  dolfin_assert(gdim >= tdim && gdim <= 3);
+
+  // Get vertices as points
+  Point p[4];
+  for (std::size_t v = 0; v <= tdim; ++v)
+    for (std::size_t i = 0; i < gdim; ++i)
+      p[v][i] = x[v*gdim + i];
+
+  // Initialize to degenerate cell
+  std::fill(quality, quality + num_measures, 0.0);
+
+  switch (tdim)
+  {
+  case 1:
+    {
+      if (p[0].distance(p[1]) > 0.0)
+        quality[0] = quality[1] = 1.0;
+      break;
+    }
+  case 2:
+    {
+      // Compute side lengths and area
+      const double a = p[1].distance(p[2]);
+      const double b = p[0].distance(p[2]);
+      const double c = p[0].distance(p[1]);
+      const double area = 0.5*(p[1] - p[0]).cross(p[2] - p[0]).norm();
+      if (area == 0.0)
+        break;
+
+      // Radius ratio 2*dim*inradius/diameter (see CellType)
+      const double r = 2.0*area/(a + b + c);
+      const double diameter = 0.5*a*b*c/area;
+      quality[0] = 4.0*r/diameter;
+
+      // Aspect ratio (inradius of equilateral triangle is
+      // side/(2*sqrt(3)))
+      quality[1] = 2.0*std::sqrt(3.0)*r/std::max(a, std::max(b, c));
+
+      // The minimum angle is opposite the shortest side (and acute)
+      const double s = std::min(a, std::min(b, c));
+      quality[2] = std::asin(std::min(1.0, 2.0*area*s/(a*b*c)));
+      break;
+    }
+  case 3:
+    {
+      // Compute outward normals of facets (facet i is opposite
+      // vertex i), with length twice the facet area
+      Point n[4];
+      double A = 0.0;
+      for (std::size_t i = 0; i < 4; ++i)
+      {
+        const Point& p0 = p[(i + 1) % 4];
+        const Point& p1 = p[(i + 2) % 4];
+        const Point& p2 = p[(i + 3) % 4];
+        n[i] = (p1 - p0).cross(p2 - p0);
+        if (n[i].dot(p[i] - p0) > 0.0)
+          n[i] *= -1.0;
+        A += 0.5*n[i].norm();
+      }
+
+      // Compute volume
+      const double V
+        = std::abs((p[1] - p[0]).dot((p[2] - p[0]).cross(p[3] - p[0])))/6.0;
+      if (V == 0.0)
+        break;
+
+      // Compute lengths of pairs of opposite edges
+      const double a = p[0].distance(p[1]);
+      const double aa = p[2].distance(p[3]);
+      const double b = p[0].distance(p[2]);
+      const double bb = p[1].distance(p[3]);
+      const double c = p[0].distance(p[3]);
+      const double cc = p[1].distance(p[2]);
+
+      // Radius ratio 2*dim*inradius/diameter (see CellType and
+      // TetrahedronCell::diameter)
+      const double r = 3.0*V/A;
+      const double la = a*aa;
+      const double lb = b*bb;
+      const double lc = c*cc;
+      const double s = 0.5*(la + lb + lc);
+      const double diameter
+        = std::sqrt(std::max(0.0, s*(s - la)*(s - lb)*(s - lc)))/(3.0*V);
+      quality[0] = 6.0*r/diameter;
+
+      // Aspect ratio (inradius of regular tetrahedron is
+      // edge/(2*sqrt(6)))
+      const double h = std::max(std::max(std::max(a, aa), std::max(b, bb)),
+                                std::max(c, cc));
+      quality[1] = 2.0*std::sqrt(6.0)*r/h;
+
+      // Minimum dihedral angle between pairs of facets
+      double angle = DOLFIN_PI;
+      for (std::size_t i = 0; i < 4; ++i)
+      {
+        for (std::size_t j = i + 1; j < 4; ++j)
+        {
+          const double cos_angle = -n[i].dot(n[j])/(n[i].norm()*n[j].norm());
+          angle = std::min(angle,
+                           std::acos(std::max(-1.0, std::min(1.0, cos_angle))));
+        }
+      }
+      quality[2] = angle;
+      break;
+    }
+  default:
+    dolfin_error("MeshQuality.cpp",
+                 "compute cell quality",
+                 "Quality measures are only implemented for simplex cells");
+  }
+}
+//-----------------------------------------------------------------------------
+std::vector<double> MeshQuality::compute_statistics(const Mesh& mesh,
+                                                    std::size_t num_bins)
+{
+  dolfin_assert(num_bins > 0);
+
+  // Check cell type
+  const CellType::Type cell_type = mesh.type().cell_type();
+  if (cell_type != CellType::interval && cell_type != CellType::triangle
+      && cell_type != CellType::tetrahedron)
+  {
+    dolfin_error("MeshQuality.cpp",
+                 "compute mesh quality",
+                 "Quality measures are only implemented for simplex cells");
+  }
+
+  // Number of bins per unit of each measure
+  std::vector<double> scale(num_measures);
+  for (std::size_t i = 0; i < num_measures; ++i)
+    scale[i] = static_cast<double>(num_bins)/upper_bound(i);
+
+  // Accumulate statistics for one block of cells per thread
+  const MeshEntityRange cells(mesh, mesh.topology().dim());
+  std::vector<QualityStatistics>
+    kernels(MeshEntityRange::num_threads(), QualityStatistics(num_bins, scale));
+  cells.parallel_for(kernels);
+  for (std::size_t i = 1; i < kernels.size(); ++i)
+    kernels[0].add(kernels[i]);
+  std::vector<double>& data = kernels[0].data;
+
+  // Reduce across processes
+  const MPI_Comm mpi_comm = mesh.mpi_comm();
+  if (MPI::size(mpi_comm) > 1)
+  {
+    for (std::size_t i = 0; i < num_measures; ++i)
+    {
+      data[i] = MPI::min(mpi_comm, data[i]);
+      data[num_measures + i] = MPI::max(mpi_comm, data[num_measures + i]);
+    }
+    const std::vector<double> sums(data.begin() + 2*num_measures, data.end());
+    const std::vector<double> global_sums = MPI::sum(mpi_comm, sums);
+    std::copy(global_sums.begin(), global_sums.end(),
+              data.begin() + 2*num_measures);
+  }
+
+  return data;
+}
+//-----------------------------------------------------------------------------
+std::size_t MeshQuality::measure_index(const Mesh& mesh, std::string measure)
+{
+  for (std::size_t i = 0; i < num_measures; ++i)
+  {
+    if (measure == measure_names[i])
+    {
+      if (i == 2 && mesh.topology().dim() == 1)
+      {
+        dolfin_error("MeshQuality.cpp",
+                     "compute mesh quality",
+                     "Dihedral angles are not defined for interval meshes");
+      }
+      return i;
+    }
+  }
+
+  dolfin_error("MeshQuality.cpp",
+               "compute mesh quality",
+               "Unknown quality measure \"%s\"", measure.c_str());
+  return 0;
+}
+//-----------------------------------------------------------------------------
+double MeshQuality::upper_bound(std::size_t measure)
+{
+  // Ratios are at most one and the minimum dihedral angle is acute
+  return measure == 2 ? DOLFIN_PI/2.0 : 1.0;
+}
+//-----------------------------------------------------------------------------
@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2013-10-07
-// Last changed:
+// Last changed: 2014-03-27
 
 #ifndef __MESH_QUALITY_H
 #define __MESH_QUALITY_H
@@ -26,6 +26,7 @@
 #include <vector>
 #include <boost/multi_array.hpp>
 #include <memory>
+#include <dolfin/log/Table.h>
 #include "Cell.h"
 
 namespace dolfin
@@ -33,7 +34,23 @@ namespace dolfin
 
   class Mesh;
 
-  /// The class provides functions to quantify mesh quality
+  /// The class provides functions to quantify mesh quality. The
+  /// quality of a (simplex) cell is measured by
+  ///
+  /// * the radius ratio (topological_dimension * inradius /
+  ///   circumradius),
+  ///
+  /// * the aspect ratio (inradius / longest edge, normalized to one
+  ///   for equilateral cells) and
+  ///
+  /// * the minimum dihedral angle (minimum angle for triangles, in
+  ///   radians).
+  ///
+  /// The ratios have range zero to one, where zero indicates a
+  /// degenerate cell. Statistics and histograms of the measures are
+  /// computed in a single pass over the vertex coordinates of the
+  /// cells, multithreaded if the global parameter "num_threads" is
+  /// set, and reduced across all processes.
 
   class MeshQuality
   {
@@ -43,10 +60,10 @@ namespace dolfin
     ///
     /// *Returns*
     ///     CellFunction<double>
-    ///         The cell radius ratio radius ratio geometric_dimension *
-    ///         * inradius / circumradius (geometric_dimension
-    ///         is normalization factor). It has range zero to one.
-    ///         Zero indicates a degenerate element.
+    ///         The cell radius ratio (topological_dimension *
+    ///         inradius / circumradius, where topological_dimension
+    ///         is a normalization factor). It has range zero to
+    ///         one. Zero indicates a degenerate element.
     ///
     /// *Example*
     ///     .. note::
@@ -62,10 +79,11 @@ namespace dolfin
     ///
     /// *Returns*
     ///     std::pair<double, double>
-    ///         The [minimum, maximum] cell radii ratio (geometric_dimension *
-    ///         * inradius / circumradius, geometric_dimension
-    ///         is normalization factor). It has range zero to one.
-    ///         Zero indicates a degenerate element.
+    ///         The [minimum, maximum] cell radius ratio
+    ///         (topological_dimension * inradius / circumradius,
+    ///         where topological_dimension is a normalization
+    ///         factor). It has range zero to one. Zero indicates a
+    ///         degenerate element.
     ///
     /// *Example*
     ///     .. note::
@@ -88,6 +106,64 @@ namespace dolfin
     static std::string
       radius_ratio_matplotlib_histogram(const Mesh& mesh,
 					std::size_t num_bins = 50);
+
+    /// Create (value, number of cells) data for creating a histogram
+    /// of given cell quality measure
+    ///
+    /// *Arguments*
+    ///     mesh (_Mesh_)
+    ///         The mesh.
+    ///     measure (std::string)
+    ///         The quality measure ("radius_ratio", "aspect_ratio" or
+    ///         "dihedral_angle").
+    ///     num_bins (std::size_t)
+    ///         The number of bins.
+    ///
+    /// *Returns*
+    ///     std::pair<std::vector<double>, std::vector<double> >
+    ///         The bin midpoints and the number of cells in each bin
+    ///         (across all processes).
+    static std::pair<std::vector<double>, std::vector<double> >
+      histogram_data(const Mesh& mesh, std::string measure,
+                     std::size_t num_bins = 50);
+
+    /// Compute the minimum, mean and maximum of each cell quality
+    /// measure (across all processes)
+    ///
+    /// *Returns*
+    ///     _Table_
+    ///         A table with one row for each quality measure.
+    ///
+    /// *Example*
+    ///     .. note::
+    ///
+    ///         UnitCubeMesh mesh(4, 4, 4);
+    ///         info(MeshQuality::statistics(mesh));
+    static Table statistics(const Mesh& mesh);
+
+    /// Compute the quality measures (radius ratio, aspect ratio and
+    /// minimum dihedral angle) of a simplex cell of topological
+    /// dimension tdim from its vertex coordinates x (vertex after
+    /// vertex, gdim values each). The minimum dihedral angle of an
+    /// interval is set to zero.
+    static void cell_quality(double* quality, const double* x,
+                             std::size_t tdim, std::size_t gdim);
+
+  private:
+
+    // Compute statistics of the cell quality measures across all
+    // processes, stored as the minimum, maximum and sum of each
+    // measure, followed by the number of cells in each of num_bins
+    // bins over [0, upper_bound(measure)] for each measure
+    static std::vector<double> compute_statistics(const Mesh& mesh,
+                                                  std::size_t num_bins);
+
+    // Return index of quality measure with given name
+    static std::size_t measure_index(const Mesh& mesh, std::string measure);
+
+    // Return upper bound of histograms of given quality measure
+    static double upper_bound(std::size_t measure);
+
   };
 
 }
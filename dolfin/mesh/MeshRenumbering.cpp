@@ -18,17 +18,27 @@
 // Modified by Garth N. Wells, 2011.
 //
 // First added:  2010-11-27
-// Last changed: 2014-02-06
+// Last changed: 2014-03-27
 
 #include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
 #include <vector>
 
 #include <dolfin/log/log.h>
+#include <dolfin/common/MPI.h>
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/utils.h>
+#include <dolfin/graph/BoostGraphOrdering.h>
+#include <dolfin/graph/Graph.h>
+#include <dolfin/graph/GraphBuilder.h>
 #include "Cell.h"
 #include "Mesh.h"
+#include "MeshData.h"
+#include "MeshDomains.h"
 #include "MeshEditor.h"
+#include "MeshEntityRange.h"
 #include "MeshTopology.h"
 #include "MeshGeometry.h"
 #include "MeshRenumbering.h"
@@ -265,3 +275,365 @@ void MeshRenumbering::compute_renumbering(const Mesh& mesh,
   }
 }
 //-----------------------------------------------------------------------------
+dolfin::Mesh MeshRenumbering::renumber_by_locality(const Mesh& mesh,
+                                                   std::string method)
+{
+  Timer timer("Renumber mesh by locality");
+
+  const std::size_t D = mesh.topology().dim();
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t num_vertices = mesh.num_vertices();
+  const std::size_t num_cells = mesh.num_cells();
+
+  // Compute new order of cells (new index -> old index)
+  std::vector<std::size_t> cells;
+  if (method == "hilbert" || method == "morton")
+    compute_curve_ordering(mesh, method == "hilbert", cells);
+  else if (method == "rcm")
+  {
+    // Reverse Cuthill-McKee ordering of cells connected by facets
+    const Graph graph = GraphBuilder::local_graph(mesh, D, D - 1);
+    const std::vector<std::size_t> new_cells
+      = BoostGraphOrdering::compute_cuthill_mckee(graph, true);
+    cells.resize(num_cells);
+    for (std::size_t c = 0; c < num_cells; ++c)
+      cells[new_cells[c]] = c;
+  }
+  else
+  {
+    dolfin_error("MeshRenumbering.cpp",
+                 "renumber mesh by locality",
+                 "Unknown renumbering method \"%s\"", method.c_str());
+  }
+  dolfin_assert(cells.size() == num_cells);
+
+  // Number vertices in order of first appearance in the renumbered
+  // cells (new index -> old index and old index -> new index)
+  const MeshConnectivity& cell_vertices = mesh.topology()(D, 0);
+  std::vector<std::size_t> vertices;
+  vertices.reserve(num_vertices);
+  std::vector<int> new_vertex_indices(num_vertices, -1);
+  for (std::size_t i = 0; i < num_cells; ++i)
+  {
+    const unsigned int* v = cell_vertices(cells[i]);
+    for (std::size_t j = 0; j < cell_vertices.size(cells[i]); ++j)
+    {
+      if (new_vertex_indices[v[j]] == -1)
+      {
+        new_vertex_indices[v[j]] = vertices.size();
+        vertices.push_back(v[j]);
+      }
+    }
+  }
+
+  // Keep vertices not connected to any cell last
+  for (std::size_t v = 0; v < num_vertices; ++v)
+  {
+    if (new_vertex_indices[v] == -1)
+    {
+      new_vertex_indices[v] = vertices.size();
+      vertices.push_back(v);
+    }
+  }
+
+  // Create new mesh
+  Mesh new_mesh(mesh.mpi_comm());
+  MeshEditor editor;
+  editor.open(new_mesh, mesh.type().cell_type(), D, gdim);
+  editor.init_vertices_global(num_vertices, mesh.size_global(0));
+  editor.init_cells_global(num_cells, mesh.size_global(D));
+
+  // Add vertices (keeping global indices)
+  const MeshTopology& topology = mesh.topology();
+  for (std::size_t i = 0; i < num_vertices; ++i)
+  {
+    const std::size_t global_index = topology.have_global_indices(0)
+      ? topology.global_indices(0)[vertices[i]] : vertices[i];
+    editor.add_vertex_global(i, global_index,
+                             mesh.geometry().point(vertices[i]));
+  }
+
+  // Add cells (keeping global indices and the local order of cell
+  // vertices, so that the mesh remains ordered if it was ordered)
+  std::vector<std::size_t> cell(mesh.type().num_vertices(D));
+  for (std::size_t i = 0; i < num_cells; ++i)
+  {
+    const unsigned int* v = cell_vertices(cells[i]);
+    for (std::size_t j = 0; j < cell.size(); ++j)
+      cell[j] = new_vertex_indices[v[j]];
+    const std::size_t global_index = topology.have_global_indices(D)
+      ? topology.global_indices(D)[cells[i]] : cells[i];
+    editor.add_cell(i, global_index, cell);
+  }
+  editor.close(false);
+
+  // Store index of vertices and cells in original mesh
+  new_mesh.data().create_array("parent_vertex_indices", 0) = vertices;
+  new_mesh.data().create_array("parent_cell_indices", D) = cells;
+
+  // Renumber shared vertices
+  if (MPI::size(mesh.mpi_comm()) > 1)
+  {
+    const std::map<unsigned int, std::set<unsigned int> >&
+      shared_vertices = topology.shared_entities(0);
+    std::map<unsigned int, std::set<unsigned int> >&
+      new_shared_vertices = new_mesh.topology().shared_entities(0);
+    std::map<unsigned int, std::set<unsigned int> >::const_iterator it;
+    for (it = shared_vertices.begin(); it != shared_vertices.end(); ++it)
+      new_shared_vertices[new_vertex_indices[it->first]] = it->second;
+  }
+
+  // Renumber cell orientations
+  const std::vector<int>& cell_orientations = mesh.cell_orientations();
+  if (cell_orientations.size() == num_cells)
+  {
+    for (std::size_t i = 0; i < num_cells; ++i)
+      new_mesh.cell_orientations()[i] = cell_orientations[cells[i]];
+  }
+
+  // Index in original mesh of entities of each dimension (computed
+  // when needed)
+  std::vector<std::vector<std::size_t> > parent_entities(D + 1);
+  parent_entities[0] = vertices;
+  parent_entities[D] = cells;
+
+  // Renumber subdomain markers
+  const MeshDomains& domains = mesh.domains();
+  if (!domains.is_empty())
+  {
+    new_mesh.domains().init(D);
+    for (std::size_t d = 0; d <= domains.max_dim(); ++d)
+    {
+      const std::map<std::size_t, std::size_t>& markers = domains.markers(d);
+      if (markers.empty())
+        continue;
+
+      // Compute old index -> new index for entities
+      if (parent_entities[d].empty())
+        compute_parent_entities(mesh, new_mesh, d, parent_entities[d]);
+      std::vector<std::size_t> new_entities(parent_entities[d].size());
+      for (std::size_t i = 0; i < parent_entities[d].size(); ++i)
+        new_entities[parent_entities[d][i]] = i;
+
+      std::map<std::size_t, std::size_t>& new_markers
+        = new_mesh.domains().markers(d);
+      std::map<std::size_t, std::size_t>::const_iterator it;
+      for (it = markers.begin(); it != markers.end(); ++it)
+        new_markers[new_entities[it->first]] = it->second;
+    }
+  }
+
+  // Renumber mesh data arrays with one value for each entity
+  const std::vector<std::map<std::string, std::vector<std::size_t> > >&
+    arrays = mesh.data()._arrays;
+  for (std::size_t d = 0; d <= D && d < arrays.size(); ++d)
+  {
+    std::map<std::string, std::vector<std::size_t> >::const_iterator it;
+    for (it = arrays[d].begin(); it != arrays[d].end(); ++it)
+    {
+      // Skip data for original mesh
+      if (it->first == "parent_vertex_indices"
+          || it->first == "parent_cell_indices")
+      {
+        continue;
+      }
+
+      if (it->second.size() != mesh.num_entities(d))
+      {
+        warning("Mesh data \"%s\" (dim %d) is not renumbered (size does not match number of entities)",
+                it->first.c_str(), d);
+        continue;
+      }
+
+      if (parent_entities[d].empty())
+        compute_parent_entities(mesh, new_mesh, d, parent_entities[d]);
+      std::vector<std::size_t>& new_array
+        = new_mesh.data().create_array(it->first, d);
+      new_array.resize(parent_entities[d].size());
+      for (std::size_t i = 0; i < parent_entities[d].size(); ++i)
+        new_array[i] = it->second[parent_entities[d][i]];
+    }
+  }
+
+  return new_mesh;
+}
+//-----------------------------------------------------------------------------
+void MeshRenumbering::compute_parent_entities(const Mesh& mesh,
+                                              const Mesh& new_mesh,
+                                              std::size_t dim,
+                                   std::vector<std::size_t>& parent_entities)
+{
+  // Check that new mesh has been renumbered from mesh
+  const std::size_t D = mesh.topology().dim();
+  if (!new_mesh.data().exists("parent_vertex_indices", 0)
+      || !new_mesh.data().exists("parent_cell_indices", D)
+      || new_mesh.num_vertices() != mesh.num_vertices()
+      || new_mesh.num_cells() != mesh.num_cells())
+  {
+    dolfin_error("MeshRenumbering.cpp",
+                 "compute entities of renumbered mesh",
+                 "Mesh has not been renumbered from the given mesh");
+  }
+
+  // Vertices and cells are stored
+  const std::vector<std::size_t>& parent_vertices
+    = new_mesh.data().array("parent_vertex_indices", 0);
+  if (dim == 0)
+  {
+    parent_entities = parent_vertices;
+    return;
+  }
+  if (dim == D)
+  {
+    parent_entities = new_mesh.data().array("parent_cell_indices", D);
+    return;
+  }
+
+  // Other entities are matched by their (renumbered) vertices
+  std::vector<std::size_t> new_vertices(parent_vertices.size());
+  for (std::size_t i = 0; i < parent_vertices.size(); ++i)
+    new_vertices[parent_vertices[i]] = i;
+
+  std::map<std::vector<std::size_t>, std::size_t> entity_of_vertices;
+  std::vector<std::size_t> key;
+  const MeshEntityRange entities(mesh, dim);
+  for (std::size_t e = entities.begin(); e < entities.end(); ++e)
+  {
+    const unsigned int* v = entities.vertices(e);
+    key.resize(entities.num_vertices(e));
+    for (std::size_t i = 0; i < key.size(); ++i)
+      key[i] = new_vertices[v[i]];
+    std::sort(key.begin(), key.end());
+    entity_of_vertices[key] = e;
+  }
+
+  const MeshEntityRange new_entities(new_mesh, dim);
+  parent_entities.resize(new_entities.size());
+  for (std::size_t e = new_entities.begin(); e < new_entities.end(); ++e)
+  {
+    const unsigned int* v = new_entities.vertices(e);
+    key.assign(v, v + new_entities.num_vertices(e));
+    std::sort(key.begin(), key.end());
+    std::map<std::vector<std::size_t>, std::size_t>::const_iterator it
+      = entity_of_vertices.find(key);
+    if (it == entity_of_vertices.end())
+    {
+      dolfin_error("MeshRenumbering.cpp",
+                   "compute entities of renumbered mesh",
+                   "Entity %d of dimension %d not found in original mesh",
+                   e, dim);
+    }
+    parent_entities[e] = it->second;
+  }
+}
+//-----------------------------------------------------------------------------
+void MeshRenumbering::compute_curve_order(std::vector<std::size_t>& order,
+                                          const double* x,
+                                          std::size_t num_points,
+                                          std::size_t gdim, bool hilbert)
+{
+  dolfin_assert(gdim > 0 && gdim <= 3);
+
+  // Compute bounding box of points
+  std::vector<double> x_min(gdim, std::numeric_limits<double>::max());
+  std::vector<double> x_max(gdim, -std::numeric_limits<double>::max());
+  for (std::size_t i = 0; i < num_points*gdim; ++i)
+  {
+    x_min[i % gdim] = std::min(x_min[i % gdim], x[i]);
+    x_max[i % gdim] = std::max(x_max[i % gdim], x[i]);
+  }
+
+  // Number of bits per coordinate (key fits in 64 bits)
+  const std::size_t num_bits = std::min<std::size_t>(32, 64/gdim);
+  const boost::uint64_t q_max = (boost::uint64_t(1) << num_bits) - 1;
+  std::vector<double> scale(gdim, 0.0);
+  for (std::size_t j = 0; j < gdim; ++j)
+  {
+    if (x_max[j] > x_min[j])
+      scale[j] = static_cast<double>(q_max)/(x_max[j] - x_min[j]);
+  }
+
+  // Compute position of points along curve
+  std::vector<std::pair<boost::uint64_t, std::size_t> > keys(num_points);
+  boost::uint64_t q[3];
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    // Quantize point
+    for (std::size_t j = 0; j < gdim; ++j)
+    {
+      const double s = (x[i*gdim + j] - x_min[j])*scale[j];
+      q[j] = std::min(q_max, static_cast<boost::uint64_t>(std::max(s, 0.0)));
+    }
+
+    // Transform to Hilbert index (in transposed form)
+    if (hilbert)
+      hilbert_transpose(q, num_bits, gdim);
+
+    // Interleave bits, most significant first
+    boost::uint64_t key = 0;
+    for (std::size_t b = num_bits; b-- > 0; )
+      for (std::size_t j = 0; j < gdim; ++j)
+        key = (key << 1) | ((q[j] >> b) & 1);
+    keys[i] = std::make_pair(key, i);
+  }
+
+  // Sort points along curve
+  std::sort(keys.begin(), keys.end());
+  order.resize(num_points);
+  for (std::size_t i = 0; i < num_points; ++i)
+    order[i] = keys[i].second;
+}
+//-----------------------------------------------------------------------------
+void MeshRenumbering::compute_curve_ordering(const Mesh& mesh, bool hilbert,
+                                             std::vector<std::size_t>& cells)
+{
+  const std::size_t D = mesh.topology().dim();
+  const std::size_t gdim = mesh.geometry().dim();
+  const std::size_t num_cells = mesh.num_cells();
+
+  // Compute cell midpoints
+  std::vector<double> midpoints(num_cells*gdim);
+  const MeshEntityRange range(mesh, D);
+  for (std::size_t c = 0; c < num_cells; ++c)
+    range.midpoint(c, midpoints.data() + c*gdim);
+
+  // Order cells along curve through midpoints
+  compute_curve_order(cells, midpoints.data(), num_cells, gdim, hilbert);
+}
+//-----------------------------------------------------------------------------
+void MeshRenumbering::hilbert_transpose(boost::uint64_t* x,
+                                        std::size_t num_bits,
+                                        std::size_t gdim)
+{
+  const boost::uint64_t m = boost::uint64_t(1) << (num_bits - 1);
+
+  // Inverse undo
+  for (boost::uint64_t q = m; q > 1; q >>= 1)
+  {
+    const boost::uint64_t p = q - 1;
+    for (std::size_t i = 0; i < gdim; ++i)
+    {
+      if (x[i] & q)
+        x[0] ^= p;
+      else
+      {
+        const boost::uint64_t t = (x[0] ^ x[i]) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+
+  // Gray encode
+  for (std::size_t i = 1; i < gdim; ++i)
+    x[i] ^= x[i - 1];
+  boost::uint64_t t = 0;
+  for (boost::uint64_t q = m; q > 1; q >>= 1)
+  {
+    if (x[gdim - 1] & q)
+      t ^= q - 1;
+  }
+  for (std::size_t i = 0; i < gdim; ++i)
+    x[i] ^= t;
+}
+//-----------------------------------------------------------------------------
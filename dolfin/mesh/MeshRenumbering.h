@@ -18,12 +18,16 @@
 // Modified by Garth N. Wells, 2011.
 //
 // First added:  2010-11-27
-// Last changed: 2011-01-16
+// Last changed: 2014-03-27
 
 #ifndef __MESH_RENUMBERING_H
 #define __MESH_RENUMBERING_H
 
+#include <string>
+#include <boost/cstdint.hpp>
 #include <vector>
+#include <dolfin/log/log.h>
+#include "MeshFunction.h"
 
 namespace dolfin
 {
@@ -53,8 +57,93 @@ namespace dolfin
     static Mesh renumber_by_color(const Mesh& mesh,
                                   std::vector<std::size_t> coloring);
 
+    /// Renumber cells and vertices to improve data locality. Cells
+    /// are ordered along a space-filling curve through the cell
+    /// midpoints ("hilbert" or "morton"), or by reverse
+    /// Cuthill-McKee ordering of the dual graph ("rcm"). Vertices are
+    /// then numbered in the order they are first visited by the
+    /// renumbered cells. Global indices, shared vertices, cell
+    /// orientations, subdomain markers (MeshDomains) and mesh data
+    /// arrays are renumbered with the mesh. The index of each vertex
+    /// and cell in the original mesh is stored in the mesh data
+    /// arrays "parent_vertex_indices" and "parent_cell_indices" of
+    /// the renumbered mesh.
+    ///
+    /// *Arguments*
+    ///     mesh (_Mesh_)
+    ///         Mesh to be renumbered.
+    ///     method (std::string)
+    ///         Renumbering method ("hilbert", "morton" or "rcm").
+    /// *Returns*
+    ///     _Mesh_
+    static Mesh renumber_by_locality(const Mesh& mesh,
+                                     std::string method="hilbert");
+
+    /// Compute order of points along a Hilbert or Morton
+    /// space-filling curve through the bounding box of the points.
+    ///
+    /// *Arguments*
+    ///     order (std::vector<std::size_t>)
+    ///         Order of points (position along curve -> point index).
+    ///     x (double*)
+    ///         Point coordinates (num_points x gdim, row-major).
+    ///     num_points (std::size_t)
+    ///         Number of points.
+    ///     gdim (std::size_t)
+    ///         Geometric dimension (1, 2 or 3).
+    ///     hilbert (bool)
+    ///         Use Hilbert curve if true, otherwise Morton curve.
+    static void compute_curve_order(std::vector<std::size_t>& order,
+                                    const double* x, std::size_t num_points,
+                                    std::size_t gdim, bool hilbert);
+
+    /// Copy values of a mesh function on a mesh to a mesh function
+    /// on the renumbered mesh (as returned by renumber_by_locality).
+    ///
+    /// *Arguments*
+    ///     f (_MeshFunction_)
+    ///         Mesh function on the original mesh.
+    ///     new_f (_MeshFunction_)
+    ///         Mesh function on the renumbered mesh (initialized to
+    ///         the dimension of f).
+    template <typename T>
+    static void renumber(const MeshFunction<T>& f, MeshFunction<T>& new_f)
+    {
+      dolfin_assert(f.mesh());
+      dolfin_assert(new_f.mesh());
+      const Mesh& mesh = *f.mesh();
+      const Mesh& new_mesh = *new_f.mesh();
+
+      // Get index of each entity of the renumbered mesh in the
+      // original mesh
+      std::vector<std::size_t> parent_entities;
+      compute_parent_entities(mesh, new_mesh, f.dim(), parent_entities);
+
+      // Copy values
+      new_f.init(f.dim());
+      for (std::size_t i = 0; i < parent_entities.size(); ++i)
+        new_f[i] = f[parent_entities[i]];
+    }
+
   private:
 
+    // Compute the index in the original mesh of each entity of given
+    // dimension of the renumbered mesh
+    static void
+      compute_parent_entities(const Mesh& mesh, const Mesh& new_mesh,
+                              std::size_t dim,
+                              std::vector<std::size_t>& parent_entities);
+
+    // Compute order of cells (new index -> old index) along a Hilbert
+    // or Morton space-filling curve through the cell midpoints
+    static void compute_curve_ordering(const Mesh& mesh, bool hilbert,
+                                       std::vector<std::size_t>& cells);
+
+    // Transform quantized coordinates x (num_bits bits each) to the
+    // transpose of their Hilbert index (Skilling's algorithm)
+    static void hilbert_transpose(boost::uint64_t* x, std::size_t num_bits,
+                                  std::size_t gdim);
+
     static void compute_renumbering(const Mesh& mesh,
                                     const std::vector<std::size_t>& coloring,
                                     std::vector<double>& coordinates,
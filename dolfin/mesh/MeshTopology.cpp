@@ -16,11 +16,13 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2006-05-08
-// Last changed: 2013-02-03
+// Last changed: 2014-03-27
 
+#include <algorithm>
 #include <numeric>
 #include <sstream>
 #include <dolfin/log/log.h>
+#include <dolfin/common/UniqueIdGenerator.h>
 #include <dolfin/common/utils.h>
 #include "MeshConnectivity.h"
 #include "MeshTopology.h"
@@ -28,8 +30,7 @@
 using namespace dolfin;
 
 //-----------------------------------------------------------------------------
-MeshTopology::MeshTopology()
-
+MeshTopology::MeshTopology() : _version(0), _changed(true)
 {
   // Do nothing
 }
@@ -39,7 +40,8 @@ MeshTopology::MeshTopology(const MeshTopology& topology)
     global_num_entities(topology.global_num_entities),
     _global_indices(topology._global_indices),
     _shared_entities(topology._shared_entities),
-    connectivity(topology.connectivity)
+    connectivity(topology.connectivity), _version(topology.version()),
+    _changed(false)
 {
   // Do nothing
 }
@@ -66,6 +68,10 @@ MeshTopology& MeshTopology::operator= (const MeshTopology& topology)
   _shared_entities = topology._shared_entities;
   connectivity = topology.connectivity;
 
+  // Equal topologies share version
+  _version = topology.version();
+  _changed = false;
+
   return *this;
 }
 //-----------------------------------------------------------------------------
@@ -101,15 +107,55 @@ void MeshTopology::clear()
   _global_indices.clear();
   _shared_entities.clear();
   connectivity.clear();
+  _changed = true;
 }
 //-----------------------------------------------------------------------------
 void MeshTopology::clear(std::size_t d0, std::size_t d1)
 {
   dolfin_assert(d0 < connectivity.size());
   dolfin_assert(d1 < connectivity[d0].size());
+  if (d0 == dim() && d1 == 0)
+    _changed = true;
   connectivity[d0][d1].clear();
 }
 //-----------------------------------------------------------------------------
+void MeshTopology::clear_entities(std::size_t dim)
+{
+  // Vertices and cells cannot be recomputed
+  if (dim == 0 || dim >= this->dim())
+  {
+    dolfin_error("MeshTopology.cpp",
+                 "clear mesh entities",
+                 "Only entities of intermediate dimension (0 < dim < %d) can be cleared",
+                 this->dim());
+  }
+
+  // Clear all connectivity involving entities of given dimension
+  for (std::size_t d = 0; d < connectivity.size(); d++)
+  {
+    connectivity[dim][d].clear();
+    connectivity[d][dim].clear();
+  }
+
+  // Clear colorings involving entities of given dimension
+  std::map<std::vector<std::size_t>,
+    std::pair<std::vector<std::size_t>,
+    std::vector<std::vector<std::size_t> > > >::iterator it = coloring.begin();
+  while (it != coloring.end())
+  {
+    if (std::find(it->first.begin(), it->first.end(), dim) != it->first.end())
+      coloring.erase(it++);
+    else
+      ++it;
+  }
+
+  // Clear entities
+  num_entities[dim] = 0;
+  global_num_entities[dim] = 0;
+  std::vector<std::size_t>().swap(_global_indices[dim]);
+  _shared_entities.erase(dim);
+}
+//-----------------------------------------------------------------------------
 void MeshTopology::init(std::size_t dim)
 {
   // Clear old data if any
@@ -133,6 +179,11 @@ void MeshTopology::init(std::size_t dim, std::size_t local_size,
                         std::size_t global_size)
 {
   dolfin_assert(dim < num_entities.size());
+
+  // Changing the number of vertices or cells changes the topology
+  if ((dim == 0 || dim == this->dim()) && num_entities[dim] != local_size)
+    _changed = true;
+
   num_entities[dim] = local_size;
 
   dolfin_assert(dim < global_num_entities.size());
@@ -194,6 +245,34 @@ size_t MeshTopology::hash() const
   return (*this)(dim(), 0).hash();
 }
 //-----------------------------------------------------------------------------
+std::size_t MeshTopology::version() const
+{
+  if (_changed)
+  {
+    _version = UniqueIdGenerator::id();
+    _changed = false;
+  }
+  return _version;
+}
+//-----------------------------------------------------------------------------
+std::size_t MeshTopology::memory_usage(std::size_t d0, std::size_t d1) const
+{
+  dolfin_assert(d0 < connectivity.size());
+  dolfin_assert(d1 < connectivity[d0].size());
+  return connectivity[d0][d1].memory_usage();
+}
+//-----------------------------------------------------------------------------
+std::size_t MeshTopology::memory_usage() const
+{
+  std::size_t bytes = 0;
+  for (std::size_t d0 = 0; d0 < connectivity.size(); d0++)
+    for (std::size_t d1 = 0; d1 < connectivity[d0].size(); d1++)
+      bytes += connectivity[d0][d1].memory_usage();
+  for (std::size_t d = 0; d < _global_indices.size(); d++)
+    bytes += _global_indices[d].capacity()*sizeof(std::size_t);
+  return bytes;
+}
+//-----------------------------------------------------------------------------
 std::string MeshTopology::str(bool verbose) const
 {
   const std::size_t _dim = num_entities.size() - 1;
@@ -226,6 +305,19 @@ std::string MeshTopology::str(bool verbose) const
     }
     s << std::endl;
 
+    s << "  Memory usage of connectivity (bytes):" << std::endl << std::endl;
+    for (std::size_t d0 = 0; d0 <= _dim; d0++)
+    {
+      for (std::size_t d1 = 0; d1 <= _dim; d1++)
+      {
+        if (connectivity[d0][d1].empty())
+          continue;
+        s << "    " << d0 << " - " << d1 << ": "
+          << connectivity[d0][d1].memory_usage() << std::endl;
+      }
+    }
+    s << std::endl;
+
     for (std::size_t d0 = 0; d0 <= _dim; d0++)
     {
       for (std::size_t d1 = 0; d1 <= _dim; d1++)
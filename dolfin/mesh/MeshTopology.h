@@ -16,7 +16,7 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2006-05-08
-// Last changed: 2012-10-25
+// Last changed: 2014-03-27
 
 #ifndef __MESH_TOPOLOGY_H
 #define __MESH_TOPOLOGY_H
@@ -71,6 +71,13 @@ namespace dolfin
     /// Clear data for given pair of topological dimensions
     void clear(std::size_t d0, std::size_t d1);
 
+    /// Clear entities of given topological dimension (0 < dim <
+    /// D), including their global indices and all connectivity
+    /// involving entities of the given dimension. The entities are
+    /// recomputed, with the same numbering, when requested again
+    /// (e.g. by Mesh::init(dim)).
+    void clear_entities(std::size_t dim);
+
     /// Initialize topology of given maximum dimension
     void init(std::size_t dim);
 
@@ -128,6 +135,22 @@ namespace dolfin
     /// Return hash based on the hash of cell-vertex connectivity
     size_t hash() const;
 
+    /// Return version of cell-vertex connectivity. The version is
+    /// unique in the lifetime of the program and changes when the
+    /// topology is initialized or cleared, when the number of
+    /// vertices or cells changes, or when cells are added or
+    /// ordered. Computing connectivity between other pairs of
+    /// dimensions does not change the version.
+    std::size_t version() const;
+
+    /// Return memory used by connectivity for given pair of
+    /// topological dimensions (in bytes)
+    std::size_t memory_usage(std::size_t d0, std::size_t d1) const;
+
+    /// Return memory used by topology, including connectivity and
+    /// global indices (in bytes)
+    std::size_t memory_usage() const;
+
     /// Return informal string representation (pretty-print)
     std::string str(bool verbose) const;
 
@@ -149,6 +172,8 @@ namespace dolfin
 
     // Friends
     friend class BinaryFile;
+    friend class MeshEditor;
+    friend class MeshOrdering;
 
     // Number of mesh entities for each topological dimension
     std::vector<unsigned int> num_entities;
@@ -167,6 +192,14 @@ namespace dolfin
     // Connectivity for pairs of topological dimensions
     std::vector<std::vector<MeshConnectivity> > connectivity;
 
+    // Version of cell-vertex connectivity (assigned lazily when
+    // changed)
+    mutable std::size_t _version;
+
+    // True if cell-vertex connectivity may have changed since
+    // version was assigned
+    mutable bool _changed;
+
   };
 
 }
@@ -18,15 +18,16 @@
 // Modified by Niclas Jansson 2009.
 //
 // First added:  2007-04-24
-// Last changed: 2011-08-31
+// Last changed: 2014-03-27
 
+#include <algorithm>
 #include <dolfin/common/Array.h>
-#include <dolfin/common/RangedIndexSet.h>
 #include <dolfin/log/log.h>
 #include "Mesh.h"
 #include "MeshData.h"
 #include "MeshEntity.h"
 #include "MeshEntityIterator.h"
+#include "MeshEntityRange.h"
 #include "Vertex.h"
 #include "MeshFunction.h"
 #include "MeshValueCollection.h"
@@ -54,6 +55,26 @@ bool SubDomain::inside(const Array<double>& x, bool on_boundary) const
   return false;
 }
 //-----------------------------------------------------------------------------
+void SubDomain::inside_batch(Array<bool>& values, const Array<double>& x,
+                             bool on_boundary) const
+{
+  const std::size_t num_points = values.size();
+  dolfin_assert(num_points == 0 || x.size() % num_points == 0);
+  const std::size_t gdim = num_points > 0 ? x.size()/num_points : 0;
+
+  // Evaluate point by point
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    const Array<double> _x(gdim, const_cast<double*>(x.data() + i*gdim));
+    values[i] = inside(_x, on_boundary);
+  }
+}
+//-----------------------------------------------------------------------------
+bool SubDomain::thread_safe() const
+{
+  return false;
+}
+//-----------------------------------------------------------------------------
 void SubDomain::map(const Array<double>& x, Array<double>& y) const
 {
   dolfin_error("SubDomain.cpp",
@@ -166,78 +187,13 @@ void SubDomain::apply_markers(S& sub_domains,
 {
   log(TRACE, "Computing sub domain markers for sub domain %d.", sub_domain);
 
-  // Get the dimension of the entities we are marking
-  const std::size_t dim = sub_domains.dim();
-
-  // Compute facet - cell connectivity if necessary
-  const std::size_t D = mesh.topology().dim();
-  if (dim == D - 1)
-  {
-    mesh.init(D - 1);
-    mesh.init(D - 1, D);
-  }
-
-  // Set geometric dimension (needed for SWIG interface)
-  _geometric_dimension = mesh.geometry().dim();
-
-  // Speed up the computation by only checking each vertex once (or
-  // twice if it is on the boundary for some but not all facets).
-  RangedIndexSet boundary_visited(mesh.num_vertices());
-  RangedIndexSet interior_visited(mesh.num_vertices());
-  std::vector<bool> boundary_inside(mesh.num_vertices());
-  std::vector<bool> interior_inside(mesh.num_vertices());
-
-  // Always false when not marking facets
-  bool on_boundary = false;
-
   // Compute sub domain markers
-  Progress p("Computing sub domain markers", mesh.num_entities(dim));
-  for (MeshEntityIterator entity(mesh, dim); !entity.end(); ++entity)
+  std::vector<char> entity_inside;
+  compute_inside(entity_inside, sub_domains.dim(), mesh, check_midpoint);
+  for (std::size_t e = 0; e < entity_inside.size(); ++e)
   {
-    // Check if entity is on the boundary if entity is a facet
-    if (dim == D - 1)
-      on_boundary = (entity->num_global_entities(D) == 1);
-
-    // Select the visited-cache to use for this facet (or entity)
-    RangedIndexSet&    is_visited = (on_boundary ? boundary_visited : interior_visited);
-    std::vector<bool>& is_inside  = (on_boundary ? boundary_inside  : interior_inside);
-
-    // Start by assuming all points are inside
-    bool all_points_inside = true;
-
-    // Check all incident vertices if dimension is > 0 (not a vertex)
-    if (entity->dim() > 0)
-    {
-      for (VertexIterator vertex(*entity); !vertex.end(); ++vertex)
-      {
-        if (is_visited.insert(vertex->index()))
-        {
-          Array<double> x(_geometric_dimension, const_cast<double*>(vertex->x()));
-          is_inside[vertex->index()] = inside(x, on_boundary);
-        }
-
-        if (!is_inside[vertex->index()])
-        {
-          all_points_inside = false;
-          break;
-        }
-      }
-    }
-
-    // Check midpoint (works also in the case when we have a single vertex)
-    if (all_points_inside && check_midpoint)
-    {
-      Array<double> x(_geometric_dimension,
-                      const_cast<double*>(entity->midpoint().coordinates()));
-      if (!inside(x, on_boundary))
-        all_points_inside = false;
-    }
-
-    // Mark entity with all vertices inside
-    if (all_points_inside)
-      sub_domains.set_value(entity->index(), sub_domain);
-
-    p++;
+    if (entity_inside[e])
+      sub_domains.set_value(e, sub_domain);
   }
 }
 //-----------------------------------------------------------------------------
@@ -248,11 +204,23 @@ void SubDomain::apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
                               const Mesh& mesh,
                               bool check_midpoint) const
 {
-  // FIXME: This function can probably be folded into the above
-  //        function operator[] in std::map and MeshFunction.
-
   log(TRACE, "Computing sub domain markers for sub domain %d.", sub_domain);
 
+  // Compute sub domain markers
+  std::vector<char> entity_inside;
+  compute_inside(entity_inside, dim, mesh, check_midpoint);
+  for (std::size_t e = 0; e < entity_inside.size(); ++e)
+  {
+    if (entity_inside[e])
+      sub_domains[e] = sub_domain;
+  }
+}
+//-----------------------------------------------------------------------------
+void SubDomain::compute_inside(std::vector<char>& entity_inside,
+                               std::size_t dim,
+                               const Mesh& mesh,
+                               bool check_midpoint) const
+{
   // Compute facet - cell connectivity if necessary
   const std::size_t D = mesh.topology().dim();
   if (dim == D - 1)
@@ -263,65 +231,171 @@ void SubDomain::apply_markers(std::map<std::size_t, std::size_t>& sub_domains,
 
   // Set geometric dimension (needed for SWIG interface)
   _geometric_dimension = mesh.geometry().dim();
+  const std::size_t gdim = _geometric_dimension;
 
-  // Speed up the computation by only checking each vertex once (or
-  // twice if it is on the boundary for some but not all facets).
-  RangedIndexSet boundary_visited(mesh.num_vertices());
-  RangedIndexSet interior_visited(mesh.num_vertices());
-  std::vector<bool> boundary_inside(mesh.num_vertices());
-  std::vector<bool> interior_inside(mesh.num_vertices());
+  // Use threads only if inside() may be called concurrently
+  const std::size_t num_threads
+    = thread_safe() ? MeshEntityRange::num_threads() : 1;
 
-  // Always false when not marking facets
-  bool on_boundary = false;
+  // Direct access to vertices of entities
+  const MeshEntityRange entities(mesh, dim);
+  const std::size_t num_entities = entities.size();
+  const std::size_t num_vertices = mesh.num_vertices();
 
-  // Compute sub domain markers
-  Progress p("Computing sub domain markers", mesh.num_entities(dim));
-  for (MeshEntityIterator entity(mesh, dim); !entity.end(); ++entity)
+  // Check which entities are on the boundary (always false when not
+  // marking facets)
+  std::vector<char> on_boundary(num_entities, 0);
+  if (dim == D - 1)
   {
-    // Check if entity is on the boundary if entity is a facet
-    if (dim == D - 1)
-      on_boundary = (entity->num_global_entities(D) == 1);
+    const MeshConnectivity& facet_cells = mesh.topology()(D - 1, D);
+    #ifdef HAS_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+    #endif
+    for (std::size_t e = 0; e < num_entities; ++e)
+      on_boundary[e] = (facet_cells.size_global(e) == 1);
+  }
 
-    // Select the visited-cache to use for this facet (or entity)
-    RangedIndexSet&    is_visited = (on_boundary ? boundary_visited : interior_visited);
-    std::vector<bool>& is_inside  = (on_boundary ? boundary_inside  : interior_inside);
+  // Find entities with all vertices inside. Vertices are checked in
+  // rounds: round i checks vertex i of each entity with all previous
+  // vertices inside, so (as for a single loop over entities) no more
+  // vertices of an entity are checked once one is found outside.
+  // Each vertex is checked at most once off the boundary and once on
+  // the boundary if it is incident to a boundary facet.
+  std::vector<std::size_t> candidates;
+  if (dim == 0)
+  {
+    candidates.resize(num_entities);
+    for (std::size_t e = 0; e < num_entities; ++e)
+      candidates[e] = e;
+  }
+  else
+  {
+    enum {vertex_unknown, vertex_pending, vertex_inside, vertex_outside};
+    std::vector<char> vertex_state[2];
+    vertex_state[0].assign(num_vertices, vertex_unknown);
+    vertex_state[1].assign(num_vertices, vertex_unknown);
 
-    // Start by assuming all points are inside
-    bool all_points_inside = true;
+    std::vector<std::size_t> active(num_entities);
+    for (std::size_t e = 0; e < num_entities; ++e)
+      active[e] = e;
 
-    // Check all incident vertices if dimension is > 0 (not a vertex)
-    if (entity->dim() > 0)
+    std::vector<std::size_t> pending[2];
+    std::vector<double> x;
+    std::vector<char> values;
+    for (std::size_t i = 0; !active.empty(); ++i)
     {
-      for (VertexIterator vertex(*entity); !vertex.end(); ++vertex)
+      // Collect vertex i of active entities if not yet checked
+      for (std::size_t a = 0; a < active.size(); ++a)
       {
-        if (is_visited.insert(vertex->index()))
+        const std::size_t e = active[a];
+        const std::size_t k = on_boundary[e];
+        const std::size_t v = entities.vertices(e)[i];
+        if (vertex_state[k][v] == vertex_unknown)
         {
-          Array<double> x(_geometric_dimension, const_cast<double*>(vertex->x()));
-          is_inside[vertex->index()] = inside(x, on_boundary);
+          vertex_state[k][v] = vertex_pending;
+          pending[k].push_back(v);
         }
+      }
 
-        if (!is_inside[vertex->index()])
+      // Check collected vertices off and on the boundary
+      for (std::size_t k = 0; k < 2; ++k)
+      {
+        const std::size_t n = pending[k].size();
+        if (n == 0)
+          continue;
+        x.resize(n*gdim);
+        for (std::size_t j = 0; j < n; ++j)
         {
-          all_points_inside = false;
-          break;
+          const double* _x = entities.x(pending[k][j]);
+          std::copy(_x, _x + gdim, x.begin() + j*gdim);
         }
+        values.resize(n);
+        compute_inside(values.data(), x.data(), n, k == 1, num_threads);
+        for (std::size_t j = 0; j < n; ++j)
+        {
+          vertex_state[k][pending[k][j]]
+            = values[j] ? vertex_inside : vertex_outside;
+        }
+        pending[k].clear();
       }
+
+      // Keep entities with vertex i inside and more vertices to check
+      std::size_t num_active = 0;
+      for (std::size_t a = 0; a < active.size(); ++a)
+      {
+        const std::size_t e = active[a];
+        const std::size_t k = on_boundary[e];
+        const std::size_t v = entities.vertices(e)[i];
+        if (vertex_state[k][v] != vertex_inside)
+          continue;
+        if (i + 1 == entities.num_vertices(e))
+          candidates.push_back(e);
+        else
+          active[num_active++] = e;
+      }
+      active.resize(num_active);
     }
+  }
+
+  // Mark entities with all vertices inside
+  entity_inside.assign(num_entities, 0);
+  if (!check_midpoint)
+  {
+    for (std::size_t c = 0; c < candidates.size(); ++c)
+      entity_inside[candidates[c]] = 1;
+    return;
+  }
 
-    // Check midpoint (works also in the case when we have a single vertex)
-    if (all_points_inside && check_midpoint)
+  // Check midpoints off and on the boundary (works also in the case
+  // when we have a single vertex)
+  for (std::size_t k = 0; k < 2; ++k)
+  {
+    std::vector<std::size_t> _candidates;
+    for (std::size_t c = 0; c < candidates.size(); ++c)
     {
-      Array<double> x(_geometric_dimension,
-                      const_cast<double*>(entity->midpoint().coordinates()));
-      if (!inside(x, on_boundary))
-        all_points_inside = false;
+      if ((std::size_t) on_boundary[candidates[c]] == k)
+        _candidates.push_back(candidates[c]);
     }
+    const std::size_t n = _candidates.size();
+    if (n == 0)
+      continue;
 
-    // Mark entity with all vertices inside
-    if (all_points_inside)
-      sub_domains[entity->index()] =  sub_domain;
+    std::vector<double> midpoints(n*gdim);
+    #ifdef HAS_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+    #endif
+    for (std::size_t c = 0; c < n; ++c)
+      entities.midpoint(_candidates[c], &midpoints[c*gdim]);
 
-    p++;
+    std::vector<char> midpoint_inside(n);
+    compute_inside(midpoint_inside.data(), midpoints.data(), n, k == 1,
+                   num_threads);
+    for (std::size_t c = 0; c < n; ++c)
+      entity_inside[_candidates[c]] = midpoint_inside[c];
+  }
+}
+//-----------------------------------------------------------------------------
+void SubDomain::compute_inside(char* values, const double* x,
+                               std::size_t num_points, bool on_boundary,
+                               std::size_t num_threads) const
+{
+  // Points are passed to inside_batch() in batches of this size
+  const std::size_t batch_size = 256;
+
+  const std::size_t gdim = _geometric_dimension;
+  const std::size_t num_batches = (num_points + batch_size - 1)/batch_size;
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for schedule(static) num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t b = 0; b < num_batches; ++b)
+  {
+    const std::size_t i0 = b*batch_size;
+    const std::size_t n = std::min(batch_size, num_points - i0);
+    Array<bool> _values(n);
+    const Array<double> _x(n*gdim, const_cast<double*>(x + i0*gdim));
+    inside_batch(_values, _x, on_boundary);
+    for (std::size_t i = 0; i < n; ++i)
+      values[i0 + i] = _values[i];
   }
 }
 //-----------------------------------------------------------------------------
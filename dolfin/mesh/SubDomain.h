@@ -16,13 +16,14 @@
 // along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 //
 // First added:  2007-04-10
-// Last changed: 2013-04-12
+// Last changed: 2014-03-27
 
 #ifndef __SUB_DOMAIN_H
 #define __SUB_DOMAIN_H
 
 #include <cstddef>
 #include <map>
+#include <vector>
 #include <dolfin/common/constants.h>
 
 namespace dolfin
@@ -66,6 +67,36 @@ namespace dolfin
     ///         True for points inside the subdomain.
     virtual bool inside(const Array<double>& x, bool on_boundary) const;
 
+    /// Compute inside() for multiple points, either all on or all
+    /// off the boundary. The coordinates of point i are x[i*gdim],
+    /// ..., x[(i + 1)*gdim - 1] (gdim is the geometric dimension)
+    /// and the result is stored in values[i]. The default
+    /// implementation calls inside() for each point. Sub-classes may
+    /// overload this function to avoid the overhead of evaluating
+    /// point by point.
+    ///
+    /// *Arguments*
+    ///     values (_Array_ <bool>)
+    ///         True for points inside the subdomain (output).
+    ///     x (_Array_ <double>)
+    ///         The coordinates of the points.
+    ///     on_boundary (bool)
+    ///         True for points on the boundary.
+    virtual void inside_batch(Array<bool>& values, const Array<double>& x,
+                              bool on_boundary) const;
+
+    /// Return true if inside() may be called concurrently from
+    /// several threads, in which case the marking of mesh entities
+    /// uses the number of threads given by the global parameter
+    /// "num_threads". The default implementation returns false;
+    /// subclasses whose inside() does not modify any state may
+    /// return true (as DomainBoundary and compiled subdomains do).
+    ///
+    /// *Returns*
+    ///     bool
+    ///         True if inside() is thread-safe.
+    virtual bool thread_safe() const;
+
     /// Map coordinate x in domain H to coordinate y in domain G (used for
     /// periodic boundary conditions)
     ///
@@ -273,6 +304,21 @@ namespace dolfin
                          const Mesh& mesh,
                          bool check_midpoint) const;
 
+    // Compute for each entity of given dimension whether all its
+    // vertices (and optionally its midpoint) are inside the sub
+    // domain
+    void compute_inside(std::vector<char>& entity_inside,
+                        std::size_t dim,
+                        const Mesh& mesh,
+                        bool check_midpoint) const;
+
+    // Compute inside_batch() for num_points points with coordinates
+    // x (in batches, using num_threads threads) and store the result
+    // in values
+    void compute_inside(char* values, const double* x,
+                        std::size_t num_points, bool on_boundary,
+                        std::size_t num_threads) const;
+
     // Friends
     friend class DirichletBC;
     friend class PeriodicBC;
@@ -18,16 +18,15 @@
 // Modified by Garth N. Wells 2012.
 //
 // First added:  2006-06-02
-// Last changed: 2014-01-12
+// Last changed: 2014-03-27
 
 #include <algorithm>
 #include <vector>
-#include <boost/unordered_map.hpp>
-#include <boost/version.hpp>
 
 #include <dolfin/common/Timer.h>
 #include <dolfin/common/utils.h>
 #include <dolfin/log/log.h>
+#include <dolfin/parameter/GlobalParameters.h>
 #include "Cell.h"
 #include "CellType.h"
 #include "Mesh.h"
@@ -71,93 +70,202 @@ std::size_t TopologyComputation::compute_entities(Mesh& mesh, std::size_t dim)
   // Start timer
   Timer timer("compute entities dim = " + to_string(dim));
 
+  // Number of bits needed to store a vertex index
+  std::size_t num_bits = 1;
+  while (num_bits < 32 && (std::size_t(1) << num_bits) < mesh.num_vertices())
+    ++num_bits;
+
+  // Compute entities using the smallest key that can hold the
+  // vertex indices of an entity
+  const std::size_t n = mesh.type().num_vertices(dim);
+  if (n*num_bits <= 64)
+    return compute_entities_by_key<boost::uint64_t>(mesh, dim, num_bits);
+  else
+  {
+    dolfin_assert(n*num_bits <= 128);
+    return compute_entities_by_key<uint128>(mesh, dim, num_bits);
+  }
+}
+//-----------------------------------------------------------------------------
+template <typename T>
+std::size_t TopologyComputation::compute_entities_by_key(Mesh& mesh,
+                                                         std::size_t dim,
+                                                         std::size_t num_bits)
+{
+  // The entities are computed without building a map from the
+  // vertices of an entity to the entity index:
+  //
+  //   1. Compute a key for each local entity of each cell, from the
+  //      sorted vertex indices of the entity
+  //
+  //   2. Sort keys (keeping the original order of equal keys), so
+  //      that the local entities representing the same entity are
+  //      consecutive
+  //
+  //   3. Number entities in order of first appearance (as cells are
+  //      traversed) and write the connectivity arrays
+
+  // Get mesh topology and connectivity (read-only access to
+  // cell-vertex connectivity)
+  MeshTopology& topology = mesh.topology();
+  const MeshTopology& const_topology = topology;
+  const std::size_t D = topology.dim();
+  const MeshConnectivity& cell_vertices = const_topology(D, 0);
+
   // Get cell type
   const CellType& cell_type = mesh.type();
 
-  // Initialize local array of entities
+  // Number of entities per cell and number of vertices per entity
+  const std::size_t num_cells = mesh.num_cells();
   const std::size_t m = cell_type.num_entities(dim);
   const std::size_t n = cell_type.num_vertices(dim);
-  std::vector<std::vector<unsigned int> >
-    e_vertices(m, std::vector<unsigned int>(n, 0));
-
-  // List of entity e indices connected to cell
-  std::vector<std::vector<unsigned int> > connectivity_ce(mesh.num_cells());
-
-  // List of vertces indices connected to entity e
-  std::vector<std::vector<unsigned int> > connectivity_ev;
-
-  std::size_t current_entity = 0;
-  std::size_t max_ce_connections = 1;
-  boost::unordered_map<std::vector<unsigned int>, unsigned int>
-    evertices_to_index;
-
-  // Rehash/reserve map for efficiency
-  const std::size_t max_elements
-    = mesh.num_cells()*mesh.type().num_entities(dim)/2;
-  #if BOOST_VERSION < 105000
-  evertices_to_index.rehash(max_elements/evertices_to_index.max_load_factor()
-                            + 1);
-  #else
-  evertices_to_index.reserve(max_elements);
-  #endif
+  const std::size_t num_local_entities = num_cells*m;
 
-  // Loop over cells
-  for (CellIterator c(mesh); !c.end(); ++c)
+  // Number of threads
+  const std::size_t num_threads = get_num_threads();
+
+  // Compute key and position (cell*m + local entity index) of each
+  // local entity
+  std::vector<std::pair<T, std::size_t> > keys(num_local_entities);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel num_threads(num_threads) if (num_threads > 1)
+  #endif
   {
-    // Cell index
-    const std::size_t cell_index = c->index();
+    std::vector<std::vector<unsigned int> >
+      e_vertices(m, std::vector<unsigned int>(n, 0));
 
-    // Reserve space to reduce dynamic allocations
-    connectivity_ce[cell_index].reserve(max_ce_connections);
+    #ifdef HAS_OPENMP
+    #pragma omp for
+    #endif
+    for (std::size_t c = 0; c < num_cells; ++c)
+    {
+      // Create entities
+      dolfin_assert(cell_vertices(c));
+      cell_type.create_entities(e_vertices, dim, cell_vertices(c));
 
-    // Get vertices from cell
-    const unsigned int* vertices = c->entities(0);
-    dolfin_assert(vertices);
+      // Compute keys from sorted vertices
+      for (std::size_t i = 0; i < m; ++i)
+      {
+        std::vector<unsigned int>& v = e_vertices[i];
+        std::sort(v.begin(), v.end());
+        T key = T();
+        for (std::size_t j = 0; j < n; ++j)
+          append_bits(key, v[j], num_bits);
+        keys[c*m + i] = std::make_pair(key, c*m + i);
+      }
+    }
+  }
 
-    // Create entities
-    cell_type.create_entities(e_vertices, dim, vertices);
+  // Sort keys
+  sort_keys(keys, n*num_bits, num_threads);
 
-    // Iterate over the given list of entities
-    std::vector<std::vector<unsigned int> >::iterator entity;
-    for (entity = e_vertices.begin(); entity != e_vertices.end(); ++entity)
-    {
-      // Sort entities (to use as map key)
-      std::sort(entity->begin(), entity->end());
+  // Mark position of first appearance of each entity and number
+  // entities in order of first appearance
+  std::vector<unsigned int> ce(num_local_entities, 0);
+  for (std::size_t k = 0; k < num_local_entities; ++k)
+  {
+    if (k == 0 || !(keys[k].first == keys[k - 1].first))
+      ce[keys[k].second] = 1;
+  }
+  std::size_t num_entities = 0;
+  for (std::size_t p = 0; p < num_local_entities; ++p)
+  {
+    if (ce[p] == 1)
+      ce[p] = num_entities++;
+  }
 
-      // Insert into map
-      std::pair<boost::unordered_map<std::vector<unsigned int>, unsigned int>::iterator, bool>
-        it = evertices_to_index.insert(std::make_pair(*entity, current_entity));
+  // Compute cell-entity and entity-vertex connectivity (the first
+  // key of each entity is its first appearance)
+  std::vector<unsigned int> ev(num_entities*n);
+  std::size_t k = 0;
+  while (k < num_local_entities)
+  {
+    const std::size_t e = ce[keys[k].second];
+    const T key = keys[k].first;
+    for (std::size_t j = 0; j < n; ++j)
+      ev[e*n + j] = extract_bits(key, (n - 1 - j)*num_bits, num_bits);
+    for (; k < num_local_entities && keys[k].first == key; ++k)
+      ce[keys[k].second] = e;
+  }
 
-      // Entity index
-      std::size_t e_index = it.first->second;
+  // Free keys before copying data into topology
+  std::vector<std::pair<T, std::size_t> >().swap(keys);
 
-      // Add entity index to cell - e connectivity
-      connectivity_ce[cell_index].push_back(e_index);
+  // Initialise connectivity data structure
+  topology.init(dim, num_entities, num_entities);
 
-      // If new key was inserted, increment entity counter
-      if (it.second)
-      {
-        // Add list of new entity vertices
-        connectivity_ev.push_back(*entity);
+  // Move connectivity data into static MeshTopology data structures
+  topology(D, dim).swap(ce, m);
+  topology(dim, 0).swap(ev, n);
 
-        // Update max vector size (used to reserve space for performance);
-        max_ce_connections = std::max(max_ce_connections,
-                                      connectivity_ce[cell_index].size());
+  return num_entities;
+}
+//-----------------------------------------------------------------------------
+template <typename T>
+void TopologyComputation::sort_keys(std::vector<std::pair<T, std::size_t> >& keys,
+                                    std::size_t num_key_bits,
+                                    std::size_t num_threads)
+{
+  // Use comparison sort for small arrays. Positions are unique, so
+  // sorting pairs keeps equal keys in their original order.
+  const std::size_t num_keys = keys.size();
+  if (num_keys < 65536)
+  {
+    std::sort(keys.begin(), keys.end());
+    return;
+  }
 
-        // Increase counter
-        current_entity++;
-      }
+  // Least significant digit radix sort, with 16 bit digits. Each
+  // thread counts and moves the keys of one block of the array.
+  const std::size_t digit_bits = 16;
+  const std::size_t radix = 1 << digit_bits;
+  const std::size_t num_blocks = num_threads;
+  const std::size_t block_size = (num_keys + num_blocks - 1)/num_blocks;
+  std::vector<std::pair<T, std::size_t> > buffer(num_keys);
+  std::vector<std::size_t> offsets(num_blocks*radix);
+  for (std::size_t shift = 0; shift < num_key_bits; shift += digit_bits)
+  {
+    const std::size_t bits = std::min(digit_bits, num_key_bits - shift);
+
+    // Count digits in each block
+    std::fill(offsets.begin(), offsets.end(), 0);
+    #ifdef HAS_OPENMP
+    #pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+    #endif
+    for (std::size_t b = 0; b < num_blocks; ++b)
+    {
+      std::size_t* count = &offsets[b*radix];
+      const std::size_t end = std::min((b + 1)*block_size, num_keys);
+      for (std::size_t i = b*block_size; i < end; ++i)
+        ++count[extract_bits(keys[i].first, shift, bits)];
     }
-  }
 
-  // Initialise connectivity data structure
-  topology.init(dim, connectivity_ev.size(), connectivity_ev.size());
+    // Compute position of first key with given digit for each block
+    std::size_t position = 0;
+    for (std::size_t d = 0; d < radix; ++d)
+    {
+      for (std::size_t b = 0; b < num_blocks; ++b)
+      {
+        const std::size_t count = offsets[b*radix + d];
+        offsets[b*radix + d] = position;
+        position += count;
+      }
+    }
 
-  // Copy connectivity data into static MeshTopology data structures
-  ce.set(connectivity_ce);
-  ev.set(connectivity_ev);
+    // Move keys
+    #ifdef HAS_OPENMP
+    #pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+    #endif
+    for (std::size_t b = 0; b < num_blocks; ++b)
+    {
+      std::size_t* offset = &offsets[b*radix];
+      const std::size_t end = std::min((b + 1)*block_size, num_keys);
+      for (std::size_t i = b*block_size; i < end; ++i)
+        buffer[offset[extract_bits(keys[i].first, shift, bits)]++] = keys[i];
+    }
 
-  return current_entity;
+    keys.swap(buffer);
+  }
 }
 //-----------------------------------------------------------------------------
 void TopologyComputation::compute_connectivity(Mesh& mesh,
@@ -247,6 +355,10 @@ void TopologyComputation::compute_from_transpose(Mesh& mesh, std::size_t d0,
   //
   //   3. Iterate again over entities of dimension d1 and add connections
   //      for each entity of dimension d0
+  //
+  // Steps 1 and 3 are run in parallel over entities of dimension
+  // d1. The connections of each entity are then sorted to give the
+  // same order as when the connections are added in serial.
 
   log(TRACE, "Computing mesh connectivity %d - %d from transpose.", d0, d1);
 
@@ -254,27 +366,72 @@ void TopologyComputation::compute_from_transpose(Mesh& mesh, std::size_t d0,
   MeshTopology& topology = mesh.topology();
   MeshConnectivity& connectivity = topology(d0, d1);
 
-  // Need connectivity d1 - d0
-  dolfin_assert(!topology(d1, d0).empty());
+  // Need connectivity d1 - d0 (read-only)
+  const MeshTopology& const_topology = topology;
+  const MeshConnectivity& connectivity10 = const_topology(d1, d0);
+  dolfin_assert(!connectivity10.empty());
 
-  // Temporary array
-  std::vector<std::size_t> tmp(topology.size(d0), 0);
+  const std::size_t num_entities0 = topology.size(d0);
+  const std::size_t num_entities1 = topology.size(d1);
+  const std::size_t num_threads = get_num_threads();
 
   // Count the number of connections
-  for (MeshEntityIterator e1(mesh, d1); !e1.end(); ++e1)
-    for (MeshEntityIterator e0(*e1, d0); !e0.end(); ++e0)
-      tmp[e0->index()]++;
-
-  // Initialize the number of connections
-  connectivity.init(tmp);
+  std::vector<unsigned int> offsets(num_entities0 + 1, 0);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t e1 = 0; e1 < num_entities1; ++e1)
+  {
+    const unsigned int* e0 = connectivity10(e1);
+    for (std::size_t i = 0; i < connectivity10.size(e1); ++i)
+    {
+      #ifdef HAS_OPENMP
+      #pragma omp atomic
+      #endif
+      ++offsets[e0[i] + 1];
+    }
+  }
 
-  // Reset current position for each entity
-  std::fill(tmp.begin(), tmp.end(), 0);
+  // Compute offsets
+  for (std::size_t e0 = 0; e0 < num_entities0; ++e0)
+    offsets[e0 + 1] += offsets[e0];
 
   // Add the connections
-  for (MeshEntityIterator e1(mesh, d1); !e1.end(); ++e1)
-    for (MeshEntityIterator e0(*e1, d0); !e0.end(); ++e0)
-      connectivity.set(e0->index(), e1->index(), tmp[e0->index()]++);
+  std::vector<unsigned int> connections(offsets[num_entities0]);
+  std::vector<unsigned int> position(offsets.begin(), offsets.end() - 1);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_threads) if (num_threads > 1)
+  #endif
+  for (std::size_t e1 = 0; e1 < num_entities1; ++e1)
+  {
+    const unsigned int* e0 = connectivity10(e1);
+    for (std::size_t i = 0; i < connectivity10.size(e1); ++i)
+    {
+      unsigned int pos;
+      #ifdef HAS_OPENMP
+      #pragma omp atomic capture
+      #endif
+      pos = position[e0[i]]++;
+      connections[pos] = e1;
+    }
+  }
+  std::vector<unsigned int>().swap(position);
+
+  // Sort connections added by different threads
+  if (num_threads > 1)
+  {
+    #ifdef HAS_OPENMP
+    #pragma omp parallel for num_threads(num_threads)
+    #endif
+    for (std::size_t e0 = 0; e0 < num_entities0; ++e0)
+    {
+      std::sort(connections.begin() + offsets[e0],
+                connections.begin() + offsets[e0 + 1]);
+    }
+  }
+
+  // Copy to static storage
+  connectivity.swap(connections, offsets);
 }
 //----------------------------------------------------------------------------
 void TopologyComputation::compute_from_intersection(Mesh& mesh,
@@ -293,74 +450,121 @@ void TopologyComputation::compute_from_intersection(Mesh& mesh,
   dolfin_assert(!topology(d0, d).empty());
   dolfin_assert(!topology(d, d1).empty());
 
-  // Temporary dynamic storage, later copied into static storage
-  std::vector<std::vector<std::size_t> > connectivity(topology.size(d0));
+  // Get connectivities (read-only)
+  const MeshTopology& const_topology = topology;
+  const MeshConnectivity& connectivity0 = const_topology(d0, d);
+  const MeshConnectivity& connectivity1 = const_topology(d, d1);
+  const MeshConnectivity& vertices0 = const_topology(d0, 0);
+  const MeshConnectivity& vertices1 = const_topology(d1, 0);
+
+  // The entities of dimension d0 are split into one block per
+  // thread. Each block stores the connections of its entities
+  // contiguously, and the number of connections of each entity is
+  // counted. The blocks are then copied into static storage.
+  const std::size_t num_entities0 = topology.size(d0);
+  const std::size_t num_entities1 = topology.size(d1);
+  const std::size_t num_blocks = get_num_threads();
+  const std::size_t block_size = (num_entities0 + num_blocks - 1)/num_blocks;
+  std::vector<std::vector<unsigned int> > block_connections(num_blocks);
+  std::vector<unsigned int> offsets(num_entities0 + 1, 0);
 
-  // A bitmap used to ensure we do not store duplicates
-  std::vector<bool> e1_visited(topology.size(d1));
-
-  // Iterate over all entities of dimension d0
-  std::size_t max_size = 1;
   const std::size_t e0_num_entities = mesh.type().num_vertices(d0);
   const std::size_t e1_num_entities = mesh.type().num_vertices(d1);
-  std::vector<std::size_t> _e0(e0_num_entities);
-  std::vector<std::size_t> _e1(e1_num_entities);
-  for (MeshEntityIterator e0(mesh, d0); !e0.end(); ++e0)
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_blocks) if (num_blocks > 1)
+  #endif
+  for (std::size_t b = 0; b < num_blocks; ++b)
   {
-    // Get set of connected entities for current entity
-    std::vector<std::size_t>& entities = connectivity[e0->index()];
+    std::vector<unsigned int>& entities = block_connections[b];
 
-    // Reserve space
-    entities.reserve(max_size);
+    // A bitmap used to ensure we do not store duplicates
+    std::vector<bool> e1_visited(num_entities1, false);
 
-    // Sorted list of e0 vertex indices (necessary to test for
-    // presence of one list in another)
-    std::copy(e0->entities(0), e0->entities(0) + e0_num_entities, _e0.begin());
-    std::sort(_e0.begin(), _e0.end());
+    // Iterate over all entities of dimension d0 in block
+    std::vector<unsigned int> _e0(e0_num_entities);
+    std::vector<unsigned int> _e1(e1_num_entities);
+    const std::size_t end = std::min((b + 1)*block_size, num_entities0);
+    for (std::size_t e0 = b*block_size; e0 < end; ++e0)
+    {
+      const std::size_t num_connections = entities.size();
 
-    // Initialise e1_visited to false for all neighbours of e0. The
-    // loop structure mirrors the one below.
-    for (MeshEntityIterator e(*e0, d); !e.end(); ++e)
-      for (MeshEntityIterator e1(*e, d1); !e1.end(); ++e1)
-        e1_visited[e1->index()] = false;
+      // Sorted list of e0 vertex indices (necessary to test for
+      // presence of one list in another)
+      std::copy(vertices0(e0), vertices0(e0) + e0_num_entities, _e0.begin());
+      std::sort(_e0.begin(), _e0.end());
 
-    // Iterate over all connected entities of dimension d
-    for (MeshEntityIterator e(*e0, d); !e.end(); ++e)
-    {
-      // Iterate over all connected entities of dimension d1
-      for (MeshEntityIterator e1(*e, d1); !e1.end(); ++e1)
+      // Iterate over all connected entities of dimension d
+      const unsigned int* e = connectivity0(e0);
+      for (std::size_t i = 0; i < connectivity0.size(e0); ++i)
       {
-        // Skip already visited connected entities (to avoid duplicates)
-        if (e1_visited[e1->index()])
-          continue;
-        e1_visited[e1->index()] = true;
-
-        if (d0 == d1)
+        // Iterate over all connected entities of dimension d1
+        const unsigned int* e1 = connectivity1(e[i]);
+        for (std::size_t j = 0; j < connectivity1.size(e[i]); ++j)
         {
-          // An entity is not a neighbor to itself (duplicate index
-          // entries removed at end)
-          if (e0->index() != e1->index())
-            entities.push_back(e1->index());
-        }
-        else
-        {
-          // Sorted list of e1 vertex indices
-          std::copy(e1->entities(0), e1->entities(0) + e1_num_entities,
-                    _e1.begin());
-          std::sort(_e1.begin(), _e1.end());
-
-          // Entity e1 must be completely contained in e0
-          if (std::includes(_e0.begin(), _e0.end(), _e1.begin(), _e1.end()))
-            entities.push_back(e1->index());
+          // Skip already visited connected entities (to avoid
+          // duplicates)
+          if (e1_visited[e1[j]])
+            continue;
+          e1_visited[e1[j]] = true;
+
+          if (d0 == d1)
+          {
+            // An entity is not a neighbor to itself
+            if (e0 != e1[j])
+              entities.push_back(e1[j]);
+          }
+          else
+          {
+            // Sorted list of e1 vertex indices
+            std::copy(vertices1(e1[j]), vertices1(e1[j]) + e1_num_entities,
+                      _e1.begin());
+            std::sort(_e1.begin(), _e1.end());
+
+            // Entity e1 must be completely contained in e0
+            if (std::includes(_e0.begin(), _e0.end(), _e1.begin(), _e1.end()))
+              entities.push_back(e1[j]);
+          }
         }
       }
+
+      // Reset e1_visited for all neighbours of e0. The loop
+      // structure mirrors the one above.
+      for (std::size_t i = 0; i < connectivity0.size(e0); ++i)
+      {
+        const unsigned int* e1 = connectivity1(e[i]);
+        for (std::size_t j = 0; j < connectivity1.size(e[i]); ++j)
+          e1_visited[e1[j]] = false;
+      }
+
+      // Store number of connections
+      offsets[e0 + 1] = entities.size() - num_connections;
     }
+  }
+
+  // Compute offsets
+  for (std::size_t e0 = 0; e0 < num_entities0; ++e0)
+    offsets[e0 + 1] += offsets[e0];
 
-    // Store maximum size
-    max_size = std::max(entities.size(), max_size);
+  // Copy blocks into contiguous array
+  std::vector<unsigned int> connections(offsets[num_entities0]);
+  #ifdef HAS_OPENMP
+  #pragma omp parallel for num_threads(num_blocks) if (num_blocks > 1)
+  #endif
+  for (std::size_t b = 0; b < num_blocks; ++b)
+  {
+    const std::size_t begin = std::min(b*block_size, num_entities0);
+    std::copy(block_connections[b].begin(), block_connections[b].end(),
+              connections.begin() + offsets[begin]);
+    std::vector<unsigned int>().swap(block_connections[b]);
   }
 
   // Copy to static storage
-  topology(d0, d1).set(connectivity);
+  topology(d0, d1).swap(connections, offsets);
+}
+//-----------------------------------------------------------------------------
+std::size_t TopologyComputation::get_num_threads()
+{
+  const std::size_t num_threads = parameters["num_threads"];
+  return std::max(num_threads, (std::size_t) 1);
 }
 //-----------------------------------------------------------------------------
@@ -18,12 +18,14 @@
 // Modified by Garth N. Wells 2012.
 //
 // First added:  2006-06-02
-// Last changed: 2012-02-14
+// Last changed: 2014-03-22
 
 #ifndef __TOPOLOGY_COMPUTATION_H
 #define __TOPOLOGY_COMPUTATION_H
 
+#include <utility>
 #include <vector>
+#include <boost/cstdint.hpp>
 
 namespace dolfin
 {
@@ -46,6 +48,49 @@ namespace dolfin
 
   private:
 
+    // Compute entities of given dimension. Each entity is identified
+    // by a key of type T holding its sorted vertex indices, with
+    // num_bits bits per vertex index. The keys are sorted to find
+    // the distinct entities.
+    template <typename T>
+    static std::size_t compute_entities_by_key(Mesh& mesh, std::size_t dim,
+                                               std::size_t num_bits);
+
+    // Sort pairs of (key, position) by key, keeping pairs with equal
+    // keys in their original order (radix sort, using the given
+    // number of threads)
+    template <typename T>
+    static void sort_keys(std::vector<std::pair<T, std::size_t> >& keys,
+                          std::size_t num_key_bits, std::size_t num_threads);
+
+    // Functions for keys stored in one or two 64 bit integers (the
+    // most significant part is stored first)
+    typedef std::pair<boost::uint64_t, boost::uint64_t> uint128;
+    static void append_bits(boost::uint64_t& key, std::size_t value,
+                            std::size_t num_bits)
+    { key = (key << num_bits) | value; }
+    static void append_bits(uint128& key, std::size_t value,
+                            std::size_t num_bits)
+    {
+      key.first = (key.first << num_bits) | (key.second >> (64 - num_bits));
+      key.second = (key.second << num_bits) | value;
+    }
+    static std::size_t extract_bits(const boost::uint64_t& key,
+                                    std::size_t shift, std::size_t num_bits)
+    { return (key >> shift) & ((boost::uint64_t(1) << num_bits) - 1); }
+    static std::size_t extract_bits(const uint128& key,
+                                    std::size_t shift, std::size_t num_bits)
+    {
+      boost::uint64_t bits = 0;
+      if (shift >= 64)
+        bits = key.first >> (shift - 64);
+      else if (shift == 0)
+        bits = key.second;
+      else
+        bits = (key.second >> shift) | (key.first << (64 - shift));
+      return bits & ((boost::uint64_t(1) << num_bits) - 1);
+    }
+
     // Compute connectivity from transpose
     static void compute_from_transpose(Mesh& mesh, std::size_t d0,
                                        std::size_t d1);
@@ -54,6 +99,10 @@ namespace dolfin
     static void compute_from_intersection(Mesh& mesh, std::size_t d0,
                                           std::size_t d1, std::size_t d);
 
+    // Return number of threads to use (parameter "num_threads", at
+    // least one)
+    static std::size_t get_num_threads();
+
   };
 
 }
@@ -18,7 +18,7 @@
 // Modified by Fredrik Valdmanis, 2011
 //
 // First added:  2009-07-02
-// Last changed: 2013-06-21
+// Last changed: 2014-03-27
 
 #ifndef __GLOBAL_PARAMETERS_H
 #define __GLOBAL_PARAMETERS_H
@@ -72,6 +72,14 @@ namespace dolfin
       // Number of threads to run, 0 = run serial version
       p.add("num_threads", 0);
 
+      // Number of cells tabulated per block by the serial assembler,
+      // 1 = assemble cell-by-cell
+      p.add("assembly_block_size", 1);
+
+      // Record time spent in the phases of local assembly (see
+      // AssemblyProfile)
+      p.add("profile_assembly", false);
+
       // DOF reordering when running in serial
       p.add("reorder_dofs_serial", true);
 
@@ -153,6 +161,15 @@ namespace dolfin
             default_refinement_algorithm,
             allowed_refinement_algorithms);
 
+      // Split strategy for building bounding box trees: "median"
+      // (fast build) or "sah" (surface area heuristic, slower build
+      // but fewer overlapping boxes to visit in queries)
+      std::set<std::string> allowed_bounding_box_tree_splits;
+      allowed_bounding_box_tree_splits.insert("median");
+      allowed_bounding_box_tree_splits.insert("sah");
+      p.add("bounding_box_tree_split", "median",
+            allowed_bounding_box_tree_splits);
+
       // Linear algebra
       std::set<std::string> allowed_backends;
       std::string default_backend("uBLAS");
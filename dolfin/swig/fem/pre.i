@@ -110,6 +110,15 @@ PROBLEM_RENAMES(NonlinearVariational)
 %ignore dolfin::SystemAssembler::SystemAssembler(const Form&, const Form&,
 						 const std::vector<const DirichletBC*>);
 
+//-----------------------------------------------------------------------------
+// Ignore functions used by the assemblers to record an AssemblyProfile
+//-----------------------------------------------------------------------------
+%ignore dolfin::AssemblyProfile::start;
+%ignore dolfin::AssemblyProfile::stop;
+%ignore dolfin::AssemblyProfile::count;
+%ignore dolfin::AssemblyProfile::inserted;
+%ignore dolfin::AssemblyProfile::add;
+
 //-----------------------------------------------------------------------------
 // Ignore operator= for DirichletBC to avoid warning
 //-----------------------------------------------------------------------------
@@ -93,6 +93,7 @@
 //-----------------------------------------------------------------------------
 %feature("director") dolfin::Expression;
 %feature("nodirector") dolfin::Expression::evaluate;
+%feature("nodirector") dolfin::Expression::eval_batch;
 %feature("nodirector") dolfin::Expression::restrict;
 %feature("nodirector") dolfin::Expression::update;
 %feature("nodirector") dolfin::Expression::value_dimension;
@@ -121,6 +121,8 @@
 //-----------------------------------------------------------------------------
 // Ignore wrapping of the Set variable (Might add typemap for this in future...)
 //-----------------------------------------------------------------------------
+%ignore dolfin::GenericSparsityPattern::insert_blocks;
+%ignore dolfin::SparsityPattern::insert_blocks;
 %ignore dolfin::SparsityPattern::diagonal_pattern;
 %ignore dolfin::SparsityPattern::off_diagonal_pattern;
 
@@ -172,6 +174,7 @@
 %ignore dolfin::GenericMatrix::get(double*, const dolfin::la_index*,
                                    const dolfin::la_index * const *) const;
 %ignore dolfin::GenericMatrix::data;
+%ignore dolfin::GenericMatrix::value_data;
 %ignore dolfin::GenericMatrix::getitem;
 %ignore dolfin::GenericMatrix::setitem;
 %ignore dolfin::GenericMatrix::operator();
@@ -22,7 +22,7 @@
 // Modified by Johan Hake 2008-2009
 //
 // First added:  2006-09-20
-// Last changed: 2011-03-11
+// Last changed: 2014-03-27
 
 //=============================================================================
 // SWIG directives for the DOLFIN Mesh kernel module (post)
@@ -97,6 +97,10 @@ def mark(self, *args):
                             "Expected a MeshFunction of type \"size_t\", \"int\", \"double\" or \"bool\"")
 
     self._mark(*args)
+
+def thread_safe(self):
+    "Return False, since inside() implemented in Python cannot be called from several threads"
+    return False
 %}
 }
 
@@ -22,7 +22,7 @@
 // Modified by Johan Hake 2008-2011
 //
 // First added:  2006-09-20
-// Last changed: 2013-05-22
+// Last changed: 2014-03-27
 
 //=============================================================================
 // SWIG directives for the DOLFIN Mesh kernel module (pre)
@@ -101,6 +101,17 @@ ALL_VALUES(dolfin::MeshFunction<std::size_t>, size_t)
 %ignore dolfin::MeshValueCollection::operator=;
 %ignore dolfin::MeshConnectivity::operator=;
 %ignore dolfin::MeshConnectivity::set;
+%ignore dolfin::MeshConnectivity::swap;
+%ignore dolfin::MeshEntityRange::vertices;
+%ignore dolfin::MeshEntityRange::x;
+%ignore dolfin::MeshEntityRange::get_vertex_coordinates;
+%ignore dolfin::MeshEntityRange::midpoint;
+%ignore dolfin::MeshEntityRange::get_cell_data;
+%ignore dolfin::MeshEntityRange::parallel_for;
+%ignore dolfin::MeshRenumbering::renumber;
+%ignore dolfin::MeshRenumbering::compute_curve_order;
+%ignore dolfin::SubDomain::inside_batch;
+%ignore dolfin::MeshQuality::cell_quality;
 %ignore dolfin::MeshEntityIterator::operator->;
 %ignore dolfin::MeshEntityIterator::operator[];
 %ignore dolfin::MeshEntity::operator->;
@@ -86,6 +86,35 @@
 }
 %enddef
 
+//-----------------------------------------------------------------------------
+// Macro for defining an out-typemap for dolfin::ArrayView -> NumPy array.
+// The data is copied, as the view does not own the data it points to.
+//
+// TYPE       : The primitive type
+// NUMPYTYPE  : The NumPy type that is going to be checked for
+//-----------------------------------------------------------------------------
+%define OUT_NUMPY_TYPEMAP_FOR_DOLFIN_ARRAY_VIEW(TYPE, NUMPYTYPE)
+
+%typemap(out) dolfin::ArrayView<const TYPE> {
+
+  // Create NumPy array
+  npy_intp size = (&$1)->size();
+  PyObject* op = PyArray_SimpleNew(1, &size, NUMPYTYPE);
+
+  if ( op == NULL )
+    SWIG_exception(SWIG_TypeError, "Error in conversion of dolfin::ArrayView< TYPE > to NumPy array.");
+
+  // Get data
+  TYPE* data = reinterpret_cast<TYPE*>(PyArray_DATA(op));
+
+  // Copy data from ArrayView
+  std::copy((&$1)->begin(), (&$1)->end(), data);
+
+  // Return the NumPy array
+  $result = op;
+}
+%enddef
+
 //-----------------------------------------------------------------------------
 // Director typemaps for dolfin::Array
 //-----------------------------------------------------------------------------
@@ -117,3 +146,5 @@ IN_NUMPY_TYPEMAP_FOR_DOLFIN_ARRAY(dolfin::la_index, INT32, NPY_UINT, dolfin_inde
 OUT_NUMPY_TYPEMAP_FOR_DOLFIN_ARRAY(std::size_t, NPY_UINTP)
 OUT_NUMPY_TYPEMAP_FOR_DOLFIN_ARRAY(int, NPY_INT)
 OUT_NUMPY_TYPEMAP_FOR_DOLFIN_ARRAY(double, NPY_DOUBLE)
+
+OUT_NUMPY_TYPEMAP_FOR_DOLFIN_ARRAY_VIEW(dolfin::la_index, NPY_INT)
@@ -20,7 +20,7 @@
 # Modified by Johan Hake 2008-2009
 #
 # First added:  2008-06-04
-# Last changed: 2011-04-18
+# Last changed: 2014-03-20
 
 import re
 import types
@@ -54,7 +54,24 @@ public:
   {
 %(evalcode)s
   }
-};
+%(evalcode_batch)s};
+"""
+
+_eval_batch_template = """
+  void eval_batch(dolfin::Array<double>& values_batch,
+                  const dolfin::Array<double>& x_batch,
+                  const ufc::cell& cell) const
+  {
+    const std::size_t gdim = cell.geometric_dimension;
+    const std::size_t size = value_size();
+    const std::size_t num_points = x_batch.size()/gdim;
+    for (std::size_t point = 0; point < num_points; ++point)
+    {
+      const double* x = x_batch.data() + point*gdim;
+      double* values = values_batch.data() + point*size;
+%(evalcode)s
+    }
+  }
 """
 
 def flatten_and_check_expression(expr):
@@ -111,6 +128,14 @@ def expression_to_dolfin_expression(expr, generic_function_members):
         "__array_, x", "__array_, x, cell")
     fragments["value_shape"] = "\n".join(value_shape_code)
 
+    # Generate batched evaluation without per-point virtual calls
+    # (only when the expression does not depend on other functions)
+    if generic_function_members:
+        fragments["evalcode_batch"] = ""
+    else:
+        fragments["evalcode_batch"] = _eval_batch_template % \
+            {"evalcode": "\n".join("  " + line for line in evalcode)}
+
     # Assign classname
     classname = "Expression_" + hashlib.md5(fragments["evalcode"]).hexdigest()
     fragments["classname"] = classname
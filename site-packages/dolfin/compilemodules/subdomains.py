@@ -18,7 +18,7 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2008-07-01
-# Last changed: 2011-04-18
+# Last changed: 2014-03-27
 
 import re
 import os
@@ -54,6 +54,12 @@ public:
     %(inside)s
   }
 
+  /// Return true (inside() may be called from several threads)
+  bool thread_safe() const
+  {
+    return true;
+  }
+
 };
 """
 
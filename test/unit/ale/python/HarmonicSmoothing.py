@@ -18,12 +18,12 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2013-03-02
-# Last changed: 2013-03-04
+# Last changed: 2014-03-27
 
 import unittest
 from dolfin import UnitSquareMesh, BoundaryMesh, Expression, \
                    CellFunction, SubMesh, Constant, MPI, MeshQuality,\
-                   mpi_comm_world
+                   mpi_comm_world, HarmonicSmoothing
 
 class HarmonicSmoothingTest(unittest.TestCase):
 
@@ -60,6 +60,42 @@ class HarmonicSmoothingTest(unittest.TestCase):
         rmin = MeshQuality.radius_ratio_min_max(mesh)[0]
         self.assertTrue(rmin > magic_number)
 
+    def test_HarmonicSmoothing_repeated(self):
+
+        print ""
+        print "Testing HarmonicSmoothing::smooth(const BoundaryMesh& " \
+              "new_boundary)"
+
+        # Create two equal meshes, one moved by persistent smoothing
+        mesh0 = UnitSquareMesh(10, 10)
+        mesh1 = UnitSquareMesh(10, 10)
+        smoothing = HarmonicSmoothing(mesh1)
+
+        # Move both meshes a few times
+        disp = Expression(("0.1*x[0]*x[1]", "0.2*(1.0-x[1])"))
+        for i in range(3):
+            boundary = BoundaryMesh(mesh1, 'exterior')
+            boundary.move(disp)
+            smoothing.smooth(boundary)
+            if i == 0:
+                mesh0.move(boundary)
+
+                # First move is identical to HarmonicSmoothing::move
+                err = sum(sum(abs(mesh0.coordinates() \
+                                - mesh1.coordinates()))) / mesh1.num_vertices()
+                self.assertAlmostEqual(err, 0.0, places=5)
+
+            # Check that boundary has been moved
+            boundary_new = BoundaryMesh(mesh1, 'exterior')
+            err = sum(sum(abs(boundary.coordinates() \
+                            - boundary_new.coordinates()))) / mesh1.num_vertices()
+            self.assertAlmostEqual(err, 0.0, places=5)
+
+        # Check mesh quality
+        magic_number = 0.2
+        rmin = MeshQuality.radius_ratio_min_max(mesh1)[0]
+        self.assertTrue(rmin > magic_number)
+
 
 if MPI.size(mpi_comm_world()) == 1:
 
@@ -21,7 +21,7 @@
 # Modified by Anders Logg 2011
 #
 # First added:  2011-03-12
-# Last changed: 2011-03-12
+# Last changed: 2014-03-18
 
 import unittest
 import numpy
@@ -91,15 +91,17 @@ class Assembly(unittest.TestCase):
             self.assertAlmostEqual(assemble(L).norm("l2"), b_l2_norm, 10)
             parameters["num_threads"] = 0
 
+        # Assemble A and b in blocks of cells
+        parameters["assembly_block_size"] = 7
+        self.assertAlmostEqual(assemble(a).norm("frobenius"), A_frobenius_norm, 10)
+        self.assertAlmostEqual(assemble(L).norm("l2"), b_l2_norm, 10)
+        parameters["assembly_block_size"] = 1
+
     def test_facet_assembly(self):
 
         mesh = UnitSquareMesh(24, 24)
         V = FunctionSpace(mesh, "DG", 1)
 
-        if MPI.size(mesh.mpi_comm()) > 1:
-            print "FIXME: This unit test does not work in parallel, skipping"
-            return
-
         # Define test and trial functions
         v = TestFunction(V)
         u = TrialFunction(V)
@@ -138,6 +140,12 @@ class Assembly(unittest.TestCase):
             self.assertAlmostEqual(assemble(L).norm("l2"), b_l2_norm, 10)
             parameters["num_threads"] = 0
 
+        # Assemble A and b in blocks of cells
+        parameters["assembly_block_size"] = 16
+        self.assertAlmostEqual(assemble(a).norm("frobenius"), A_frobenius_norm, 10)
+        self.assertAlmostEqual(assemble(L).norm("l2"), b_l2_norm, 10)
+        parameters["assembly_block_size"] = 1
+
     def test_functional_assembly(self):
 
         mesh = UnitSquareMesh(24, 24)
@@ -405,6 +413,87 @@ class Assembly(unittest.TestCase):
                                    A_frobenius_norm, 10)
             parameters["num_threads"] = 0
 
+    def test_matrix_free_operator(self):
+        """Test action of matrix-free operator against assembled matrix"""
+
+        mesh = UnitSquareMesh(12, 12)
+        V = FunctionSpace(mesh, "CG", 3)
+        u = TrialFunction(V)
+        v = TestFunction(V)
+        c = Expression("1.0 + x[0]*x[1]", degree=2)
+        a = c*inner(grad(u), grad(v))*dx + u*v*ds
+
+        # Reference action from assembled matrix
+        A = assemble(a)
+        x = Function(V)
+        x.interpolate(Expression("sin(x[0])*x[1]", degree=3))
+        y_ref = A*x.vector()
+
+        # Action from matrix-free operator
+        O = MatrixFreeOperator(Form(a))
+        self.assertEqual(O.size(0), V.dim())
+        self.assertEqual(O.size(1), V.dim())
+        y = Function(V).vector()
+        O.mult(x.vector(), y)
+        y -= y_ref
+        self.assertAlmostEqual(y.norm("l2")/y_ref.norm("l2"), 0.0, 12)
+
+    def test_cached_insertion_positions(self):
+        """Test reassembly using cached insertion positions"""
+
+        if not has_linear_algebra_backend("uBLAS"):
+            return
+
+        mesh = UnitSquareMesh(8, 8)
+        if MPI.size(mesh.mpi_comm()) > 1:
+            return
+
+        V = FunctionSpace(mesh, "DG", 1)
+        u = TrialFunction(V)
+        v = TestFunction(V)
+        n = FacetNormal(mesh)
+        a = Form(inner(grad(u), grad(v))*dx + u*v*ds
+                 + inner(jump(u, n), jump(v, n))*dS)
+
+        backend = parameters["linear_algebra_backend"]
+        parameters["linear_algebra_backend"] = "uBLAS"
+        A_ref = assemble(a)
+
+        assembler = Assembler()
+        assembler.cache_insertion_positions = True
+        assembler.reset_sparsity = False
+        A = Matrix()
+        for i in range(3):
+            assembler.assemble(A, a)
+            self.assertAlmostEqual(A.norm("frobenius"),
+                                   A_ref.norm("frobenius"), 10)
+        parameters["linear_algebra_backend"] = backend
+
+    def test_assembly_profile(self):
+        """Test recording of assembly profile"""
+
+        mesh = UnitSquareMesh(4, 4)
+        V = FunctionSpace(mesh, "CG", 1)
+        u = TrialFunction(V)
+        v = TestFunction(V)
+        a = Form(u*v*dx + u*v*ds)
+
+        profile_assembly = parameters["profile_assembly"]
+        parameters["profile_assembly"] = True
+        assembler = Assembler()
+        A = Matrix()
+        assembler.assemble(A, a)
+        parameters["profile_assembly"] = profile_assembly
+
+        profile = assembler.profile
+        self.assertEqual(profile.num_entities(AssemblyProfile.cell),
+                         mesh.num_cells())
+        self.assertTrue(profile.bytes_inserted() > 0)
+        self.assertTrue(timing("Assembly: tabulate tensor") >= 0.0)
+        if MPI.size(mesh.mpi_comm()) == 1:
+            self.assertEqual(profile.num_entities(AssemblyProfile.exterior_facet),
+                             16)
+
     def test_reference_assembly(self):
         "Test assembly against a reference solution"
 
@@ -21,7 +21,7 @@
 # Modified by Anders Logg 2011
 #
 # First added:  2011-10-04
-# Last changed: 2013-06-02
+# Last changed: 2014-03-15
 
 import unittest
 import numpy
@@ -125,6 +125,15 @@ class TestSystemAssembler(unittest.TestCase):
         assembler.assemble(b)
         self.assertAlmostEqual(b.norm("l2"), b_l2_norm, 10)
 
+        # Assemble system multi-threaded
+        if has_openmp() and MPI.size(mesh.mpi_comm()) == 1:
+            parameters["num_threads"] = 4
+            A, b = Matrix(), Vector()
+            assembler.assemble(A, b)
+            self.assertAlmostEqual(A.norm("frobenius"), A_frobenius_norm, 10)
+            self.assertAlmostEqual(b.norm("l2"), b_l2_norm, 10)
+            parameters["num_threads"] = 0
+
 
     def test_facet_assembly(self):
 
@@ -185,6 +194,14 @@ class TestSystemAssembler(unittest.TestCase):
         assembler.assemble(b)
         self.assertAlmostEqual(b.norm("l2"), b_l2_norm, 10)
 
+        # Assemble system multi-threaded
+        if has_openmp() and MPI.size(mesh.mpi_comm()) == 1:
+            parameters["num_threads"] = 4
+            A, b = assemble_system(a, L)
+            self.assertAlmostEqual(A.norm("frobenius"), A_frobenius_norm, 10)
+            self.assertAlmostEqual(b.norm("l2"), b_l2_norm, 10)
+            parameters["num_threads"] = 0
+
 
     def test_incremental_assembly(self):
 
@@ -20,7 +20,7 @@
 # Modified by Benjamin Kehlet 2012
 #
 # First added:  2007-05-24
-# Last changed: 2012-11-12
+# Last changed: 2014-03-20
 
 import unittest
 from dolfin import *
@@ -208,6 +208,27 @@ class MeshEvaluation(unittest.TestCase):
           self.assertTrue(all(e1_values[mesh.num_vertices():mesh.num_vertices()*2]==2))
           self.assertTrue(all(e1_values[mesh.num_vertices()*2:mesh.num_vertices()*3]==3))
 
+     def test_batched_evaluation(self):
+          "Compare compiled (batched) and Python (point-wise) evaluation"
+
+          class PythonExpression(Expression):
+               def eval(self, values, x):
+                    values[0] = sin(x[0])*x[1] + x[2]
+                    values[1] = x[0]*x[0]
+                    values[2] = cos(x[2])
+
+          e0 = Expression(("sin(x[0])*x[1] + x[2]", "x[0]*x[0]", "cos(x[2])"))
+          e1 = PythonExpression(element=W.ufl_element())
+
+          u0 = interpolate(e0, W)
+          u1 = interpolate(e1, W)
+          u0.vector().axpy(-1.0, u1.vector())
+          self.assertAlmostEqual(u0.vector().norm("l2"), 0.0, 12)
+
+          v0 = e0.compute_vertex_values(mesh)
+          v1 = e1.compute_vertex_values(mesh)
+          self.assertAlmostEqual(max(abs(v0 - v1)), 0.0, 12)
+
 class Instantiation(unittest.TestCase):
 
      def test_wrong_sub_classing(self):
@@ -18,7 +18,7 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2011-03-23
-# Last changed: 2011-03-23
+# Last changed: 2014-03-27
 
 import unittest
 from dolfin import *
@@ -241,6 +241,50 @@ class Interface(unittest.TestCase):
         self.assertRaises(TypeError, u0, [0,0,0,0])
         self.assertRaises(TypeError, u0, [0,0])
 
+    def test_eval_points(self):
+        from numpy import zeros, random
+        u1 = Function(V)
+        u2 = Function(W)
+        u1.interpolate(Expression("x[0]+x[1]+x[2]"))
+        u2.interpolate(Expression(("x[0]+x[1]+x[2]", "x[0]-x[1]-x[2]",
+                                   "x[0]+x[1]+x[2]")))
+
+        random.seed(1)
+        num_points = 50
+        x = random.rand(num_points, 3).flatten()
+
+        values1 = zeros(num_points, dtype='d')
+        u1.eval_points(values1, x)
+        values2 = zeros(3*num_points, dtype='d')
+        u2.eval_points(values2, x)
+        for i in range(num_points):
+            p = x[3*i:3*i + 3]
+            self.assertAlmostEqual(values1[i], u1(p))
+            for j in range(3):
+                self.assertAlmostEqual(values2[3*i + j], u2(p)[j])
+
+        # Sizes must match
+        self.assertRaises(RuntimeError, u1.eval_points, zeros(2), x)
+
+    def test_eval_points_collective(self):
+        from numpy import zeros, random
+        u1 = Function(V)
+        u1.interpolate(Expression("x[0]+x[1]+x[2]"))
+
+        # All processes ask for the same points, which in parallel are
+        # mostly owned by other processes
+        random.seed(2)
+        num_points = 50
+        x = random.rand(num_points, 3).flatten()
+        values = zeros(num_points, dtype='d')
+        u1.eval_points_collective(values, x)
+        for i in range(num_points):
+            self.assertAlmostEqual(values[i], sum(x[3*i:3*i + 3]))
+
+        # Points outside the domain
+        x[0] = 2.0
+        self.assertRaises(RuntimeError, u1.eval_points_collective, values, x)
+
 class ScalarFunctions(unittest.TestCase):
     def test_constant_float_conversion(self):
         c = Constant(3.45)
@@ -18,7 +18,7 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2013-12-14
-# Last changed:
+# Last changed: 2014-03-27
 
 import unittest
 import numpy
@@ -45,19 +45,18 @@ class NonmatchingFunctionInterpolationTest(unittest.TestCase):
         u0 = Function(V0)
         u0.interpolate(f)
 
-        if MPI.size(mesh0.mpi_comm()) == 1:
-            # Interpolate FE function on finer mesh
-            mesh1 = UnitSquareMesh(31, 31)
-            V1 = FunctionSpace(mesh1, "Lagrange", 2)
-            u1 = Function(V1)
-            u1.interpolate(u0)
-            self.assertAlmostEqual(assemble(u0*dx), assemble(u1*dx), 10)
+        # Interpolate FE function on finer mesh
+        mesh1 = UnitSquareMesh(31, 31)
+        V1 = FunctionSpace(mesh1, "Lagrange", 2)
+        u1 = Function(V1)
+        u1.interpolate(u0)
+        self.assertAlmostEqual(assemble(u0*dx), assemble(u1*dx), 10)
 
-            mesh1 = UnitSquareMesh(30, 30)
-            V1 = FunctionSpace(mesh1, "Lagrange", 2)
-            u1 = Function(V1)
-            u1.interpolate(u0)
-            self.assertAlmostEqual(assemble(u0*dx), assemble(u1*dx), 10)
+        mesh1 = UnitSquareMesh(30, 30)
+        V1 = FunctionSpace(mesh1, "Lagrange", 2)
+        u1 = Function(V1)
+        u1.interpolate(u0)
+        self.assertAlmostEqual(assemble(u0*dx), assemble(u1*dx), 10)
 
     def test_functional3D(self):
         """Test integration of function interpolated in non-matching meshes"""
@@ -70,19 +69,38 @@ class NonmatchingFunctionInterpolationTest(unittest.TestCase):
         u0 = Function(V0)
         u0.interpolate(f)
 
-        if MPI.size(mesh0.mpi_comm()) == 1:
-            # Interpolate FE function on finer mesh
-            mesh1 = UnitCubeMesh(11, 11, 11)
-            V1 = FunctionSpace(mesh1, "Lagrange", 2)
-            u1 = Function(V1)
-            u1.interpolate(u0)
-            self.assertAlmostEqual(assemble(u0*dx), assemble(u1*dx), 10)
-
-            mesh1 = UnitCubeMesh(10, 11, 10)
-            V1 = FunctionSpace(mesh1, "Lagrange", 2)
-            u1 = Function(V1)
-            u1.interpolate(u0)
-            self.assertAlmostEqual(assemble(u0*dx), assemble(u1*dx), 10)
+        # Interpolate FE function on finer mesh
+        mesh1 = UnitCubeMesh(11, 11, 11)
+        V1 = FunctionSpace(mesh1, "Lagrange", 2)
+        u1 = Function(V1)
+        u1.interpolate(u0)
+        self.assertAlmostEqual(assemble(u0*dx), assemble(u1*dx), 10)
+
+        mesh1 = UnitCubeMesh(10, 11, 10)
+        V1 = FunctionSpace(mesh1, "Lagrange", 2)
+        u1 = Function(V1)
+        u1.interpolate(u0)
+        self.assertAlmostEqual(assemble(u0*dx), assemble(u1*dx), 10)
+
+    def test_vector_valued(self):
+        """Test interpolation of vector-valued function between
+        non-matching meshes"""
+
+        f = Expression(("x[0]*x[1]", "x[0] - x[1]"))
+
+        mesh0 = UnitSquareMesh(8, 8)
+        V0 = VectorFunctionSpace(mesh0, "Lagrange", 2)
+        u0 = Function(V0)
+        u0.interpolate(f)
+
+        mesh1 = UnitSquareMesh(13, 13, "crossed")
+        V1 = VectorFunctionSpace(mesh1, "Lagrange", 2)
+        u1 = Function(V1)
+        u1.interpolate(u0)
+        u2 = Function(V1)
+        u2.interpolate(f)
+        u1.vector().axpy(-1.0, u2.vector())
+        self.assertAlmostEqual(u1.vector().norm("linf"), 0.0, 10)
 
 if __name__ == "__main__":
     unittest.main()
@@ -18,15 +18,15 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2013-04-15
-# Last changed: 2014-02-24
+# Last changed: 2014-03-27
 
 import unittest
 import numpy
 
 from dolfin import BoundingBoxTree
 from dolfin import UnitIntervalMesh, UnitSquareMesh, UnitCubeMesh
-from dolfin import Point
-from dolfin import MPI
+from dolfin import Point, cells
+from dolfin import MPI, parameters, has_openmp
 
 class BoundingBoxTreeTest(unittest.TestCase):
 
@@ -474,6 +474,114 @@ class BoundingBoxTreeTest(unittest.TestCase):
             self.assertEqual(entity, reference[0])
             self.assertAlmostEqual(distance, reference[1])
 
+    #--- build options ---
+
+    def test_build_split_and_threads(self):
+
+        mesh = UnitCubeMesh(8, 8, 8)
+        points = [Point(0.3, 0.3, 0.3), Point(0.9, 0.1, 0.5),
+                  Point(0.0, 0.0, 0.0), Point(0.55, 0.75, 0.25)]
+
+        tree = BoundingBoxTree()
+        tree.build(mesh)
+        references = [set(tree.compute_entity_collisions(p)) for p in points]
+
+        num_threads = [0, 2] if has_openmp() else [0]
+        for split in ["median", "sah"]:
+            for n in num_threads:
+                parameters["bounding_box_tree_split"] = split
+                parameters["num_threads"] = n
+                tree = BoundingBoxTree()
+                tree.build(mesh)
+                parameters["bounding_box_tree_split"] = "median"
+                parameters["num_threads"] = 0
+
+                for p, reference in zip(points, references):
+                    self.assertEqual(set(tree.compute_entity_collisions(p)),
+                                     reference)
+                    self.assertEqual(tree.compute_first_entity_collision(p)
+                                     in reference, True)
+
+    #--- refit ---
+
+    def test_refit(self):
+
+        points = [Point(0.3, 0.3, 0.3), Point(0.9, 0.1, 0.5),
+                  Point(1.2, 0.8, 0.4), Point(0.55, 0.75, 0.25)]
+
+        mesh = UnitCubeMesh(8, 8, 8)
+        tree = BoundingBoxTree()
+        tree.build(mesh)
+
+        # Smooth motion: refit and compare with new tree
+        x = mesh.coordinates()
+        x[:, 0] += 0.2*x[:, 0]*x[:, 1]
+        self.assertTrue(tree.refit())
+        reference = BoundingBoxTree()
+        reference.build(mesh)
+        for p in points:
+            self.assertEqual(set(tree.compute_entity_collisions(p)),
+                             set(reference.compute_entity_collisions(p)))
+        q = Point(2.0, 0.5, 0.5)
+        self.assertAlmostEqual(tree.compute_closest_entity(q)[1],
+                               reference.compute_closest_entity(q)[1])
+
+        # Scrambled vertices: tree is rebuilt
+        numpy.random.seed(1)
+        x[:] = x[numpy.random.permutation(x.shape[0])]
+        self.assertFalse(tree.refit())
+        reference.build(mesh)
+        for p in points:
+            self.assertEqual(set(tree.compute_entity_collisions(p)),
+                             set(reference.compute_entity_collisions(p)))
+
+    def test_mesh_tree_follows_coordinates(self):
+
+        mesh = UnitSquareMesh(8, 8)
+        p = Point(1.5, 0.5)
+        self.assertEqual(len(mesh.bounding_box_tree().compute_entity_collisions(p)), 0)
+
+        # Stretch mesh, tree should be refitted
+        mesh.coordinates()[:, 0] *= 2.0
+        tree = BoundingBoxTree()
+        tree.build(mesh)
+        self.assertEqual(set(mesh.bounding_box_tree().compute_entity_collisions(p)),
+                         set(tree.compute_entity_collisions(p)))
+        self.assertTrue(len(tree.compute_entity_collisions(p)) > 0)
+
+    #--- point queries against brute force ---
+
+    def test_point_queries_brute_force(self):
+
+        def barycentric_collisions(mesh, x):
+            "Cells containing x, from barycentric coordinates"
+            vertices = mesh.coordinates()[mesh.cells()]
+            collisions = set()
+            for i, v in enumerate(vertices):
+                lam = numpy.linalg.solve((v[1:] - v[0]).T, x - v[0])
+                if lam.min() >= -1e-12 and lam.sum() <= 1.0 + 1e-12:
+                    collisions.add(i)
+            return collisions
+
+        numpy.random.seed(2)
+        for mesh in [UnitSquareMesh(6, 5), UnitCubeMesh(4, 3, 5)]:
+            gdim = mesh.geometry().dim()
+            tree = BoundingBoxTree()
+            tree.build(mesh)
+            for i in range(50):
+                x = 1.2*numpy.random.rand(gdim) - 0.1
+                p = Point(*x)
+                reference = barycentric_collisions(mesh, x)
+                self.assertEqual(set(c.index() for c in cells(mesh)
+                                     if c.collides(p)), reference)
+                self.assertEqual(set(tree.compute_entity_collisions(p)),
+                                 reference)
+                first = tree.compute_first_entity_collision(p)
+                if reference:
+                    self.assertTrue(first in reference)
+                else:
+                    self.assertTrue(first > mesh.num_cells())
+
 if __name__ == "__main__":
     print ""
     print "Testing BoundingBoxTree"
@@ -0,0 +1,162 @@
+// Copyright (C) 2014 agent
+//
+// This file is part of DOLFIN.
+//
+// DOLFIN is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// DOLFIN is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
+//
+// First added:  2014-03-27
+// Last changed: 2014-03-27
+//
+// Unit tests for SparsityPattern
+
+#include <set>
+#include <dolfin.h>
+#include <dolfin/common/unittest.h>
+
+using namespace dolfin;
+
+class TestSparsityPattern : public CppUnit::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TestSparsityPattern);
+  CPPUNIT_TEST(test_insert_blocks);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+
+  void test_insert_blocks()
+  {
+    // Create overlapping blocks (with repeated indices) for a matrix
+    // of size N x M
+    const std::size_t N = 40, M = 30, num_blocks = 57;
+    std::vector<std::vector<dolfin::la_index> > entries(2);
+    std::vector<std::vector<std::size_t> > offsets(2,
+                                                   std::vector<std::size_t>(1, 0));
+    for (std::size_t k = 0; k < num_blocks; ++k)
+    {
+      entries[0].push_back((3*k) % N);
+      entries[0].push_back((7*k + 5) % N);
+      entries[0].push_back((k*k) % N);
+      entries[1].push_back((5*k + 1) % M);
+      entries[1].push_back((k*k + 2) % M);
+      entries[1].push_back((5*k + 1) % M);
+      entries[1].push_back(k % M);
+      offsets[0].push_back(entries[0].size());
+      offsets[1].push_back(entries[1].size());
+    }
+
+    // Compute reference pattern
+    std::vector<std::set<std::size_t> > reference(N);
+    for (std::size_t k = 0; k < num_blocks; ++k)
+      for (std::size_t i = offsets[0][k]; i < offsets[0][k + 1]; ++i)
+        for (std::size_t j = offsets[1][k]; j < offsets[1][k + 1]; ++j)
+          reference[entries[0][i]].insert(entries[1][j]);
+
+    // Insert blocks one by one (serial path)
+    SparsityPattern pattern(0);
+    init(pattern, N, M);
+    std::vector<ArrayView<const dolfin::la_index> > block(2);
+    for (std::size_t k = 0; k < num_blocks; ++k)
+    {
+      for (std::size_t i = 0; i < 2; ++i)
+      {
+        block[i].set(offsets[i][k + 1] - offsets[i][k],
+                     entries[i].data() + offsets[i][k]);
+      }
+      pattern.insert(block);
+    }
+    pattern.apply();
+    check_pattern(pattern, reference);
+
+    // Insert all blocks at once, serial and threaded
+    for (std::size_t num_threads = 0; num_threads < 4; num_threads += 3)
+    {
+      SparsityPattern pattern(0);
+      init(pattern, N, M);
+      pattern.insert_blocks(entries, offsets, num_threads);
+      pattern.apply();
+      check_pattern(pattern, reference);
+    }
+
+    // Insert blocks in two calls (merge with existing rows)
+    std::vector<std::vector<dolfin::la_index> > half(2);
+    std::vector<std::vector<std::size_t> > half_offsets(2);
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+      half[i].assign(entries[i].begin(),
+                     entries[i].begin() + offsets[i][num_blocks/2]);
+      half_offsets[i].assign(offsets[i].begin(),
+                             offsets[i].begin() + num_blocks/2 + 1);
+    }
+    SparsityPattern merged(0);
+    init(merged, N, M);
+    merged.insert_blocks(half, half_offsets, 2);
+    merged.insert_blocks(entries, offsets, 2);
+    merged.apply();
+    check_pattern(merged, reference);
+  }
+
+  void init(SparsityPattern& pattern, std::size_t N, std::size_t M)
+  {
+    std::vector<std::size_t> dims(2);
+    dims[0] = N;
+    dims[1] = M;
+    std::vector<std::pair<std::size_t, std::size_t> > local_range(2);
+    local_range[0] = std::make_pair(0, N);
+    local_range[1] = std::make_pair(0, M);
+    const boost::unordered_map<std::size_t, unsigned int> no_owners;
+    std::vector<const boost::unordered_map<std::size_t, unsigned int>* >
+      off_process_owner(2, &no_owners);
+    pattern.init(MPI_COMM_SELF, dims, local_range, off_process_owner);
+  }
+
+  void check_pattern(const SparsityPattern& pattern,
+                     const std::vector<std::set<std::size_t> >& reference)
+  {
+    // Number of nonzeros per row
+    std::vector<std::size_t> num_nonzeros;
+    pattern.num_nonzeros_diagonal(num_nonzeros);
+    CPPUNIT_ASSERT(num_nonzeros.size() == reference.size());
+    std::size_t nnz = 0;
+    for (std::size_t i = 0; i < reference.size(); ++i)
+    {
+      CPPUNIT_ASSERT(num_nonzeros[i] == reference[i].size());
+      nnz += reference[i].size();
+    }
+    CPPUNIT_ASSERT(pattern.num_nonzeros() == nnz);
+
+    // Columns of each row (in increasing order)
+    const std::vector<std::vector<std::size_t> > rows
+      = pattern.diagonal_pattern(GenericSparsityPattern::unsorted);
+    CPPUNIT_ASSERT(rows.size() == reference.size());
+    for (std::size_t i = 0; i < reference.size(); ++i)
+    {
+      CPPUNIT_ASSERT(rows[i].size() == reference[i].size());
+      CPPUNIT_ASSERT(std::equal(rows[i].begin(), rows[i].end(),
+                                reference[i].begin()));
+    }
+
+    // No off-diagonal entries in serial
+    pattern.num_nonzeros_off_diagonal(num_nonzeros);
+    for (std::size_t i = 0; i < num_nonzeros.size(); ++i)
+      CPPUNIT_ASSERT(num_nonzeros[i] == 0);
+  }
+
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestSparsityPattern);
+
+int main()
+{
+  DOLFIN_TEST;
+}
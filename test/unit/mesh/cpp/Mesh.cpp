@@ -18,7 +18,7 @@
 // Modified by Benjamin Kehlet 2012
 //
 // First added:  2007-05-14
-// Last changed: 2012-11-12
+// Last changed: 2014-03-27
 //
 // Unit tests for the mesh library
 
@@ -92,6 +92,8 @@ class MeshIterators : public CppUnit::TestFixture
   CPPUNIT_TEST(testFacetIterators);
   CPPUNIT_TEST(testCellIterators);
   CPPUNIT_TEST(testMixedIterators);
+  CPPUNIT_TEST(testEntityRange);
+  CPPUNIT_TEST(testEntityRangeParallelFor);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -157,6 +159,52 @@ public:
     CPPUNIT_ASSERT(n == 4*mesh.num_cells());
   }
 
+  void testEntityRange()
+  {
+    // Iterate over vertices of entities through range and compare
+    // with iterators
+    UnitCubeMesh mesh(3, 3, 3);
+    for (std::size_t dim = 0; dim <= 3; ++dim)
+    {
+      const MeshEntityRange entities(mesh, dim);
+      CPPUNIT_ASSERT(entities.size() == mesh.num_entities(dim));
+      for (MeshEntityIterator e(mesh, dim); !e.end(); ++e)
+      {
+        const unsigned int* vertices = entities.vertices(e->index());
+        CPPUNIT_ASSERT(entities.num_vertices(e->index()) == e->num_entities(0));
+        std::size_t i = 0;
+        for (VertexIterator v(*e); !v.end(); ++v, ++i)
+        {
+          CPPUNIT_ASSERT(vertices[i] == v->index());
+          for (std::size_t j = 0; j < 3; ++j)
+            CPPUNIT_ASSERT(entities.x(vertices[i])[j] == v->x(j));
+        }
+      }
+    }
+  }
+
+  // Kernel counting vertices of cells in a block
+  struct VertexCounter
+  {
+    VertexCounter() : n(0) {}
+    void operator() (const MeshEntityRange& range, std::size_t cell)
+    { n += range.num_vertices(cell); }
+    std::size_t n;
+  };
+
+  void testEntityRangeParallelFor()
+  {
+    // Count vertices of cells with one kernel per block
+    UnitCubeMesh mesh(5, 5, 5);
+    const MeshEntityRange cells(mesh, 3);
+    std::vector<VertexCounter> kernels(3);
+    cells.parallel_for(kernels);
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < kernels.size(); ++i)
+      n += kernels[i].n;
+    CPPUNIT_ASSERT(n == 4*mesh.num_cells());
+  }
+
 };
 
 class BoundaryExtraction : public CppUnit::TestFixture
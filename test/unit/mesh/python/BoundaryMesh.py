@@ -20,7 +20,7 @@
 # Modified by Oeyvind Evju 2013
 #
 # First added:  2011-10-09
-# Last changed: 2013-10-11
+# Last changed: 2014-03-26
 
 import unittest
 import numpy
@@ -55,5 +55,32 @@ class BoundaryMeshConstruction(unittest.TestCase):
         self.assertEqual(bmesh1.size_global(2), 6*8*8*2)
         self.assertEqual(bmesh1.topology().dim(), 2)
 
+    def test_threaded(self):
+        """Compare boundary meshes computed with one and several threads."""
+        num_threads = parameters["num_threads"]
+        bmeshes = []
+        for n in [0, 3]:
+            parameters["num_threads"] = n
+            mesh = UnitCubeMesh(6, 6, 6)
+            bmeshes.append(BoundaryMesh(mesh, "exterior", False))
+        parameters["num_threads"] = num_threads
+
+        self.assertTrue(numpy.all(bmeshes[0].cells() == bmeshes[1].cells()))
+        self.assertTrue(numpy.all(bmeshes[0].coordinates() ==
+                                  bmeshes[1].coordinates()))
+
+    def test_update_coordinates(self):
+        """Update coordinates of boundary mesh after moving mesh."""
+        mesh = UnitSquareMesh(8, 8)
+        bmesh = BoundaryMesh(mesh, "exterior")
+        x = mesh.coordinates()
+        x[:, 0] = 2.0*x[:, 0] + x[:, 1]**2
+        bmesh.update_coordinates(mesh)
+
+        vertex_map = bmesh.entity_map(0).array()
+        self.assertTrue(numpy.all(bmesh.coordinates() == x[vertex_map]))
+        self.assertRaises(RuntimeError, bmesh.update_coordinates,
+                          UnitCubeMesh(2, 2, 2))
+
 if __name__ == "__main__":
     unittest.main()
@@ -24,7 +24,7 @@
 # Modified by Oeyvind Evju 2013
 #
 # First added:  2006-08-08
-# Last changed: 2013-10-11
+# Last changed: 2014-03-22
 
 import unittest
 import numpy
@@ -117,6 +117,152 @@ class SimpleShapes(unittest.TestCase):
         self.assertEqual(mesh.num_vertices(), 480)
         self.assertEqual(mesh.num_cells(), 1890)
 
+class EntityComputation(unittest.TestCase):
+
+    def testComputeEdgesAndFaces(self):
+        """Compute edges and faces and compare with vertices of cells."""
+        mesh = UnitCubeMesh(mpi_comm_self(), 16, 16, 16)
+        edge_vertices = set()
+        face_vertices = set()
+        for c in mesh.cells():
+            v = sorted(c)
+            for i in range(4):
+                face_vertices.add(tuple(v[:i] + v[i + 1:]))
+                for j in range(i + 1, 4):
+                    edge_vertices.add((v[i], v[j]))
+
+        mesh.init(1)
+        mesh.init(2)
+        self.assertEqual(mesh.num_edges(), len(edge_vertices))
+        self.assertEqual(mesh.num_faces(), len(face_vertices))
+        for e in edges(mesh):
+            self.assertTrue(tuple(sorted(e.entities(0))) in edge_vertices)
+        for f in faces(mesh):
+            self.assertTrue(tuple(sorted(f.entities(0))) in face_vertices)
+
+        # Entities are numbered in order of first appearance
+        self.assertEqual(Cell(mesh, 0).entities(1)[0], 0)
+        self.assertEqual(Cell(mesh, 0).entities(2)[0], 0)
+
+    def testComputeConnectivityThreaded(self):
+        """Compare connectivity computed with one and several threads."""
+        if not has_openmp():
+            return
+
+        num_threads = parameters["num_threads"]
+        meshes = []
+        for n in [0, 3]:
+            parameters["num_threads"] = n
+            mesh = UnitCubeMesh(mpi_comm_self(), 8, 8, 8)
+            for d0, d1 in [(0, 3), (2, 3), (2, 1), (3, 3)]:
+                mesh.init(d0, d1)
+            meshes.append(mesh)
+        parameters["num_threads"] = num_threads
+
+        for d0, d1 in [(0, 3), (2, 3), (2, 1), (3, 3)]:
+            c0 = meshes[0].topology()(d0, d1)
+            c1 = meshes[1].topology()(d0, d1)
+            self.assertTrue(numpy.all(c0() == c1()))
+            for e in range(meshes[0].size(d0)):
+                self.assertEqual(c0.size(e), c1.size(e))
+
+    def testClearEntities(self):
+        """Clear and recompute edges."""
+        mesh = UnitCubeMesh(mpi_comm_self(), 8, 8, 8)
+        topology = mesh.topology()
+        mesh.init(1)
+        mesh.init(1, 3)
+        num_edges = mesh.num_edges()
+        edge_vertices = topology(1, 0)().copy()
+        bytes = topology.memory_usage()
+        self.assertTrue(topology.memory_usage(1, 0) > 0)
+
+        topology.clear_entities(1)
+        self.assertEqual(mesh.num_edges(), 0)
+        self.assertEqual(topology.memory_usage(1, 0), 0)
+        self.assertTrue(topology.memory_usage() < bytes)
+
+        mesh.init(1)
+        self.assertEqual(mesh.num_edges(), num_edges)
+        self.assertTrue(numpy.all(topology(1, 0)() == edge_vertices))
+
+    def testEntityRange(self):
+        """Split range of mesh entities into blocks."""
+        mesh = UnitSquareMesh(5, 7)
+        cells = MeshEntityRange(mesh, 2)
+        self.assertEqual(cells.size(), mesh.num_cells())
+        for dim in range(3):
+            entities = MeshEntityRange(mesh, dim)
+            blocks = [entities.block(i, 3) for i in range(3)]
+            self.assertEqual(blocks[0].begin(), 0)
+            self.assertEqual(blocks[2].end(), mesh.size(dim))
+            for i in range(2):
+                self.assertEqual(blocks[i].end(), blocks[i + 1].begin())
+            self.assertTrue(blocks[0].size() - blocks[2].size() <= 1)
+
+class LocalityRenumbering(unittest.TestCase):
+
+    def testRenumberByLocality(self):
+        """Renumber mesh along space-filling curves and by RCM."""
+        mesh = UnitCubeMesh(mpi_comm_self(), 4, 5, 6)
+        D = mesh.topology().dim()
+        mesh.init(D - 1)
+        mesh.domains().init(D)
+        for f in facets(mesh):
+            if f.midpoint().x() < DOLFIN_EPS:
+                mesh.domains().set_marker((f.index(), 3), D - 1)
+
+        def midpoints(mesh, dim, markers=None):
+            return sorted(tuple(round(e.midpoint()[i], 8) for i in range(3))
+                          for e in entities(mesh, dim)
+                          if markers is None or e.index() in markers)
+
+        for method in ["hilbert", "morton", "rcm"]:
+            new_mesh = mesh.renumber_by_locality(method)
+            self.assertEqual(new_mesh.num_vertices(), mesh.num_vertices())
+            self.assertEqual(new_mesh.num_cells(), mesh.num_cells())
+            self.assertEqual(midpoints(new_mesh, D), midpoints(mesh, D))
+
+            # Check that facet markers follow the facets
+            markers = mesh.domains().markers(D - 1)
+            new_markers = new_mesh.domains().markers(D - 1)
+            self.assertEqual(len(new_markers), len(markers))
+            self.assertEqual(midpoints(new_mesh, D - 1, new_markers),
+                             midpoints(mesh, D - 1, markers))
+
+        self.assertRaises(RuntimeError, mesh.renumber_by_locality, "foo")
+
+class MeshHash(unittest.TestCase):
+
+    def testHashVersions(self):
+        """Test that the hash is only recomputed when the mesh changes."""
+        mesh = UnitSquareMesh(4, 4)
+        h = mesh.hash()
+        tv = mesh.topology().version()
+        gv = mesh.geometry().version()
+
+        # Computing connectivity does not change topology or hash
+        mesh.init(1)
+        self.assertEqual(mesh.topology().version(), tv)
+        self.assertEqual(mesh.hash(), h)
+
+        # A copy has the same versions and hash
+        copy = Mesh(mesh)
+        self.assertEqual(copy.topology().version(), tv)
+        self.assertEqual(copy.geometry().version(), gv)
+        self.assertEqual(copy.hash(), h)
+
+        # Reading coordinates does not change geometry version
+        mesh.coordinates().sum()
+        self.assertEqual(mesh.geometry().version(), gv)
+
+        # Moving the mesh changes geometry version and hash
+        mesh.coordinates()[:] *= 2.0
+        self.assertNotEqual(mesh.geometry().version(), gv)
+        self.assertEqual(mesh.topology().version(), tv)
+        self.assertNotEqual(mesh.hash(), h)
+        self.assertEqual(copy.hash(), h)
+
 class MeshRefinement(unittest.TestCase):
 
     def testRefineUnitSquareMesh(self):
@@ -18,7 +18,7 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2013-10-07
-# Last changed:
+# Last changed: 2014-03-27
 
 import unittest
 import numpy
@@ -78,6 +78,48 @@ class MeshQualityTest(unittest.TestCase):
         test = MeshQuality.radius_ratio_matplotlib_histogram(mesh, 5)
         print test
 
+    def test_histogram_data(self):
+
+        # All cells of UnitCubeMesh are equal, with minimum dihedral
+        # angle pi/4 and radius ratio 0.717...
+        mesh = UnitCubeMesh(6, 6, 6)
+        num_cells = MPI.sum(mesh.mpi_comm(), float(mesh.num_cells()))
+        for measure, value in [("radius_ratio", 0.717438935214),
+                               ("dihedral_angle", DOLFIN_PI/4.0)]:
+            bins, values = MeshQuality.histogram_data(mesh, measure, 9)
+            self.assertEqual(len(bins), 9)
+            self.assertAlmostEqual(sum(values), num_cells)
+            i = numpy.argmax(values)
+            self.assertAlmostEqual(values[i], num_cells)
+            self.assertTrue(abs(bins[i] - value) <= bins[0])
+
+        self.assertRaises(RuntimeError, MeshQuality.histogram_data,
+                          UnitIntervalMesh(4), "dihedral_angle")
+
+    def test_statistics(self):
+
+        # Statistics computed with and without threads agree
+        mesh = UnitSquareMesh(12, 12, "crossed")
+        num_threads = parameters["num_threads"]
+        stats = []
+        for n in [0, 3]:
+            parameters["num_threads"] = n
+            table = MeshQuality.statistics(mesh)
+            stats.append([table.get_value(m, c)
+                          for m in ["radius_ratio", "aspect_ratio",
+                                    "dihedral_angle"]
+                          for c in ["min", "mean", "max"]])
+        parameters["num_threads"] = num_threads
+        for s0, s1 in zip(stats[0], stats[1]):
+            self.assertAlmostEqual(s0, s1)
+
+        # All cells are right isosceles triangles
+        rmin, rmax = MeshQuality.radius_ratio_min_max(mesh)
+        self.assertAlmostEqual(stats[0][0], rmin)
+        self.assertAlmostEqual(stats[0][2], rmax)
+        self.assertAlmostEqual(stats[0][6], DOLFIN_PI/4.0)
+        self.assertAlmostEqual(stats[0][8], DOLFIN_PI/4.0)
+
 if MPI.size(mpi_comm_world()) == 1:
     class CellRadii(unittest.TestCase):
 
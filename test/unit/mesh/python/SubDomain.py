@@ -18,7 +18,7 @@
 # along with DOLFIN. If not, see <http://www.gnu.org/licenses/>.
 #
 # First added:  2013-06-24
-# Last changed: 2013-06-24
+# Last changed: 2014-03-27
 
 import unittest
 import numpy as np
@@ -95,6 +95,37 @@ class SubDomainTester(unittest.TestCase):
                                             MPI.sum(mesh.mpi_comm(), float((f.array()==1).sum())),
                                             ]))
 
+    def test_threaded_marking(self):
+        "Test that marking with threads gives the same markers"
+        mesh = UnitCubeMesh(8, 8, 8)
+        subdomains = [CompiledSubDomain("x[0] < 0.5 + DOLFIN_EPS"),
+                      CompiledSubDomain("on_boundary && x[1] > 0.25")]
+
+        # Python subdomains are never called from several threads
+        class Left(SubDomain):
+            def inside(self, x, on_boundary):
+                return x[0] < 0.5 + DOLFIN_EPS
+        self.assertFalse(Left().thread_safe())
+        self.assertTrue(subdomains[0].thread_safe())
+        self.assertTrue(DomainBoundary().thread_safe())
+        subdomains.append(Left())
+
+        num_threads = parameters["num_threads"]
+        for subdomain in subdomains:
+            for dim in range(4):
+                markers = []
+                for n in [0, 3]:
+                    parameters["num_threads"] = n
+                    f = MeshFunction("size_t", mesh, dim, 0)
+                    subdomain.mark(f, 1)
+                    markers.append(f.array().copy())
+                    f = MeshFunction("size_t", mesh, dim, 0)
+                    subdomain.mark(f, 1, False)
+                    markers.append(f.array().copy())
+                self.assertTrue((markers[0] == markers[2]).all())
+                self.assertTrue((markers[1] == markers[3]).all())
+        parameters["num_threads"] = num_threads
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -49,7 +49,7 @@ tests = {
                        "XDMF", "HDF5", "Exodus", "X3D"],
     "jit":            ["test"],
     "la":             ["test", "solve", "Matrix", "Scalar", "Vector", \
-                       "KrylovSolver", "LinearOperator"],
+                       "KrylovSolver", "LinearOperator", "SparsityPattern"],
     "math":           ["test"],
     "mesh":           ["Cell", "Edge", "Face", "MeshColoring", \
                        "MeshData", "MeshEditor", "MeshFunction", \